@@ -1,4 +1,6 @@
 
+#include "app.h"
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -9,7 +11,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main()
 {
-    glfwInit();
+    app::init();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -18,7 +20,7 @@ int main()
     if (window == nullptr)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+        app::terminate();
         return -1;
     }
 
@@ -32,7 +34,7 @@ int main()
 
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    while (!glfwWindowShouldClose(window))
+    while (app::nextFrame(window))
     {
         // input
         process_input(window);
@@ -46,7 +48,7 @@ int main()
         glfwPollEvents();
     }
 
-    glfwTerminate();
+    app::terminate();
     return 0;
 }
 
@@ -1,4 +1,6 @@
 
+#include "app.h"
+
 #include <glad/glad.h>
 
 #include <GLFW/glfw3.h>
@@ -37,7 +39,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -48,7 +50,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -147,7 +149,7 @@ int main() {
   glDeleteShader(vertexShader);
   glDeleteShader(fragmentShader);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -166,7 +168,7 @@ int main() {
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
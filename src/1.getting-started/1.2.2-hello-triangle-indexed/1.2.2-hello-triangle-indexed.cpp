@@ -1,4 +1,6 @@
 
+#include "app.h"
+
 #include <glad/glad.h>
 
 #include <GLFW/glfw3.h>
@@ -32,7 +34,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -43,7 +45,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -153,7 +155,7 @@ int main() {
   glDeleteShader(vertexShader);
   glDeleteShader(fragmentShader);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -172,7 +174,7 @@ int main() {
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
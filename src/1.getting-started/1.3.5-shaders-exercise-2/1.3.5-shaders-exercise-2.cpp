@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "shader.h"
 
 #include <glad/glad.h>
@@ -17,7 +18,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -28,7 +29,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -95,7 +96,7 @@ int main() {
 
   gpu::Shader shader("shader.vs", "shader.fs");
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -104,7 +105,7 @@ int main() {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    float time = (float)glfwGetTime();
+    float time = (float)app::getTime();
     float offset = sin(time) * 0.5f;
 
     shader.setFloat("xOffset", offset);
@@ -119,7 +120,7 @@ int main() {
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
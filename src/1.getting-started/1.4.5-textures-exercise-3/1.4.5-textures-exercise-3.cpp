@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "shader.h"
 
 #include <stb_image.h>
@@ -19,7 +20,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -30,7 +31,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -184,7 +185,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
   shader.setInt("texture1", 0);
   shader.setInt("texture2", 1);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -207,7 +208,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "shader.h"
 
 #include <glm/glm.hpp>
@@ -22,7 +23,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -33,7 +34,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -187,14 +188,14 @@ gpu::Shader shader("shader.vs", "shader.fs");
   shader.setInt("texture1", 0);
   shader.setInt("texture2", 1);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
 
     glm::mat4 trans = glm::mat4{1.0f};
 
-    float time = static_cast<float>(glfwGetTime());
+    float time = static_cast<float>(app::getTime());
 
     trans = glm::rotate(trans, time, glm::vec3{0.0f, 0.0f, 1.0f});
 
@@ -220,7 +221,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "shader.h"
 
 #include <glm/glm.hpp>
@@ -22,7 +23,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -33,7 +34,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -202,7 +203,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glEnable(GL_DEPTH_TEST);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -214,7 +215,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
     shader.use();
 
     glm::mat4 model = glm::mat4{1.0f};
-    model = glm::rotate(model, static_cast<float>(glfwGetTime()),
+    model = glm::rotate(model, static_cast<float>(app::getTime()),
                         glm::vec3{0.5f, 1.0f, 0.0f});
 
     glm::mat4 view = glm::mat4{1.0f};
@@ -239,7 +240,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
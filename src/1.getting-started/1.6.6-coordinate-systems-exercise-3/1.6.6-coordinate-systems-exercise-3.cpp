@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "shader.h"
 
 #include <glm/glm.hpp>
@@ -22,7 +23,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -33,7 +34,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -216,7 +217,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glEnable(GL_DEPTH_TEST);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -249,7 +250,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
       float angle = glm::radians(20.0f * i);
 
       if (i % 3 == 0) {
-        angle = angle + static_cast<float>(glfwGetTime());
+        angle = angle + static_cast<float>(app::getTime());
       }
 
       model = glm::rotate(model, angle, glm::vec3{1.0f, 0.3f, 0.5f});
@@ -264,7 +265,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glfwPollEvents();
   }
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
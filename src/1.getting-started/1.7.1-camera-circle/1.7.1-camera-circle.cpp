@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "shader.h"
 
@@ -23,7 +24,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -34,7 +35,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -220,7 +221,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glEnable(GL_DEPTH_TEST);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
     // input
     process_input(window);
@@ -240,8 +241,8 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glBindVertexArray(VAO);
 
     float radius = 10.0f;
-    float camX = static_cast<float>(sin(glfwGetTime())) * radius;
-    float camZ = static_cast<float>(cos(glfwGetTime())) * radius;
+    float camX = static_cast<float>(sin(app::getTime())) * radius;
+    float camZ = static_cast<float>(cos(app::getTime())) * radius;
 
     camera.setPosition(glm::vec3{camX, 0.0f, camZ});
     camera.lookAt(glm::vec3{0.0f});
@@ -269,7 +270,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "shader.h"
 
@@ -31,7 +32,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -42,7 +43,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -225,9 +226,9 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glEnable(GL_DEPTH_TEST);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     lastTime = timeSinceStart;
@@ -272,7 +273,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "shader.h"
 
@@ -44,7 +45,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -55,7 +56,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -279,9 +280,9 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glEnable(GL_DEPTH_TEST);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     lastTime = timeSinceStart;
@@ -345,7 +346,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "shader.h"
 
@@ -43,7 +44,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -54,7 +55,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -178,9 +179,9 @@ int main() {
   // vsync off
   glfwSwapInterval(0);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -250,7 +251,7 @@ int main() {
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "pointlight.h"
 #include "shader.h"
@@ -49,7 +50,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -61,7 +62,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -282,9 +283,9 @@ int main() {
   // vsync off
   glfwSwapInterval(0);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -441,7 +442,7 @@ int main() {
   glDeleteProgram(lightCubeShader.getID());
   glDeleteProgram(lightingShader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
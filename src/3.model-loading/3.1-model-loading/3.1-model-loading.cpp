@@ -1,8 +1,11 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "model.h"
 #include "pointlight.h"
 #include "shader.h"
+#include "texturestreamer.h"
+#include "transformhierarchy.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -13,10 +16,14 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 float cameraSpeed = 3.0f;
 
+bool textureStreaming = true;
+
 float lastTime = 0.0f;
 float deltaTime = 0.0f;
 
@@ -50,7 +57,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -62,7 +69,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -182,14 +189,55 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
 
   Model backpack{modelPath.str()};
 
+  // LEARNOPENGL_TEXTURE_STREAMING=0 keeps the textures as loaded,
+  // LEARNOPENGL_TEXTURE_BUDGET_MB=<megabytes> (64 by default)
+  if (const char *streamingValue =
+          std::getenv("LEARNOPENGL_TEXTURE_STREAMING")) {
+    textureStreaming = std::atoi(streamingValue) != 0;
+  }
+
+  streaming::TextureStreamerCreateInfo streamerCreateInfo;
+
+  if (const char *budget = std::getenv("LEARNOPENGL_TEXTURE_BUDGET_MB")) {
+    streamerCreateInfo.budget =
+        static_cast<size_t>(std::max(1, std::atoi(budget))) * 1024 * 1024;
+  }
+
+  // the backpack textures from their tail, finer levels as the camera gets
+  // closer
+  streaming::TextureStreamer textureStreamer{streamerCreateInfo};
+
+  if (textureStreaming) {
+    textureStreamer.addModel(backpack);
+  }
+
+  // the placement of the backpack, its file nodes below it, and the light
+  // cubes. Nothing moves: the matrices are computed by the first update
+  scene::TransformHierarchy transforms;
+
+  uint32_t backpackNode = transforms.addNode(glm::mat4{1.0f});
+  uint32_t backpackFirstNode =
+      backpack.addToHierarchy(transforms, backpackNode);
+
+  uint32_t lightCubeNodes[4];
+
+  for (int i = 0; i < 4; ++i) {
+
+    glm::mat4 model = glm::mat4{1.0f};
+    model = glm::translate(model, pointLights[i].position);
+    model = glm::scale(model, glm::vec3{0.1f});
+
+    lightCubeNodes[i] = transforms.addNode(model);
+  }
+
   glEnable(GL_DEPTH_TEST);
 
   // vsync off
   glfwSwapInterval(0);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -203,6 +251,16 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
          << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
          << " [ " << nrFrames << " FPS]";
 
+      if (textureStreaming) {
+
+        const streaming::TextureStreamerStats &stats =
+            textureStreamer.getStats();
+
+        ss << " [textures " << stats.residentBytes / (1024 * 1024) << " / "
+           << textureStreamer.getBudget() / (1024 * 1024) << " MB, "
+           << stats.nLoading << " loading]";
+      }
+
       glfwSetWindowTitle(window, ss.str().c_str());
 
       nrFrames = 0;
@@ -233,6 +291,16 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
     const glm::mat4 &view = camera.getViewMatrix();
     const glm::mat4 &projection = camera.getProjectionMatrix();
 
+    transforms.update();
+
+    if (textureStreaming) {
+
+      int framebufferWidth, framebufferHeight;
+      glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+      textureStreamer.update(camera, framebufferHeight);
+    }
+
     // cube lights
 
     lightCubeShader.use();
@@ -244,11 +312,7 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
 
     for (int i = 0; i < 4; ++i) {
 
-      glm::mat4 model = glm::mat4{1.0f};
-      model = glm::translate(model, pointLights[i].position);
-      model = glm::scale(model, glm::vec3{0.1f});
-
-      lightCubeShader.setMat4("model", model);
+      lightCubeShader.setMat4("model", transforms.getWorld(lightCubeNodes[i]));
       lightCubeShader.setVec3("lightColor", pointLights[i].diffuse);
 
       glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -271,14 +335,9 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
 
     lightingShader.setVec3("viewPos", cameraPos);
 
-    glm::mat4 model = glm::mat4{1.0f};
-
-    lightingShader.setMat4("model", model);
     lightingShader.setMat4("view", view);
     lightingShader.setMat4("projection", projection);
 
-    lightingShader.setMat4("invModel", glm::inverse(model));
-
     // point lights
 
     for (int i = 0; i < 4; ++i) {
@@ -328,7 +387,8 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
         lightingShader.setFloat("spotLight.quadraticAtt", 0.032f);
     */
 
-    backpack.draw(lightingShader);
+    // model and normalMatrix of each part from its node
+    backpack.draw(lightingShader, transforms, backpackFirstNode);
 
     // sysevents and buffer swaping
     glfwSwapBuffers(window);
@@ -337,7 +397,9 @@ gpu::Shader lightCubeShader("light-cube.vs", "light-cube.fs");
 
   glDeleteProgram(lightingShader.getID());
 
-  glfwTerminate();
+  textureStreamer.destroy();
+
+  app::terminate();
   return 0;
 }
 
@@ -8,7 +8,7 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-uniform mat4 invModel;
+uniform mat3 normalMatrix;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -17,7 +17,7 @@ out vec2 TexCoords;
 void main() {
 
   FragPos = vec3(model * vec4(aPos, 1.0));
-  Normal = mat3(transpose(invModel)) * aNormal;
+  Normal = normalMatrix * aNormal;
   TexCoords = aTexCoords;
   
   gl_Position = projection * view * model * vec4(aPos, 1.0);
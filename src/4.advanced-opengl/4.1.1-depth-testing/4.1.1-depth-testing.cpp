@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "model.h"
 #include "pointlight.h"
@@ -50,7 +51,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -62,7 +63,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -258,9 +259,9 @@ gpu::Shader shader("depth-testing.vs", "depth-testing.fs");
 
   glUseProgram(0);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -344,7 +345,7 @@ gpu::Shader shader("depth-testing.vs", "depth-testing.fs");
 
   glDeleteProgram(shader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,6 @@
 
+#include "app.h"
+#include "instancebuffer.h"
 #include "shader.h"
 
 #include <glm/glm.hpp>
@@ -32,7 +34,7 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -44,7 +46,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -107,26 +109,23 @@ int main() {
                             5 * sizeof(float));
   glVertexArrayAttribBinding(quadVAO, 1, 1);
 
-  GLuint instanceVBO;
-  glCreateBuffers(1, &instanceVBO);
-  glNamedBufferData(instanceVBO, sizeof(translations), &translations[0],
-                    GL_STATIC_DRAW);
+  // per-instance offset, at location 2 of the shader
+  gpu::InstanceBufferCreateInfo instancesCreateInfo;
+  instancesCreateInfo.capacity = 100;
+  instancesCreateInfo.location = 2;
 
-  // per-instance offset
-  glEnableVertexArrayAttrib(quadVAO, 2);
-  glVertexArrayAttribFormat(quadVAO, 2, 2, GL_FLOAT, GL_FALSE, 0);
-  glVertexArrayVertexBuffer(quadVAO, 2, instanceVBO, 0, 2 * sizeof(float));
-  glVertexArrayAttribBinding(quadVAO, 2, 2);
-  glVertexArrayBindingDivisor(quadVAO, 2, 1);
+  gpu::InstanceBuffer<glm::vec2> instances{instancesCreateInfo};
+  instances.update(translations, 100);
+  instances.attach(quadVAO);
 
   // vsync off
   glfwSwapInterval(0);
 
 gpu::Shader shader("instancing.vs", "instancing.fs");
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -170,12 +169,14 @@ gpu::Shader shader("instancing.vs", "instancing.fs");
     glfwPollEvents();
   }
 
+  instances.destroy();
+
   glDeleteVertexArrays(1, &quadVAO);
   glDeleteBuffers(1, &quadVBO);
 
   glDeleteProgram(shader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -1,4 +1,6 @@
 
+#include "app.h"
+#include "drawlist.h"
 #include "flycamera.h"
 #include "model.h"
 #include "pointlight.h"
@@ -14,6 +16,7 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <vector>
 
 float cameraSpeed = 3.0f;
 
@@ -50,7 +53,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -62,7 +65,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -91,7 +94,7 @@ int main() {
 
   unsigned int nrRocks = 3000;
   glm::mat4 *modelMatrices = new glm::mat4[nrRocks];
-  srand(static_cast<int>(100.0 * glfwGetTime()));
+  srand(static_cast<int>(100.0 * app::getTime()));
 
   float radius = 30.f;
   float offset = 2.5f;
@@ -150,9 +153,31 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   Model planet{planetObjPath.str()};
 
-  while (!glfwWindowShouldClose(window)) {
+  // the rocks are culled, sorted and recorded by worker threads, the loop
+  // below only submits their command lists
+  drawlist::DrawListBuilder drawLists;
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+  uint32_t rockDrawable = drawLists.addDrawable(rock, shader);
+  uint32_t planetDrawable = drawLists.addDrawable(planet, shader);
+
+  std::vector<drawlist::SceneObject> objects;
+  objects.reserve(nrRocks + 1);
+
+  {
+    glm::mat4 model{1.0f};
+    model = glm::translate(model, glm::vec3{0.0f, -3.0f, 0.0f});
+    model = glm::scale(model, glm::vec3{4.0f});
+
+    objects.emplace_back(model, planetDrawable);
+  }
+
+  for (unsigned int i = 0; i < nrRocks; ++i) {
+    objects.emplace_back(modelMatrices[i], rockDrawable);
+  }
+
+  while (app::nextFrame(window)) {
+
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -164,7 +189,8 @@ gpu::Shader shader("shader.vs", "shader.fs");
       std::stringstream ss;
       ss << "LearnOpenGL"
          << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
-         << " [ " << nrFrames << " FPS]";
+         << " [ " << nrFrames << " FPS]"
+         << " [" << drawLists.getStats().nVisible << " visible]";
 
       glfwSetWindowTitle(window, ss.str().c_str());
 
@@ -188,25 +214,9 @@ gpu::Shader shader("shader.vs", "shader.fs");
     glNamedBufferSubData(ubo, sizeof(glm::mat4), sizeof(glm::mat4),
                          glm::value_ptr(projection));
 
-    // planet
-    {
-      glm::mat4 model{1.0f};
-      model = glm::translate(model, glm::vec3{0.0f, -3.0f, 0.0f});
-      model = glm::scale(model, glm::vec3{4.0f});
-
-      shader.use();
-      shader.setMat4("model", model);
-
-      planet.draw(shader);
-    }
-
-    // asteroids
-    {
-      for (unsigned int i = 0; i < nrRocks; ++i) {
-        shader.setMat4("model", modelMatrices[i]);
-        rock.draw(shader);
-      }
-    }
+    // planet and asteroids
+    drawLists.build(objects.data(), objects.size(), view, projection);
+    drawLists.submit();
 
     glBindVertexArray(0);
     glUseProgram(0);
@@ -222,7 +232,7 @@ gpu::Shader shader("shader.vs", "shader.fs");
 
   glDeleteProgram(shader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
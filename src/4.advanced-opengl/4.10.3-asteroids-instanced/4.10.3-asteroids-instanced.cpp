@@ -1,5 +1,9 @@
 
+#include "app.h"
+#include "asteroidbelt.h"
 #include "flycamera.h"
+#include "impostor.h"
+#include "instancebuffer.h"
 #include "model.h"
 #include "pointlight.h"
 #include "shader.h"
@@ -13,6 +17,9 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 float cameraSpeed = 3.0f;
@@ -33,6 +40,19 @@ constexpr int HEIGHT = 600;
 
 float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
 
+// F1: the instances computed once, F2: the rocks orbit and spin, their
+// instances are recomputed every frame into a persistently mapped buffer
+bool animated = false;
+
+// F3: a mat4 per rock, F4: a gpu::CompactInstance (16 bytes) per rock
+bool compact = false;
+
+// F5: every rock is a mesh, F6: the rocks further than impostorDistance are
+// camera facing quads textured from the baked views of the rock (4 vertices
+// instead of the whole mesh)
+bool useImpostors = true;
+float impostorDistance = 50.0f;
+
 FlyCamera camera{glm::vec3{0.0f, 20.0f, 150.0f}, glm::radians(45.0f), aspect,
                  0.1f, 1000.0f};
 
@@ -48,9 +68,73 @@ void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
 
 void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
+// the belt at time seconds, in the layout of the instances
+void writeInstances(const scene::AsteroidBelt &belt, float time,
+                    glm::mat4 *out);
+
+void writeInstances(const scene::AsteroidBelt &belt, float time,
+                    gpu::CompactInstance *out);
+
+glm::vec3 instancePosition(const scene::AsteroidBelt &belt,
+                           const glm::mat4 &instance);
+
+glm::vec3 instancePosition(const scene::AsteroidBelt &belt,
+                           const gpu::CompactInstance &instance);
+
+// the rock instances in one format and the vaos reading them
+template <typename T> struct RockInstances {
+
+  // every rock, or the ones closer than impostorDistance
+  gpu::InstanceBuffer<T> meshInstances;
+  std::vector<GLuint> meshVAOs;
+
+  // impostors: the other rocks, drawn without vertex attributes
+  gpu::InstanceBuffer<T> impostorInstances;
+  GLuint impostorVAO = 0;
+
+  // impostors: all the rocks, split by distance every frame
+  std::vector<T> allInstances;
+};
+
+// what the rocks of a frame are drawn with
+struct RockDraws {
+  GLuint meshBaseInstance = 0;
+  size_t nMeshes = 0;
+
+  GLuint impostorBaseInstance = 0;
+  size_t nImpostors = 0;
+};
+
+// the instances of the mode: the belt at time 0 written once, or rewritten
+// every frame when animated or split by distance
+template <typename T>
+void createRockInstances(RockInstances<T> &rocks,
+                         const scene::AsteroidBelt &belt, const Model &rock,
+                         bool animated, bool withImpostors);
+
+template <typename T> void destroyRockInstances(RockInstances<T> &rocks);
+
+// the instances of this frame, when they change every frame
+template <typename T>
+RockDraws writeFrameInstances(RockInstances<T> &rocks,
+                              const scene::AsteroidBelt &belt, float time,
+                              bool animated, bool withImpostors,
+                              const glm::vec3 &eye);
+
+template <typename T>
+void drawRocks(const RockInstances<T> &rocks, const RockDraws &draws,
+               const Model &rock, const gpu::Shader &rockShader,
+               const gpu::Shader &impostorShader,
+               const impostors::ImpostorAtlas &rockAtlas);
+
+// after the draws of the frame
+template <typename T>
+void endFrameInstances(RockInstances<T> &rocks, bool animated,
+                       bool withImpostors);
+
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -62,7 +146,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -89,53 +173,36 @@ int main() {
 
   glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
 
+  // LEARNOPENGL_ROCKS=<count> (100000 by default), LEARNOPENGL_ANIMATED=1
+  // and LEARNOPENGL_COMPACT=1 to start in the animated mode and with the
+  // compact instances, LEARNOPENGL_IMPOSTORS=0 without impostors and
+  // LEARNOPENGL_IMPOSTOR_DISTANCE=<distance>
   unsigned int nrRocks = 100000;
-  glm::mat4 *modelMatrices = new glm::mat4[nrRocks];
-  srand(static_cast<int>(100.0 * glfwGetTime()));
-
-  float radius = 150.f;
-  float offset = 25.0f;
 
-  for (unsigned int i = 0; i < nrRocks; ++i) {
-
-    glm::mat4 model = glm::mat4{1.0};
-
-    // 1. translation around circle with radius = offset
-
-    float angle = static_cast<float>(i) / static_cast<float>(nrRocks) * 360.0f;
-
-    float displacement =
-        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
-
-    float x = sin(angle) * radius + displacement;
-
-    displacement =
-        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
-
-    float y = displacement * 0.4f;
-
-    displacement =
-        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
-
-    float z = cos(angle) * radius + displacement;
+  if (const char *rocks = std::getenv("LEARNOPENGL_ROCKS")) {
+    nrRocks = static_cast<unsigned int>(std::max(1, std::atoi(rocks)));
+  }
 
-    model = glm::translate(model, glm::vec3{x, y, z});
+  if (const char *animatedValue = std::getenv("LEARNOPENGL_ANIMATED")) {
+    animated = std::atoi(animatedValue) != 0;
+  }
 
-    // 2. scale
-    float scale = static_cast<float>(rand() % 20) / 100.0f + 0.05f;
-    model = glm::scale(model, glm::vec3{scale});
+  if (const char *compactValue = std::getenv("LEARNOPENGL_COMPACT")) {
+    compact = std::atoi(compactValue) != 0;
+  }
 
-    // 3. rotation - random rot around a rotation axis
-    float rotAngle = static_cast<float>(rand() % 360);
-    model = glm::rotate(model, rotAngle, glm::vec3{0.4f, 0.6f, 0.8f});
+  if (const char *impostorsValue = std::getenv("LEARNOPENGL_IMPOSTORS")) {
+    useImpostors = std::atoi(impostorsValue) != 0;
+  }
 
-    modelMatrices[i] = model;
+  if (const char *distance = std::getenv("LEARNOPENGL_IMPOSTOR_DISTANCE")) {
+    impostorDistance = static_cast<float>(std::atof(distance));
   }
 
-  GLuint instancedVBO;
-  glCreateBuffers(1, &instancedVBO);
-  glNamedBufferData(instancedVBO, nrRocks * sizeof(glm::mat4),
-                    &modelMatrices[0], GL_STATIC_DRAW);
+  scene::AsteroidBeltCreateInfo beltCreateInfo;
+  beltCreateInfo.nInstances = nrRocks;
+
+  scene::AsteroidBelt belt{beltCreateInfo};
 
   // vsync off
   glfwSwapInterval(0);
@@ -145,53 +212,55 @@ int main() {
 
   gpu::Shader shader("shader.vs", "shader.fs");
   gpu::Shader instancedShader("instanced.vs", "instanced.fs");
+  gpu::Shader compactShader("instanced-compact.vs", "instanced.fs");
+
+  const gpu::InstanceQuantization &quantization =
+      belt.getInstanceQuantization();
+
+  compactShader.setVec4("instanceMin", quantization.min);
+  compactShader.setVec4("instanceExtent", quantization.extent);
 
   std::stringstream rockObjPath;
   rockObjPath << getModelPath("rock") << separator << "rock.obj";
 
   Model rock{rockObjPath.str()};
 
-  for (unsigned int i = 0; i < rock.m_meshes.size(); ++i) {
-
-    GLuint vao = rock.m_meshes[i].getVAO();
-
-    glEnableVertexArrayAttrib(vao, 3);
-    glEnableVertexArrayAttrib(vao, 4);
-    glEnableVertexArrayAttrib(vao, 5);
-    glEnableVertexArrayAttrib(vao, 6);
-
-    glVertexArrayAttribFormat(vao, 3, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(vao, 4, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(vao, 5, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(vao, 6, 4, GL_FLOAT, GL_FALSE, 0);
-
-    glVertexArrayVertexBuffer(vao, 3, instancedVBO, 0, sizeof(glm::mat4));
-    glVertexArrayVertexBuffer(vao, 4, instancedVBO, sizeof(glm::vec4),
-                              sizeof(glm::mat4));
-    glVertexArrayVertexBuffer(vao, 5, instancedVBO, 2 * sizeof(glm::vec4),
-                              sizeof(glm::mat4));
-    glVertexArrayVertexBuffer(vao, 6, instancedVBO, 3 * sizeof(glm::vec4),
-                              sizeof(glm::mat4));
-
-    glVertexArrayAttribBinding(vao, 3, 3);
-    glVertexArrayAttribBinding(vao, 4, 4);
-    glVertexArrayAttribBinding(vao, 5, 5);
-    glVertexArrayAttribBinding(vao, 6, 6);
-
-    glVertexArrayBindingDivisor(vao, 3, 1);
-    glVertexArrayBindingDivisor(vao, 4, 1);
-    glVertexArrayBindingDivisor(vao, 5, 1);
-    glVertexArrayBindingDivisor(vao, 6, 1);
-  }
+  // the rock seen from 8x8 directions, baked on the first run and loaded
+  // from next to the executable afterwards
+  impostors::ImpostorAtlasCreateInfo atlasCreateInfo;
+  atlasCreateInfo.cachePath = getExecPath().append("rock.impostor").string();
+
+  impostors::ImpostorAtlas rockAtlas{rock, atlasCreateInfo};
+
+  gpu::Shader impostorShader = impostors::createShader<glm::mat4>();
+  gpu::Shader compactImpostorShader =
+      impostors::createShader<gpu::CompactInstance>();
+
+  compactImpostorShader.setVec4("instanceMin", quantization.min);
+  compactImpostorShader.setVec4("instanceExtent", quantization.extent);
+
+  // only the instances of the current mode and format exist, (re)created
+  // when they change. The rock meshes are drawn with vaos of the instance
+  // buffer, their own vaos are left as they are
+  RockInstances<glm::mat4> matrixRocks;
+  RockInstances<gpu::CompactInstance> compactRocks;
+
+  bool instancesAnimated = !animated;
+  bool instancesCompact = compact;
+  bool instancesImpostors = useImpostors;
+
+  RockDraws draws;
+
+  double updateMilliseconds = 0.0;
 
   std::stringstream planetObjPath;
   planetObjPath << getModelPath("planet") << separator << "planet.obj";
 
   Model planet{planetObjPath.str()};
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -203,7 +272,25 @@ int main() {
       std::stringstream ss;
       ss << "LearnOpenGL"
          << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
-         << " [ " << nrFrames << " FPS]";
+         << " [ " << nrFrames << " FPS]"
+         << " [" << nrRocks << (animated ? " animated" : " static")
+         << " rocks, "
+         << (compact ? sizeof(gpu::CompactInstance) : sizeof(glm::mat4))
+         << " bytes each]";
+
+      if (useImpostors) {
+        ss << " [" << draws.nMeshes << " meshes, " << draws.nImpostors
+           << " impostors]";
+      }
+
+      if (animated || useImpostors) {
+        ss << " [update " << updateMilliseconds / nrFrames << " ms, "
+           << (compact ? compactRocks.meshInstances.getNumStalls()
+                       : matrixRocks.meshInstances.getNumStalls())
+           << " stalls]";
+      }
+
+      updateMilliseconds = 0.0;
 
       glfwSetWindowTitle(window, ss.str().c_str());
 
@@ -216,6 +303,41 @@ int main() {
     // input
     process_input(window);
 
+    if (animated != instancesAnimated || compact != instancesCompact ||
+        useImpostors != instancesImpostors) {
+
+      destroyRockInstances(matrixRocks);
+      destroyRockInstances(compactRocks);
+
+      if (compact) {
+        createRockInstances(compactRocks, belt, rock, animated, useImpostors);
+      } else {
+        createRockInstances(matrixRocks, belt, rock, animated, useImpostors);
+      }
+
+      instancesAnimated = animated;
+      instancesCompact = compact;
+      instancesImpostors = useImpostors;
+    }
+
+    // the instances of this frame go to the next region of the buffers,
+    // drawn with it as base instance
+    {
+      auto updateStart = std::chrono::steady_clock::now();
+
+      const glm::vec3 &eye = camera.getPosition();
+
+      draws = compact ? writeFrameInstances(compactRocks, belt, timeSinceStart,
+                                            animated, useImpostors, eye)
+                      : writeFrameInstances(matrixRocks, belt, timeSinceStart,
+                                            animated, useImpostors, eye);
+
+      updateMilliseconds +=
+          std::chrono::duration<double, std::milli>(
+              std::chrono::steady_clock::now() - updateStart)
+              .count();
+    }
+
     // rendering
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -240,19 +362,25 @@ int main() {
     }
 
     // asteroids
-    {
-      instancedShader.use();
-      instancedShader.setInt("material.diffuse_texture0", 0);
+    if (compact) {
 
-      for (unsigned int i = 0; i < rock.m_meshes.size(); ++i) {
+      compactImpostorShader.setMat4("view", view);
+      compactImpostorShader.setMat4("projection", projection);
 
-        glBindVertexArray(rock.m_meshes[i].getVAO());
+      drawRocks(compactRocks, draws, rock, compactShader,
+                compactImpostorShader, rockAtlas);
 
-        glBindTextureUnit(0, rock.m_meshes[i].m_textures[0].texture.getID());
+      endFrameInstances(compactRocks, animated, useImpostors);
 
-        glDrawElementsInstanced(GL_TRIANGLES, rock.m_meshes[i].m_indices.size(),
-                                GL_UNSIGNED_INT, nullptr, nrRocks);
-      }
+    } else {
+
+      impostorShader.setMat4("view", view);
+      impostorShader.setMat4("projection", projection);
+
+      drawRocks(matrixRocks, draws, rock, instancedShader, impostorShader,
+                rockAtlas);
+
+      endFrameInstances(matrixRocks, animated, useImpostors);
     }
 
     glBindVertexArray(0);
@@ -263,13 +391,16 @@ int main() {
     glfwPollEvents();
   }
 
-  delete[] modelMatrices;
+  destroyRockInstances(matrixRocks);
+  destroyRockInstances(compactRocks);
+
+  rockAtlas.destroy();
 
   glDeleteVertexArrays(1, &ubo);
 
   glDeleteProgram(shader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -278,6 +409,24 @@ void process_input(GLFWwindow *window) {
     glfwSetWindowShouldClose(window, true);
   }
 
+  if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) {
+    animated = false;
+  } else if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
+    animated = true;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+    compact = false;
+  } else if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS) {
+    compact = true;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
+    useImpostors = false;
+  } else if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS) {
+    useImpostors = true;
+  }
+
   int front = 0;
   int right = 0;
 
@@ -306,6 +455,190 @@ void process_input(GLFWwindow *window) {
   }
 }
 
+void writeInstances(const scene::AsteroidBelt &belt, float time,
+                    glm::mat4 *out) {
+  belt.update(time, out);
+}
+
+void writeInstances(const scene::AsteroidBelt &belt, float time,
+                    gpu::CompactInstance *out) {
+  belt.updateCompact(time, out);
+}
+
+glm::vec3 instancePosition(const scene::AsteroidBelt &belt,
+                           const glm::mat4 &instance) {
+  return glm::vec3{instance[3]};
+}
+
+glm::vec3 instancePosition(const scene::AsteroidBelt &belt,
+                           const gpu::CompactInstance &instance) {
+  return gpu::decodePosition(belt.getInstanceQuantization(), instance);
+}
+
+template <typename T>
+void createRockInstances(RockInstances<T> &rocks,
+                         const scene::AsteroidBelt &belt, const Model &rock,
+                         bool animated, bool withImpostors) {
+
+  size_t nInstances = belt.getNumInstances();
+
+  gpu::InstanceBufferCreateInfo createInfo;
+  createInfo.mode = animated || withImpostors
+                        ? gpu::InstanceBufferMode::PERSISTENT
+                        : gpu::InstanceBufferMode::DYNAMIC;
+  createInfo.capacity = nInstances;
+
+  rocks.meshInstances = gpu::InstanceBuffer<T>{createInfo};
+
+  for (const Mesh &mesh : rock.m_meshes) {
+    rocks.meshVAOs.push_back(rocks.meshInstances.createVertexArray(mesh));
+  }
+
+  if (withImpostors) {
+
+    rocks.impostorInstances = gpu::InstanceBuffer<T>{createInfo};
+
+    glCreateVertexArrays(1, &rocks.impostorVAO);
+    rocks.impostorInstances.attach(rocks.impostorVAO);
+
+    rocks.allInstances.resize(nInstances);
+
+    if (!animated) {
+      writeInstances(belt, 0.0f, rocks.allInstances.data());
+    }
+
+  } else if (!animated) {
+
+    std::vector<T> staticInstances(nInstances);
+    writeInstances(belt, 0.0f, staticInstances.data());
+    rocks.meshInstances.update(staticInstances);
+  }
+}
+
+template <typename T> void destroyRockInstances(RockInstances<T> &rocks) {
+
+  if (rocks.meshInstances.getID() != 0) {
+    rocks.meshInstances.destroy();
+  }
+
+  if (rocks.impostorInstances.getID() != 0) {
+    rocks.impostorInstances.destroy();
+  }
+
+  if (rocks.impostorVAO != 0) {
+    glDeleteVertexArrays(1, &rocks.impostorVAO);
+    rocks.impostorVAO = 0;
+  }
+
+  rocks.meshVAOs.clear();
+  rocks.allInstances.clear();
+}
+
+template <typename T>
+RockDraws writeFrameInstances(RockInstances<T> &rocks,
+                              const scene::AsteroidBelt &belt, float time,
+                              bool animated, bool withImpostors,
+                              const glm::vec3 &eye) {
+
+  size_t nInstances = belt.getNumInstances();
+
+  RockDraws draws;
+
+  if (!withImpostors) {
+
+    draws.nMeshes = nInstances;
+
+    if (animated) {
+
+      T *instances = rocks.meshInstances.beginFrame(nInstances);
+
+      // the buffer couldn't be mapped, nothing is drawn
+      if (instances == nullptr) {
+        draws.nMeshes = 0;
+        return draws;
+      }
+
+      writeInstances(belt, time, instances);
+      draws.meshBaseInstance = rocks.meshInstances.getBaseInstance();
+    }
+
+    return draws;
+  }
+
+  if (animated) {
+    writeInstances(belt, time, rocks.allInstances.data());
+  }
+
+  // both regions can hold every rock, the split fills them in part
+  T *meshInstances = rocks.meshInstances.beginFrame(nInstances);
+  T *impostorInstances = rocks.impostorInstances.beginFrame(nInstances);
+
+  if (meshInstances == nullptr || impostorInstances == nullptr) {
+    return draws;
+  }
+
+  impostors::DistanceSplit split = impostors::splitByDistance(
+      rocks.allInstances.data(), nInstances, eye, impostorDistance,
+      [&](const T &instance) { return instancePosition(belt, instance); },
+      meshInstances, impostorInstances);
+
+  draws.meshBaseInstance = rocks.meshInstances.getBaseInstance();
+  draws.nMeshes = split.nNear;
+
+  draws.impostorBaseInstance = rocks.impostorInstances.getBaseInstance();
+  draws.nImpostors = split.nFar;
+
+  return draws;
+}
+
+template <typename T>
+void drawRocks(const RockInstances<T> &rocks, const RockDraws &draws,
+               const Model &rock, const gpu::Shader &rockShader,
+               const gpu::Shader &impostorShader,
+               const impostors::ImpostorAtlas &rockAtlas) {
+
+  if (draws.nMeshes > 0) {
+
+    rockShader.use();
+    rockShader.setInt("material.diffuse_texture0", 0);
+
+    for (unsigned int i = 0; i < rock.m_meshes.size(); ++i) {
+
+      glBindVertexArray(rocks.meshVAOs[i]);
+
+      glBindTextureUnit(0, rock.m_meshes[i].m_textures[0].texture.getID());
+
+      glDrawElementsInstancedBaseInstance(
+          GL_TRIANGLES, rock.m_meshes[i].m_indices.size(), GL_UNSIGNED_INT,
+          nullptr, draws.nMeshes, draws.meshBaseInstance);
+    }
+  }
+
+  if (draws.nImpostors > 0) {
+
+    rockAtlas.bind(impostorShader);
+    impostorShader.use();
+
+    glBindVertexArray(rocks.impostorVAO);
+
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4,
+                                      draws.nImpostors,
+                                      draws.impostorBaseInstance);
+  }
+}
+
+template <typename T>
+void endFrameInstances(RockInstances<T> &rocks, bool animated,
+                       bool withImpostors) {
+
+  if (withImpostors) {
+    rocks.meshInstances.endFrame();
+    rocks.impostorInstances.endFrame();
+  } else if (animated) {
+    rocks.meshInstances.endFrame();
+  }
+}
+
 void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
 
   float mouseX = static_cast<float>(xPos);
@@ -0,0 +1,33 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 2) in vec2 aTexCoords;
+// gpu::CompactInstance: position and scale as unorm16 over the range of the
+// belt, rotation as a snorm16 quaternion
+layout(location = 8) in vec4 instancePositionScale;
+layout(location = 9) in vec4 instanceRotation;
+
+layout(std140, binding = 0) uniform Matrices {
+  mat4 view;
+  mat4 projection;
+};
+
+uniform vec4 instanceMin;
+uniform vec4 instanceExtent;
+
+out VS_OUT { vec2 texCoords; }
+vs_out;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+  vec4 positionScale = instanceMin + instancePositionScale * instanceExtent;
+
+  vec3 worldPos =
+      positionScale.xyz + rotate(instanceRotation, positionScale.w * aPos);
+
+  vs_out.texCoords = aTexCoords;
+  gl_Position = projection * view * vec4(worldPos, 1.0);
+}
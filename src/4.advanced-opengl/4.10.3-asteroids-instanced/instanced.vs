@@ -3,8 +3,9 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 2) in vec2 aTexCoords;
 // since it's a matrix and vertex attributes can't be bigger than a vec4, we
-// need to use 4 slots (loc 3, 4, 5, 6)
-layout(location = 3) in mat4 instanceMatrix;
+// need to use 4 slots (loc 8, 9, 10, 11), after the mesh attributes
+// (gpu::INSTANCE_ATTRIBUTE_LOCATION)
+layout(location = 8) in mat4 instanceMatrix;
 
 layout(std140, binding = 0) uniform Matrices {
   mat4 view;
@@ -0,0 +1,464 @@
+
+#include "app.h"
+#include "dynamicresolution.h"
+#include "flycamera.h"
+#include "instancebuffer.h"
+#include "model.h"
+#include "pointlight.h"
+#include "shader.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+float cameraSpeed = 3.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+float lastMouseX = 400.0f;
+float lastMouseY = 300.0f;
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+FlyCamera camera{glm::vec3{0.0f, 20.0f, 150.0f}, glm::radians(45.0f), aspect,
+                 0.1f, 1000.0f};
+
+// the scene is rendered at a scale of the window size that follows its gpu
+// time. R toggles the adaptation (back to full resolution), up/down change
+// the budget and H prints the history
+dynres::DynamicResolution dynamicResolution;
+
+bool adaptiveKeyPressed = false;
+bool historyKeyPressed = false;
+bool budgetKeyPressed = false;
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  GLuint ubo;
+  glCreateBuffers(1, &ubo);
+  glNamedBufferData(ubo, 2 * sizeof(glm::mat4), nullptr, GL_STATIC_DRAW);
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+
+  unsigned int nrRocks = 100000;
+  glm::mat4 *modelMatrices = new glm::mat4[nrRocks];
+  srand(static_cast<int>(100.0 * app::getTime()));
+
+  float radius = 150.f;
+  float offset = 25.0f;
+
+  for (unsigned int i = 0; i < nrRocks; ++i) {
+
+    glm::mat4 model = glm::mat4{1.0};
+
+    // 1. translation around circle with radius = offset
+
+    float angle = static_cast<float>(i) / static_cast<float>(nrRocks) * 360.0f;
+
+    float displacement =
+        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
+
+    float x = sin(angle) * radius + displacement;
+
+    displacement =
+        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
+
+    float y = displacement * 0.4f;
+
+    displacement =
+        (rand() % static_cast<int>(2.0f * offset * 100)) / 100.0f - offset;
+
+    float z = cos(angle) * radius + displacement;
+
+    model = glm::translate(model, glm::vec3{x, y, z});
+
+    // 2. scale
+    float scale = static_cast<float>(rand() % 20) / 100.0f + 0.05f;
+    model = glm::scale(model, glm::vec3{scale});
+
+    // 3. rotation - random rot around a rotation axis
+    float rotAngle = static_cast<float>(rand() % 360);
+    model = glm::rotate(model, rotAngle, glm::vec3{0.4f, 0.6f, 0.8f});
+
+    modelMatrices[i] = model;
+  }
+
+  gpu::InstanceBufferCreateInfo instancesCreateInfo;
+  instancesCreateInfo.capacity = nrRocks;
+
+  gpu::InstanceBuffer<glm::mat4> instances{instancesCreateInfo};
+  instances.update(modelMatrices, nrRocks);
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  gpu::Shader shader("shader.vs", "shader.fs");
+  gpu::Shader instancedShader("instanced.vs", "instanced.fs");
+
+  std::stringstream rockObjPath;
+  rockObjPath << getModelPath("rock") << separator << "rock.obj";
+
+  Model rock{rockObjPath.str()};
+
+  // the meshes with the instance matrices
+  std::vector<GLuint> rockVAOs;
+
+  for (const Mesh &mesh : rock.m_meshes) {
+    rockVAOs.push_back(instances.createVertexArray(mesh));
+  }
+
+  std::stringstream planetObjPath;
+  planetObjPath << getModelPath("planet") << separator << "planet.obj";
+
+  Model planet{planetObjPath.str()};
+
+  dynres::DynamicResolutionCreateInfo dynamicResolutionCreateInfo;
+  dynamicResolutionCreateInfo.width = WIDTH;
+  dynamicResolutionCreateInfo.height = HEIGHT;
+  dynamicResolutionCreateInfo.targetMilliseconds = 4.0f;
+
+  dynamicResolution = dynres::DynamicResolution{dynamicResolutionCreateInfo};
+
+  while (app::nextFrame(window)) {
+
+    float timeSinceStart = static_cast<float>(app::getTime());
+    deltaTime = timeSinceStart - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]";
+
+      ss << " [" << dynamicResolution.getRenderWidth() << "x"
+         << dynamicResolution.getRenderHeight() << " ("
+         << dynamicResolution.getScale() << "), scene "
+         << dynamicResolution.getSceneMilliseconds() << " / "
+         << dynamicResolution.getTargetMilliseconds() << " ms, upsample "
+         << dynamicResolution.getUpsampleMilliseconds() << " ms"
+         << (dynamicResolution.isAdaptive() ? "" : ", fixed") << "]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = timeSinceStart;
+
+    // input
+    process_input(window);
+
+    // rendering
+    dynamicResolution.beginScene();
+
+    glEnable(GL_DEPTH_TEST);
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const glm::mat4 &view = camera.getViewMatrix();
+    const glm::mat4 &projection = camera.getProjectionMatrix();
+
+    glNamedBufferSubData(ubo, 0, sizeof(glm::mat4), glm::value_ptr(view));
+    glNamedBufferSubData(ubo, sizeof(glm::mat4), sizeof(glm::mat4),
+                         glm::value_ptr(projection));
+
+    // planet
+    {
+      glm::mat4 model{1.0f};
+      model = glm::translate(model, glm::vec3{0.0f, -3.0f, 0.0f});
+      model = glm::scale(model, glm::vec3{4.0f});
+
+      shader.use();
+      shader.setMat4("model", model);
+
+      planet.draw(shader);
+    }
+
+    // asteroids
+    {
+      instancedShader.use();
+      instancedShader.setInt("material.diffuse_texture0", 0);
+
+      for (unsigned int i = 0; i < rock.m_meshes.size(); ++i) {
+
+        glBindVertexArray(rockVAOs[i]);
+
+        glBindTextureUnit(0, rock.m_meshes[i].m_textures[0].texture.getID());
+
+        glDrawElementsInstanced(GL_TRIANGLES, rock.m_meshes[i].m_indices.size(),
+                                GL_UNSIGNED_INT, nullptr, nrRocks);
+      }
+    }
+
+    dynamicResolution.endScene();
+
+    // upsample to the window
+    dynamicResolution.present();
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  delete[] modelMatrices;
+
+  instances.destroy();
+
+  glDeleteVertexArrays(1, &ubo);
+
+  glDeleteProgram(shader.getID());
+
+  dynamicResolution.destroy();
+
+  app::terminate();
+  return 0;
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+    if (!adaptiveKeyPressed) {
+
+      bool adaptive = !dynamicResolution.isAdaptive();
+
+      dynamicResolution.setAdaptive(adaptive);
+
+      if (!adaptive) {
+        dynamicResolution.setScale(1.0f);
+      }
+
+      adaptiveKeyPressed = true;
+    }
+  } else {
+    adaptiveKeyPressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS ||
+      glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+    if (!budgetKeyPressed) {
+
+      float step = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS ? 0.5f : -0.5f;
+
+      dynamicResolution.setTargetMilliseconds(std::max(
+          0.5f, dynamicResolution.getTargetMilliseconds() + step));
+
+      budgetKeyPressed = true;
+    }
+  } else {
+    budgetKeyPressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS) {
+    if (!historyKeyPressed) {
+
+      std::cout << "scale history (scene ms, scale), target "
+                << dynamicResolution.getTargetMilliseconds() << " ms"
+                << std::endl;
+
+      for (const dynres::FrameSample &sample :
+           dynamicResolution.getHistory()) {
+        std::cout << sample.milliseconds << " " << sample.scale << std::endl;
+      }
+
+      historyKeyPressed = true;
+    }
+  } else {
+    historyKeyPressed = false;
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
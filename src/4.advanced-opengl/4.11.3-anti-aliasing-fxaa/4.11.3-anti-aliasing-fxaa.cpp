@@ -0,0 +1,705 @@
+#include "app.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "model.h"
+#include "pointlight.h"
+#include "query.h"
+#include "renderbuffer.h"
+#include "shader.h"
+#include "texture2d.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+float cameraSpeed = 3.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+float lastMouseX = 400.0f;
+float lastMouseY = 300.0f;
+
+constexpr int WIDTH = 1360;
+constexpr int HEIGHT = 768;
+
+constexpr int MSAA_SAMPLES = 4;
+
+constexpr GLuint COLOR_FORMAT = GL_RGBA8;
+constexpr GLuint DEPTH_FORMAT = GL_DEPTH24_STENCIL8;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+enum class AAMode : int { NONE = 0, MSAA, FXAA, COUNT };
+
+const char *aaModeNames[] = {"no aa", "4x msaa", "fxaa"};
+
+// F1-F3 select the mode. The multisampled targets only exist while msaa is
+// selected, fxaa runs on the single sample framebuffer
+AAMode aaMode = AAMode::FXAA;
+bool aaModeDirty = true;
+
+FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
+                 100.0f};
+
+gpu::Shader shader;
+gpu::Shader screenShader;
+gpu::Shader fxaaShader;
+
+gpu::Renderbuffer msColorRbo;
+gpu::Renderbuffer msDepthRbo;
+gpu::framebuffer::Framebuffer msFramebuffer;
+
+GLuint cubeVAO;
+GLuint planeVAO;
+
+GLuint marbleTex;
+GLuint metalTex;
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+void drawScene();
+
+void createMsaaTargets();
+void destroyMsaaTargets();
+
+size_t getRenderTargetBytes(AAMode mode);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // clang-format off
+
+  float cubeVertices[] = {
+      // positions         // texture Coords
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 
+       0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 
+       0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+      -0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+      -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 
+      -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+      -0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f
+  };
+
+  float planeVertices[] = {
+      // positions         // texture Coords
+       5.0f, -0.5f,  5.0f, 2.0f, 0.0f,  
+      -5.0f, -0.5f,  5.0f, 0.0f, 0.0f,  
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,
+
+       5.0f, -0.5f,  5.0f, 2.0f, 0.0f, 
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f, 
+       5.0f, -0.5f, -5.0f, 2.0f, 2.0f
+  };
+  float quadVertices[] = {
+      // pos(x, y)  // texcoords
+      -1.0f,  1.0f, 0.0f, 1.0f,
+      -1.0f, -1.0f, 0.0f, 0.0f,
+       1.0f, -1.0f, 1.0f, 0.0f,
+
+       1.0f, -1.0f, 1.0f, 0.0f,
+       1.0f,  1.0f, 1.0f, 1.0f,
+      -1.0f,  1.0f, 0.0f, 1.0f
+  };
+
+  // clang-format on
+
+  GLuint cubeVBO;
+  glCreateBuffers(1, &cubeVBO);
+  glNamedBufferData(cubeVBO, sizeof(cubeVertices), cubeVertices,
+                    GL_STATIC_DRAW);
+
+  glCreateVertexArrays(1, &cubeVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(cubeVAO, 0);
+  glVertexArrayAttribFormat(cubeVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(cubeVAO, 0, cubeVBO, 0, 5 * sizeof(float));
+  glVertexArrayAttribBinding(cubeVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(cubeVAO, 1);
+  glVertexArrayAttribFormat(cubeVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(cubeVAO, 1, cubeVBO, 3 * sizeof(float),
+                            5 * sizeof(float));
+  glVertexArrayAttribBinding(cubeVAO, 1, 1);
+
+  GLuint planeVBO;
+  glCreateBuffers(1, &planeVBO);
+  glNamedBufferData(planeVBO, sizeof(planeVertices), planeVertices,
+                    GL_STATIC_DRAW);
+
+  glCreateVertexArrays(1, &planeVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(planeVAO, 0);
+  glVertexArrayAttribFormat(planeVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(planeVAO, 0, planeVBO, 0, 5 * sizeof(float));
+  glVertexArrayAttribBinding(planeVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(planeVAO, 1);
+  glVertexArrayAttribFormat(planeVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(planeVAO, 1, planeVBO, 3 * sizeof(float),
+                            5 * sizeof(float));
+  glVertexArrayAttribBinding(planeVAO, 1, 1);
+
+  glBindVertexArray(0);
+
+  GLuint quadVBO;
+  glCreateBuffers(1, &quadVBO);
+  glNamedBufferData(quadVBO, sizeof(quadVertices), quadVertices,
+                    GL_STATIC_DRAW);
+
+  GLuint quadVAO;
+  glCreateVertexArrays(1, &quadVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(quadVAO, 0);
+  glVertexArrayAttribFormat(quadVAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(quadVAO, 0, quadVBO, 0, 4 * sizeof(float));
+  glVertexArrayAttribBinding(quadVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(quadVAO, 1);
+  glVertexArrayAttribFormat(quadVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(quadVAO, 1, quadVBO, 2 * sizeof(float),
+                            4 * sizeof(float));
+  glVertexArrayAttribBinding(quadVAO, 1, 1);
+
+  // single sample framebuffer: rendered to directly without aa and with fxaa,
+  // resolve target with msaa. Linear filtering, fxaa samples between texels
+
+  gpu::texture::Texture2D sceneColorTex{WIDTH, HEIGHT, COLOR_FORMAT};
+  sceneColorTex.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+  sceneColorTex.setMinMagFilter(gpu::texture::Filter::LINEAR);
+
+  gpu::Renderbuffer sceneDepthRbo{WIDTH, HEIGHT, DEPTH_FORMAT};
+
+  gpu::framebuffer::Framebuffer sceneFramebuffer;
+  sceneFramebuffer.setColorAttachment(sceneColorTex, 0);
+  sceneFramebuffer.setDepthStencilAttachment(sceneDepthRbo);
+  sceneFramebuffer.checkStatus();
+
+  gpu::GpuTimer sceneTimer;
+  gpu::GpuTimer aaTimer;
+
+  stbi_set_flip_vertically_on_load(true);
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &marbleTex);
+
+  {
+    int texWidth;
+    int texHeight;
+    int texNrChannels;
+
+    std::string texPath = getTexturePath("awesomeface.png");
+
+    unsigned char *data =
+        stbi_load(texPath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
+
+    glTextureParameteri(marbleTex, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(marbleTex, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTextureParameteri(marbleTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(marbleTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(marbleTex, 1, GL_RGBA8, texWidth, texHeight);
+    glTextureSubImage2D(marbleTex, 0, 0, 0, texWidth, texHeight, GL_RGBA,
+                        GL_UNSIGNED_BYTE, data);
+
+    glGenerateTextureMipmap(marbleTex);
+
+    stbi_image_free(data);
+  }
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &metalTex);
+
+  {
+    int texWidth;
+    int texHeight;
+    int texNrChannels;
+
+    std::string texPath = getTexturePath("metal.png");
+
+    unsigned char *data =
+        stbi_load(texPath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
+
+    glTextureParameteri(metalTex, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(metalTex, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTextureParameteri(metalTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(metalTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(metalTex, 1, GL_RGB8, texWidth, texHeight);
+    glTextureSubImage2D(metalTex, 0, 0, 0, texWidth, texHeight, GL_RGB,
+                        GL_UNSIGNED_BYTE, data);
+
+    glGenerateTextureMipmap(metalTex);
+
+    stbi_image_free(data);
+  }
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  shader = gpu::Shader("scene.vs", "scene.fs");
+  screenShader = gpu::Shader("screen-quad.vs", "screen-quad.fs");
+  fxaaShader = gpu::Shader("screen-quad.vs", "fxaa.fs");
+
+  shader.use();
+  shader.setInt("texture0", 0);
+
+  screenShader.use();
+  screenShader.setInt("screenTexture", 0);
+
+  fxaaShader.use();
+  fxaaShader.setInt("screenTexture", 0);
+  fxaaShader.setVec2("inverseScreenSize", 1.0f / static_cast<float>(WIDTH),
+                     1.0f / static_cast<float>(HEIGHT));
+  fxaaShader.setFloat("edgeThreshold", 0.125f);
+  fxaaShader.setFloat("edgeThresholdMin", 0.0312f);
+  fxaaShader.setFloat("subpixelQuality", 0.75f);
+
+  glUseProgram(0);
+
+  while (app::nextFrame(window)) {
+    float timeSinceStart = static_cast<float>(app::getTime());
+    deltaTime = timeSinceStart - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]";
+
+      ss << " [" << aaModeNames[static_cast<int>(aaMode)] << ", "
+         << static_cast<double>(getRenderTargetBytes(aaMode)) /
+                (1024.0 * 1024.0)
+         << " MB targets, scene " << sceneTimer.getMilliseconds()
+         << " ms, aa " << aaTimer.getMilliseconds() << " ms]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = timeSinceStart;
+
+    // input
+    process_input(window);
+
+    if (aaModeDirty) {
+
+      if (aaMode == AAMode::MSAA) {
+        createMsaaTargets();
+      } else {
+        destroyMsaaTargets();
+      }
+
+      std::cout << aaModeNames[static_cast<int>(aaMode)] << ": "
+                << getRenderTargetBytes(aaMode) << " bytes of render targets"
+                << std::endl;
+
+      aaModeDirty = false;
+    }
+
+    // rendering
+
+    // first pass
+
+    sceneTimer.begin();
+
+    if (aaMode == AAMode::MSAA) {
+      msFramebuffer.bind();
+    } else {
+      sceneFramebuffer.bind();
+    }
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glEnable(GL_DEPTH_TEST);
+
+    drawScene();
+
+    sceneTimer.end();
+
+    // anti-aliasing and present. Timed together so every mode pays for the
+    // same fullscreen pass: a copy, resolve + copy, or the fxaa pass itself
+
+    aaTimer.begin();
+
+    if (aaMode == AAMode::MSAA) {
+      glBlitNamedFramebuffer(msFramebuffer.getID(), sceneFramebuffer.getID(), 0,
+                             0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT,
+                             GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    gpu::framebuffer::bindDefault();
+
+    glDisable(GL_DEPTH_TEST);
+
+    if (aaMode == AAMode::FXAA) {
+      fxaaShader.use();
+    } else {
+      screenShader.use();
+    }
+
+    glBindTextureUnit(0, sceneColorTex.getID());
+
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    aaTimer.end();
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  glDeleteVertexArrays(1, &cubeVAO);
+  glDeleteVertexArrays(1, &planeVAO);
+  glDeleteVertexArrays(1, &quadVAO);
+
+  glDeleteBuffers(1, &cubeVBO);
+  glDeleteBuffers(1, &planeVBO);
+  glDeleteBuffers(1, &quadVBO);
+
+  sceneFramebuffer.destroy();
+  sceneColorTex.destroy();
+  sceneDepthRbo.destroy();
+
+  destroyMsaaTargets();
+
+  sceneTimer.destroy();
+  aaTimer.destroy();
+
+  glDeleteTextures(1, &marbleTex);
+  glDeleteTextures(1, &metalTex);
+
+  glDeleteProgram(shader.getID());
+  glDeleteProgram(screenShader.getID());
+  glDeleteProgram(fxaaShader.getID());
+
+  app::terminate();
+  return 0;
+}
+
+void createMsaaTargets() {
+
+  if (msFramebuffer.getID() != 0) {
+    return;
+  }
+
+  msColorRbo = gpu::Renderbuffer{WIDTH, HEIGHT, COLOR_FORMAT, MSAA_SAMPLES};
+  msDepthRbo = gpu::Renderbuffer{WIDTH, HEIGHT, DEPTH_FORMAT, MSAA_SAMPLES};
+
+  msFramebuffer.setColorAttachment(msColorRbo, 0);
+  msFramebuffer.setDepthStencilAttachment(msDepthRbo);
+  msFramebuffer.checkStatus();
+}
+
+void destroyMsaaTargets() {
+
+  if (msFramebuffer.getID() == 0) {
+    return;
+  }
+
+  msFramebuffer.destroy();
+  msColorRbo.destroy();
+  msDepthRbo.destroy();
+}
+
+/**
+ * Render target memory a mode needs: the single sample color and depth, plus
+ * the multisampled color and depth with msaa (the single sample color is then
+ * the resolve target, its depth is not needed).
+ */
+size_t getRenderTargetBytes(AAMode mode) {
+
+  size_t nPixels = static_cast<size_t>(WIDTH) * static_cast<size_t>(HEIGHT);
+
+  size_t colorBytes = gpu::texture::bytesPerTexel(COLOR_FORMAT);
+  size_t depthBytes = gpu::texture::bytesPerTexel(DEPTH_FORMAT);
+
+  if (mode == AAMode::MSAA) {
+    return nPixels * (MSAA_SAMPLES * (colorBytes + depthBytes) + colorBytes);
+  }
+
+  return nPixels * (colorBytes + depthBytes);
+}
+
+void drawScene() {
+
+  const glm::mat4 &view = camera.getViewMatrix();
+  const glm::mat4 &projection = camera.getProjectionMatrix();
+
+  shader.use();
+  shader.setMat4("view", view);
+  shader.setMat4("projection", projection);
+
+  // cubes, rotated so most of their edges are diagonal on screen
+  {
+    static glm::vec3 cubePositions[] = {
+        glm::vec3{-1.0f, 0.0f, -1.0f}, glm::vec3{2.0f, 0.0f, 0.0f},
+        glm::vec3{0.5f, 0.0f, 1.0f}, glm::vec3{-2.5f, 0.0f, 1.5f},
+        glm::vec3{1.5f, 0.0f, -3.0f}};
+
+    glBindVertexArray(cubeVAO);
+    glBindTextureUnit(0, marbleTex);
+
+    for (int i = 0; i < 5; ++i) {
+
+      glm::mat4 model = glm::mat4{1.0f};
+      model = glm::translate(model, cubePositions[i]);
+      model = glm::rotate(model, glm::radians(17.0f * static_cast<float>(i)),
+                          glm::vec3{0.0f, 1.0f, 0.0f});
+      shader.setMat4("model", model);
+
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+  }
+
+  // floor
+  {
+    glBindVertexArray(planeVAO);
+    glBindTextureUnit(0, metalTex);
+
+    glm::mat4 model = glm::mat4{1.0f};
+    shader.setMat4("model", model);
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+  }
+}
+
+void process_input(GLFWwindow *window) {
+
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  for (int i = 0; i < static_cast<int>(AAMode::COUNT); ++i) {
+    if (glfwGetKey(window, GLFW_KEY_F1 + i) == GLFW_PRESS &&
+        aaMode != static_cast<AAMode>(i)) {
+      aaMode = static_cast<AAMode>(i);
+      aaModeDirty = true;
+    }
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
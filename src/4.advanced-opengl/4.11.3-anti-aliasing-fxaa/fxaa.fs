@@ -0,0 +1,190 @@
+#version 450 core
+
+// morphological anti-aliasing on the resolved single sample image, after
+// FXAA 3.11 (quality preset): luma edge detection, a search along the edge
+// for its end points and a subpixel blend for thin features.
+
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D screenTexture;
+
+uniform vec2 inverseScreenSize;
+
+// local contrast needed to process a pixel, relative to the max luma and
+// absolute (dark areas)
+uniform float edgeThreshold;
+uniform float edgeThresholdMin;
+
+// 0 turns the subpixel blend off, 1 is the softest
+uniform float subpixelQuality;
+
+const int MAX_SEARCH_STEPS = 12;
+const float SEARCH_STEPS[MAX_SEARCH_STEPS] =
+    float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+// the input is not srgb, its values are already perceptual
+float luma(vec3 rgb) { return dot(rgb, vec3(0.299, 0.587, 0.114)); }
+
+float lumaAt(vec2 uv) { return luma(textureLod(screenTexture, uv, 0.0).rgb); }
+
+void main() {
+
+  vec3 colorCenter = textureLod(screenTexture, TexCoords, 0.0).rgb;
+
+  float lumaCenter = luma(colorCenter);
+  float lumaDown =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(0, -1)).rgb);
+  float lumaUp =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(0, 1)).rgb);
+  float lumaLeft =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(-1, 0)).rgb);
+  float lumaRight =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(1, 0)).rgb);
+
+  float lumaMin =
+      min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+  float lumaMax =
+      max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+
+  float lumaRange = lumaMax - lumaMin;
+
+  // early out, most pixels are not on an edge
+  if (lumaRange < max(edgeThresholdMin, lumaMax * edgeThreshold)) {
+    FragColor = vec4(colorCenter, 1.0);
+    return;
+  }
+
+  float lumaDownLeft =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(-1, -1)).rgb);
+  float lumaUpRight =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(1, 1)).rgb);
+  float lumaUpLeft =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(-1, 1)).rgb);
+  float lumaDownRight =
+      luma(textureLodOffset(screenTexture, TexCoords, 0.0, ivec2(1, -1)).rgb);
+
+  float lumaDownUp = lumaDown + lumaUp;
+  float lumaLeftRight = lumaLeft + lumaRight;
+
+  float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+  float lumaDownCorners = lumaDownLeft + lumaDownRight;
+  float lumaRightCorners = lumaDownRight + lumaUpRight;
+  float lumaUpCorners = lumaUpRight + lumaUpLeft;
+
+  // edge orientation from the second derivatives
+  float edgeHorizontal = abs(-2.0 * lumaLeft + lumaLeftCorners) +
+                         abs(-2.0 * lumaCenter + lumaDownUp) * 2.0 +
+                         abs(-2.0 * lumaRight + lumaRightCorners);
+  float edgeVertical = abs(-2.0 * lumaUp + lumaUpCorners) +
+                       abs(-2.0 * lumaCenter + lumaLeftRight) * 2.0 +
+                       abs(-2.0 * lumaDown + lumaDownCorners);
+
+  bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+  // which side of the pixel the edge is on
+  float luma1 = isHorizontal ? lumaDown : lumaLeft;
+  float luma2 = isHorizontal ? lumaUp : lumaRight;
+
+  float gradient1 = luma1 - lumaCenter;
+  float gradient2 = luma2 - lumaCenter;
+
+  bool is1Steepest = abs(gradient1) >= abs(gradient2);
+
+  float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+
+  float stepLength = isHorizontal ? inverseScreenSize.y : inverseScreenSize.x;
+
+  float lumaLocalAverage;
+
+  if (is1Steepest) {
+    stepLength = -stepLength;
+    lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+  } else {
+    lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+  }
+
+  // walk along the edge, half a pixel towards it, in both directions until
+  // the luma differs enough from the local average
+  vec2 edgeUv = TexCoords;
+
+  if (isHorizontal) {
+    edgeUv.y += stepLength * 0.5;
+  } else {
+    edgeUv.x += stepLength * 0.5;
+  }
+
+  vec2 offset = isHorizontal ? vec2(inverseScreenSize.x, 0.0)
+                             : vec2(0.0, inverseScreenSize.y);
+
+  vec2 uv1 = edgeUv - offset;
+  vec2 uv2 = edgeUv + offset;
+
+  float lumaEnd1 = 0.0;
+  float lumaEnd2 = 0.0;
+
+  bool reached1 = false;
+  bool reached2 = false;
+
+  for (int i = 0; i < MAX_SEARCH_STEPS; ++i) {
+
+    if (!reached1) {
+      lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+    }
+    if (!reached2) {
+      lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+    }
+
+    reached1 = abs(lumaEnd1) >= gradientScaled;
+    reached2 = abs(lumaEnd2) >= gradientScaled;
+
+    if (reached1 && reached2) {
+      break;
+    }
+
+    if (!reached1) {
+      uv1 -= offset * SEARCH_STEPS[i];
+    }
+    if (!reached2) {
+      uv2 += offset * SEARCH_STEPS[i];
+    }
+  }
+
+  float distance1 =
+      isHorizontal ? (TexCoords.x - uv1.x) : (TexCoords.y - uv1.y);
+  float distance2 =
+      isHorizontal ? (uv2.x - TexCoords.x) : (uv2.y - TexCoords.y);
+
+  bool isDirection1 = distance1 < distance2;
+  float distanceFinal = min(distance1, distance2);
+
+  float edgeLength = distance1 + distance2;
+
+  // only blend if the closest end point goes the same way as the center
+  bool isLumaCenterSmaller = lumaCenter < lumaLocalAverage;
+  bool correctVariation =
+      ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0) != isLumaCenterSmaller;
+
+  float pixelOffset = -distanceFinal / edgeLength + 0.5;
+  float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+  // subpixel blend, for features thinner than a pixel
+  float lumaAverage = (1.0 / 12.0) * (2.0 * (lumaDownUp + lumaLeftRight) +
+                                      lumaLeftCorners + lumaRightCorners);
+
+  float subpixel1 = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+  float subpixel2 = (-2.0 * subpixel1 + 3.0) * subpixel1 * subpixel1;
+  float subpixelOffset = subpixel2 * subpixel2 * subpixelQuality;
+
+  finalOffset = max(finalOffset, subpixelOffset);
+
+  vec2 finalUv = TexCoords;
+
+  if (isHorizontal) {
+    finalUv.y += finalOffset * stepLength;
+  } else {
+    finalUv.x += finalOffset * stepLength;
+  }
+
+  FragColor = vec4(textureLod(screenTexture, finalUv, 0.0).rgb, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#version 450 core
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D texture0;
+
+void main() { FragColor = texture(texture0, TexCoords); }
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 450 core
+
+uniform sampler2D screenTexture;
+
+in vec2 TexCoords;
+out vec4 FragColor;
+
+void main() { FragColor = texture(screenTexture, TexCoords); }
\ No newline at end of file
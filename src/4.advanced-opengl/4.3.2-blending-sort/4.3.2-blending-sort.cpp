@@ -1,7 +1,9 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "model.h"
 #include "pointlight.h"
+#include "radixsort.h"
 #include "shader.h"
 
 #include <glm/glm.hpp>
@@ -50,7 +52,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -62,7 +64,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -336,9 +338,11 @@ gpu::Shader shader("blending.vs", "blending.fs");
 
   glUseProgram(0);
 
-  while (!glfwWindowShouldClose(window)) {
+  sorting::RadixSorter sorter;
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+  while (app::nextFrame(window)) {
+
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -415,18 +419,12 @@ gpu::Shader shader("blending.vs", "blending.fs");
     // window
     {
 
-      glm::vec3 cameraPos = camera.getPosition();
-
-      std::sort(windows.begin(), windows.end(),
-                [cameraPos](glm::vec3 a, glm::vec3 b) {
-                  a -= cameraPos;
-                  b -= cameraPos;
-
-                  float d1 = glm::dot(a, a);
-                  float d2 = glm::dot(b, b);
+      // distances are computed once per window, not once per comparison
+      sorter.sortByDistance(windows.data(), windows.size(),
+                            camera.getPosition(),
+                            sorting::SortOrder::BACK_TO_FRONT, true);
 
-                  return d1 > d2;
-                });
+      const std::vector<uint32_t> &order = sorter.getOrder();
 
       glBindVertexArray(windowVAO);
       glBindTextureUnit(0, windowTex);
@@ -438,7 +436,7 @@ gpu::Shader shader("blending.vs", "blending.fs");
       for (unsigned int i = 0; i < windows.size(); ++i) {
 
         glm::mat4 model = glm::mat4{1.0f};
-        model = glm::translate(model, windows[i]);
+        model = glm::translate(model, windows[order[i]]);
 
         shader.setMat4("model", model);
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -464,7 +462,7 @@ gpu::Shader shader("blending.vs", "blending.fs");
 
   glDeleteProgram(shader.getID());
 
-  glfwTerminate();
+  app::terminate();
   return 0;
 }
 
@@ -0,0 +1,756 @@
+
+#include "app.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "model.h"
+#include "pointlight.h"
+#include "radixsort.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "vertexarray.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+float cameraSpeed = 3.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+float lastMouseX = 400.0f;
+float lastMouseY = 300.0f;
+
+constexpr int WIDTH = 1360;
+constexpr int HEIGHT = 768;
+
+// extra windows scattered behind the original five
+constexpr int N_EXTRA_WINDOWS = 2000;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+// O switches between weighted blended oit and sorting back to front
+bool oit = true;
+bool oitKeyPressed = false;
+
+FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
+                 100.0f};
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // clang-format off
+
+
+  float cubeVertices[] = {
+      // positions         // texture Coords
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 
+       0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 
+       0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+      -0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+      -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 
+      -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 
+       0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+      -0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 
+       0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+      -0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 
+      -0.5f,  0.5f, -0.5f, 0.0f, 1.0f
+  };
+
+  float planeVertices[] = {
+      // positions         // texture Coords
+       5.0f, -0.5f,  5.0f, 2.0f, 0.0f,  
+      -5.0f, -0.5f,  5.0f, 0.0f, 0.0f,  
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,
+
+       5.0f, -0.5f,  5.0f, 2.0f, 0.0f, 
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f, 
+       5.0f, -0.5f, -5.0f, 2.0f, 2.0f
+  };
+
+  float windowVertices[] = {
+      // positions         // texture Coords
+       0.0f,  0.5f,  0.0f, 0.0f, 1.0f,
+       0.0f, -0.5f,  0.0f, 0.0f, 0.0f,
+       1.0f, -0.5f,  0.0f, 1.0f, 0.0f,
+
+       0.0f,  0.5f,  0.0f, 0.0f, 1.0f,
+       1.0f, -0.5f,  0.0f, 1.0f, 0.0f,
+       1.0f,  0.5f,  0.0f, 1.0f, 1.0f
+  };
+
+  glm::vec3 cubePositions[] = {
+    glm::vec3(-1.0f, 0.0f, -1.0f),
+    glm::vec3(2.0f, 0.0f, 0.0f)
+  };
+
+  std::vector<glm::vec3> windows;
+  windows.push_back(glm::vec3{-1.5f, 0.0f, -0.48f});
+  windows.push_back(glm::vec3{ 1.5f, 0.0f,  0.51f});
+  windows.push_back(glm::vec3{ 0.0f, 0.0f,  0.7f});
+  windows.push_back(glm::vec3{-0.3f, 0.0f, -2.3f});
+  windows.push_back(glm::vec3{ 0.5f, 0.0f, -0.6f});
+
+  // clang-format on
+
+  srand(static_cast<int>(100.0 * app::getTime()));
+
+  for (int i = 0; i < N_EXTRA_WINDOWS; ++i) {
+
+    float x = (rand() % 4000) / 100.0f - 20.0f;
+    float y = (rand() % 1000) / 100.0f;
+    float z = -(rand() % 3000) / 100.0f - 4.0f;
+
+    windows.push_back(glm::vec3{x, y, z});
+  }
+
+  // cubes
+
+  GLuint cubeVBO;
+  glCreateBuffers(1, &cubeVBO);
+  glNamedBufferData(cubeVBO, sizeof(cubeVertices), cubeVertices,
+                    GL_STATIC_DRAW);
+
+  GLuint cubeVAO;
+  glCreateVertexArrays(1, &cubeVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(cubeVAO, 0);
+  glVertexArrayAttribFormat(cubeVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(cubeVAO, 0, cubeVBO, 0, 5 * sizeof(float));
+  glVertexArrayAttribBinding(cubeVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(cubeVAO, 1);
+  glVertexArrayAttribFormat(cubeVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(cubeVAO, 1, cubeVBO, 3 * sizeof(float),
+                            5 * sizeof(float));
+  glVertexArrayAttribBinding(cubeVAO, 1, 1);
+
+  // window
+
+  GLuint windowVBO;
+  glCreateBuffers(1, &windowVBO);
+  glNamedBufferData(windowVBO, sizeof(windowVertices), windowVertices,
+                    GL_STATIC_DRAW);
+
+  GLuint windowVAO;
+  glCreateVertexArrays(1, &windowVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(windowVAO, 0);
+  glVertexArrayAttribFormat(windowVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(windowVAO, 0, windowVBO, 0, 5 * sizeof(float));
+  glVertexArrayAttribBinding(windowVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(windowVAO, 1);
+  glVertexArrayAttribFormat(windowVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(windowVAO, 1, windowVBO, 3 * sizeof(float),
+                            5 * sizeof(float));
+  glVertexArrayAttribBinding(windowVAO, 1, 1);
+
+  // per-instance offsets, all the windows go in a single draw call
+  GLuint windowInstanceVBO;
+  glCreateBuffers(1, &windowInstanceVBO);
+  glNamedBufferData(windowInstanceVBO, windows.size() * sizeof(glm::vec3),
+                    windows.data(), GL_DYNAMIC_DRAW);
+
+  glEnableVertexArrayAttrib(windowVAO, 2);
+  glVertexArrayAttribFormat(windowVAO, 2, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(windowVAO, 2, windowInstanceVBO, 0,
+                            sizeof(glm::vec3));
+  glVertexArrayAttribBinding(windowVAO, 2, 2);
+  glVertexArrayBindingDivisor(windowVAO, 2, 1);
+
+  // plane
+
+  GLuint planeVBO;
+  glCreateBuffers(1, &planeVBO);
+  glNamedBufferData(planeVBO, sizeof(planeVertices), planeVertices,
+                    GL_STATIC_DRAW);
+
+  GLuint planeVAO;
+  glCreateVertexArrays(1, &planeVAO);
+
+  // positions
+  glEnableVertexArrayAttrib(planeVAO, 0);
+  glVertexArrayAttribFormat(planeVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(planeVAO, 0, planeVBO, 0, 5 * sizeof(float));
+  glVertexArrayAttribBinding(planeVAO, 0, 0);
+
+  // texcoords
+  glEnableVertexArrayAttrib(planeVAO, 1);
+  glVertexArrayAttribFormat(planeVAO, 1, 2, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayVertexBuffer(planeVAO, 1, planeVBO, 3 * sizeof(float),
+                            5 * sizeof(float));
+  glVertexArrayAttribBinding(planeVAO, 1, 1);
+
+  glBindVertexArray(0);
+
+  stbi_set_flip_vertically_on_load(true);
+
+  GLuint windowTex;
+  glCreateTextures(GL_TEXTURE_2D, 1, &windowTex);
+  {
+    int texWidth;
+    int texHeight;
+    int texNrChannels;
+
+    std::string texPath = getTexturePath("blending_transparent_window.png");
+
+    unsigned char *data =
+        stbi_load(texPath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
+
+    // clamp_to_edge to avoid artifacts when transparent
+    glTextureParameteri(windowTex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(windowTex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTextureParameteri(windowTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(windowTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(windowTex, 1, GL_RGBA8, texWidth, texHeight);
+    glTextureSubImage2D(windowTex, 0, 0, 0, texWidth, texHeight, GL_RGBA,
+                        GL_UNSIGNED_BYTE, data);
+
+    glGenerateTextureMipmap(windowTex);
+
+    stbi_image_free(data);
+  }
+
+  GLuint marbleTex;
+  glCreateTextures(GL_TEXTURE_2D, 1, &marbleTex);
+  {
+    int texWidth;
+    int texHeight;
+    int texNrChannels;
+
+    std::string texPath = getTexturePath("marble.jpg");
+
+    unsigned char *data =
+        stbi_load(texPath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
+
+    glTextureParameteri(marbleTex, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(marbleTex, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTextureParameteri(marbleTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(marbleTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(marbleTex, 1, GL_RGB8, texWidth, texHeight);
+    glTextureSubImage2D(marbleTex, 0, 0, 0, texWidth, texHeight, GL_RGB,
+                        GL_UNSIGNED_BYTE, data);
+
+    glGenerateTextureMipmap(marbleTex);
+
+    stbi_image_free(data);
+  }
+
+  GLuint metalTex;
+  glCreateTextures(GL_TEXTURE_2D, 1, &metalTex);
+  {
+    int texWidth;
+    int texHeight;
+    int texNrChannels;
+
+    std::string texPath = getTexturePath("metal.png");
+
+    unsigned char *data =
+        stbi_load(texPath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
+
+    glTextureParameteri(metalTex, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(metalTex, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTextureParameteri(metalTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(metalTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(metalTex, 1, GL_RGB8, texWidth, texHeight);
+    glTextureSubImage2D(metalTex, 0, 0, 0, texWidth, texHeight, GL_RGB,
+                        GL_UNSIGNED_BYTE, data);
+
+    glGenerateTextureMipmap(metalTex);
+
+    stbi_image_free(data);
+  }
+
+  // offscreen targets. The opaque pass renders to sceneFramebuffer, the
+  // transparent pass shares its depth texture so the windows are still
+  // occluded by the cubes
+
+  gpu::texture::Texture2D sceneColorTex{WIDTH, HEIGHT, GL_RGBA8};
+  gpu::texture::Texture2D sceneDepthTex{WIDTH, HEIGHT, GL_DEPTH_COMPONENT24};
+
+  gpu::framebuffer::Framebuffer sceneFramebuffer;
+  sceneFramebuffer.setColorAttachment(sceneColorTex, 0);
+  sceneFramebuffer.setDepthAttachment(sceneDepthTex);
+  sceneFramebuffer.checkStatus();
+
+  // weighted blended oit (McGuire and Bavoil 2013):
+  // accumulation = sum(premultiplied color * w), sum(alpha * w)
+  // revealage = product(1 - alpha)
+  gpu::texture::Texture2D accumTex{WIDTH, HEIGHT, GL_RGBA16F};
+  gpu::texture::Texture2D revealageTex{WIDTH, HEIGHT, GL_R8};
+
+  gpu::framebuffer::Framebuffer oitFramebuffer;
+  oitFramebuffer.setColorAttachment(accumTex, 0);
+  oitFramebuffer.setColorAttachment(revealageTex, 1);
+  oitFramebuffer.setDrawBuffers(2);
+  oitFramebuffer.setDepthAttachment(sceneDepthTex);
+  oitFramebuffer.checkStatus();
+
+  gpu::VertexArray emptyVAO;
+
+  glEnable(GL_DEPTH_TEST);
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  gpu::Shader shader("blending.vs", "blending.fs");
+
+  shader.use();
+  shader.setInt("texture0", 0);
+
+  gpu::Shader windowShader("blending-instanced.vs", "blending.fs");
+  windowShader.setInt("texture0", 0);
+
+  gpu::Shader oitAccumShader("blending-instanced.vs", "oit-accum.fs");
+  oitAccumShader.setInt("texture0", 0);
+
+  gpu::Shader oitCompositeShader("oit-composite.vs", "oit-composite.fs");
+  oitCompositeShader.setInt("opaqueTexture", 0);
+  oitCompositeShader.setInt("accumTexture", 1);
+  oitCompositeShader.setInt("revealageTexture", 2);
+
+  glUseProgram(0);
+
+  // sorted path
+  sorting::RadixSorter sorter;
+  std::vector<glm::vec3> sortedWindows = windows;
+
+  while (app::nextFrame(window)) {
+
+    float timeSinceStart = static_cast<float>(app::getTime());
+    deltaTime = timeSinceStart - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]"
+         << " [" << windows.size() << " windows, "
+         << (oit ? "weighted blended oit" : "sorted") << "]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = timeSinceStart;
+
+    // input
+    process_input(window);
+
+    // rendering
+    sceneFramebuffer.bind();
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const glm::mat4 &view = camera.getViewMatrix();
+    const glm::mat4 &projection = camera.getProjectionMatrix();
+
+    // floor
+    {
+      shader.use();
+      shader.setMat4("view", view);
+      shader.setMat4("projection", projection);
+
+      glBindVertexArray(planeVAO);
+      glBindTextureUnit(0, metalTex);
+
+      glm::mat4 model = glm::mat4{1.0f};
+      shader.setMat4("model", model);
+
+      glDrawArrays(GL_TRIANGLES, 0, 6);
+
+      glUseProgram(0);
+      glBindVertexArray(0);
+    }
+
+    // cubes
+    {
+
+      glBindTextureUnit(0, marbleTex);
+
+      shader.use();
+      shader.setMat4("view", view);
+      shader.setMat4("projection", projection);
+
+      glBindVertexArray(cubeVAO);
+
+      for (int i = 0; i < 2; ++i) {
+
+        glm::mat4 model = glm::mat4{1.0f};
+        model = glm::translate(model, cubePositions[i]);
+
+        shader.setMat4("model", model);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+      }
+
+      glUseProgram(0);
+      glBindVertexArray(0);
+    }
+
+    // windows
+    if (oit) {
+
+      // any order, one instanced draw. Depth is tested against the opaque
+      // geometry but not written
+      oitFramebuffer.bind();
+      oitFramebuffer.clearColorAttachment(0, 0.0f, 0.0f, 0.0f, 0.0f);
+      oitFramebuffer.clearColorAttachment(1, 1.0f, 1.0f, 1.0f, 1.0f);
+
+      glDepthMask(GL_FALSE);
+
+      glEnable(GL_BLEND);
+      glBlendFunci(0, GL_ONE, GL_ONE);
+      glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+      glBindVertexArray(windowVAO);
+      glBindTextureUnit(0, windowTex);
+
+      oitAccumShader.use();
+      oitAccumShader.setMat4("view", view);
+      oitAccumShader.setMat4("projection", projection);
+
+      glDrawArraysInstanced(GL_TRIANGLES, 0, 6, windows.size());
+
+      glUseProgram(0);
+      glBindVertexArray(0);
+
+      glDisable(GL_BLEND);
+      glDepthMask(GL_TRUE);
+
+    } else {
+
+      sorter.sortByDistance(windows.data(), windows.size(),
+                            camera.getPosition(),
+                            sorting::SortOrder::BACK_TO_FRONT, true);
+
+      const std::vector<uint32_t> &order = sorter.getOrder();
+
+      for (size_t i = 0; i < order.size(); ++i) {
+        sortedWindows[i] = windows[order[i]];
+      }
+
+      // instances are drawn in order, back to front
+      glNamedBufferSubData(windowInstanceVBO, 0,
+                           sortedWindows.size() * sizeof(glm::vec3),
+                           sortedWindows.data());
+
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+      glBindVertexArray(windowVAO);
+      glBindTextureUnit(0, windowTex);
+
+      windowShader.use();
+      windowShader.setMat4("view", view);
+      windowShader.setMat4("projection", projection);
+
+      glDrawArraysInstanced(GL_TRIANGLES, 0, 6, windows.size());
+
+      glUseProgram(0);
+      glBindVertexArray(0);
+
+      glDisable(GL_BLEND);
+    }
+
+    // composite (the sorted path has nothing to resolve, the accumulation
+    // target is cleared so the opaque image goes through untouched)
+    {
+      if (!oit) {
+        oitFramebuffer.clearColorAttachment(0, 0.0f, 0.0f, 0.0f, 0.0f);
+        oitFramebuffer.clearColorAttachment(1, 1.0f, 1.0f, 1.0f, 1.0f);
+      }
+
+      gpu::framebuffer::bindDefault();
+
+      glDisable(GL_DEPTH_TEST);
+
+      glBindTextureUnit(0, sceneColorTex.getID());
+      glBindTextureUnit(1, accumTex.getID());
+      glBindTextureUnit(2, revealageTex.getID());
+
+      oitCompositeShader.use();
+      emptyVAO.bind();
+
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+
+      glUseProgram(0);
+      glBindVertexArray(0);
+
+      glEnable(GL_DEPTH_TEST);
+    }
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  glDeleteVertexArrays(1, &cubeVAO);
+  glDeleteVertexArrays(1, &windowVAO);
+  glDeleteVertexArrays(1, &planeVAO);
+
+  glDeleteBuffers(1, &cubeVBO);
+  glDeleteBuffers(1, &windowVBO);
+  glDeleteBuffers(1, &windowInstanceVBO);
+  glDeleteBuffers(1, &planeVBO);
+
+  glDeleteTextures(1, &windowTex);
+  glDeleteTextures(1, &marbleTex);
+  glDeleteTextures(1, &metalTex);
+
+  sceneFramebuffer.destroy();
+  oitFramebuffer.destroy();
+
+  sceneColorTex.destroy();
+  sceneDepthTex.destroy();
+  accumTex.destroy();
+  revealageTex.destroy();
+
+  emptyVAO.destroy();
+
+  shader.destroy();
+  windowShader.destroy();
+  oitAccumShader.destroy();
+  oitCompositeShader.destroy();
+
+  app::terminate();
+  return 0;
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
+    if (!oitKeyPressed) {
+      oit = !oit;
+      oitKeyPressed = true;
+    }
+  } else {
+    oitKeyPressed = false;
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
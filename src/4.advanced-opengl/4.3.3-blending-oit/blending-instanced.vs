@@ -0,0 +1,15 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec2 aTexCoords;
+layout(location = 2) in vec3 aOffset;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec2 TexCoords;
+
+void main() {
+  gl_Position = projection * view * vec4(aPos + aOffset, 1.0);
+  TexCoords = aTexCoords;
+}
\ No newline at end of file
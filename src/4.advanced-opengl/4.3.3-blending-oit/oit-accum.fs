@@ -0,0 +1,26 @@
+#version 450 core
+
+in vec2 TexCoords;
+
+layout(location = 0) out vec4 accum;
+layout(location = 1) out float revealage;
+
+uniform sampler2D texture0;
+
+void main() {
+
+  vec4 color = texture(texture0, TexCoords);
+
+  // depth weight (eq. 10 of the paper), closer surfaces count more. The
+  // clamp keeps the 16f accumulation target in range
+  float weight =
+      clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 *
+                pow(1.0 - gl_FragCoord.z * 0.9, 3.0),
+            1e-2, 3e3);
+
+  // blended with ONE, ONE
+  accum = vec4(color.rgb * color.a, color.a) * weight;
+
+  // blended with ZERO, ONE_MINUS_SRC_COLOR
+  revealage = color.a;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 450 core
+
+out vec4 FragColor;
+
+uniform sampler2D opaqueTexture;
+uniform sampler2D accumTexture;
+uniform sampler2D revealageTexture;
+
+void main() {
+
+  ivec2 texel = ivec2(gl_FragCoord.xy);
+
+  vec3 opaque = texelFetch(opaqueTexture, texel, 0).rgb;
+
+  vec4 accum = texelFetch(accumTexture, texel, 0);
+  float revealage = texelFetch(revealageTexture, texel, 0).r;
+
+  // weighted average of the transparent colors, over the opaque image
+  vec3 average = accum.rgb / max(accum.a, 1e-5);
+
+  FragColor = vec4(mix(average, opaque, revealage), 1.0);
+}
\ No newline at end of file
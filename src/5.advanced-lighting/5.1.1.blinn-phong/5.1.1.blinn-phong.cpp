@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "pointlight.h"
 #include "shader.h"
@@ -52,7 +53,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -65,7 +66,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -292,9 +293,9 @@ int main() {
 
   glBindTextureUnit(0, woodTex);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -414,7 +415,7 @@ int main() {
   glDeleteProgram(lightingShader.getID());
   glDeleteTextures(1, &woodTex);
 
-  glfwTerminate();
+  app::terminate();
 
   return 0;
 }
@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "flycamera.h"
 #include "pointlight.h"
 #include "shader.h"
@@ -71,7 +72,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -83,7 +84,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -349,8 +350,8 @@ int main() {
   // no point lights for now
   lightingShader.setInt("nPointLights", 0);
 
-  while (!glfwWindowShouldClose(window)) {
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+  while (app::nextFrame(window)) {
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -478,7 +479,7 @@ int main() {
 
   glDeleteProgram(lightingShader.getID());
 
-  glfwTerminate();
+  app::terminate();
 
   return 0;
 }
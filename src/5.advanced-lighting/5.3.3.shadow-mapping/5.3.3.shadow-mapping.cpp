@@ -1,4 +1,6 @@
 
+#include "app.h"
+#include "commandbuffer.h"
 #include "flycamera.h"
 #include "model.h"
 #include "shader.h"
@@ -13,6 +15,7 @@
 
 #include <GLFW/glfw3.h>
 
+#include <cstdlib>
 #include <iostream>
 
 float cameraSpeed = 3.0f;
@@ -58,7 +61,7 @@ GLuint whiteTex10;
 FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
                  100.0f};
 
-void drawScene(const gpu::Shader &shader);
+void drawScene(gpu::CommandBuffer &commands, const gpu::Shader &shader);
 void fillLightInfo(const gpu::Shader &shader);
 
 void process_input(GLFWwindow *window);
@@ -75,7 +78,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -87,7 +90,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -396,9 +399,36 @@ gpu::Shader debugScreenShader("debug-quad-depth.vs", "debug-quad-depth.fs");
 
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
-  while (!glfwWindowShouldClose(window)) {
+  // first pass
+  // calculate depth from the light's perspective. The light and the scene
+  // are static: the pass is recorded once and re-executed every frame
+  gpu::CommandBuffer shadowCommands;
+  {
+    // a directional light doesn't really have a position, but we need one for
+    // the algorithm so we'll pick a point and a ray that crosses the origin
+
+    shadowCommands.bindFramebuffer(depthMapFBO);
+
+    shadowCommands.setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+
+    shadowCommands.clear(ClearFlagBits::DEPTH_BIT);
+
+    drawScene(shadowCommands, shadowMappingDepthShader);
+  }
+
+  int dirLightDirectionLocation =
+      lightingShader.getUniformLocation("dirLight.direction");
 
-    float timeSinceStart = static_cast<float>(glfwGetTime());
+  // recorded every frame (the camera moves)
+  gpu::CommandBuffer frameCommands;
+
+  // LEARNOPENGL_CAPTURE=<file>: the commands of the first frame are saved
+  // for the command-replay benchmark
+  const char *capturePath = std::getenv("LEARNOPENGL_CAPTURE");
+
+  while (app::nextFrame(window)) {
+
+    float timeSinceStart = static_cast<float>(app::getTime());
     deltaTime = timeSinceStart - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -423,38 +453,26 @@ gpu::Shader debugScreenShader("debug-quad-depth.vs", "debug-quad-depth.fs");
     // input
     process_input(window);
 
-    // first pass
-    // calculate depth from the light's perspective
-    {
-      // a directional light doesn't really have a position, but we need one for
-      // the algorithm so we'll pick a point and a ray that crosses the origin
-
-      glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-
-      glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-
-      glClear(GL_DEPTH_BUFFER_BIT);
-
-      drawScene(shadowMappingDepthShader);
-    }
-
     // second pass
     // draw scene normally (with shadow info from the previous pass)
+    frameCommands.reset();
     {
-      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      frameCommands.bindDefaultFramebuffer();
 
-      glViewport(0, 0, WIDTH, HEIGHT);
-      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      frameCommands.setViewport(0, 0, WIDTH, HEIGHT);
+      frameCommands.clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
 
       const glm::mat4 &view = camera.getViewMatrix();
       const glm::mat4 &projection = camera.getProjectionMatrix();
 
       // uniform buffers
       {
-        glNamedBufferSubData(camUbo, 0, sizeof(glm::mat4),
-                             glm::value_ptr(view));
-        glNamedBufferSubData(camUbo, sizeof(glm::mat4), sizeof(glm::mat4),
-                             glm::value_ptr(projection));
+        frameCommands.bindBufferBase(GL_UNIFORM_BUFFER, 0, camUbo);
+        frameCommands.updateBuffer(camUbo, 0, glm::value_ptr(view),
+                                   sizeof(glm::mat4));
+        frameCommands.updateBuffer(camUbo, sizeof(glm::mat4),
+                                   glm::value_ptr(projection),
+                                   sizeof(glm::mat4));
       }
 
       // dir light
@@ -464,12 +482,30 @@ gpu::Shader debugScreenShader("debug-quad-depth.vs", "debug-quad-depth.fs");
         glm::vec3 lightDirCameraSpace =
             glm::vec3{glm::transpose(invView) * glm::vec4{lightDir, 0.0}};
 
-        lightingShader.setVec3("dirLight.direction", lightDirCameraSpace);
+        frameCommands.setVec3(lightingShader, dirLightDirectionLocation,
+                              lightDirCameraSpace);
       }
 
-      glBindTextureUnit(2, depthTexture);
+      frameCommands.bindTexture(2, depthTexture);
 
-      drawScene(lightingShader);
+      drawScene(frameCommands, lightingShader);
+    }
+
+    shadowCommands.execute();
+    frameCommands.execute();
+
+    if (capturePath != nullptr) {
+
+      gpu::CommandBuffer capture;
+      capture.append(shadowCommands);
+      capture.append(frameCommands);
+
+      if (capture.save(capturePath)) {
+        std::cout << "Saved " << capture.getNumCommands() << " commands to "
+                  << capturePath << std::endl;
+      }
+
+      capturePath = nullptr;
     }
 
     glBindVertexArray(0);
@@ -498,53 +534,55 @@ gpu::Shader debugScreenShader("debug-quad-depth.vs", "debug-quad-depth.fs");
   glDeleteTextures(1, &whiteTex03);
   glDeleteTextures(1, &whiteTex10);
 
-  glfwTerminate();
+  app::terminate();
 
   return 0;
 }
 
 void fillLightInfo(const gpu::Shader &shader) {}
 
-void drawScene(const gpu::Shader &shader) {
+void drawScene(gpu::CommandBuffer &commands, const gpu::Shader &shader) {
 
-  shader.use();
+  int modelLocation = shader.getUniformLocation("model");
+
+  commands.useProgram(shader);
 
   // floor
   {
-    glBindTextureUnit(0, woodTex.getID());
-    glBindTextureUnit(1, whiteTex03);
+    commands.bindTexture(0, woodTex);
+    commands.bindTexture(1, whiteTex03);
 
-    glBindVertexArray(quadVAO);
+    commands.bindVertexArray(quadVAO);
 
     glm::mat4 model{1.0f};
     model = glm::translate(model, glm::vec3{0.0f, -0.5f, 0.0f});
 
-    shader.setMat4("model", model);
+    commands.setMat4(shader, modelLocation, model);
 
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    commands.drawArrays(GL_TRIANGLES, 0, 6);
   }
 
   // cubes
   {
-    glBindTextureUnit(0, containerDiffTex.getID());
-    glBindTextureUnit(1, containerSpecTex.getID());
+    commands.bindTexture(0, containerDiffTex);
+    commands.bindTexture(1, containerSpecTex);
 
-    glBindVertexArray(cubeVAO);
+    commands.bindVertexArray(cubeVAO);
 
     // 1
     glm::mat4 model{1.0f};
     model = glm::translate(model, glm::vec3{0.0f, 1.5f, 0.0});
     model = glm::scale(model, glm::vec3{0.5f});
-    shader.setMat4("model", model);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    commands.setMat4(shader, modelLocation, model);
+    commands.drawArrays(GL_TRIANGLES, 0, 36);
 
     // 2
     model = glm::mat4{1.0f};
     model = glm::translate(model, glm::vec3{2.0f, -0.25f, 1.0});
     model = glm::scale(model, glm::vec3{0.5f});
 
-    shader.setMat4("model", model);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    commands.setMat4(shader, modelLocation, model);
+    commands.drawArrays(GL_TRIANGLES, 0, 36);
 
     // 3
     model = glm::mat4{1.0f};
@@ -553,14 +591,14 @@ void drawScene(const gpu::Shader &shader) {
                         glm::normalize(glm::vec3{1.0, 0.0, 1.0}));
     model = glm::scale(model, glm::vec3{0.25});
 
-    shader.setMat4("model", model);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    commands.setMat4(shader, modelLocation, model);
+    commands.drawArrays(GL_TRIANGLES, 0, 36);
   }
 
   // monkey
   {
-    glBindTextureUnit(0, whiteTex10);
-    glBindTextureUnit(1, 0);
+    commands.bindTexture(0, whiteTex10);
+    commands.bindTexture(1, 0);
 
     glm::mat4 model = glm::mat4{1.0f};
 
@@ -570,8 +608,11 @@ void drawScene(const gpu::Shader &shader) {
     model =
         glm::rotate(model, -glm::radians(15.0f), glm::vec3{1.0f, 0.0f, 0.0f});
 
-    shader.setMat4("model", model);
-    suzzane->draw(shader);
+    commands.setMat4(shader, modelLocation, model);
+
+    for (const Mesh &mesh : suzzane->m_meshes) {
+      commands.drawMesh(mesh, shader);
+    }
   }
 }
 
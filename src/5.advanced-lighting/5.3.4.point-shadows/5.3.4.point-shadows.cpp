@@ -1,4 +1,5 @@
 
+#include "app.h"
 #include "basicmeshes.h"
 #include "cubemap.h"
 #include "flycamera.h"
@@ -91,7 +92,7 @@ void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
 int main() {
 
-  glfwInit();
+  app::init();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -103,7 +104,7 @@ int main() {
 
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
+    app::terminate();
     return -1;
   }
 
@@ -312,9 +313,9 @@ int main() {
 
   gpu::framebuffer::setClearColor(0.1f, 0.1f, 0.1f);
 
-  while (!glfwWindowShouldClose(window)) {
+  while (app::nextFrame(window)) {
 
-    currentTime = static_cast<float>(glfwGetTime());
+    currentTime = static_cast<float>(app::getTime());
     deltaTime = currentTime - lastTime;
 
     fpsCounterTime += deltaTime;
@@ -501,7 +502,7 @@ int main() {
 
   glDeleteTextures(1, &whiteTex10);
 
-  glfwTerminate();
+  app::terminate();
 
   return 0;
 }
@@ -0,0 +1,7 @@
+#version 450 core
+
+out vec4 FragColor;
+
+uniform vec3 lightColor;
+
+void main() { FragColor = vec4(lightColor, 1.0); }
\ No newline at end of file
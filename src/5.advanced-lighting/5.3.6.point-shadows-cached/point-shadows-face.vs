@@ -0,0 +1,15 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+// projection * view of the cube face being rendered
+uniform mat4 faceMatrix;
+
+out vec4 FragPos;
+
+void main() {
+  FragPos = model * vec4(aPos, 1.0);
+  gl_Position = faceMatrix * FragPos;
+}
\ No newline at end of file
@@ -0,0 +1,546 @@
+#include "app.h"
+#include "basicmeshes.h"
+#include "bounds.h"
+#include "cascadedshadows.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "mesh.h"
+#include "model.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "uniformbuffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+
+float cameraSpeed = 6.0f;
+
+float currentTime = 0.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+constexpr int SHADOW_SIZE = 2048;
+
+// objects are laid out on a GRID_SIZE x GRID_SIZE grid
+constexpr int GRID_SIZE = 24;
+constexpr float GRID_SPACING = 4.0f;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+float lastMouseX = static_cast<float>(WIDTH) * 0.5f;
+float lastMouseY = static_cast<float>(HEIGHT) * 0.5f;
+
+Model *suzzane;
+
+Mesh floorMesh;
+Mesh cubeMesh;
+
+gpu::texture::Texture2D containerDiffTex;
+gpu::texture::Texture2D containerSpecTex;
+
+gpu::texture::Texture2D woodTex;
+
+GLuint whiteTex10;
+
+struct SceneObject {
+  glm::mat4 model;
+  AABB bounds;
+  bool isMonkey;
+};
+
+std::vector<SceneObject> sceneObjects;
+
+// C shows the cascades, B toggles the blending between them
+bool showCascades = false;
+bool blendCascades = true;
+
+bool showCascadesKeyPressed = false;
+bool blendCascadesKeyPressed = false;
+
+// hold L to rotate the light
+bool rotateLight = false;
+
+FlyCamera camera{glm::vec3{0.0f, 3.0f, 10.0f}, glm::radians(45.0f), aspect,
+                 0.1f, 200.0f};
+
+void drawScene(const gpu::Shader &shader, const Frustum *frustum);
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // cascaded shadow maps
+
+  shadows::CascadedShadowsCreateInfo csmCreateInfo;
+  csmCreateInfo.nCascades = 4;
+  csmCreateInfo.size = SHADOW_SIZE;
+  csmCreateInfo.maxDistance = 80.0f;
+
+  shadows::CascadedShadows cascadedShadows{csmCreateInfo};
+
+  // uniform buffers
+
+  gpu::UniformBufferCreateInfo uboCreateInfo;
+
+  uboCreateInfo.bindingIndex = 0;
+  uboCreateInfo.nBlocks = 3;
+
+  std::string blockNames[] = {"cameraPosition", "cameraView",
+                              "cameraProjection"};
+
+  size_t blockSizes[] = {sizeof(glm::vec3), sizeof(glm::mat4),
+                         sizeof(glm::mat4)};
+
+  uboCreateInfo.pBlockNames = blockNames;
+  uboCreateInfo.pBlockSizes = blockSizes;
+
+  gpu::UniformBuffer camUniformBuffer{uboCreateInfo};
+
+  // floor
+
+  MeshCreateInfo floorCreateInfo;
+  floorCreateInfo.scale = glm::vec3{GRID_SIZE * GRID_SPACING};
+  floorCreateInfo.uvScale = glm::vec2{GRID_SIZE * GRID_SPACING * 0.5f};
+
+  floorMesh = createQuad(floorCreateInfo);
+
+  // cubes
+
+  cubeMesh = createCube();
+
+  containerDiffTex = gpu::texture::Texture2D{"container2.png"};
+  containerSpecTex = gpu::texture::Texture2D{"container2_specular.png"};
+
+  woodTex = gpu::texture::Texture2D{"wood.png"};
+  woodTex.setWrapST(gpu::texture::Wrap::REPEAT);
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &whiteTex10);
+  // 1px x 1px, single color texture (useful for default values)
+  {
+    float data[] = {1.0f, 1.0f, 1.0f};
+    glTextureStorage2D(whiteTex10, 1, GL_RGB8, 1, 1);
+    glTextureSubImage2D(whiteTex10, 0, 0, 0, 1, 1, GL_RGB, GL_FLOAT, &data);
+  }
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  std::stringstream monkeyModelPath;
+  monkeyModelPath << getModelPath("monkey") << separator << "monkey.obj";
+
+  suzzane = new Model{monkeyModelPath.str()};
+
+  // scene objects: pillars of different heights and a few monkeys
+  {
+    AABB cubeBounds = computeAABB(cubeMesh);
+    AABB suzzaneBounds = computeAABB(*suzzane);
+
+    float halfGrid = 0.5f * (GRID_SIZE - 1) * GRID_SPACING;
+
+    for (int z = 0; z < GRID_SIZE; ++z) {
+      for (int x = 0; x < GRID_SIZE; ++x) {
+
+        glm::vec3 position{x * GRID_SPACING - halfGrid, 0.0f,
+                           z * GRID_SPACING - halfGrid};
+
+        SceneObject object;
+
+        if ((x + z) % 5 == 0) {
+
+          object.isMonkey = true;
+          object.model = glm::translate(glm::mat4{1.0f},
+                                        position + glm::vec3{0.0f, 1.0f, 0.0f});
+          object.model = glm::rotate(object.model, glm::radians(37.0f * x),
+                                     glm::vec3{0.0f, 1.0f, 0.0f});
+          object.bounds = transformAABB(suzzaneBounds, object.model);
+
+        } else {
+
+          float height = 0.5f + static_cast<float>((x * 7 + z * 13) % 6);
+
+          object.isMonkey = false;
+          object.model = glm::translate(
+              glm::mat4{1.0f}, position + glm::vec3{0.0f, 0.5f * height, 0.0f});
+          object.model =
+              glm::scale(object.model, glm::vec3{0.4f, 0.5f * height, 0.4f});
+          object.bounds = transformAABB(cubeBounds, object.model);
+        }
+
+        sceneObjects.push_back(object);
+      }
+    }
+  }
+
+  gpu::Shader lightingShader{"lit-csm.vs", "lit-csm.fs"};
+
+  gpu::Shader shadowMappingDepthShader{"shadow-mapping-depth.vs",
+                                       "shadow-mapping-depth.fs"};
+
+  lightingShader.setInt("diffuse_texture0", 0);
+  lightingShader.setInt("specular_texture0", 1);
+
+  lightingShader.setInt("cascadeShadowMap", 2);
+
+  // dirLight params
+
+  glm::vec3 lightDir = glm::normalize(glm::vec3{0.4f, -0.7f, 0.3f});
+  float lightAngle = 0.0f;
+
+  lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+  lightingShader.setVec3("dirLight.diffuse", 0.8f, 0.8f, 0.8f);
+  lightingShader.setVec3("dirLight.specular", 0.3f, 0.3f, 0.3f);
+
+  glEnable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+
+  gpu::framebuffer::setClearColor(0.1f, 0.1f, 0.1f);
+
+  while (app::nextFrame(window)) {
+
+    currentTime = static_cast<float>(app::getTime());
+    deltaTime = currentTime - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]"
+         << " [" << cascadedShadows.getNumRendered() << " cascades/frame]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = currentTime;
+
+    // input
+    process_input(window);
+
+    if (rotateLight) {
+      lightAngle += 0.2f * deltaTime;
+      lightDir = glm::normalize(glm::vec3{0.4f * glm::cos(lightAngle), -0.7f,
+                                          0.4f * glm::sin(lightAngle)});
+    }
+
+    // first pass - cascades
+    {
+      cascadedShadows.update(camera, lightDir);
+
+      cascadedShadows.render(
+          shadowMappingDepthShader,
+          [](const gpu::Shader &shader, const Frustum &frustum) {
+            drawScene(shader, &frustum);
+          });
+    }
+
+    // second pass - lighting
+    {
+      {
+        using namespace gpu::framebuffer;
+
+        bindDefault();
+
+        setViewport(0, 0, WIDTH, HEIGHT);
+        clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
+      }
+
+      // uniform buffers
+      {
+        camUniformBuffer.updateSubdata("cameraPosition", camera.getPosition());
+        camUniformBuffer.updateSubdata("cameraView", camera.getViewMatrix());
+        camUniformBuffer.updateSubdata("cameraProjection",
+                                       camera.getProjectionMatrix());
+      }
+
+      lightingShader.setVec3("dirLight.direction", lightDir);
+
+      lightingShader.setInt("showCascades", showCascades);
+      lightingShader.setInt("blendCascades", blendCascades);
+
+      cascadedShadows.setUniforms(lightingShader);
+
+      glBindTextureUnit(2, cascadedShadows.getShadowMapID());
+
+      Frustum cameraFrustum{camera.getViewProjectionMatrix()};
+      drawScene(lightingShader, &cameraFrustum);
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  delete suzzane;
+
+  cascadedShadows.destroy();
+
+  camUniformBuffer.destroy();
+
+  lightingShader.destroy();
+  shadowMappingDepthShader.destroy();
+
+  containerDiffTex.destroy();
+  containerSpecTex.destroy();
+  woodTex.destroy();
+
+  glDeleteTextures(1, &whiteTex10);
+
+  app::terminate();
+
+  return 0;
+}
+
+void drawScene(const gpu::Shader &shader, const Frustum *frustum) {
+
+  shader.use();
+
+  // floor
+  {
+    glBindTextureUnit(0, woodTex.getID());
+    glBindTextureUnit(1, 0);
+
+    shader.setMat4("model", glm::mat4{1.0f});
+    floorMesh.draw(shader);
+  }
+
+  // objects
+  for (const SceneObject &object : sceneObjects) {
+
+    if (frustum && !frustum->intersects(object.bounds)) {
+      continue;
+    }
+
+    shader.setMat4("model", object.model);
+
+    if (object.isMonkey) {
+      glBindTextureUnit(0, whiteTex10);
+      glBindTextureUnit(1, 0);
+
+      suzzane->draw(shader);
+    } else {
+      glBindTextureUnit(0, containerDiffTex.getID());
+      glBindTextureUnit(1, containerSpecTex.getID());
+
+      cubeMesh.draw(shader);
+    }
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+    if (!showCascadesKeyPressed) {
+      showCascades = !showCascades;
+      showCascadesKeyPressed = true;
+    }
+  } else {
+    showCascadesKeyPressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
+    if (!blendCascadesKeyPressed) {
+      blendCascades = !blendCascades;
+      blendCascadesKeyPressed = true;
+    }
+  } else {
+    blendCascadesKeyPressed = false;
+  }
+
+  rotateLight = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
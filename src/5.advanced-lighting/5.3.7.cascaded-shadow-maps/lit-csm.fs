@@ -0,0 +1,162 @@
+#version 450 core
+
+struct DirLight {
+
+  vec3 direction;
+
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+};
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+in VS_OUT {
+  vec3 fragPos;
+  vec3 normal;
+  vec2 texCoords;
+  float viewDepth;
+}
+fs_in;
+
+out vec4 FragColor;
+
+uniform DirLight dirLight;
+
+const int MAX_CASCADES = 4;
+
+uniform int nCascades;
+uniform float cascadeSplits[MAX_CASCADES];
+uniform mat4 cascadeMatrices[MAX_CASCADES];
+
+// fraction of each cascade that fades into the next one
+uniform float cascadeBlendFraction;
+
+uniform bool blendCascades;
+uniform bool showCascades;
+
+uniform sampler2D diffuse_texture0;
+uniform sampler2D specular_texture0;
+
+// depth compare enabled, each fetch is a 2x2 pcf
+uniform sampler2DArrayShadow cascadeShadowMap;
+
+float calculateCascadeShadow(int cascade, vec3 normal) {
+
+  vec2 texelSize = 1.0 / vec2(textureSize(cascadeShadowMap, 0).xy);
+
+  // world-space size of a shadow map texel in this cascade (the first row
+  // of an orthographic light matrix is scaled by 2 / width)
+  mat4 lightMatrix = cascadeMatrices[cascade];
+  float worldTexel =
+      2.0 * texelSize.x /
+      length(vec3(lightMatrix[0][0], lightMatrix[1][0], lightMatrix[2][0]));
+
+  // normal offset: push the lookup out of the surface, scaled with the
+  // texel size so every cascade gets the same amount of acne protection
+  float cosTheta = clamp(dot(normal, -dirLight.direction), 0.0, 1.0);
+  vec3 offsetPos = fs_in.fragPos + normal * worldTexel * (1.0 - cosTheta + 0.5);
+
+  // orthographic, w = 1
+  vec3 projCoords = vec3(lightMatrix * vec4(offsetPos, 1.0)) * 0.5 + 0.5;
+
+  float bias = 0.0002;
+
+  float lit = 0.0;
+
+  for (int x = -1; x <= 1; ++x) {
+    for (int y = -1; y <= 1; ++y) {
+      lit += texture(cascadeShadowMap,
+                     vec4(projCoords.xy + vec2(x, y) * texelSize, cascade,
+                          projCoords.z - bias));
+    }
+  }
+
+  return 1.0 - lit / 9.0;
+}
+
+float calculateShadow(vec3 normal, out int cascade) {
+
+  cascade = nCascades;
+
+  for (int i = 0; i < nCascades; ++i) {
+    if (fs_in.viewDepth < cascadeSplits[i]) {
+      cascade = i;
+      break;
+    }
+  }
+
+  if (cascade == nCascades) {
+    // beyond the shadow distance
+    return 0.0;
+  }
+
+  float shadow = calculateCascadeShadow(cascade, normal);
+
+  if (!blendCascades) {
+    return shadow;
+  }
+
+  float start = cascade == 0 ? 0.0 : cascadeSplits[cascade - 1];
+  float end = cascadeSplits[cascade];
+
+  float blendStart = end - cascadeBlendFraction * (end - start);
+
+  if (fs_in.viewDepth > blendStart) {
+
+    // the last cascade fades out instead of popping
+    float next = cascade + 1 < nCascades
+                     ? calculateCascadeShadow(cascade + 1, normal)
+                     : 0.0;
+
+    shadow = mix(shadow, next,
+                 smoothstep(blendStart, end, fs_in.viewDepth));
+  }
+
+  return shadow;
+}
+
+void main() {
+
+  vec3 diffColor = vec3(texture(diffuse_texture0, fs_in.texCoords));
+  vec3 specColor = vec3(texture(specular_texture0, fs_in.texCoords));
+
+  vec3 normal = normalize(fs_in.normal);
+
+  vec3 fragLightDir = -normalize(dirLight.direction);
+
+  // ambient
+  vec3 ambient = dirLight.ambient * diffColor;
+
+  // diffuse
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * dirLight.diffuse * diffColor;
+
+  // specular (blinn-phong)
+  vec3 fragCameraDir = normalize(cameraPosition - fs_in.fragPos);
+
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 64.0);
+
+  vec3 specular = dirLight.specular * spec * specColor;
+
+  int cascade;
+  float shadow = calculateShadow(normal, cascade);
+
+  vec3 result = ambient + (1.0 - shadow) * (diffuse + specular);
+
+  if (showCascades && cascade < nCascades) {
+
+    vec3 cascadeColors[MAX_CASCADES] =
+        vec3[](vec3(1.0, 0.3, 0.3), vec3(0.3, 1.0, 0.3), vec3(0.3, 0.3, 1.0),
+               vec3(1.0, 1.0, 0.3));
+
+    result *= cascadeColors[cascade];
+  }
+
+  FragColor = vec4(result, 1.0);
+}
\ No newline at end of file
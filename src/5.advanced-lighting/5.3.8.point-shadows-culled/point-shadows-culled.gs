@@ -0,0 +1,29 @@
+#version 450 core
+layout(triangles) in;
+
+// no amplification, each instance writes a single face
+layout(triangle_strip, max_vertices = 3) out;
+
+uniform mat4 shadowMatrices[6];
+
+in VS_OUT { flat int face; }
+gs_in[];
+
+out vec4 FragPos;
+
+void main() {
+
+  int face = gs_in[0].face;
+
+  gl_Layer = face;
+
+  for (int i = 0; i < 3; ++i) {
+
+    FragPos = gl_in[i].gl_Position;
+    gl_Position = shadowMatrices[face] * FragPos;
+
+    EmitVertex();
+  }
+
+  EndPrimitive();
+}
\ No newline at end of file
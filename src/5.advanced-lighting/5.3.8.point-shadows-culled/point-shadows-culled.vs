@@ -0,0 +1,16 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+// the cube faces this draw touches, one instance per face
+uniform int faceIndices[6];
+
+out VS_OUT { flat int face; }
+vs_out;
+
+void main() {
+  vs_out.face = faceIndices[gl_InstanceID];
+  gl_Position = model * vec4(aPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+void main() { gl_Position = model * vec4(aPos, 1.0); }
\ No newline at end of file
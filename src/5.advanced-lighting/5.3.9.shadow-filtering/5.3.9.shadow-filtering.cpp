@@ -0,0 +1,935 @@
+#include "app.h"
+#include "basicmeshes.h"
+#include "cubemap.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "mesh.h"
+#include "model.h"
+#include "pointlight.h"
+#include "pointshadows.h"
+#include "query.h"
+#include "renderbuffer.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "uniformbuffer.h"
+#include "vertexarray.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iomanip>
+#include <iostream>
+
+float cameraSpeed = 3.0f;
+
+float currentTime = 0.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+constexpr int SHADOW_WIDTH = 1024;
+constexpr int SHADOW_HEIGHT = 1024;
+
+constexpr int MAX_POINT_LIGHTS = 4;
+
+constexpr float ESM_EXPONENT = 40.0f;
+
+// benchmark: frames skipped after switching mode (the timers lag a few
+// frames) and frames averaged
+constexpr int BENCHMARK_WARMUP_FRAMES = 30;
+constexpr int BENCHMARK_FRAMES = 300;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+float lastMouseX = static_cast<float>(WIDTH) * 0.5f;
+float lastMouseY = static_cast<float>(HEIGHT) * 0.5f;
+
+// must match the FILTER_* constants of lit-shadow-filtering.fs
+enum class ShadowFilter : int {
+  PCF = 0,
+  HARDWARE_PCF,
+  POISSON,
+  VSM,
+  ESM,
+  COUNT
+};
+
+const char *shadowFilterNames[] = {"pcf (9 + 20 taps)",
+                                   "hardware pcf (4 + 4 taps)",
+                                   "rotated poisson (8 + 8 taps)",
+                                   "vsm (prefiltered)", "esm (prefiltered)"};
+
+ShadowFilter shadowFilter = ShadowFilter::PCF;
+bool shadowFilterDirty = true;
+
+// B runs every mode for BENCHMARK_FRAMES frames and prints the averages
+bool benchmarkRequested = false;
+
+Model *suzzane;
+
+Mesh roomMesh;
+Mesh cubeMesh;
+
+gpu::texture::Texture2D containerDiffTex;
+gpu::texture::Texture2D containerSpecTex;
+
+gpu::texture::Texture2D woodTex;
+
+GLuint whiteTex10;
+
+size_t nActiveLights = 1;
+
+FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
+                 100.0f};
+
+std::vector<PointLight> pointLights;
+
+gpu::Shader lightCubeShader;
+
+void drawLightCubes();
+void drawScene(const gpu::Shader &shader);
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // shadow mapping
+
+  // directional (depth)
+
+  gpu::framebuffer::Framebuffer depthMapFramebuffer;
+  gpu::texture::Texture2D depthTexture{SHADOW_WIDTH, SHADOW_HEIGHT,
+                                       GL_DEPTH_COMPONENT24};
+
+  depthTexture.setWrapST(gpu::texture::Wrap::CLAMP_TO_BORDER);
+  depthTexture.setBorderColor(glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+
+  depthMapFramebuffer.setDepthAttachment(depthTexture);
+  depthMapFramebuffer.checkStatus();
+
+  // directional (moments, blurred in place through a temporary texture)
+
+  gpu::texture::Texture2D momentsTextures[2] = {
+      gpu::texture::Texture2D{SHADOW_WIDTH, SHADOW_HEIGHT, GL_RG32F},
+      gpu::texture::Texture2D{SHADOW_WIDTH, SHADOW_HEIGHT, GL_RG32F}};
+
+  gpu::framebuffer::Framebuffer momentsFramebuffers[2];
+
+  gpu::Renderbuffer momentsDepthRenderbuffer{SHADOW_WIDTH, SHADOW_HEIGHT,
+                                             GL_DEPTH_COMPONENT24};
+
+  for (int i = 0; i < 2; ++i) {
+
+    momentsTextures[i].setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+    momentsTextures[i].setMinMagFilter(gpu::texture::Filter::LINEAR);
+
+    momentsFramebuffers[i].setColorAttachment(momentsTextures[i], 0);
+    momentsFramebuffers[i].checkStatus();
+  }
+
+  // only the first one is rendered with depth testing
+  momentsFramebuffers[0].setDepthAttachment(momentsDepthRenderbuffer);
+  momentsFramebuffers[0].checkStatus();
+
+  gpu::VertexArray emptyVAO;
+
+  // omni
+
+  gpu::framebuffer::Framebuffer depthMapOmniFramebuffers[MAX_POINT_LIGHTS];
+  gpu::texture::Cubemap depthCubemaps[MAX_POINT_LIGHTS];
+
+  for (size_t i = 0; i < MAX_POINT_LIGHTS; ++i) {
+
+    depthCubemaps[i] = gpu::texture::Cubemap{SHADOW_WIDTH, SHADOW_HEIGHT,
+                                             GL_DEPTH_COMPONENT24};
+
+    depthCubemaps[i].setWrapRST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+
+    depthMapOmniFramebuffers[i].setDepthAttachment(depthCubemaps[i]);
+    depthMapOmniFramebuffers[i].checkStatus();
+  }
+
+  // gpu timers
+
+  gpu::GpuTimer shadowPassTimer;
+  gpu::GpuTimer lightingPassTimer;
+
+  // uniform buffers
+
+  gpu::UniformBufferCreateInfo uboCreateInfo;
+
+  uboCreateInfo.bindingIndex = 0;
+  uboCreateInfo.nBlocks = 3;
+
+  std::string blockNames[] = {"cameraPosition", "cameraView",
+                              "cameraProjection"};
+
+  size_t blockSizes[] = {sizeof(glm::vec3), sizeof(glm::mat4),
+                         sizeof(glm::mat4)};
+
+  uboCreateInfo.pBlockNames = blockNames;
+  uboCreateInfo.pBlockSizes = blockSizes;
+
+  gpu::UniformBuffer camUniformBuffer{uboCreateInfo};
+
+  // room
+  MeshCreateInfo roomVertexDataCreateInfo;
+  roomVertexDataCreateInfo.insideOut = true;
+
+  roomMesh = createCube(roomVertexDataCreateInfo);
+
+  // cubes
+
+  cubeMesh = createCube();
+
+  containerDiffTex = gpu::texture::Texture2D{"container2.png"};
+  containerSpecTex = gpu::texture::Texture2D{"container2_specular.png"};
+
+  woodTex = gpu::texture::Texture2D{"wood.png"};
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &whiteTex10);
+  // 1px x 1px, single color texture (useful for default values)
+  {
+    float data[] = {1.0f, 1.0f, 1.0f};
+    glTextureStorage2D(whiteTex10, 1, GL_RGB8, 1, 1);
+    glTextureSubImage2D(whiteTex10, 0, 0, 0, 1, 1, GL_RGB, GL_FLOAT, &data);
+  }
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  std::stringstream monkeyModelPath;
+  monkeyModelPath << getModelPath("monkey") << separator << "monkey.obj";
+
+  suzzane = new Model{monkeyModelPath.str()};
+
+  lightCubeShader = gpu::Shader{"light-cube.vs", "light-cube.fs"};
+
+  gpu::Shader lightingShader{"lit-shadows.vs", "lit-shadow-filtering.fs"};
+
+  gpu::Shader shadowMappingDepthShader{"shadow-mapping-depth.vs",
+                                       "shadow-mapping-depth.fs"};
+
+  gpu::Shader shadowMomentsShader{"shadow-mapping-depth.vs",
+                                  "shadow-moments.fs"};
+
+  gpu::Shader blurShader{"blur.vs", "blur.fs"};
+
+  gpu::Shader pointShadowsDepthShader{"point-shadows-depth.vs",
+                                      "point-shadows-depth.fs",
+                                      "point-shadows-depth.gs"};
+
+  lightingShader.setInt("diffuse_texture0", 0);
+  lightingShader.setInt("specular_texture0", 1);
+
+  // texture units: 2 dir depth, 3-6 point depth, 7 dir depth (compare),
+  // 8-11 point depth (compare), 12 dir moments
+  lightingShader.setInt("dirLightShadowMap", 2);
+  lightingShader.setInt("dirLightShadowMapCmp", 7);
+  lightingShader.setInt("dirLightMoments", 12);
+
+  for (int i = 0; i < MAX_POINT_LIGHTS; ++i) {
+    lightingShader.setInt("pointLightShadowMaps[" + std::to_string(i) + "]",
+                          3 + i);
+    lightingShader.setInt("pointLightShadowMapsCmp[" + std::to_string(i) + "]",
+                          8 + i);
+  }
+
+  lightingShader.setFloat("esmExponent", ESM_EXPONENT);
+  shadowMomentsShader.setFloat("esmExponent", ESM_EXPONENT);
+
+  blurShader.setInt("image", 0);
+
+  // point lights
+
+  {
+    {
+      PointLight light;
+      light.position = glm::vec3{-1.3f, 0.1f, -1.7f};
+      light.ambient = glm::vec3{0.01f};
+      light.diffuse = glm::vec3{0.2, 0.2, 0.2};
+      light.specular = glm::vec3{0.3f, 0.3f, 0.3f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{-1.8f, -0.5f, 1.7f};
+      light.ambient = glm::vec3{0.01f};
+      light.diffuse = glm::vec3{0.2, 0.2, 0.2};
+      light.specular = glm::vec3{0.3f, 0.3f, 0.3f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{1.4f, -0.3f, -1.9f};
+      light.ambient = glm::vec3{0.01f};
+      light.diffuse = glm::vec3{0.2, 0.2, 0.2};
+      light.specular = glm::vec3{0.3f, 0.3f, 0.3f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{1.7f, 0.3f, 1.5f};
+      light.ambient = glm::vec3{0.01f};
+      light.diffuse = glm::vec3{0.2, 0.2, 0.2};
+      light.specular = glm::vec3{0.3f, 0.3f, 0.3f};
+      pointLights.push_back(light);
+    }
+
+    for (unsigned int i = 0; i < pointLights.size(); ++i) {
+      pointLights[i].constantAtt = 1.0f;
+      pointLights[i].linearAtt = 0.09f;
+      pointLights[i].quadraticAtt = 0.032f;
+    }
+  }
+
+  // dirLight params
+
+  lightingShader.setVec3("dirLight.ambient", 0.02f, 0.02f, 0.02f);
+  lightingShader.setVec3("dirLight.diffuse", 0.3f, 0.3f, 0.3f);
+  lightingShader.setVec3("dirLight.specular", 0.3f, 0.3f, 0.3f);
+
+  glEnable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+
+  gpu::framebuffer::setClearColor(0.1f, 0.1f, 0.1f);
+
+  // benchmark state
+  bool benchmarkRunning = false;
+  int benchmarkMode = 0;
+  int benchmarkFrame = 0;
+  double benchmarkShadowMs[static_cast<int>(ShadowFilter::COUNT)] = {};
+  double benchmarkLightingMs[static_cast<int>(ShadowFilter::COUNT)] = {};
+
+  while (app::nextFrame(window)) {
+
+    currentTime = static_cast<float>(app::getTime());
+    deltaTime = currentTime - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]"
+         << " [" << shadowFilterNames[static_cast<int>(shadowFilter)]
+         << ": shadows " << shadowPassTimer.getMilliseconds()
+         << " ms, lighting " << lightingPassTimer.getMilliseconds() << " ms]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = currentTime;
+
+    // input
+    process_input(window);
+
+    // benchmark
+    {
+      if (benchmarkRequested && !benchmarkRunning) {
+        benchmarkRunning = true;
+        benchmarkMode = 0;
+        benchmarkFrame = 0;
+
+        shadowFilter = ShadowFilter::PCF;
+        shadowFilterDirty = true;
+      }
+
+      benchmarkRequested = false;
+
+      if (benchmarkRunning) {
+
+        if (benchmarkFrame >= BENCHMARK_WARMUP_FRAMES) {
+          benchmarkShadowMs[benchmarkMode] += shadowPassTimer.getMilliseconds();
+          benchmarkLightingMs[benchmarkMode] +=
+              lightingPassTimer.getMilliseconds();
+        }
+
+        if (++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES) {
+
+          benchmarkFrame = 0;
+
+          if (++benchmarkMode == static_cast<int>(ShadowFilter::COUNT)) {
+
+            benchmarkRunning = false;
+
+            std::cout << "shadow filtering benchmark (" << nActiveLights
+                      << " point lights, " << BENCHMARK_FRAMES
+                      << " frames per mode)" << std::endl;
+
+            for (int i = 0; i < static_cast<int>(ShadowFilter::COUNT); ++i) {
+
+              std::cout << std::setw(30) << shadowFilterNames[i]
+                        << "  shadow pass " << std::fixed
+                        << std::setprecision(3)
+                        << benchmarkShadowMs[i] / BENCHMARK_FRAMES
+                        << " ms  lighting pass "
+                        << benchmarkLightingMs[i] / BENCHMARK_FRAMES << " ms"
+                        << std::endl;
+
+              benchmarkShadowMs[i] = 0.0;
+              benchmarkLightingMs[i] = 0.0;
+            }
+
+            benchmarkMode = 0;
+          }
+
+          shadowFilter = static_cast<ShadowFilter>(benchmarkMode);
+          shadowFilterDirty = true;
+        }
+      }
+    }
+
+    bool prefiltered =
+        shadowFilter == ShadowFilter::VSM || shadowFilter == ShadowFilter::ESM;
+
+    if (shadowFilterDirty) {
+
+      // the compare modes need the hardware comparison and bilinear
+      // filtering, the manual pcf reads raw depths
+      bool compare = shadowFilter != ShadowFilter::PCF;
+
+      gpu::texture::Filter filter = compare ? gpu::texture::Filter::LINEAR
+                                            : gpu::texture::Filter::NEAREST;
+
+      depthTexture.setDepthCompare(compare);
+      depthTexture.setMinMagFilter(filter);
+
+      for (gpu::texture::Cubemap &cubemap : depthCubemaps) {
+        cubemap.setDepthCompare(compare);
+        cubemap.setMinMagFilter(filter);
+      }
+
+      lightingShader.setInt("filterMode", static_cast<int>(shadowFilter));
+      shadowMomentsShader.setInt("momentsMode",
+                                 shadowFilter == ShadowFilter::VSM ? 0 : 1);
+
+      shadowFilterDirty = false;
+    }
+
+    // the directional light orbits so its map is re-rendered every frame
+    glm::vec3 lightDir =
+        glm::vec3{0.2f * glm::cos(0.3f * currentTime), -0.4f,
+                  0.2f * glm::sin(0.3f * currentTime)};
+
+    glm::mat4 lightSpaceMatrix;
+    {
+      glm::vec3 lightPos = -10.0f * lightDir;
+
+      glm::mat4 view = glm::lookAt(lightPos, glm::vec3{0.0f, 0.0f, 0.0f},
+                                   glm::vec3{0.0f, 1.0f, 0.0f});
+
+      glm::mat4 projection =
+          glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 7.5f);
+
+      lightSpaceMatrix = projection * view;
+    }
+
+    // first pass - generate shadows
+    shadowPassTimer.begin();
+    {
+      // directional
+      if (prefiltered) {
+
+        shadowMomentsShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+
+        momentsFramebuffers[0].bind();
+
+        {
+          using namespace gpu::framebuffer;
+
+          setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+
+          // cleared to the values of an unoccluded texel (depth = 1)
+          float clearMoments[] = {1.0f, 1.0f, 0.0f, 0.0f};
+          if (shadowFilter == ShadowFilter::ESM) {
+            clearMoments[0] = glm::exp(ESM_EXPONENT);
+          }
+
+          glClearNamedFramebufferfv(momentsFramebuffers[0].getID(), GL_COLOR,
+                                    0, clearMoments);
+          clear(ClearFlagBits::DEPTH_BIT);
+        }
+
+        drawScene(shadowMomentsShader);
+
+        // separable blur, done once per shadow map update instead of once
+        // per fragment
+        glDisable(GL_DEPTH_TEST);
+
+        blurShader.use();
+        emptyVAO.bind();
+
+        momentsFramebuffers[1].bind();
+        glBindTextureUnit(0, momentsTextures[0].getID());
+        blurShader.setVec2("texelStep", 1.0f / SHADOW_WIDTH, 0.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        momentsFramebuffers[0].bind();
+        glBindTextureUnit(0, momentsTextures[1].getID());
+        blurShader.setVec2("texelStep", 0.0f, 1.0f / SHADOW_HEIGHT);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glEnable(GL_DEPTH_TEST);
+
+      } else {
+
+        shadowMappingDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+
+        depthMapFramebuffer.bind();
+
+        {
+          using namespace gpu::framebuffer;
+
+          setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+          clear(ClearFlagBits::DEPTH_BIT);
+        }
+
+        drawScene(shadowMappingDepthShader);
+      }
+
+      // omni
+      float zNear = 0.1f;
+      float zFar = 25.0f;
+
+      pointShadowsDepthShader.setFloat("zNear", zNear);
+      pointShadowsDepthShader.setFloat("zFar", zFar);
+
+      for (size_t i = 0; i < nActiveLights; ++i) {
+
+        depthMapOmniFramebuffers[i].bind();
+
+        {
+          using namespace gpu::framebuffer;
+
+          setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+          clear(ClearFlagBits::DEPTH_BIT);
+        }
+
+        const PointLight &pointLight = pointLights[i];
+
+        pointShadowsDepthShader.setVec3("lightPos", pointLight.position);
+
+        std::array<glm::mat4, shadows::CUBE_FACES> shadowMatrices =
+            shadows::pointShadowMatrices(pointLight.position, zNear, zFar);
+
+        for (int face = 0; face < shadows::CUBE_FACES; ++face) {
+          pointShadowsDepthShader.setMat4(
+              "shadowMatrices[" + std::to_string(face) + "]",
+              shadowMatrices[face]);
+        }
+
+        drawScene(pointShadowsDepthShader);
+      }
+    }
+    shadowPassTimer.end();
+
+    // draw scene normally
+    {
+      {
+        using namespace gpu::framebuffer;
+
+        bindDefault();
+
+        setViewport(0, 0, WIDTH, HEIGHT);
+        clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
+      }
+
+      // uniform buffers
+      {
+        camUniformBuffer.updateSubdata("cameraPosition", camera.getPosition());
+        camUniformBuffer.updateSubdata("cameraView", camera.getViewMatrix());
+        camUniformBuffer.updateSubdata("cameraProjection",
+                                       camera.getProjectionMatrix());
+      }
+
+      // dir light
+      {
+        lightingShader.setVec3("dirLight.direction", lightDir);
+        lightingShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+      }
+
+      // point lights
+      {
+        lightingShader.setInt("nPointLights", nActiveLights);
+
+        for (size_t i = 0; i < nActiveLights; ++i) {
+
+          const PointLight &point = pointLights[i];
+          std::string prefix = "pointLights[" + std::to_string(i) + "]";
+
+          lightingShader.setFloat(prefix + ".zNear", 0.1f);
+          lightingShader.setFloat(prefix + ".zFar", 25.0f);
+
+          lightingShader.setVec3(prefix + ".position", point.position);
+
+          lightingShader.setVec3(prefix + ".ambient", point.ambient);
+          lightingShader.setVec3(prefix + ".diffuse", point.diffuse);
+          lightingShader.setVec3(prefix + ".specular", point.specular);
+
+          lightingShader.setFloat(prefix + ".constantAtt", point.constantAtt);
+          lightingShader.setFloat(prefix + ".linearAtt", point.linearAtt);
+          lightingShader.setFloat(prefix + ".quadraticAtt", point.quadraticAtt);
+
+          glBindTextureUnit(3 + i, depthCubemaps[i].getID());
+          glBindTextureUnit(8 + i, depthCubemaps[i].getID());
+        }
+      }
+
+      glBindTextureUnit(2, depthTexture.getID());
+      glBindTextureUnit(7, depthTexture.getID());
+      glBindTextureUnit(12, momentsTextures[0].getID());
+
+      lightingPassTimer.begin();
+      drawScene(lightingShader);
+      lightingPassTimer.end();
+
+      drawLightCubes();
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  delete suzzane;
+
+  depthMapFramebuffer.destroy();
+  depthTexture.destroy();
+
+  for (int i = 0; i < 2; ++i) {
+    momentsFramebuffers[i].destroy();
+    momentsTextures[i].destroy();
+  }
+
+  momentsDepthRenderbuffer.destroy();
+  emptyVAO.destroy();
+
+  for (size_t i = 0; i < MAX_POINT_LIGHTS; ++i) {
+    depthMapOmniFramebuffers[i].destroy();
+    depthCubemaps[i].destroy();
+  }
+
+  shadowPassTimer.destroy();
+  lightingPassTimer.destroy();
+
+  camUniformBuffer.destroy();
+
+  lightingShader.destroy();
+  shadowMappingDepthShader.destroy();
+  shadowMomentsShader.destroy();
+  blurShader.destroy();
+  pointShadowsDepthShader.destroy();
+
+  containerDiffTex.destroy();
+  containerSpecTex.destroy();
+
+  glDeleteTextures(1, &whiteTex10);
+
+  app::terminate();
+
+  return 0;
+}
+
+void drawLightCubes() {
+
+  lightCubeShader.use();
+
+  for (size_t i = 0; i < nActiveLights; ++i) {
+
+    glm::mat4 model{1.0f};
+    model = glm::translate(model, pointLights[i].position);
+    model = glm::scale(model, glm::vec3{0.1f});
+
+    lightCubeShader.setMat4("model", model);
+    lightCubeShader.setVec3("lightColor",
+                            glm::normalize(pointLights[i].diffuse));
+
+    cubeMesh.draw(lightCubeShader);
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void drawScene(const gpu::Shader &shader) {
+
+  shader.use();
+
+  // room
+  {
+    glBindTextureUnit(0, woodTex.getID());
+    glBindTextureUnit(1, 0);
+
+    glm::mat4 model{1.0f};
+    model = glm::scale(model, glm::vec3{8.0f});
+
+    shader.setMat4("model", model);
+    roomMesh.draw(shader);
+  }
+
+  // cubes
+  {
+    glBindTextureUnit(0, containerDiffTex.getID());
+    glBindTextureUnit(1, containerSpecTex.getID());
+
+    // 1
+    glm::mat4 model{1.0f};
+    model = glm::translate(model, glm::vec3{0.0f, 0.75f, 0.0});
+    model = glm::scale(model, glm::vec3{0.3f});
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+
+    // 2
+    model = glm::mat4{1.0f};
+    model = glm::translate(model, glm::vec3{2.0f, -0.25f, 1.0});
+    model = glm::rotate(model, glm::radians(35.0f),
+                        glm::normalize(glm::vec3{0.0, 1.0, 1.0}));
+    model = glm::scale(model, glm::vec3{0.5f});
+
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+
+    // 3
+    model = glm::mat4{1.0f};
+    model = glm::translate(model, glm::vec3{-1.0f, 0.0f, 2.0});
+    model = glm::rotate(model, glm::radians(60.0f),
+                        glm::normalize(glm::vec3{1.0, 0.0, 1.0}));
+    model = glm::scale(model, glm::vec3{0.25});
+
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+  }
+
+  // monkey
+  {
+    glBindTextureUnit(0, whiteTex10);
+    glBindTextureUnit(1, 0);
+
+    glm::mat4 model = glm::mat4{1.0f};
+
+    model = glm::rotate(model, glm::radians(15.0f * currentTime),
+                        glm::vec3{0.3f, 0.4f, 0.0f});
+
+    shader.setMat4("model", model);
+    suzzane->draw(shader);
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
+    nActiveLights = 1;
+  } else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
+    nActiveLights = 2;
+  } else if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
+    nActiveLights = 3;
+  } else if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) {
+    nActiveLights = 4;
+  }
+
+  // F1-F5 select the filtering mode
+  for (int i = 0; i < static_cast<int>(ShadowFilter::COUNT); ++i) {
+    if (glfwGetKey(window, GLFW_KEY_F1 + i) == GLFW_PRESS &&
+        shadowFilter != static_cast<ShadowFilter>(i)) {
+      shadowFilter = static_cast<ShadowFilter>(i);
+      shadowFilterDirty = true;
+    }
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
+    benchmarkRequested = true;
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
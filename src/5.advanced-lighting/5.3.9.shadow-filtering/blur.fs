@@ -0,0 +1,26 @@
+#version 450 core
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D image;
+
+// one texel along the blur axis (separable: horizontal pass + vertical pass)
+uniform vec2 texelStep;
+
+// 9 tap gaussian (sigma ~ 2)
+const float weights[5] = float[](0.2270270270, 0.1945945946, 0.1216216216,
+                                 0.0540540541, 0.0162162162);
+
+void main() {
+
+  vec4 result = texture(image, TexCoords) * weights[0];
+
+  for (int i = 1; i < 5; ++i) {
+    result += texture(image, TexCoords + texelStep * i) * weights[i];
+    result += texture(image, TexCoords - texelStep * i) * weights[i];
+  }
+
+  FragColor = result;
+}
\ No newline at end of file
@@ -0,0 +1,353 @@
+#version 450 core
+
+struct DirLight {
+
+  vec3 direction;
+
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+};
+
+struct PointLight {
+
+  vec3 position;
+
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+
+  float constantAtt;
+  float linearAtt;
+  float quadraticAtt;
+
+  float zNear;
+  float zFar;
+};
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+in VS_OUT {
+  vec3 fragPos;
+  vec3 normal;
+  vec2 texCoords;
+  vec4 fragPosLightSpace;
+}
+fs_in;
+
+out vec4 FragColor;
+
+// must match the ShadowFilter enum of the demo
+const int FILTER_PCF = 0;
+const int FILTER_HARDWARE_PCF = 1;
+const int FILTER_POISSON = 2;
+const int FILTER_VSM = 3;
+const int FILTER_ESM = 4;
+
+uniform int filterMode;
+
+uniform DirLight dirLight;
+
+const int MAX_POINT_LIGHTS = 4;
+
+uniform int nPointLights;
+uniform PointLight pointLights[MAX_POINT_LIGHTS];
+
+uniform sampler2D diffuse_texture0;
+uniform sampler2D specular_texture0;
+
+// depth maps, compare mode off (FILTER_PCF)
+uniform sampler2D dirLightShadowMap;
+uniform samplerCube pointLightShadowMaps[MAX_POINT_LIGHTS];
+
+// same depth maps, compare mode on (every other mode)
+uniform sampler2DShadow dirLightShadowMapCmp;
+uniform samplerCubeShadow pointLightShadowMapsCmp[MAX_POINT_LIGHTS];
+
+// prefiltered moments (FILTER_VSM / FILTER_ESM)
+uniform sampler2D dirLightMoments;
+uniform float esmExponent;
+
+// clang-format off
+
+const vec2 poissonDisk[8] = vec2[](
+  vec2(-0.7071,  0.7071), vec2(-0.0000, -0.8750),
+  vec2( 0.5303,  0.5303), vec2(-0.6250, -0.0000),
+  vec2( 0.3536, -0.3536), vec2(-0.0000,  0.3750),
+  vec2(-0.1768, -0.1768), vec2( 0.1250,  0.0000)
+);
+
+// clang-format on
+
+// per pixel rotation of the poisson disk, trades banding for noise
+float interleavedGradientNoise() {
+  return fract(52.9829189 *
+               fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+mat2 poissonRotation() {
+  float angle = 6.28318530718 * interleavedGradientNoise();
+  float s = sin(angle);
+  float c = cos(angle);
+  return mat2(c, s, -s, c);
+}
+
+float calculateDirLightShadow(vec3 normal) {
+
+  vec3 projCoords = fs_in.fragPosLightSpace.xyz / fs_in.fragPosLightSpace.w;
+  projCoords = (1 + projCoords) * 0.5;
+
+  float currentDepth = projCoords.z;
+
+  if (currentDepth > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) ||
+      any(greaterThan(projCoords.xy, vec2(1.0)))) {
+    // outside of the light view frustrum
+    return 0.0;
+  }
+
+  float bias = max(0.001, 0.005 * (1.0 - dot(normal, -dirLight.direction)));
+
+  vec2 texelSize = 1.0 / textureSize(dirLightShadowMap, 0);
+
+  if (filterMode == FILTER_PCF) {
+
+    // 9 taps, software compare
+    float shadow = 0.0;
+
+    for (int x = -1; x <= 1; ++x) {
+      for (int y = -1; y <= 1; ++y) {
+        float pcfDepth =
+            texture(dirLightShadowMap, projCoords.xy + vec2(x, y) * texelSize)
+                .r;
+        shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+      }
+    }
+
+    return shadow / 9.0;
+  }
+
+  if (filterMode == FILTER_HARDWARE_PCF) {
+
+    // 4 bilinear compare taps placed between texels cover the same 4x4
+    // footprint as 16 manual taps
+    float lit = 0.0;
+
+    for (int x = 0; x < 2; ++x) {
+      for (int y = 0; y < 2; ++y) {
+        vec2 offset = (vec2(x, y) - 0.5) * texelSize;
+        lit += texture(dirLightShadowMapCmp,
+                       vec3(projCoords.xy + offset, currentDepth - bias));
+      }
+    }
+
+    return 1.0 - lit * 0.25;
+  }
+
+  if (filterMode == FILTER_POISSON) {
+
+    mat2 rotation = poissonRotation();
+
+    float radius = 2.5;
+    float lit = 0.0;
+
+    for (int i = 0; i < 8; ++i) {
+      vec2 offset = rotation * poissonDisk[i] * radius * texelSize;
+      lit += texture(dirLightShadowMapCmp,
+                     vec3(projCoords.xy + offset, currentDepth - bias));
+    }
+
+    return 1.0 - lit / 8.0;
+  }
+
+  vec2 moments = texture(dirLightMoments, projCoords.xy).rg;
+
+  if (filterMode == FILTER_VSM) {
+
+    if (currentDepth <= moments.x) {
+      return 0.0;
+    }
+
+    // chebyshev upper bound
+    float variance = max(moments.y - moments.x * moments.x, 0.00002);
+    float d = currentDepth - moments.x;
+    float pMax = variance / (variance + d * d);
+
+    // light bleeding reduction: the tail of the bound is cut off
+    pMax = clamp((pMax - 0.2) / 0.8, 0.0, 1.0);
+
+    return 1.0 - pMax;
+  }
+
+  // FILTER_ESM: moments.x = exp(c * occluder depth)
+  float lit = clamp(exp(-esmExponent * currentDepth) * moments.x, 0.0, 1.0);
+
+  return 1.0 - lit;
+}
+
+vec3 calculateDirLight(vec3 normal, vec3 diffuseColor, vec3 specularColor) {
+
+  vec3 fragLightDir = -normalize(dirLight.direction);
+
+  // ambient
+  vec3 ambient = dirLight.ambient * diffuseColor;
+
+  // diffuse
+
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * dirLight.diffuse * diffuseColor;
+
+  // specular (blinn-phong)
+
+  vec3 fragCameraDir = normalize(cameraPosition - fs_in.fragPos);
+
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 64.0);
+
+  vec3 specular = dirLight.specular * spec * specularColor;
+
+  float shadow = calculateDirLightShadow(normal);
+
+  return (ambient + (1.0 - shadow) * (diffuse + specular));
+}
+
+float calculatePointLightShadow(int lightIndex) {
+
+  vec3 lightToFrag = fs_in.fragPos - pointLights[lightIndex].position;
+  float lightToFragLength = length(lightToFrag);
+
+  // normalized [0, 1]
+  float currentDepth = lightToFragLength / (pointLights[lightIndex].zFar -
+                                            pointLights[lightIndex].zNear);
+
+  if (currentDepth > 1.0) {
+    return 0.0;
+  }
+
+  float viewDistance =
+      length(cameraPosition - fs_in.fragPos) /
+      (pointLights[lightIndex].zFar - pointLights[lightIndex].zNear);
+
+  float diskRadius = (1.0 + viewDistance) / (25.0);
+
+  float bias = 0.005;
+
+  if (filterMode == FILTER_PCF) {
+
+    // clang-format off
+
+    vec3 sampleOffsetDirections[20] =  vec3[](
+        vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
+        vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+        vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
+        vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
+        vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
+    );
+
+    // clang-format on
+
+    float shadow = 0.0;
+
+    for (int i = 0; i < 20; ++i) {
+      float depth =
+          texture(pointLightShadowMaps[lightIndex],
+                  lightToFrag + sampleOffsetDirections[i] * diskRadius)
+              .r;
+
+      shadow += currentDepth - bias > depth ? 1.0 : 0.0;
+    }
+
+    return shadow / 20.0;
+  }
+
+  // disk perpendicular to the lookup direction
+  vec3 axis = abs(lightToFrag.y) < 0.99 * lightToFragLength ? vec3(0, 1, 0)
+                                                            : vec3(1, 0, 0);
+  vec3 tangent = normalize(cross(axis, lightToFrag));
+  vec3 bitangent = normalize(cross(lightToFrag, tangent));
+
+  float lit = 0.0;
+
+  if (filterMode == FILTER_POISSON) {
+
+    mat2 rotation = poissonRotation();
+
+    for (int i = 0; i < 8; ++i) {
+
+      vec2 offset = rotation * poissonDisk[i] * diskRadius;
+      vec3 dir = lightToFrag + offset.x * tangent + offset.y * bitangent;
+
+      lit += texture(pointLightShadowMapsCmp[lightIndex],
+                     vec4(dir, currentDepth - bias));
+    }
+
+    return 1.0 - lit / 8.0;
+  }
+
+  // FILTER_HARDWARE_PCF (and the prefiltered modes, which only cover the
+  // directional light): 4 bilinear compare taps
+  for (int i = 0; i < 4; ++i) {
+
+    vec2 offset = 0.5 * diskRadius * vec2(i & 1, i >> 1) - 0.25 * diskRadius;
+    vec3 dir = lightToFrag + offset.x * tangent + offset.y * bitangent;
+
+    lit += texture(pointLightShadowMapsCmp[lightIndex],
+                   vec4(dir, currentDepth - bias));
+  }
+
+  return 1.0 - lit * 0.25;
+}
+
+vec3 calculatePointLight(vec3 normal, vec3 diffuseColor, vec3 specularColor,
+                         int index) {
+
+  PointLight light = pointLights[index];
+
+  vec3 fragLightDir = normalize(light.position - fs_in.fragPos);
+  float distance = length(light.position - fs_in.fragPos);
+
+  float attenuation = 1.0 / (light.constantAtt + distance * light.linearAtt +
+                             distance * distance * light.quadraticAtt);
+
+  // ambient
+  vec3 ambient = light.ambient * diffuseColor;
+
+  // diffuse
+
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * light.diffuse * diffuseColor;
+
+  // specular (blinn-phong)
+
+  vec3 fragCameraDir = normalize(cameraPosition - fs_in.fragPos);
+
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 32.0);
+
+  vec3 specular = light.specular * spec * specularColor;
+
+  float shadow = calculatePointLightShadow(index);
+
+  return attenuation * (ambient + (1.0 - shadow) * (diffuse + specular));
+}
+
+void main() {
+
+  vec3 diffColor = vec3(texture(diffuse_texture0, fs_in.texCoords));
+  vec3 specColor = vec3(texture(specular_texture0, fs_in.texCoords));
+
+  vec3 n = normalize(fs_in.normal);
+
+  vec3 result = vec3(0.0);
+
+  result += calculateDirLight(n, diffColor, specColor);
+
+  for (int i = 0; i < nPointLights; ++i) {
+    result += calculatePointLight(n, diffColor, specColor, i);
+  }
+
+  FragColor = vec4(result, 1.0);
+}
\ No newline at end of file
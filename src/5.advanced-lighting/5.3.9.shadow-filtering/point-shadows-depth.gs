@@ -0,0 +1,26 @@
+#version 450 core
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 18) out;
+
+uniform mat4 shadowMatrices[6];
+
+out vec4 FragPos;
+
+void main() {
+
+  for (int face = 0; face < 6; ++face) {
+
+    // built-in var - the face that we are writing to
+    gl_Layer = face;
+
+    for (int i = 0; i < 3; ++i) {
+
+      FragPos = gl_in[i].gl_Position;
+      gl_Position = shadowMatrices[face] * FragPos;
+
+      EmitVertex();
+    }
+
+    EndPrimitive();
+  }
+}
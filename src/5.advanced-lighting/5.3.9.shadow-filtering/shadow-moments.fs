@@ -0,0 +1,25 @@
+#version 450 core
+
+// 0 = variance (VSM), 1 = exponential (ESM)
+uniform int momentsMode;
+uniform float esmExponent;
+
+out vec4 FragColor;
+
+void main() {
+
+  float depth = gl_FragCoord.z;
+
+  if (momentsMode == 0) {
+
+    // the derivative term approximates the variance inside the texel
+    // (reduces acne on slopes)
+    float dx = dFdx(depth);
+    float dy = dFdy(depth);
+
+    FragColor = vec4(depth, depth * depth + 0.25 * (dx * dx + dy * dy), 0.0,
+                     0.0);
+  } else {
+    FragColor = vec4(exp(esmExponent * depth), 0.0, 0.0, 0.0);
+  }
+}
\ No newline at end of file
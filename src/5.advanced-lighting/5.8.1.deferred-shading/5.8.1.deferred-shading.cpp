@@ -0,0 +1,974 @@
+#include "app.h"
+#include "basicmeshes.h"
+#include "cpuprofiler.h"
+#include "cubemap.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "gpuprofiler.h"
+#include "mesh.h"
+#include "model.h"
+#include "pointlight.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "uniformbuffer.h"
+#include "vertexarray.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+float cameraSpeed = 3.0f;
+
+float currentTime = 0.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+constexpr int SHADOW_WIDTH = 1024;
+constexpr int SHADOW_HEIGHT = 1024;
+
+constexpr int MAX_SHADOWED_LIGHTS = 4;
+constexpr int MAX_SMALL_LIGHTS = 128;
+
+constexpr float POINT_SHADOW_NEAR = 0.1f;
+constexpr float POINT_SHADOW_FAR = 25.0f;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+float shadowAspect =
+    static_cast<float>(SHADOW_WIDTH) / static_cast<float>(SHADOW_HEIGHT);
+
+float lastMouseX = static_cast<float>(WIDTH) * 0.5f;
+float lastMouseY = static_cast<float>(HEIGHT) * 0.5f;
+
+Model *suzzane;
+
+Mesh roomMesh;
+Mesh cubeMesh;
+
+gpu::texture::Texture2D containerDiffTex;
+gpu::texture::Texture2D containerSpecTex;
+
+gpu::texture::Texture2D woodTex;
+gpu::texture::Texture2D whiteTex;
+gpu::texture::Texture2D blackTex;
+
+size_t nActiveLights = 1;
+
+bool smallLightsEnabled = true;
+bool smallLightsKeyPressed = false;
+
+// P prints the gpu pass timings and writes the last frames as a chrome trace
+// (with the cpu zones too when built with ENABLE_CPU_PROFILER)
+profiler::GpuProfiler gpuProfiler;
+bool profilerKeyPressed = false;
+bool profilerReportRequested = false;
+
+FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
+                 100.0f};
+
+// the first MAX_SHADOWED_LIGHTS lights cast shadows, the rest are small
+// unshadowed lights
+std::vector<PointLight> pointLights;
+std::vector<float> pointLightRadii;
+
+gpu::Shader lightCubeShader;
+
+void drawLightCubes();
+void drawScene(const gpu::Shader &shader);
+void drawLightVolume(const gpu::Shader &shader, size_t lightIdx);
+
+void setPointShadowMatrices(const gpu::Shader &shader,
+                            const glm::vec3 &lightPos);
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // g-buffer
+  // 0: albedo (rgb) + specular intensity (a)
+  // 1: octahedral-encoded normal (2x snorm16)
+  // depth: 24 bit depth, world positions are reconstructed from it
+
+  gpu::framebuffer::Framebuffer gBuffer;
+
+  gpu::texture::Texture2D gAlbedoSpecTex{WIDTH, HEIGHT, GL_RGBA8};
+  gpu::texture::Texture2D gNormalTex{WIDTH, HEIGHT, GL_RG16_SNORM};
+  gpu::texture::Texture2D gDepthTex{WIDTH, HEIGHT, GL_DEPTH24_STENCIL8};
+
+  gAlbedoSpecTex.setMinMagFilter(gpu::texture::Filter::NEAREST);
+  gNormalTex.setMinMagFilter(gpu::texture::Filter::NEAREST);
+  gDepthTex.setMinMagFilter(gpu::texture::Filter::NEAREST);
+
+  gAlbedoSpecTex.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+  gNormalTex.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+  gDepthTex.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+
+  gBuffer.setColorAttachment(gAlbedoSpecTex, 0);
+  gBuffer.setColorAttachment(gNormalTex, 1);
+  gBuffer.setDepthStencilAttachment(gDepthTex);
+  gBuffer.setDrawBuffers(2);
+  gBuffer.checkStatus();
+
+  // shadow mapping
+
+  // directional
+
+  gpu::framebuffer::Framebuffer depthMapFramebuffer;
+  gpu::texture::Texture2D depthTexture{SHADOW_WIDTH, SHADOW_HEIGHT,
+                                       GL_DEPTH_COMPONENT16};
+
+  depthTexture.setWrapST(gpu::texture::Wrap::CLAMP_TO_BORDER);
+  depthTexture.setMinMagFilter(gpu::texture::Filter::NEAREST);
+  depthTexture.setBorderColor(glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+
+  depthMapFramebuffer.setDepthAttachment(depthTexture);
+  depthMapFramebuffer.checkStatus();
+
+  // omni
+
+  gpu::framebuffer::Framebuffer depthMapOmniFramebuffers[MAX_SHADOWED_LIGHTS];
+  for (size_t i = 0; i < MAX_SHADOWED_LIGHTS; ++i) {
+
+    auto &framebuffer = depthMapOmniFramebuffers[i];
+    gpu::texture::Cubemap depthCubemap{SHADOW_WIDTH, SHADOW_HEIGHT,
+                                       GL_DEPTH_COMPONENT16};
+
+    depthCubemap.setMinMagFilter(gpu::texture::Filter::NEAREST);
+    depthCubemap.setWrapRST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+
+    framebuffer.setDepthAttachment(depthCubemap);
+    framebuffer.checkStatus();
+  }
+
+  // uniform buffers
+
+  gpu::UniformBufferCreateInfo uboCreateInfo;
+
+  uboCreateInfo.bindingIndex = 0;
+  uboCreateInfo.nBlocks = 3;
+
+  std::string blockNames[] = {"cameraPosition", "cameraView",
+                              "cameraProjection"};
+
+  size_t blockSizes[] = {sizeof(glm::vec3), sizeof(glm::mat4),
+                         sizeof(glm::mat4)};
+
+  uboCreateInfo.pBlockNames = blockNames;
+  uboCreateInfo.pBlockSizes = blockSizes;
+
+  gpu::UniformBuffer camUniformBuffer{uboCreateInfo};
+
+  // room
+  MeshCreateInfo roomVertexDataCreateInfo;
+  roomVertexDataCreateInfo.insideOut = true;
+
+  roomMesh = createCube(roomVertexDataCreateInfo);
+
+  // cubes
+
+  cubeMesh = createCube();
+
+  containerDiffTex = gpu::texture::Texture2D{"container2.png"};
+  containerSpecTex = gpu::texture::Texture2D{"container2_specular.png"};
+
+  woodTex = gpu::texture::Texture2D{"wood.png"};
+
+  whiteTex = gpu::texture::createUnitTexture2D(glm::vec3{1.0f});
+  blackTex = gpu::texture::createUnitTexture2D(glm::vec3{0.0f});
+
+  // the fullscreen passes generate their vertices from gl_VertexID, but a
+  // vao still has to be bound
+  gpu::VertexArray emptyVAO;
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  std::stringstream monkeyModelPath;
+  monkeyModelPath << getModelPath("monkey") << separator << "monkey.obj";
+
+  suzzane = new Model{monkeyModelPath.str()};
+
+  lightCubeShader = gpu::Shader{"light-cube.vs", "light-cube.fs"};
+
+  gpu::Shader gBufferShader{"gbuffer.vs", "gbuffer.fs"};
+
+  gpu::Shader directionalShader{"deferred-quad.vs", "deferred-directional.fs"};
+
+  gpu::Shader lightVolumeShader{"light-volume.vs", "light-volume.fs"};
+
+  gpu::Shader shadowMappingDepthShader{"shadow-mapping-depth.vs",
+                                       "shadow-mapping-depth.fs"};
+
+  gpu::Shader pointShadowsDepthShader{"point-shadows-depth.vs",
+                                      "point-shadows-depth.fs",
+                                      "point-shadows-depth.gs"};
+
+  gBufferShader.setInt("diffuse_texture0", 0);
+  gBufferShader.setInt("specular_texture0", 1);
+
+  // g-buffer in units 0-2 for the lighting passes, shadow maps after that
+
+  directionalShader.setInt("gAlbedoSpec", 0);
+  directionalShader.setInt("gNormal", 1);
+  directionalShader.setInt("gDepth", 2);
+  directionalShader.setInt("dirLightShadowMap", 3);
+
+  lightVolumeShader.setInt("gAlbedoSpec", 0);
+  lightVolumeShader.setInt("gNormal", 1);
+  lightVolumeShader.setInt("gDepth", 2);
+  lightVolumeShader.setInt("pointLightShadowMap", 3);
+
+  lightVolumeShader.setVec2("screenSize", static_cast<float>(WIDTH),
+                            static_cast<float>(HEIGHT));
+
+  // point lights
+
+  {
+    {
+      PointLight light;
+      light.position = glm::vec3{-1.3f, 0.1f, -1.7f};
+      light.diffuse = glm::vec3{0.6f, 0.6f, 0.6f};
+      light.specular = glm::vec3{0.8f, 0.8f, 0.8f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{-1.8f, -0.5f, 1.7f};
+      light.diffuse = glm::vec3{0.6f, 0.6f, 0.6f};
+      light.specular = glm::vec3{0.8f, 0.8f, 0.8f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{1.4f, -0.3f, -1.9f};
+      light.diffuse = glm::vec3{0.6f, 0.6f, 0.6f};
+      light.specular = glm::vec3{0.8f, 0.8f, 0.8f};
+      pointLights.push_back(light);
+    }
+    {
+      PointLight light;
+      light.position = glm::vec3{1.7f, 0.3f, 1.5f};
+      light.diffuse = glm::vec3{0.6f, 0.6f, 0.6f};
+      light.specular = glm::vec3{0.8f, 0.8f, 0.8f};
+      pointLights.push_back(light);
+    }
+
+    for (unsigned int i = 0; i < pointLights.size(); ++i) {
+      pointLights[i].ambient = glm::vec3{0.01f};
+      pointLights[i].constantAtt = 1.0f;
+      pointLights[i].linearAtt = 0.09f;
+      pointLights[i].quadraticAtt = 0.032f;
+    }
+
+    // small colored lights close to the floor
+
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    for (size_t i = 0; i < MAX_SMALL_LIGHTS; ++i) {
+
+      glm::vec3 color = glm::normalize(
+          glm::vec3{unit(rng), unit(rng), unit(rng)});
+
+      PointLight light;
+      light.position = glm::vec3{unit(rng) * 7.0f - 3.5f, -3.7f,
+                                 unit(rng) * 7.0f - 3.5f};
+      light.ambient = glm::vec3{0.0f};
+      light.diffuse = color;
+      light.specular = color;
+      light.constantAtt = 1.0f;
+      light.linearAtt = 1.4f;
+      light.quadraticAtt = 3.6f;
+
+      pointLights.push_back(light);
+    }
+
+    for (const PointLight &light : pointLights) {
+      pointLightRadii.push_back(computeLightRadius(light));
+    }
+  }
+
+  // dirLight params
+
+  glm::vec3 lightDir = glm::vec3{0.2f, -0.4f, 0.1f};
+
+  directionalShader.setVec3("dirLight.ambient", 0.0f, 0.0f, 0.0f);
+  directionalShader.setVec3("dirLight.diffuse", 0.05f, 0.05f, 0.05f);
+  directionalShader.setVec3("dirLight.specular", 0.05f, 0.05f, 0.05f);
+  directionalShader.setVec3("dirLight.direction", lightDir);
+
+  glEnable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+
+  // if the directional light is going to be static we only need to do this once
+  // (baked shadows!)
+  {
+    glm::vec3 lightPos = -10.0f * lightDir;
+
+    glm::mat4 view = glm::lookAt(lightPos, glm::vec3{0.0f, 0.0f, 0.0f},
+                                 glm::vec3{0.0f, 1.0f, 0.0f});
+
+    // ortho, since a directional light has no perspective distoriton
+    glm::mat4 projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 7.5f);
+
+    glm::mat4 lightSpaceMatrix = projection * view;
+
+    shadowMappingDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+    directionalShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+
+    depthMapFramebuffer.bind();
+
+    {
+      using namespace gpu::framebuffer;
+
+      setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+      clear(ClearFlagBits::DEPTH_BIT);
+    }
+
+    drawScene(shadowMappingDepthShader);
+  }
+
+  gpuProfiler = profiler::GpuProfiler{profiler::GpuProfilerCreateInfo{}};
+
+  while (app::nextFrame(window)) {
+
+    CPU_PROFILE_FRAME();
+
+    currentTime = static_cast<float>(app::getTime());
+    deltaTime = currentTime - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]";
+
+      ss << " [gpu " << gpuProfiler.getStats("frame").avgMs << " ms]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = currentTime;
+
+    // input
+    {
+      CPU_PROFILE_ZONE("input");
+      process_input(window);
+    }
+
+    if (profilerReportRequested) {
+
+      std::cout << std::setw(40) << "gpu scope" << std::setw(10) << "min"
+                << std::setw(10) << "avg" << std::setw(10) << "p99"
+                << std::endl;
+
+      for (const std::string &path : gpuProfiler.getScopePaths()) {
+
+        profiler::ScopeStats stats = gpuProfiler.getStats(path);
+
+        std::cout << std::setw(40) << path << std::fixed
+                  << std::setprecision(3) << std::setw(10) << stats.minMs
+                  << std::setw(10) << stats.avgMs << std::setw(10)
+                  << stats.p99Ms << std::endl;
+      }
+
+      if (gpuProfiler.exportChromeTrace("deferred-shading-trace.json")) {
+        std::cout << "trace written to deferred-shading-trace.json"
+                  << std::endl;
+      }
+
+      profilerReportRequested = false;
+    }
+
+    gpuProfiler.beginFrame();
+
+    // first pass - point light shadows
+    {
+      CPU_PROFILE_ZONE("point shadows");
+      GPU_PROFILE_SCOPE(gpuProfiler, "point shadows");
+
+      pointShadowsDepthShader.setFloat("zNear", POINT_SHADOW_NEAR);
+      pointShadowsDepthShader.setFloat("zFar", POINT_SHADOW_FAR);
+
+      for (size_t i = 0; i < nActiveLights; ++i) {
+
+        depthMapOmniFramebuffers[i].bind();
+
+        {
+          using namespace gpu::framebuffer;
+
+          setViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+          clear(ClearFlagBits::DEPTH_BIT);
+        }
+
+        setPointShadowMatrices(pointShadowsDepthShader,
+                               pointLights[i].position);
+
+        drawScene(pointShadowsDepthShader);
+      }
+    }
+
+    // uniform buffers
+    {
+      CPU_PROFILE_ZONE("uniform buffers");
+
+      camUniformBuffer.updateSubdata("cameraPosition", camera.getPosition());
+      camUniformBuffer.updateSubdata("cameraView", camera.getViewMatrix());
+      camUniformBuffer.updateSubdata("cameraProjection",
+                                     camera.getProjectionMatrix());
+    }
+
+    // second pass - geometry, only material attributes are written so the
+    // cost of overdraw doesn't depend on the number of lights
+    {
+      CPU_PROFILE_ZONE("geometry");
+      GPU_PROFILE_SCOPE(gpuProfiler, "geometry");
+
+      gBuffer.bind();
+
+      {
+        using namespace gpu::framebuffer;
+
+        setViewport(0, 0, WIDTH, HEIGHT);
+        setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
+      }
+
+      drawScene(gBufferShader);
+    }
+
+    // third pass - lighting, every pixel is shaded once per light that
+    // reaches it
+    {
+      CPU_PROFILE_ZONE("lighting");
+      GPU_PROFILE_SCOPE(gpuProfiler, "lighting");
+
+      {
+        using namespace gpu::framebuffer;
+
+        bindDefault();
+
+        setViewport(0, 0, WIDTH, HEIGHT);
+        setClearColor(0.1f, 0.1f, 0.1f);
+        clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
+      }
+
+      glm::mat4 invViewProjection =
+          glm::inverse(camera.getViewProjectionMatrix());
+
+      glBindTextureUnit(0, gAlbedoSpecTex.getID());
+      glBindTextureUnit(1, gNormalTex.getID());
+      glBindTextureUnit(2, gDepthTex.getID());
+
+      glDisable(GL_DEPTH_TEST);
+
+      // ambient + directional light (fullscreen)
+      {
+        GPU_PROFILE_SCOPE(gpuProfiler, "directional");
+
+        glm::vec3 ambient{0.0f};
+        for (size_t i = 0; i < nActiveLights; ++i) {
+          ambient += pointLights[i].ambient;
+        }
+
+        directionalShader.setVec3("ambient", ambient);
+        directionalShader.setMat4("invViewProjection", invViewProjection);
+
+        glBindTextureUnit(3, depthTexture.getID());
+
+        directionalShader.use();
+        emptyVAO.bind();
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+      }
+
+      // point lights, additive light volumes. Only the back faces are
+      // rasterized so the volume still works with the camera inside it.
+
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_ONE, GL_ONE);
+
+      glCullFace(GL_FRONT);
+
+      lightVolumeShader.setMat4("invViewProjection", invViewProjection);
+
+      {
+        GPU_PROFILE_SCOPE(gpuProfiler, "shadowed volumes");
+
+        for (size_t i = 0; i < nActiveLights; ++i) {
+
+          lightVolumeShader.setInt("castShadows", 1);
+          glBindTextureUnit(
+              3, depthMapOmniFramebuffers[i].getDepthAttachmentID());
+
+          drawLightVolume(lightVolumeShader, i);
+        }
+      }
+
+      if (smallLightsEnabled) {
+
+        GPU_PROFILE_SCOPE(gpuProfiler, "small volumes");
+
+        lightVolumeShader.setInt("castShadows", 0);
+
+        for (size_t i = MAX_SHADOWED_LIGHTS; i < pointLights.size(); ++i) {
+          drawLightVolume(lightVolumeShader, i);
+        }
+      }
+
+      glCullFace(GL_BACK);
+      glDisable(GL_BLEND);
+
+      glEnable(GL_DEPTH_TEST);
+    }
+
+    // forward pass on top of the lit image (needs the scene depth)
+    {
+      CPU_PROFILE_ZONE("forward");
+      GPU_PROFILE_SCOPE(gpuProfiler, "forward");
+
+      glBlitNamedFramebuffer(gBuffer.getID(), 0, 0, 0, WIDTH, HEIGHT, 0, 0,
+                             WIDTH, HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+      drawLightCubes();
+    }
+
+    gpuProfiler.endFrame();
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    {
+      CPU_PROFILE_ZONE("swap");
+
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+    }
+  }
+
+  delete suzzane;
+
+  gBuffer.destroy();
+  gAlbedoSpecTex.destroy();
+  gNormalTex.destroy();
+  gDepthTex.destroy();
+
+  depthMapFramebuffer.destroy();
+  depthTexture.destroy();
+
+  emptyVAO.destroy();
+
+  gpuProfiler.destroy();
+
+  camUniformBuffer.destroy();
+
+  gBufferShader.destroy();
+  directionalShader.destroy();
+  lightVolumeShader.destroy();
+
+  containerDiffTex.destroy();
+  containerSpecTex.destroy();
+  woodTex.destroy();
+  whiteTex.destroy();
+  blackTex.destroy();
+
+  app::terminate();
+
+  return 0;
+}
+
+void setPointShadowMatrices(const gpu::Shader &shader,
+                            const glm::vec3 &lightPos) {
+
+  glm::mat4 projection = glm::perspective(
+      glm::radians(90.0f), shadowAspect, POINT_SHADOW_NEAR, POINT_SHADOW_FAR);
+
+  shader.setVec3("lightPos", lightPos);
+
+  // right face (+x)
+  shader.setMat4("shadowMatrices[0]",
+                 projection * glm::lookAt(lightPos,
+                                          lightPos + glm::vec3{1.0f, 0.0f, 0.0f},
+                                          glm::vec3{0.0f, -1.0f, 0.0f}));
+
+  // left face (-x)
+  shader.setMat4(
+      "shadowMatrices[1]",
+      projection * glm::lookAt(lightPos, lightPos + glm::vec3{-1.0f, 0.0f, 0.0f},
+                               glm::vec3{0.0f, -1.0f, 0.0f}));
+
+  // up face (+y)
+  shader.setMat4("shadowMatrices[2]",
+                 projection * glm::lookAt(lightPos,
+                                          lightPos + glm::vec3{0.0f, 1.0f, 0.0f},
+                                          glm::vec3{0.0f, 0.0f, 1.0f}));
+
+  // down face (-y)
+  shader.setMat4(
+      "shadowMatrices[3]",
+      projection * glm::lookAt(lightPos, lightPos + glm::vec3{0.0f, -1.0f, 0.0f},
+                               glm::vec3{0.0f, 0.0f, -1.0f}));
+
+  // front face (+z)
+  shader.setMat4("shadowMatrices[4]",
+                 projection * glm::lookAt(lightPos,
+                                          lightPos + glm::vec3{0.0f, 0.0f, 1.0f},
+                                          glm::vec3{0.0f, -1.0f, 0.0f}));
+
+  // back face (-z)
+  shader.setMat4(
+      "shadowMatrices[5]",
+      projection * glm::lookAt(lightPos, lightPos + glm::vec3{0.0f, 0.0f, -1.0f},
+                               glm::vec3{0.0f, -1.0f, 0.0f}));
+}
+
+void drawLightVolume(const gpu::Shader &shader, size_t lightIdx) {
+
+  const PointLight &light = pointLights[lightIdx];
+  float radius = pointLightRadii[lightIdx];
+
+  std::string prefix = "pointLight";
+
+  shader.setVec3(prefix + ".position", light.position);
+
+  shader.setVec3(prefix + ".diffuse", light.diffuse);
+  shader.setVec3(prefix + ".specular", light.specular);
+
+  shader.setFloat(prefix + ".constantAtt", light.constantAtt);
+  shader.setFloat(prefix + ".linearAtt", light.linearAtt);
+  shader.setFloat(prefix + ".quadraticAtt", light.quadraticAtt);
+
+  shader.setFloat(prefix + ".radius", radius);
+
+  shader.setFloat(prefix + ".zNear", POINT_SHADOW_NEAR);
+  shader.setFloat(prefix + ".zFar", POINT_SHADOW_FAR);
+
+  shader.setVec3("lightPosition", light.position);
+  shader.setFloat("lightRadius", radius);
+
+  shader.use();
+
+  glBindVertexArray(cubeMesh.getVAO());
+  glDrawArrays(GL_TRIANGLES, 0, cubeMesh.m_vertices.size());
+}
+
+void drawLightCubes() {
+
+  lightCubeShader.use();
+
+  for (size_t i = 0; i < nActiveLights; ++i) {
+
+    glm::mat4 model{1.0f};
+    model = glm::translate(model, pointLights[i].position);
+    model = glm::scale(model, glm::vec3{0.1f});
+
+    lightCubeShader.setMat4("model", model);
+    lightCubeShader.setVec3("lightColor",
+                            glm::normalize(pointLights[i].diffuse));
+
+    cubeMesh.draw(lightCubeShader);
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void drawScene(const gpu::Shader &shader) {
+
+  shader.use();
+
+  // room
+  {
+    glBindTextureUnit(0, woodTex.getID());
+    glBindTextureUnit(1, blackTex.getID());
+
+    glm::mat4 model{1.0f};
+    model = glm::scale(model, glm::vec3{8.0f});
+
+    shader.setMat4("model", model);
+    roomMesh.draw(shader);
+  }
+
+  // cubes
+  {
+    glBindTextureUnit(0, containerDiffTex.getID());
+    glBindTextureUnit(1, containerSpecTex.getID());
+
+    // 1
+    glm::mat4 model{1.0f};
+    model = glm::translate(model, glm::vec3{0.0f, 0.75f, 0.0});
+    model = glm::scale(model, glm::vec3{0.3f});
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+
+    // 2
+    model = glm::mat4{1.0f};
+    model = glm::translate(model, glm::vec3{2.0f, -0.25f, 1.0});
+    model = glm::rotate(model, glm::radians(35.0f),
+                        glm::normalize(glm::vec3{0.0, 1.0, 1.0}));
+    model = glm::scale(model, glm::vec3{0.5f});
+
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+
+    // 3
+    model = glm::mat4{1.0f};
+    model = glm::translate(model, glm::vec3{-1.0f, 0.0f, 2.0});
+    model = glm::rotate(model, glm::radians(60.0f),
+                        glm::normalize(glm::vec3{1.0, 0.0, 1.0}));
+    model = glm::scale(model, glm::vec3{0.25});
+
+    shader.setMat4("model", model);
+    cubeMesh.draw(shader);
+  }
+
+  // monkeys, several rows one behind the other (lots of overdraw when
+  // looking down the z axis)
+  {
+    glBindTextureUnit(0, whiteTex.getID());
+    glBindTextureUnit(1, whiteTex.getID());
+
+    for (int row = 0; row < 6; ++row) {
+      for (int col = -2; col <= 2; ++col) {
+
+        glm::mat4 model = glm::mat4{1.0f};
+
+        model = glm::translate(
+            model, glm::vec3{col * 0.8f, -1.5f, -3.0f + row * 0.6f});
+        model = glm::rotate(model, glm::radians(15.0f * currentTime),
+                            glm::vec3{0.3f, 0.4f, 0.0f});
+        model = glm::scale(model, glm::vec3{0.35f});
+
+        shader.setMat4("model", model);
+        suzzane->draw(shader);
+      }
+    }
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
+    nActiveLights = 1;
+  } else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
+    nActiveLights = 2;
+  } else if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
+    nActiveLights = 3;
+  } else if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) {
+    nActiveLights = 4;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+    if (!profilerKeyPressed) {
+      profilerReportRequested = true;
+      profilerKeyPressed = true;
+    }
+  } else {
+    profilerKeyPressed = false;
+  }
+
+  // toggle the small (unshadowed) lights
+  if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+    if (!smallLightsKeyPressed) {
+      smallLightsEnabled = !smallLightsEnabled;
+      smallLightsKeyPressed = true;
+    }
+  } else {
+    smallLightsKeyPressed = false;
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
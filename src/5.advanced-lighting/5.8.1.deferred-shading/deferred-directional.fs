@@ -0,0 +1,120 @@
+#version 450 core
+
+struct DirLight {
+
+  vec3 direction;
+
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+};
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform DirLight dirLight;
+
+// ambient term of all the point lights (it doesn't depend on the distance
+// once it's inside a light volume, so it's cheaper to add it here)
+uniform vec3 ambient;
+
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform sampler2D dirLightShadowMap;
+
+uniform mat4 invViewProjection;
+uniform mat4 lightSpaceMatrix;
+
+vec3 decodeNormal(vec2 f) {
+  vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 uv, float depth) {
+  vec4 ndc = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+  vec4 world = invViewProjection * ndc;
+  return world.xyz / world.w;
+}
+
+float calculateDirLightShadow(vec3 fragPos, vec3 normal) {
+
+  vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
+
+  vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+  projCoords = (1 + projCoords) * 0.5;
+
+  float currentDepth = projCoords.z;
+
+  if (currentDepth > 1.0) {
+    return 0.0;
+  }
+
+  float bias = max(0.001, 0.05 * (1.0 - dot(normal, -dirLight.direction)));
+
+  float shadow = 0.0;
+
+  vec2 texelSize = 1.0 / textureSize(dirLightShadowMap, 0);
+
+  for (int x = -1; x <= 1; ++x) {
+    for (int y = -1; y <= 1; ++y) {
+
+      float pcfDepth =
+          texture(dirLightShadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+
+      shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+    }
+  }
+
+  return shadow / 9.0;
+}
+
+void main() {
+
+  float depth = texture(gDepth, TexCoords).r;
+
+  if (depth == 1.0) {
+    // background, nothing was rasterized here
+    discard;
+  }
+
+  vec4 albedoSpec = texture(gAlbedoSpec, TexCoords);
+
+  vec3 diffuseColor = albedoSpec.rgb;
+  vec3 specularColor = vec3(albedoSpec.a);
+
+  vec3 normal = decodeNormal(texture(gNormal, TexCoords).rg);
+  vec3 fragPos = reconstructPosition(TexCoords, depth);
+
+  vec3 fragLightDir = -normalize(dirLight.direction);
+
+  // diffuse
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * dirLight.diffuse * diffuseColor;
+
+  // specular (blinn-phong)
+  vec3 fragCameraDir = normalize(cameraPosition - fragPos);
+
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 64.0);
+
+  vec3 specular = dirLight.specular * spec * specularColor;
+
+  float shadow = calculateDirLightShadow(fragPos, normal);
+
+  vec3 result = (ambient + dirLight.ambient) * diffuseColor +
+                (1.0 - shadow) * (diffuse + specular);
+
+  FragColor = vec4(result, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 450 core
+
+in VS_OUT {
+  vec3 normal;
+  vec2 texCoords;
+}
+fs_in;
+
+// rgb = albedo, a = specular intensity
+layout(location = 0) out vec4 gAlbedoSpec;
+// octahedral-encoded world space normal
+layout(location = 1) out vec2 gNormal;
+
+uniform sampler2D diffuse_texture0;
+uniform sampler2D specular_texture0;
+
+vec2 octWrap(vec2 v) {
+  return (1.0 - abs(v.yx)) *
+         vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n) {
+  n /= (abs(n.x) + abs(n.y) + abs(n.z));
+  return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void main() {
+  gAlbedoSpec.rgb = texture(diffuse_texture0, fs_in.texCoords).rgb;
+  gAlbedoSpec.a = texture(specular_texture0, fs_in.texCoords).r;
+
+  gNormal = encodeNormal(normalize(fs_in.normal));
+}
\ No newline at end of file
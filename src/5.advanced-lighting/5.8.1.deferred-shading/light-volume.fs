@@ -0,0 +1,152 @@
+#version 450 core
+
+struct PointLight {
+
+  vec3 position;
+
+  vec3 diffuse;
+  vec3 specular;
+
+  float constantAtt;
+  float linearAtt;
+  float quadraticAtt;
+
+  float radius;
+
+  float zNear;
+  float zFar;
+};
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+out vec4 FragColor;
+
+uniform PointLight pointLight;
+
+uniform bool castShadows;
+uniform samplerCube pointLightShadowMap;
+
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform vec2 screenSize;
+uniform mat4 invViewProjection;
+
+vec3 decodeNormal(vec2 f) {
+  vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 uv, float depth) {
+  vec4 ndc = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+  vec4 world = invViewProjection * ndc;
+  return world.xyz / world.w;
+}
+
+float calculatePointLightShadow(vec3 fragPos) {
+
+  vec3 lightToFrag = fragPos - pointLight.position;
+  float lightToFragLength = length(lightToFrag);
+
+  // normalized [0, 1]
+  float currentDepth =
+      lightToFragLength / (pointLight.zFar - pointLight.zNear);
+
+  if (currentDepth > 1.0) {
+    return 0.0;
+  }
+
+  // clang-format off
+
+  vec3 sampleOffsetDirections[20] =  vec3[](
+      vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
+      vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+      vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
+      vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
+      vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
+  );
+
+  // clang-format on
+
+  float viewDistance = length(cameraPosition - fragPos) /
+                       (pointLight.zFar - pointLight.zNear);
+
+  float diskRadius = (1.0 + viewDistance) / (25.0);
+
+  float shadow = 0.0;
+  float bias = 0.005;
+
+  int samples = 20;
+
+  for (int i = 0; i < samples; ++i) {
+    float depth = texture(pointLightShadowMap,
+                          lightToFrag + sampleOffsetDirections[i] * diskRadius)
+                      .r;
+
+    shadow += currentDepth - bias > depth ? 1.0 : 0.0;
+  }
+
+  return shadow / samples;
+}
+
+void main() {
+
+  vec2 uv = gl_FragCoord.xy / screenSize;
+
+  float depth = texture(gDepth, uv).r;
+
+  if (depth == 1.0) {
+    discard;
+  }
+
+  vec3 fragPos = reconstructPosition(uv, depth);
+
+  vec3 fragToLight = pointLight.position - fragPos;
+  float distance = length(fragToLight);
+
+  // the volume is a box, reject the corners outside the light sphere
+  if (distance > pointLight.radius) {
+    discard;
+  }
+
+  vec4 albedoSpec = texture(gAlbedoSpec, uv);
+
+  vec3 diffuseColor = albedoSpec.rgb;
+  vec3 specularColor = vec3(albedoSpec.a);
+
+  vec3 normal = decodeNormal(texture(gNormal, uv).rg);
+
+  vec3 fragLightDir = fragToLight / distance;
+
+  float attenuation =
+      1.0 / (pointLight.constantAtt + distance * pointLight.linearAtt +
+             distance * distance * pointLight.quadraticAtt);
+
+  // fade to zero at the radius so the volume borders aren't visible
+  float window = clamp(1.0 - pow(distance / pointLight.radius, 4.0), 0.0, 1.0);
+  attenuation *= window * window;
+
+  // diffuse
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * pointLight.diffuse * diffuseColor;
+
+  // specular (blinn-phong)
+  vec3 fragCameraDir = normalize(cameraPosition - fragPos);
+
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 32.0);
+
+  vec3 specular = pointLight.specular * spec * specularColor;
+
+  float shadow = castShadows ? calculatePointLightShadow(fragPos) : 0.0;
+
+  FragColor = vec4(attenuation * (1.0 - shadow) * (diffuse + specular), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+uniform vec3 lightPosition;
+uniform float lightRadius;
+
+void main() {
+  // the unit cube is [-0.5, 0.5], scale it so it encloses the light sphere
+  vec3 worldPos = lightPosition + aPos * 2.0 * lightRadius;
+
+  gl_Position = cameraProjection * cameraView * vec4(worldPos, 1.0);
+}
\ No newline at end of file
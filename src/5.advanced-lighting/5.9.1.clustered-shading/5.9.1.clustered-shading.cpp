@@ -0,0 +1,541 @@
+#include "app.h"
+#include "basicmeshes.h"
+#include "clusteredlights.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "mesh.h"
+#include "model.h"
+#include "pointlight.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "uniformbuffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <random>
+
+float cameraSpeed = 3.0f;
+
+float currentTime = 0.0f;
+
+float lastTime = 0.0f;
+float deltaTime = 0.0f;
+
+float fpsCounterTime = 0.0f;
+int nrFrames = 0;
+
+bool firstMouse = true;
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+constexpr size_t MAX_POINT_LIGHTS = 1024;
+
+constexpr float ROOM_SIZE = 20.0f;
+
+float aspect = static_cast<float>(WIDTH) / static_cast<float>(HEIGHT);
+
+float lastMouseX = static_cast<float>(WIDTH) * 0.5f;
+float lastMouseY = static_cast<float>(HEIGHT) * 0.5f;
+
+Model *suzzane;
+
+Mesh roomMesh;
+Mesh cubeMesh;
+
+gpu::texture::Texture2D containerDiffTex;
+gpu::texture::Texture2D containerSpecTex;
+
+gpu::texture::Texture2D woodTex;
+gpu::texture::Texture2D whiteTex;
+gpu::texture::Texture2D blackTex;
+
+size_t nActiveLights = 512;
+
+bool debugClusters = false;
+bool debugKeyPressed = false;
+
+FlyCamera camera{glm::vec3{0.0f, 0.0f, 3.0f}, glm::radians(45.0f), aspect, 0.1f,
+                 100.0f};
+
+std::vector<PointLight> pointLights;
+
+// orbit of each light around the y axis (radius, angular speed, phase)
+std::vector<glm::vec3> lightOrbits;
+
+gpu::Shader lightCubeShader;
+
+void drawLightCubes();
+void drawScene(const gpu::Shader &shader);
+
+void process_input(GLFWwindow *window);
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam);
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos);
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
+
+int main() {
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(message_callback, 0);
+
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+
+  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // uniform buffers
+
+  gpu::UniformBufferCreateInfo uboCreateInfo;
+
+  uboCreateInfo.bindingIndex = 0;
+  uboCreateInfo.nBlocks = 3;
+
+  std::string blockNames[] = {"cameraPosition", "cameraView",
+                              "cameraProjection"};
+
+  size_t blockSizes[] = {sizeof(glm::vec3), sizeof(glm::mat4),
+                         sizeof(glm::mat4)};
+
+  uboCreateInfo.pBlockNames = blockNames;
+  uboCreateInfo.pBlockSizes = blockSizes;
+
+  gpu::UniformBuffer camUniformBuffer{uboCreateInfo};
+
+  // light clusters (lights, cluster ranges & light indices go to the shader
+  // storage bindings 1, 2 and 3)
+
+  clustered::ClusteredLightsCreateInfo clustersCreateInfo;
+  clustered::ClusteredLights lightClusters{clustersCreateInfo};
+
+  // room
+  MeshCreateInfo roomVertexDataCreateInfo;
+  roomVertexDataCreateInfo.insideOut = true;
+
+  roomMesh = createCube(roomVertexDataCreateInfo);
+
+  // cubes
+
+  cubeMesh = createCube();
+
+  containerDiffTex = gpu::texture::Texture2D{"container2.png"};
+  containerSpecTex = gpu::texture::Texture2D{"container2_specular.png"};
+
+  woodTex = gpu::texture::Texture2D{"wood.png"};
+
+  whiteTex = gpu::texture::createUnitTexture2D(glm::vec3{1.0f});
+  blackTex = gpu::texture::createUnitTexture2D(glm::vec3{0.0f});
+
+  // vsync off
+  glfwSwapInterval(0);
+
+  std::stringstream monkeyModelPath;
+  monkeyModelPath << getModelPath("monkey") << separator << "monkey.obj";
+
+  suzzane = new Model{monkeyModelPath.str()};
+
+  lightCubeShader = gpu::Shader{"light-cube.vs", "light-cube.fs"};
+
+  gpu::Shader lightingShader{"lit-clustered.vs", "lit-clustered.fs"};
+
+  lightingShader.setInt("diffuse_texture0", 0);
+  lightingShader.setInt("specular_texture0", 1);
+
+  // point lights (random positions inside the room, each one orbiting around
+  // the y axis)
+
+  {
+    std::mt19937 rng{1337};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    float halfRoom = 0.5f * ROOM_SIZE;
+
+    for (size_t i = 0; i < MAX_POINT_LIGHTS; ++i) {
+
+      glm::vec3 color{unit(rng), unit(rng), unit(rng)};
+      color = glm::normalize(color);
+
+      PointLight light;
+      light.position =
+          glm::vec3{0.0f, (unit(rng) * 0.9f - 0.45f) * ROOM_SIZE, 0.0f};
+      light.ambient = glm::vec3{0.0f};
+      light.diffuse = color;
+      light.specular = color;
+
+      light.constantAtt = 1.0f;
+      light.linearAtt = 0.7f;
+      light.quadraticAtt = 1.8f;
+
+      pointLights.push_back(light);
+
+      float orbitRadius = unit(rng) * 0.9f * halfRoom;
+      float angularSpeed = (unit(rng) - 0.5f) * 0.5f;
+      float phase = unit(rng) * glm::two_pi<float>();
+
+      lightOrbits.push_back(glm::vec3{orbitRadius, angularSpeed, phase});
+    }
+  }
+
+  lightingShader.setVec3("ambient", glm::vec3{0.02f});
+
+  glEnable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+
+  gpu::framebuffer::setClearColor(0.1f, 0.1f, 0.1f);
+
+  while (app::nextFrame(window)) {
+
+    currentTime = static_cast<float>(app::getTime());
+    deltaTime = currentTime - lastTime;
+
+    fpsCounterTime += deltaTime;
+
+    nrFrames++;
+
+    if (fpsCounterTime > 1.0f) {
+
+      std::stringstream ss;
+      ss << "LearnOpenGL"
+         << " [" << (1000.0 / static_cast<double>(nrFrames)) << " ms/frame]"
+         << " [ " << nrFrames << " FPS]"
+         << " [" << nActiveLights << " lights, "
+         << lightClusters.getNumLightIndices() << " light indices, max "
+         << lightClusters.getMaxLightsPerCluster() << " per cluster]";
+
+      glfwSetWindowTitle(window, ss.str().c_str());
+
+      nrFrames = 0;
+      fpsCounterTime = 0.0f;
+    }
+
+    lastTime = currentTime;
+
+    // input
+    process_input(window);
+
+    // move the lights
+    for (size_t i = 0; i < nActiveLights; ++i) {
+
+      const glm::vec3 &orbit = lightOrbits[i];
+      float angle = orbit.z + orbit.y * currentTime;
+
+      pointLights[i].position.x = orbit.x * glm::cos(angle);
+      pointLights[i].position.z = orbit.x * glm::sin(angle);
+    }
+
+    // light assignment
+    lightClusters.update(camera, pointLights, nActiveLights);
+
+    {
+      using namespace gpu::framebuffer;
+
+      bindDefault();
+
+      setViewport(0, 0, WIDTH, HEIGHT);
+      clear(ClearFlagBits::COLOR_BIT | ClearFlagBits::DEPTH_BIT);
+    }
+
+    // uniform buffers
+    {
+      camUniformBuffer.updateSubdata("cameraPosition", camera.getPosition());
+      camUniformBuffer.updateSubdata("cameraView", camera.getViewMatrix());
+      camUniformBuffer.updateSubdata("cameraProjection",
+                                     camera.getProjectionMatrix());
+    }
+
+    lightClusters.setUniforms(lightingShader, WIDTH, HEIGHT);
+    lightingShader.setInt("debugClusters", debugClusters ? 1 : 0);
+
+    drawScene(lightingShader);
+    drawLightCubes();
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // sysevents and buffer swaping
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  delete suzzane;
+
+  lightClusters.destroy();
+
+  camUniformBuffer.destroy();
+
+  lightingShader.destroy();
+  lightCubeShader.destroy();
+
+  containerDiffTex.destroy();
+  containerSpecTex.destroy();
+  woodTex.destroy();
+  whiteTex.destroy();
+  blackTex.destroy();
+
+  app::terminate();
+
+  return 0;
+}
+
+void drawLightCubes() {
+
+  // light positions & colors are read from the lights storage buffer, so all
+  // the cubes are drawn in a single instanced call
+
+  lightCubeShader.use();
+  lightCubeShader.setFloat("scale", 0.05f);
+
+  glBindVertexArray(cubeMesh.getVAO());
+  glDrawArraysInstanced(GL_TRIANGLES, 0, cubeMesh.m_vertices.size(),
+                        nActiveLights);
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void drawScene(const gpu::Shader &shader) {
+
+  shader.use();
+
+  // room
+  {
+    glBindTextureUnit(0, woodTex.getID());
+    glBindTextureUnit(1, blackTex.getID());
+
+    glm::mat4 model{1.0f};
+    model = glm::scale(model, glm::vec3{ROOM_SIZE});
+
+    shader.setMat4("model", model);
+    roomMesh.draw(shader);
+  }
+
+  // grid of cubes & monkeys on the floor
+
+  constexpr int GRID_SIZE = 7;
+  float spacing = ROOM_SIZE / (GRID_SIZE + 1);
+  float floorY = -0.5f * ROOM_SIZE;
+
+  for (int i = 0; i < GRID_SIZE; ++i) {
+    for (int j = 0; j < GRID_SIZE; ++j) {
+
+      glm::vec3 position{(i - GRID_SIZE / 2) * spacing, floorY,
+                         (j - GRID_SIZE / 2) * spacing};
+
+      if ((i + j) % 2 == 0) {
+
+        glBindTextureUnit(0, containerDiffTex.getID());
+        glBindTextureUnit(1, containerSpecTex.getID());
+
+        glm::mat4 model{1.0f};
+        model = glm::translate(model, position + glm::vec3{0.0f, 0.5f, 0.0f});
+        model = glm::rotate(model, glm::radians(15.0f * (i * GRID_SIZE + j)),
+                            glm::vec3{0.0f, 1.0f, 0.0f});
+
+        shader.setMat4("model", model);
+        cubeMesh.draw(shader);
+
+      } else {
+
+        glBindTextureUnit(0, whiteTex.getID());
+        glBindTextureUnit(1, whiteTex.getID());
+
+        glm::mat4 model{1.0f};
+        model = glm::translate(model, position + glm::vec3{0.0f, 1.0f, 0.0f});
+        model = glm::rotate(model, glm::radians(15.0f * currentTime),
+                            glm::vec3{0.0f, 1.0f, 0.0f});
+
+        shader.setMat4("model", model);
+        suzzane->draw(shader);
+      }
+    }
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+}
+
+void process_input(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
+    nActiveLights = 6;
+  } else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
+    nActiveLights = 64;
+  } else if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
+    nActiveLights = 256;
+  } else if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) {
+    nActiveLights = 512;
+  } else if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS) {
+    nActiveLights = MAX_POINT_LIGHTS;
+  }
+
+  // toggle the cluster heatmap (lights per cluster)
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+    if (!debugKeyPressed) {
+      debugClusters = !debugClusters;
+      debugKeyPressed = true;
+    }
+  } else {
+    debugKeyPressed = false;
+  }
+
+  int front = 0;
+  int right = 0;
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    // in cam-space, forward-z is negative!
+    front = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    front = 1;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    right = -1;
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    right = 1;
+  }
+
+  if (front != 0 || right != 0) {
+
+    float speed = cameraSpeed * deltaTime;
+
+    glm::vec3 dirCamSpace = glm::vec3{right, 0.0f, front};
+    dirCamSpace = glm::normalize(dirCamSpace);
+
+    glm::vec3 dirWorldSpace = camera.transformDirection(dirCamSpace);
+    camera.translate(dirWorldSpace * speed);
+  }
+}
+
+void cursorPosCallback(GLFWwindow *window, double xPos, double yPos) {
+
+  float mouseX = static_cast<float>(xPos);
+  float mouseY = static_cast<float>(yPos);
+
+  if (firstMouse) {
+
+    lastMouseX = mouseX;
+    lastMouseY = mouseY;
+
+    firstMouse = false;
+  }
+
+  float xOffset = mouseX - lastMouseX;
+  float yOffset = lastMouseY - mouseY;
+
+  lastMouseX = mouseX;
+  lastMouseY = mouseY;
+
+  const float sensitivity = 0.005f;
+
+  xOffset *= sensitivity;
+  yOffset *= sensitivity;
+
+  camera.rotateTaitBryan(xOffset, yOffset);
+}
+
+void scrollCallback(GLFWwindow *window, double xOffset, double yOffset) {
+
+  float fov = glm::degrees(camera.getFov()) - static_cast<float>(yOffset);
+  fov = glm::clamp(fov, 1.0f, 45.0f);
+
+  camera.setFov(glm::radians(fov));
+}
+
+void GLAPIENTRY message_callback(GLenum source, GLenum type, GLuint id,
+                                 GLenum severity, GLsizei length,
+                                 const GLchar *message, const void *userParam) {
+
+  std::cout << "---------------------opengl-callback-start------------"
+            << std::endl;
+
+  std::cout << "message: " << message << std::endl;
+  std::cout << "type: ";
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    std::cout << "ERROR";
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    std::cout << "DEPRECATED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    std::cout << "UNDEFINED_BEHAVIOR";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    std::cout << "PORTABILITY";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    std::cout << "PERFORMANCE";
+    break;
+  case GL_DEBUG_TYPE_OTHER:
+    std::cout << "OTHER";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "id: " << id << std::endl;
+  std::cout << "severity: ";
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_NOTIFICATION:
+    std::cout << "NOTIFICATION";
+    return;
+  case GL_DEBUG_SEVERITY_LOW:
+    std::cout << "LOW";
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    std::cout << "MEDIUM";
+    break;
+  case GL_DEBUG_SEVERITY_HIGH:
+    std::cout << "HIGH";
+    break;
+  }
+  std::cout << std::endl;
+
+  std::cout << "---------------------opengl-callback-end--------------"
+            << std::endl;
+}
+
+void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+  glViewport(0, 0, width, height);
+}
@@ -0,0 +1,7 @@
+#version 450 core
+
+in vec3 lightColor;
+
+out vec4 FragColor;
+
+void main() { FragColor = vec4(lightColor, 1.0); }
\ No newline at end of file
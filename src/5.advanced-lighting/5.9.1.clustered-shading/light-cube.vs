@@ -0,0 +1,33 @@
+#version 450 core
+
+struct PointLight {
+  vec4 positionRadius;
+  vec4 ambientConstant;
+  vec4 diffuseLinear;
+  vec4 specularQuadratic;
+};
+
+layout(location = 0) in vec3 aPos;
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+layout(std430, binding = 1) readonly buffer Lights { PointLight lights[]; };
+
+uniform float scale;
+
+out vec3 lightColor;
+
+void main() {
+
+  PointLight light = lights[gl_InstanceID];
+
+  lightColor = normalize(light.diffuseLinear.xyz);
+
+  vec3 worldPos = light.positionRadius.xyz + aPos * scale;
+
+  gl_Position = cameraProjection * cameraView * vec4(worldPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#version 450 core
+
+struct PointLight {
+  vec4 positionRadius;    // xyz = position, w = radius
+  vec4 ambientConstant;   // xyz = ambient, w = constant att.
+  vec4 diffuseLinear;     // xyz = diffuse, w = linear att.
+  vec4 specularQuadratic; // xyz = specular, w = quadratic att.
+};
+
+struct ClusterRange {
+  uint offset;
+  uint count;
+};
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+layout(std430, binding = 1) readonly buffer Lights { PointLight lights[]; };
+
+layout(std430, binding = 2) readonly buffer Clusters {
+  ClusterRange clusters[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndices {
+  uint lightIndices[];
+};
+
+in VS_OUT {
+  vec3 fragPos;
+  vec3 normal;
+  vec2 texCoords;
+  float viewDepth;
+}
+fs_in;
+
+out vec4 FragColor;
+
+uniform vec3 ambient;
+
+uniform sampler2D diffuse_texture0;
+uniform sampler2D specular_texture0;
+
+uniform int clusterTilesX;
+uniform int clusterTilesY;
+uniform int clusterSlicesZ;
+
+uniform vec2 clusterTileSize;
+
+uniform float clusterZScale;
+uniform float clusterZBias;
+
+uniform bool debugClusters;
+
+uint clusterIndex() {
+
+  // same exponential slicing used by the cpu assignment
+  int slice = int(floor(log(fs_in.viewDepth) * clusterZScale + clusterZBias));
+  slice = clamp(slice, 0, clusterSlicesZ - 1);
+
+  ivec2 tile = ivec2(gl_FragCoord.xy / clusterTileSize);
+  tile = clamp(tile, ivec2(0), ivec2(clusterTilesX - 1, clusterTilesY - 1));
+
+  return uint((slice * clusterTilesY + tile.y) * clusterTilesX + tile.x);
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 fragCameraDir,
+                         vec3 diffuseColor, vec3 specularColor) {
+
+  vec3 fragToLight = light.positionRadius.xyz - fs_in.fragPos;
+  float distance = length(fragToLight);
+
+  float radius = light.positionRadius.w;
+
+  if (distance > radius) {
+    return vec3(0.0);
+  }
+
+  vec3 fragLightDir = fragToLight / distance;
+
+  float attenuation =
+      1.0 / (light.ambientConstant.w + distance * light.diffuseLinear.w +
+             distance * distance * light.specularQuadratic.w);
+
+  // fade out to exactly zero at the radius, otherwise the cluster borders
+  // become visible
+  float window = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+  attenuation *= window * window;
+
+  // ambient
+  vec3 ambient = light.ambientConstant.xyz * diffuseColor;
+
+  // diffuse
+  float diff = max(0.0, dot(fragLightDir, normal));
+  vec3 diffuse = diff * light.diffuseLinear.xyz * diffuseColor;
+
+  // specular (blinn-phong)
+  vec3 halfwayDir = normalize(fragLightDir + fragCameraDir);
+  float spec = pow(max(0.0, dot(halfwayDir, normal)), 32.0);
+  vec3 specular = spec * light.specularQuadratic.xyz * specularColor;
+
+  return attenuation * (ambient + diffuse + specular);
+}
+
+vec3 heatmap(float t) {
+  return clamp(vec3(1.5 - abs(4.0 * t - vec3(3.0, 2.0, 1.0))), 0.0, 1.0);
+}
+
+void main() {
+
+  ClusterRange cluster = clusters[clusterIndex()];
+
+  if (debugClusters) {
+    // 32+ lights in a cluster = red
+    FragColor = vec4(heatmap(float(cluster.count) / 32.0), 1.0);
+    return;
+  }
+
+  vec3 diffColor = vec3(texture(diffuse_texture0, fs_in.texCoords));
+  vec3 specColor = vec3(texture(specular_texture0, fs_in.texCoords));
+
+  vec3 n = normalize(fs_in.normal);
+  vec3 fragCameraDir = normalize(cameraPosition - fs_in.fragPos);
+
+  vec3 result = ambient * diffColor;
+
+  for (uint i = 0; i < cluster.count; ++i) {
+
+    uint lightIndex = lightIndices[cluster.offset + i];
+
+    result += calculatePointLight(lights[lightIndex], n, fragCameraDir,
+                                  diffColor, specColor);
+  }
+
+  FragColor = vec4(result, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+
+layout(std140, binding = 0) uniform Camera {
+  vec3 cameraPosition;
+  mat4 cameraView;
+  mat4 cameraProjection;
+};
+
+uniform mat4 model;
+
+out VS_OUT {
+  vec3 fragPos;
+  vec3 normal;
+  vec2 texCoords;
+  float viewDepth;
+}
+vs_out;
+
+void main() {
+
+  vec4 worldPos = model * vec4(aPos, 1.0);
+  vec4 viewPos = cameraView * worldPos;
+
+  vs_out.fragPos = vec3(worldPos);
+  vs_out.normal = transpose(inverse(mat3(model))) * aNormal;
+  vs_out.texCoords = aTexCoords;
+
+  // view space looks down -z
+  vs_out.viewDepth = -viewPos.z;
+
+  gl_Position = cameraProjection * viewPos;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "asteroidbelt.h"
+#include "compactinstance.h"
+#include "jobsystem.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// per frame cost of the animated belt of 4.10.3-asteroids-instanced: the
+// model matrices of 1M rocks recomputed from their orbit and spin, with glm
+// one rock at a time and with the sse kernel 4 rocks at a time, on 1, 2,
+// 4... threads of the job system. The sse results are compared with glm.
+// Then the same with 16 bytes gpu::CompactInstance instead of mat4, and the
+// distance between the decoded and the glm positions
+
+constexpr int N_REPEATS = 10;
+
+constexpr size_t N_ROCKS = 1000000;
+
+// simulated frame time between repeats
+constexpr float TIMESTEP = 1.0f / 60.0f;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+template <typename Fn> double averageMilliseconds(Fn &&fn) {
+
+  double total = 0.0;
+
+  for (int r = 0; r < N_REPEATS; ++r) {
+
+    auto start = Clock::now();
+    fn(static_cast<float>(r) * TIMESTEP);
+    auto end = Clock::now();
+
+    total += std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  return total / N_REPEATS;
+}
+
+float maxPositionError(const scene::AsteroidBelt &belt,
+                       const std::vector<gpu::CompactInstance> &instances,
+                       const std::vector<glm::mat4> &reference) {
+
+  float error = 0.0f;
+
+  for (size_t i = 0; i < instances.size(); ++i) {
+
+    glm::mat4 model =
+        gpu::decodeInstance(belt.getInstanceQuantization(), instances[i]);
+
+    error = std::max(error, glm::length(glm::vec3{model[3]} -
+                                        glm::vec3{reference[i][3]}));
+  }
+
+  return error;
+}
+
+float maxRelativeError(const std::vector<glm::mat4> &a,
+                       const std::vector<glm::mat4> &b) {
+
+  float error = 0.0f;
+
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (int col = 0; col < 4; ++col) {
+      for (int row = 0; row < 4; ++row) {
+        error = std::max(error, std::fabs(a[i][col][row] - b[i][col][row]) /
+                                    (1.0f + std::fabs(b[i][col][row])));
+      }
+    }
+  }
+
+  return error;
+}
+
+int main() {
+
+  unsigned int nCores = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<unsigned int> threadCounts;
+  for (unsigned int n = 1; n < nCores; n *= 2) {
+    threadCounts.push_back(n);
+  }
+  threadCounts.push_back(nCores);
+
+  scene::AsteroidBeltCreateInfo createInfo;
+  createInfo.nInstances = N_ROCKS;
+
+  scene::AsteroidBelt belt{createInfo};
+
+  std::vector<glm::mat4> reference(N_ROCKS);
+  std::vector<glm::mat4> models(N_ROCKS);
+  std::vector<gpu::CompactInstance> compactInstances(N_ROCKS);
+
+  std::cout << N_ROCKS << " animated rocks, "
+            << N_ROCKS * sizeof(glm::mat4) / (1024 * 1024)
+            << " MB of matrices or "
+            << N_ROCKS * sizeof(gpu::CompactInstance) / (1024 * 1024)
+            << " MB of compact instances per frame, average of " << N_REPEATS
+            << " frames (ms)" << std::endl;
+
+  std::cout << std::setw(8) << "threads" << std::setw(10) << "glm"
+            << std::setw(10) << "sse" << std::setw(10) << "compact"
+            << std::setw(10) << "speedup" << std::setw(14) << "max rel err"
+            << std::setw(14) << "max pos err" << std::endl;
+
+  double singleThreadedGlmMs = 0.0;
+
+  for (unsigned int nThreads : threadCounts) {
+
+    jobs::JobSystemCreateInfo jobSystemCreateInfo;
+    jobSystemCreateInfo.nThreads = nThreads;
+
+    jobs::JobSystem jobSystem{jobSystemCreateInfo};
+
+    size_t nBlocks =
+        (N_ROCKS + scene::ASTEROID_BLOCK_SIZE - 1) / scene::ASTEROID_BLOCK_SIZE;
+
+    double glmMs = averageMilliseconds([&](float time) {
+      jobSystem.parallelFor(nBlocks, 1, [&](size_t begin, size_t end) {
+        belt.computeMatricesScalar(
+            time, begin * scene::ASTEROID_BLOCK_SIZE,
+            std::min(end * scene::ASTEROID_BLOCK_SIZE, N_ROCKS),
+            reference.data());
+      });
+    });
+
+    double sseMs = averageMilliseconds(
+        [&](float time) { belt.update(time, models.data(), jobSystem); });
+
+    double compactMs = averageMilliseconds([&](float time) {
+      belt.updateCompact(time, compactInstances.data(), jobSystem);
+    });
+
+    if (nThreads == 1) {
+      singleThreadedGlmMs = glmMs;
+    }
+
+    // all hold the last repeat
+    float error = maxRelativeError(models, reference);
+    float positionError = maxPositionError(belt, compactInstances, reference);
+
+    std::cout << std::setw(8) << nThreads << std::fixed << std::setprecision(3)
+              << std::setw(10) << glmMs << std::setw(10) << sseMs
+              << std::setw(10) << compactMs << std::setw(10)
+              << std::setprecision(2) << singleThreadedGlmMs / sseMs
+              << std::setw(14) << std::scientific << error << std::setw(14)
+              << positionError << std::defaultfloat << std::endl;
+  }
+
+  return 0;
+}
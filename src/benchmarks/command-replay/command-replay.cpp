@@ -0,0 +1,150 @@
+#include "app.h"
+#include "commandbuffer.h"
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// replays a command file saved by a demo (LEARNOPENGL_CAPTURE=<file>) in a
+// loop, without the demo: the time spent in execute() is the cost of
+// submitting the commands to the driver. Run it with the file as the first
+// argument, LEARNOPENGL_HEADLESS=egl works here too
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+constexpr int N_WARMUP_REPLAYS = 10;
+constexpr int N_REPLAYS = 1000;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+int main(int argc, char **argv) {
+
+  if (argc < 2) {
+    std::cout << "usage: command-replay <command file> [replays]" << std::endl;
+    return -1;
+  }
+
+  int nReplays = argc > 2 ? std::max(1, std::atoi(argv[2])) : N_REPLAYS;
+
+  app::init();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow *window =
+      glfwCreateWindow(WIDTH, HEIGHT, "command-replay", nullptr, nullptr);
+
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  glfwSwapInterval(0);
+
+  gpu::CommandCapture capture = gpu::CommandCapture::load(argv[1]);
+
+  if (!capture.isValid()) {
+    std::cout << "Could not load " << argv[1] << std::endl;
+    app::terminate();
+    return -1;
+  }
+
+  const gpu::CommandBuffer &commands = capture.getCommands();
+
+  std::cout << argv[1] << ": " << commands.getNumCommands() << " commands, "
+            << commands.getNumDraws() << " draws, " << commands.getSizeBytes()
+            << " bytes" << std::endl;
+
+  std::cout << "objects: "
+            << capture.getNumObjects(gpu::ResourceKind::PROGRAM)
+            << " programs, "
+            << capture.getNumObjects(gpu::ResourceKind::BUFFER) << " buffers, "
+            << capture.getNumObjects(gpu::ResourceKind::VERTEX_ARRAY)
+            << " vertex arrays, "
+            << capture.getNumObjects(gpu::ResourceKind::TEXTURE)
+            << " textures, "
+            << capture.getNumObjects(gpu::ResourceKind::RENDERBUFFER)
+            << " renderbuffers, "
+            << capture.getNumObjects(gpu::ResourceKind::FRAMEBUFFER)
+            << " framebuffers" << std::endl;
+
+  // what the demos enable once at startup, outside of their commands
+  glEnable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+
+  for (int i = 0; i < N_WARMUP_REPLAYS; ++i) {
+    commands.execute();
+  }
+
+  glFinish();
+
+  // submission only: the driver queues the work, the gpu may lag behind
+  // (the final glFinish is timed separately)
+  auto start = Clock::now();
+
+  for (int i = 0; i < nReplays; ++i) {
+    commands.execute();
+  }
+
+  auto submitted = Clock::now();
+
+  glFinish();
+
+  auto finished = Clock::now();
+
+  // one replay at a time, gpu included
+  auto syncedStart = Clock::now();
+
+  for (int i = 0; i < N_WARMUP_REPLAYS; ++i) {
+    commands.execute();
+    glFinish();
+  }
+
+  auto syncedEnd = Clock::now();
+
+  double submitMs =
+      std::chrono::duration<double, std::milli>(submitted - start).count() /
+      nReplays;
+  double drainMs =
+      std::chrono::duration<double, std::milli>(finished - submitted).count();
+  double syncedMs =
+      std::chrono::duration<double, std::milli>(syncedEnd - syncedStart)
+          .count() /
+      N_WARMUP_REPLAYS;
+
+  double commandsPerSecond = commands.getNumCommands() / (submitMs * 1e-3);
+  double drawsPerSecond = commands.getNumDraws() / (submitMs * 1e-3);
+
+  std::cout << std::fixed << std::setprecision(4);
+
+  std::cout << "replays:                 " << nReplays << std::endl;
+  std::cout << "submit ms/replay:        " << submitMs << std::endl;
+  std::cout << "commands/s (submit):     " << commandsPerSecond << std::endl;
+  std::cout << "draws/s (submit):        " << drawsPerSecond << std::endl;
+  std::cout << "final glFinish ms:       " << drainMs << std::endl;
+  std::cout << "ms/replay with glFinish: " << syncedMs << std::endl;
+
+  capture.destroy();
+
+  app::terminate();
+
+  return 0;
+}
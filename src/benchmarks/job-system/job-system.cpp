@@ -0,0 +1,256 @@
+#include "jobsystem.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// jobs::JobSystem with 1, 2, 4... threads:
+//
+//  - spawn overhead: empty jobs spawned by the main thread, a binary tree of
+//    jobs that spawn and wait for their children, and std::thread per task
+//    for comparison,
+//  - parallel-for scaling: the model matrices of the asteroid field of
+//    4.10.3-asteroids-instanced (translation on a ring, scale, rotation)
+//    with several grain sizes
+
+constexpr int N_REPEATS = 10;
+
+constexpr size_t N_EMPTY_JOBS = 100000;
+
+// flat jobs spawned before each wait, less than jobs::DEQUE_CAPACITY so they
+// all go to the deque of the main thread
+constexpr size_t JOB_BATCH_SIZE = 1000;
+
+// 2^(depth + 1) - 1 jobs
+constexpr int TREE_DEPTH = 16;
+
+constexpr size_t N_THREAD_TASKS = 200;
+
+constexpr size_t N_MATRICES = 1000000;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+template <typename Fn> double averageMilliseconds(Fn &&fn) {
+
+  double total = 0.0;
+
+  for (int r = 0; r < N_REPEATS; ++r) {
+
+    auto start = Clock::now();
+    fn();
+    auto end = Clock::now();
+
+    total += std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  return total / N_REPEATS;
+}
+
+// integer hash, the same random values whatever thread computes an index
+inline uint32_t hash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+inline float random01(uint32_t index, uint32_t stream) {
+  return static_cast<float>(hash(index * 4 + stream) & 0xffffff) /
+         static_cast<float>(0x1000000);
+}
+
+void computeAsteroid(size_t i, glm::mat4 &model) {
+
+  const float radius = 150.0f;
+  const float offset = 25.0f;
+
+  float angle = static_cast<float>(i) / static_cast<float>(N_MATRICES) *
+                glm::radians(360.0f);
+
+  uint32_t index = static_cast<uint32_t>(i);
+
+  float x = std::sin(angle) * radius + (random01(index, 0) * 2.0f - 1.0f) *
+                                           offset;
+  float y = (random01(index, 1) * 2.0f - 1.0f) * offset * 0.4f;
+  float z = std::cos(angle) * radius + (random01(index, 2) * 2.0f - 1.0f) *
+                                           offset;
+
+  float random = random01(index, 3);
+
+  model = glm::translate(glm::mat4{1.0f}, glm::vec3{x, y, z});
+  model = glm::scale(model, glm::vec3{0.05f + random * 0.2f});
+  model = glm::rotate(model, random * glm::radians(360.0f),
+                      glm::vec3{0.4f, 0.6f, 0.8f});
+}
+
+void spawnTree(jobs::JobSystem &jobSystem, int depth,
+               std::atomic<size_t> &nJobs) {
+
+  nJobs.fetch_add(1, std::memory_order_relaxed);
+
+  if (depth == 0) {
+    return;
+  }
+
+  jobs::Counter counter;
+
+  jobSystem.spawn([&] { spawnTree(jobSystem, depth - 1, nJobs); }, &counter);
+  jobSystem.spawn([&] { spawnTree(jobSystem, depth - 1, nJobs); }, &counter);
+
+  jobSystem.wait(counter);
+}
+
+int main() {
+
+  unsigned int nCores = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<unsigned int> threadCounts;
+  for (unsigned int n = 1; n < nCores; n *= 2) {
+    threadCounts.push_back(n);
+  }
+  threadCounts.push_back(nCores);
+
+  // std::thread per task, the cost the job system avoids
+
+  double threadMs = averageMilliseconds([] {
+    std::vector<std::thread> threads;
+    threads.reserve(N_THREAD_TASKS);
+
+    for (size_t i = 0; i < N_THREAD_TASKS; ++i) {
+      threads.emplace_back([] {});
+    }
+
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  });
+
+  std::cout << "std::thread create + join: " << std::fixed
+            << std::setprecision(1) << threadMs * 1e6 / N_THREAD_TASKS
+            << " ns/task" << std::endl
+            << std::endl;
+
+  std::cout << "spawn overhead, average of " << N_REPEATS
+            << " runs (ns per job)" << std::endl;
+
+  std::cout << std::setw(8) << "threads" << std::setw(14) << "flat"
+            << std::setw(14) << "tree" << std::endl;
+
+  for (unsigned int nThreads : threadCounts) {
+
+    jobs::JobSystemCreateInfo createInfo;
+    createInfo.nThreads = nThreads;
+
+    jobs::JobSystem jobSystem{createInfo};
+
+    std::atomic<size_t> nRun{0};
+
+    // the first run allocates the job blocks
+    auto spawnFlat = [&] {
+      jobs::Counter counter;
+
+      for (size_t i = 0; i < N_EMPTY_JOBS; i += JOB_BATCH_SIZE) {
+
+        for (size_t j = 0; j < JOB_BATCH_SIZE; ++j) {
+          jobSystem.spawn(
+              [&] { nRun.fetch_add(1, std::memory_order_relaxed); },
+              &counter);
+        }
+
+        jobSystem.wait(counter);
+      }
+    };
+
+    spawnFlat();
+
+    double flatMs = averageMilliseconds(spawnFlat);
+
+    std::atomic<size_t> nTreeJobs{0};
+
+    double treeMs = averageMilliseconds(
+        [&] { spawnTree(jobSystem, TREE_DEPTH, nTreeJobs); });
+
+    double nJobsPerTree = static_cast<double>(nTreeJobs) / N_REPEATS;
+
+    std::cout << std::setw(8) << nThreads << std::setw(14)
+              << flatMs * 1e6 / N_EMPTY_JOBS << std::setw(14)
+              << treeMs * 1e6 / nJobsPerTree << std::endl;
+  }
+
+  std::cout << std::endl
+            << "parallel-for, " << N_MATRICES
+            << " asteroid model matrices, average of " << N_REPEATS
+            << " runs (ms)" << std::endl;
+
+  size_t grains[] = {0, 256, 16384};
+
+  std::cout << std::setw(8) << "threads";
+  for (size_t grain : grains) {
+    std::cout << std::setw(12) << "grain " + std::to_string(grain);
+  }
+  std::cout << std::setw(10) << "speedup" << std::setw(8) << "same"
+            << std::endl;
+
+  std::vector<glm::mat4> reference(N_MATRICES);
+  for (size_t i = 0; i < N_MATRICES; ++i) {
+    computeAsteroid(i, reference[i]);
+  }
+
+  std::vector<glm::mat4> models(N_MATRICES);
+
+  double singleThreadedMs = 0.0;
+
+  for (unsigned int nThreads : threadCounts) {
+
+    jobs::JobSystemCreateInfo createInfo;
+    createInfo.nThreads = nThreads;
+
+    jobs::JobSystem jobSystem{createInfo};
+
+    std::cout << std::setw(8) << nThreads << std::fixed
+              << std::setprecision(3);
+
+    double bestMs = 0.0;
+
+    for (size_t grain : grains) {
+
+      double ms = averageMilliseconds([&] {
+        jobSystem.parallelFor(N_MATRICES, grain,
+                              [&](size_t begin, size_t end) {
+                                for (size_t i = begin; i < end; ++i) {
+                                  computeAsteroid(i, models[i]);
+                                }
+                              });
+      });
+
+      bestMs = bestMs == 0.0 ? ms : std::min(bestMs, ms);
+
+      std::cout << std::setw(12) << ms;
+    }
+
+    if (nThreads == 1) {
+      singleThreadedMs = bestMs;
+    }
+
+    bool same = std::memcmp(models.data(), reference.data(),
+                            N_MATRICES * sizeof(glm::mat4)) == 0;
+
+    std::cout << std::setw(10) << std::setprecision(2)
+              << singleThreadedMs / bestMs << std::setw(8)
+              << (same ? "yes" : "NO") << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include "radixsort.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// depth sorting of n positions, std::sort (distance computed in the
+// comparator, like 4.3.2-blending-sort) against the radix sorter
+
+constexpr int N_REPEATS = 10;
+
+// camera motion between two coherent re-sorts
+constexpr float EYE_STEP = 0.05f;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// setup(r) runs before each timed fn(r), outside of the measure
+template <typename Setup, typename Fn>
+double averageMilliseconds(Setup &&setup, Fn &&fn) {
+
+  double total = 0.0;
+
+  for (int r = 0; r < N_REPEATS; ++r) {
+
+    setup(r);
+
+    auto start = Clock::now();
+    fn(r);
+    auto end = Clock::now();
+
+    total += std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  return total / N_REPEATS;
+}
+
+template <typename Fn> double averageMilliseconds(Fn &&fn) {
+  return averageMilliseconds([](int) {}, fn);
+}
+
+bool isSorted(const std::vector<glm::vec3> &positions,
+              const std::vector<uint32_t> &order, const glm::vec3 &eye) {
+
+  for (size_t i = 1; i < order.size(); ++i) {
+
+    glm::vec3 a = positions[order[i - 1]] - eye;
+    glm::vec3 b = positions[order[i]] - eye;
+
+    // some slack, the sorter may round its distances differently
+    if (glm::dot(a, a) < glm::dot(b, b) * (1.0f - 1e-6f)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main() {
+
+  srand(42);
+
+  size_t sizes[] = {1000, 10000, 100000, 1000000};
+
+  sorting::RadixSorterCreateInfo singleThreadedCreateInfo;
+  singleThreadedCreateInfo.nThreads = 1;
+
+  sorting::RadixSorterCreateInfo multiThreadedCreateInfo;
+
+  sorting::RadixSorter singleThreaded{singleThreadedCreateInfo};
+  sorting::RadixSorter multiThreaded{multiThreadedCreateInfo};
+
+  std::cout << "back to front depth sort, average of " << N_REPEATS
+            << " runs (ms), " << multiThreaded.getNumThreads()
+            << " threads for lists >= "
+            << multiThreadedCreateInfo.parallelThreshold << std::endl;
+
+  std::cout << std::setw(10) << "items" << std::setw(12) << "std::sort"
+            << std::setw(12) << "radix" << std::setw(12) << "radix mt"
+            << std::setw(12) << "coherent" << std::endl;
+
+  for (size_t n : sizes) {
+
+    std::vector<glm::vec3> positions(n);
+
+    for (glm::vec3 &position : positions) {
+      position = glm::vec3{(rand() % 20000) / 100.0f - 100.0f,
+                           (rand() % 20000) / 100.0f - 100.0f,
+                           (rand() % 20000) / 100.0f - 100.0f};
+    }
+
+    glm::vec3 eye{0.0f, 0.0f, 0.0f};
+
+    std::vector<glm::vec3> copy;
+
+    double stdSortMs = averageMilliseconds(
+        [&](int) { copy = positions; },
+        [&](int) {
+          std::sort(copy.begin(), copy.end(),
+                    [eye](glm::vec3 a, glm::vec3 b) {
+                      a -= eye;
+                      b -= eye;
+                      return glm::dot(a, a) > glm::dot(b, b);
+                    });
+        });
+
+    double radixMs = averageMilliseconds([&](int) {
+      singleThreaded.sortByDistance(positions.data(), n, eye,
+                                    sorting::SortOrder::BACK_TO_FRONT);
+    });
+
+    double radixMtMs = averageMilliseconds([&](int) {
+      multiThreaded.sortByDistance(positions.data(), n, eye,
+                                   sorting::SortOrder::BACK_TO_FRONT);
+    });
+
+    bool sorted = isSorted(positions, singleThreaded.getOrder(), eye) &&
+                  isSorted(positions, multiThreaded.getOrder(), eye);
+
+    // the eye moves a bit each run, the previous order is nearly sorted
+    int nCoherent = 0;
+
+    double coherentMs = averageMilliseconds([&](int r) {
+      eye = glm::vec3{EYE_STEP * (r + 1), 0.0f, 0.0f};
+
+      multiThreaded.sortByDistance(positions.data(), n, eye,
+                                   sorting::SortOrder::BACK_TO_FRONT, true);
+
+      nCoherent += multiThreaded.wasCoherent() ? 1 : 0;
+    });
+
+    sorted = sorted && isSorted(positions, multiThreaded.getOrder(), eye);
+
+    std::cout << std::setw(10) << n << std::fixed << std::setprecision(3)
+              << std::setw(12) << stdSortMs << std::setw(12) << radixMs
+              << std::setw(12) << radixMtMs << std::setw(12) << coherentMs
+              << "  (" << nCoherent << "/" << N_REPEATS << " coherent)"
+              << (sorted ? "" : "  NOT SORTED") << std::endl;
+  }
+
+  return 0;
+}
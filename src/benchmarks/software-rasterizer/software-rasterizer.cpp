@@ -0,0 +1,273 @@
+#include "basicmeshes.h"
+#include "radixsort.h"
+#include "resources.h"
+#include "softwarerasterizer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// the scene of 5.3.3.shadow-mapping (a floor and a field of boxes lit by a
+// directional light) drawn by swr::Rasterizer with 1, 2, 4... threads: a
+// shadow map pass with DepthShader and a pass with ShadowShader, at a fixed
+// camera path so every thread count draws the same frames
+
+constexpr int WIDTH = 1280;
+constexpr int HEIGHT = 720;
+
+constexpr int SHADOW_SIZE = 2048;
+
+constexpr int N_FRAMES = 30;
+
+// boxes per side
+constexpr int GRID_SIZE = 24;
+
+// camera turn between two frames (radians)
+constexpr float CAMERA_STEP = 0.02f;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Scene {
+
+  MeshData floor;
+  MeshData cube;
+
+  std::vector<glm::mat4> cubeModels;
+  std::vector<glm::vec3> cubePositions;
+
+  swr::Texture floorTexture;
+  swr::Texture cubeDiffuse;
+  swr::Texture cubeSpecular;
+
+  swr::Material floorMaterial;
+  swr::Material cubeMaterial;
+
+  glm::vec3 lightDirection;
+  glm::mat4 lightSpaceMatrix;
+};
+
+Scene createScene() {
+
+  Scene scene;
+
+  MeshCreateInfo floorCreateInfo;
+  floorCreateInfo.scale = glm::vec3{30.0f};
+
+  scene.floor = createQuadMeshData(floorCreateInfo);
+
+  // the texture repeats every 2 units
+  for (Vertex &vertex : scene.floor.vertices) {
+    vertex.texCoords = glm::vec2{vertex.position.x, vertex.position.z} * 0.5f;
+  }
+
+  scene.cube = createCubeMeshData();
+
+  for (int z = 0; z < GRID_SIZE; ++z) {
+    for (int x = 0; x < GRID_SIZE; ++x) {
+
+      float height = 0.5f + static_cast<float>((x * 7 + z * 13) % 5) * 0.4f;
+
+      glm::vec3 position{(x - GRID_SIZE / 2) * 2.0f, height * 0.5f,
+                         (z - GRID_SIZE / 2) * 2.0f};
+
+      glm::mat4 model = glm::translate(glm::mat4{1.0f}, position);
+      model = glm::rotate(model, static_cast<float>(x + z) * 0.3f,
+                          glm::vec3{0.0f, 1.0f, 0.0f});
+      model = glm::scale(model, glm::vec3{1.0f, height, 1.0f});
+
+      scene.cubeModels.push_back(model);
+      scene.cubePositions.push_back(glm::vec3{model[3]});
+    }
+  }
+
+  scene.floorTexture = swr::Texture::load(getTexturePath("wood.png"));
+  scene.cubeDiffuse = swr::Texture::load(getTexturePath("container2.png"));
+  scene.cubeSpecular =
+      swr::Texture::load(getTexturePath("container2_specular.png"));
+
+  scene.floorMaterial.diffuse = &scene.floorTexture;
+  scene.floorMaterial.specularColor = glm::vec3{0.2f};
+
+  scene.cubeMaterial.diffuse = &scene.cubeDiffuse;
+  scene.cubeMaterial.specular = &scene.cubeSpecular;
+  scene.cubeMaterial.shininess = 64.0f;
+
+  scene.lightDirection = glm::normalize(glm::vec3{-0.4f, -1.0f, -0.3f});
+
+  glm::mat4 lightView =
+      glm::lookAt(-scene.lightDirection * 40.0f, glm::vec3{0.0f},
+                  glm::vec3{0.0f, 1.0f, 0.0f});
+  glm::mat4 lightProjection =
+      glm::ortho(-35.0f, 35.0f, -35.0f, 35.0f, 1.0f, 80.0f);
+
+  scene.lightSpaceMatrix = lightProjection * lightView;
+
+  return scene;
+}
+
+// front to back, then the floor: occluded blocks are skipped by the
+// hierarchical depth test before they are shaded
+void drawScene(swr::Rasterizer &rasterizer, const Scene &scene,
+               const swr::ShadowShader &shader,
+               sorting::RadixSorter &sorter) {
+
+  sorter.sortByDistance(scene.cubePositions.data(),
+                        scene.cubePositions.size(), shader.viewPos,
+                        sorting::SortOrder::FRONT_TO_BACK);
+
+  for (uint32_t i : sorter.getOrder()) {
+    rasterizer.draw(scene.cube, scene.cubeModels[i], shader,
+                    scene.cubeMaterial);
+  }
+
+  rasterizer.draw(scene.floor, glm::mat4{1.0f}, shader, scene.floorMaterial);
+}
+
+void renderFrame(swr::Rasterizer &rasterizer, sorting::RadixSorter &sorter,
+                 const Scene &scene, swr::RenderTarget &shadowMap,
+                 swr::RenderTarget &target, int frame) {
+
+  // shadow map
+
+  rasterizer.clear(shadowMap, glm::vec4{0.0f});
+  rasterizer.setViewProjection(scene.lightSpaceMatrix);
+
+  rasterizer.draw(scene.floor, glm::mat4{1.0f}, swr::DepthShader{});
+
+  for (const glm::mat4 &model : scene.cubeModels) {
+    rasterizer.draw(scene.cube, model, swr::DepthShader{});
+  }
+
+  rasterizer.flush(shadowMap);
+
+  // lit scene
+
+  float angle = static_cast<float>(frame) * CAMERA_STEP;
+
+  glm::vec3 cameraPos{std::sin(angle) * 22.0f, 9.0f, std::cos(angle) * 22.0f};
+
+  glm::mat4 view = glm::lookAt(cameraPos, glm::vec3{0.0f, 0.0f, 0.0f},
+                               glm::vec3{0.0f, 1.0f, 0.0f});
+  glm::mat4 projection =
+      glm::perspective(glm::radians(45.0f),
+                       static_cast<float>(WIDTH) / HEIGHT, 0.1f, 100.0f);
+
+  swr::ShadowShader shader;
+  shader.viewPos = cameraPos;
+  shader.direction = scene.lightDirection;
+  shader.lightSpaceMatrix = scene.lightSpaceMatrix;
+  shader.shadowMap = &shadowMap;
+
+  rasterizer.clear(target, glm::vec4{0.1f, 0.1f, 0.1f, 1.0f});
+  rasterizer.setViewProjection(projection * view);
+
+  drawScene(rasterizer, scene, shader, sorter);
+
+  rasterizer.flush(target);
+}
+
+// FNV-1a of the color buffer
+uint64_t hashImage(const swr::RenderTarget &target) {
+
+  uint64_t hash = 14695981039346656037ull;
+
+  for (uint32_t color : target.getColorBuffer()) {
+    hash = (hash ^ color) * 1099511628211ull;
+  }
+
+  return hash;
+}
+
+int main() {
+
+  Scene scene = createScene();
+
+  unsigned int nCores = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<unsigned int> threadCounts;
+  for (unsigned int n = 1; n < nCores; n *= 2) {
+    threadCounts.push_back(n);
+  }
+  threadCounts.push_back(nCores);
+
+  size_t nTrianglesPerFrame =
+      2 * (scene.floor.vertices.size() +
+           scene.cube.vertices.size() * scene.cubeModels.size()) /
+      3;
+
+  std::cout << "software rasterizer, " << WIDTH << "x" << HEIGHT << " + "
+            << SHADOW_SIZE << "x" << SHADOW_SIZE << " shadow map, "
+            << nTrianglesPerFrame << " triangles per frame, " << N_FRAMES
+            << " frames" << std::endl;
+
+  std::cout << std::setw(8) << "threads" << std::setw(12) << "ms/frame"
+            << std::setw(14) << "Mtris/s" << std::setw(14) << "Mpixels/s"
+            << std::setw(10) << "speedup" << std::setw(12) << "culled %"
+            << std::setw(10) << "same" << std::endl;
+
+  double singleThreadedMs = 0.0;
+  uint64_t referenceHash = 0;
+
+  swr::RenderTarget shadowMap{SHADOW_SIZE, SHADOW_SIZE, false};
+  swr::RenderTarget target{WIDTH, HEIGHT};
+
+  for (unsigned int nThreads : threadCounts) {
+
+    swr::RasterizerCreateInfo createInfo;
+    createInfo.nThreads = nThreads;
+
+    swr::Rasterizer rasterizer{createInfo};
+
+    sorting::RadixSorterCreateInfo sorterCreateInfo;
+    sorterCreateInfo.nThreads = 1;
+
+    sorting::RadixSorter sorter{sorterCreateInfo};
+
+    // warm up (first touch of the bins and the buffers)
+    renderFrame(rasterizer, sorter, scene, shadowMap, target, 0);
+    rasterizer.resetStats();
+
+    auto start = Clock::now();
+
+    for (int frame = 0; frame < N_FRAMES; ++frame) {
+      renderFrame(rasterizer, sorter, scene, shadowMap, target, frame);
+    }
+
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    double ms = seconds * 1000.0 / N_FRAMES;
+
+    const swr::RasterizerStats &stats = rasterizer.getStats();
+
+    if (nThreads == 1) {
+      singleThreadedMs = ms;
+      referenceHash = hashImage(target);
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << std::setw(8) << nThreads
+              << std::setw(12) << ms << std::setw(14)
+              << stats.nTriangles / seconds * 1e-6 << std::setw(14)
+              << stats.nShadedPixels / seconds * 1e-6 << std::setw(10)
+              << singleThreadedMs / ms << std::setw(12)
+              << 100.0 * stats.nCulledBlocks /
+                     std::max<uint64_t>(stats.nTestedBlocks, 1)
+              << std::setw(10)
+              << (hashImage(target) == referenceHash ? "yes" : "NO")
+              << std::endl;
+  }
+
+  std::string imagePath =
+      getExecPath().append("software-rasterizer.ppm").string();
+
+  if (target.writePPM(imagePath)) {
+    std::cout << "last frame written to " << imagePath << std::endl;
+  }
+
+  return 0;
+}
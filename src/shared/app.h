@@ -0,0 +1,341 @@
+#ifndef APP_H
+#define APP_H
+
+#include "filesystem.h"
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/**
+ * Window/main loop harness shared by the demos, so they can be run as
+ * reproducible benchmarks. The demos call
+ *
+ *  app::init()               instead of glfwInit()
+ *  app::getTime()            instead of glfwGetTime()
+ *  app::nextFrame(window)    instead of !glfwWindowShouldClose(window)
+ *  app::terminate()          instead of glfwTerminate()
+ *
+ * and behave as before unless LEARNOPENGL_FRAMES is set. Then:
+ *
+ *  - the demo runs that many frames and exits,
+ *  - getTime() is simulated: frame * LEARNOPENGL_TIMESTEP (1/60 by default),
+ *    so animations and the camera movement don't depend on the frame rate,
+ *  - every frame ends with a glFinish, so the frame times include the gpu,
+ *  - a json report (load time, frame time percentiles, peak memory) is
+ *    written to LEARNOPENGL_REPORT, or stdout.
+ *
+ * LEARNOPENGL_HEADLESS=egl|osmesa runs without a window system (glfw's null
+ * platform, glfw 3.4+): an EGL surfaceless context (Mesa llvmpipe with
+ * LIBGL_ALWAYS_SOFTWARE=1) or OSMesa. With older glfw versions the window is
+ * only hidden. The resolution is the demo's own fixed window size.
+ */
+namespace app {
+
+enum class Headless { NONE = 0, EGL, OSMESA };
+
+struct AppSettings {
+
+  AppSettings() {}
+
+  // 0: interactive, the demo runs until its window is closed
+  int nFrames = 0;
+
+  // first frames left out of the frame time statistics (lazy allocations,
+  // shader compilation in the driver)
+  int nWarmupFrames = 10;
+
+  double timestep = 1.0 / 60.0;
+
+  Headless headless = Headless::NONE;
+
+  // empty: stdout
+  std::string reportPath;
+};
+
+struct AppState {
+
+  AppSettings settings;
+
+  std::chrono::steady_clock::time_point initTime;
+  std::chrono::steady_clock::time_point frameStartTime;
+
+  double loadMilliseconds = 0.0;
+
+  int frameIndex = 0;
+  std::vector<double> frameMilliseconds;
+
+  int width = 0;
+  int height = 0;
+
+  std::string renderer;
+  std::string version;
+};
+
+inline AppState &getState() {
+  static AppState state;
+  return state;
+}
+
+inline const char *getHeadlessName(Headless headless) {
+
+  switch (headless) {
+  case Headless::EGL:
+    return "egl";
+  case Headless::OSMESA:
+    return "osmesa";
+  default:
+    return "none";
+  }
+}
+
+inline AppSettings readSettingsFromEnvironment() {
+
+  AppSettings settings;
+
+  if (const char *frames = std::getenv("LEARNOPENGL_FRAMES")) {
+    settings.nFrames = std::max(0, std::atoi(frames));
+  }
+
+  if (const char *warmup = std::getenv("LEARNOPENGL_WARMUP_FRAMES")) {
+    settings.nWarmupFrames = std::max(0, std::atoi(warmup));
+  }
+
+  if (const char *timestep = std::getenv("LEARNOPENGL_TIMESTEP")) {
+    settings.timestep = std::atof(timestep);
+  }
+
+  if (const char *headless = std::getenv("LEARNOPENGL_HEADLESS")) {
+
+    std::string value{headless};
+
+    if (value == "egl" || value == "1") {
+      settings.headless = Headless::EGL;
+    } else if (value == "osmesa") {
+      settings.headless = Headless::OSMESA;
+    }
+  }
+
+  if (const char *report = std::getenv("LEARNOPENGL_REPORT")) {
+    settings.reportPath = report;
+  }
+
+  return settings;
+}
+
+inline bool isBenchmark() { return getState().settings.nFrames > 0; }
+
+inline bool init() {
+
+  AppState &state = getState();
+
+  state.settings = readSettingsFromEnvironment();
+  state.initTime = std::chrono::steady_clock::now();
+
+  bool headless = state.settings.headless != Headless::NONE;
+
+#ifdef GLFW_PLATFORM_NULL
+  if (headless) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
+
+  if (!glfwInit()) {
+    return false;
+  }
+
+  if (headless) {
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+#ifdef GLFW_PLATFORM_NULL
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+                   state.settings.headless == Headless::OSMESA
+                       ? GLFW_OSMESA_CONTEXT_API
+                       : GLFW_EGL_CONTEXT_API);
+#endif
+  }
+
+  return true;
+}
+
+inline double getTime() {
+
+  const AppState &state = getState();
+
+  if (state.settings.nFrames > 0) {
+    return static_cast<double>(state.frameIndex) * state.settings.timestep;
+  }
+
+  return glfwGetTime();
+}
+
+/**
+ * Called at the start of every frame, false when the demo has to stop.
+ */
+inline bool nextFrame(GLFWwindow *window) {
+
+  AppState &state = getState();
+
+  if (state.settings.nFrames <= 0) {
+    return !glfwWindowShouldClose(window);
+  }
+
+  if (state.frameStartTime == std::chrono::steady_clock::time_point{}) {
+
+    // first frame, everything before it is loading
+    state.frameStartTime = std::chrono::steady_clock::now();
+
+    state.loadMilliseconds =
+        std::chrono::duration<double, std::milli>(state.frameStartTime -
+                                                  state.initTime)
+            .count();
+
+    glfwGetFramebufferSize(window, &state.width, &state.height);
+
+    state.renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    state.version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+
+    return !glfwWindowShouldClose(window);
+  }
+
+  glFinish();
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  state.frameMilliseconds.push_back(
+      std::chrono::duration<double, std::milli>(now - state.frameStartTime)
+          .count());
+
+  state.frameStartTime = now;
+
+  ++state.frameIndex;
+
+  return state.frameIndex < state.settings.nFrames &&
+         !glfwWindowShouldClose(window);
+}
+
+// peak resident set size of the process, 0 where it isn't implemented
+inline size_t getPeakMemoryBytes() {
+
+#if defined(__linux__)
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#elif defined(__APPLE__)
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  return 0;
+#endif
+}
+
+// nearest rank
+inline double getPercentile(const std::vector<double> &sorted,
+                            double percentile) {
+
+  if (sorted.empty()) {
+    return 0.0;
+  }
+
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+inline void writeReport(std::ostream &out) {
+
+  const AppState &state = getState();
+
+  size_t nWarmup = std::min(static_cast<size_t>(state.settings.nWarmupFrames),
+                            state.frameMilliseconds.size());
+
+  std::vector<double> sorted{state.frameMilliseconds.begin() + nWarmup,
+                             state.frameMilliseconds.end()};
+  std::sort(sorted.begin(), sorted.end());
+
+  double total = 0.0;
+  for (double ms : state.frameMilliseconds) {
+    total += ms;
+  }
+
+  double measured = 0.0;
+  for (double ms : sorted) {
+    measured += ms;
+  }
+
+  double average =
+      sorted.empty() ? 0.0 : measured / static_cast<double>(sorted.size());
+
+  out << "{\n"
+      << "  \"demo\": \"" << getExecPath().filename().string() << "\",\n"
+      << "  \"renderer\": \"" << state.renderer << "\",\n"
+      << "  \"version\": \"" << state.version << "\",\n"
+      << "  \"headless\": \"" << getHeadlessName(state.settings.headless)
+      << "\",\n"
+      << "  \"width\": " << state.width << ",\n"
+      << "  \"height\": " << state.height << ",\n"
+      << "  \"frames\": " << state.frameMilliseconds.size() << ",\n"
+      << "  \"warmup_frames\": " << nWarmup << ",\n"
+      << "  \"timestep\": " << state.settings.timestep << ",\n"
+      << "  \"load_ms\": " << state.loadMilliseconds << ",\n"
+      << "  \"total_ms\": " << total << ",\n"
+      << "  \"frame_ms\": {\n"
+      << "    \"min\": " << (sorted.empty() ? 0.0 : sorted.front()) << ",\n"
+      << "    \"avg\": " << average << ",\n"
+      << "    \"p50\": " << getPercentile(sorted, 50.0) << ",\n"
+      << "    \"p90\": " << getPercentile(sorted, 90.0) << ",\n"
+      << "    \"p95\": " << getPercentile(sorted, 95.0) << ",\n"
+      << "    \"p99\": " << getPercentile(sorted, 99.0) << ",\n"
+      << "    \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << "\n"
+      << "  },\n"
+      << "  \"peak_memory_bytes\": " << getPeakMemoryBytes() << "\n"
+      << "}\n";
+}
+
+/**
+ * Writes the benchmark report (if the demo ran any frame) and terminates
+ * glfw.
+ */
+inline void terminate() {
+
+  const AppState &state = getState();
+
+  if (state.settings.nFrames > 0 && !state.frameMilliseconds.empty()) {
+
+    if (state.settings.reportPath.empty()) {
+      writeReport(std::cout);
+    } else {
+
+      std::ofstream report{state.settings.reportPath};
+
+      if (report) {
+        writeReport(report);
+      } else {
+        std::cout << "Could not write the report to "
+                  << state.settings.reportPath << std::endl;
+      }
+    }
+  }
+
+  glfwTerminate();
+}
+
+} // namespace app
+
+#endif // APP_H
@@ -0,0 +1,489 @@
+#ifndef ASTEROID_BELT_H
+#define ASTEROID_BELT_H
+
+#include "compactinstance.h"
+#include "cpuprofiler.h"
+#include "jobsystem.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASTEROID_BELT_SSE 1
+#endif
+
+namespace scene {
+
+// instances per job system task, a multiple of the simd width
+constexpr size_t ASTEROID_BLOCK_SIZE = 1024;
+
+struct AsteroidBeltCreateInfo {
+
+  AsteroidBeltCreateInfo() {}
+
+  size_t nInstances = 100000;
+
+  // the rocks are spread around a circle of this radius, up to offset away
+  // from it (0.4 * offset vertically)
+  float radius = 150.0f;
+  float offset = 25.0f;
+
+  float minScale = 0.05f;
+  float maxScale = 0.25f;
+
+  // radians per second at the radius, slower further out (kepler)
+  float orbitSpeed = 0.05f;
+
+  // radians per second, random in [-maxSpinSpeed, maxSpinSpeed]
+  float maxSpinSpeed = 1.0f;
+
+  uint32_t seed = 0;
+};
+
+/**
+ * A ring of rocks orbiting around the origin and spinning around their own
+ * axis, as in 4.10.3-asteroids-instanced but animated. The state of each rock
+ * is stored as one array per parameter, so that matrices can be computed for
+ * 4 rocks at a time:
+ *
+ *  model = translate(orbit position) * scale * rotate(spin axis, spin angle)
+ *
+ * the same matrix glm::translate/scale/rotate give (the rotation written
+ * out), computeMatricesScalar() is that reference. Or as 16 bytes
+ * gpu::CompactInstance, quantized over the range of the belt.
+ */
+class AsteroidBelt {
+
+public:
+  AsteroidBelt() {}
+
+  AsteroidBelt(const AsteroidBeltCreateInfo &createInfo) {
+
+    size_t n = createInfo.nInstances;
+
+    float outerRadius = createInfo.radius + createInfo.offset;
+    float height = 0.4f * createInfo.offset;
+
+    m_quantization.min = glm::vec4{-outerRadius, -height, -outerRadius,
+                                   createInfo.minScale};
+    m_quantization.extent =
+        glm::max(glm::vec4{2.0f * outerRadius, 2.0f * height,
+                           2.0f * outerRadius,
+                           createInfo.maxScale - createInfo.minScale},
+                 glm::vec4{1e-6f});
+
+    m_orbitAngles.resize(n);
+    m_orbitSpeeds.resize(n);
+    m_orbitRadii.resize(n);
+    m_heights.resize(n);
+    m_axesX.resize(n);
+    m_axesY.resize(n);
+    m_axesZ.resize(n);
+    m_spinAngles.resize(n);
+    m_spinSpeeds.resize(n);
+    m_scales.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+
+      uint32_t index = static_cast<uint32_t>(i) ^ createInfo.seed;
+
+      float radius = createInfo.radius +
+                     random(index, 0, -1.0f, 1.0f) * createInfo.offset;
+
+      m_orbitAngles[i] = static_cast<float>(i) / static_cast<float>(n) *
+                         glm::radians(360.0f);
+      m_orbitRadii[i] = radius;
+      m_orbitSpeeds[i] = createInfo.orbitSpeed *
+                         std::pow(createInfo.radius / radius, 1.5f);
+      m_heights[i] =
+          random(index, 1, -1.0f, 1.0f) * createInfo.offset * 0.4f;
+
+      glm::vec3 axis{random(index, 2, -1.0f, 1.0f),
+                     random(index, 3, -1.0f, 1.0f),
+                     random(index, 4, -1.0f, 1.0f)};
+
+      axis = glm::dot(axis, axis) > 1e-4f ? glm::normalize(axis)
+                                          : glm::vec3{0.0f, 1.0f, 0.0f};
+
+      m_axesX[i] = axis.x;
+      m_axesY[i] = axis.y;
+      m_axesZ[i] = axis.z;
+
+      m_spinAngles[i] = random(index, 5, 0.0f, glm::radians(360.0f));
+      m_spinSpeeds[i] = random(index, 6, -1.0f, 1.0f) *
+                        createInfo.maxSpinSpeed;
+      m_scales[i] =
+          random(index, 7, createInfo.minScale, createInfo.maxScale);
+    }
+  }
+
+  inline size_t getNumInstances() const { return m_scales.size(); }
+
+  // what the compact instances are quantized over, for the shader
+  inline const gpu::InstanceQuantization &getInstanceQuantization() const {
+    return m_quantization;
+  }
+
+  /**
+   * The model matrices of all the rocks at time seconds, split across the
+   * job system. out can be mapped gpu memory, it is only written.
+   */
+  void update(float time, glm::mat4 *out,
+              jobs::JobSystem &jobSystem = jobs::getJobSystem()) const {
+
+    CPU_PROFILE_ZONE("AsteroidBelt::update");
+
+    forEachBlock(jobSystem, [&](size_t begin, size_t end) {
+      computeMatrices(time, begin, end, out);
+    });
+  }
+
+  // update() with 16 bytes per rock instead of 64
+  void updateCompact(float time, gpu::CompactInstance *out,
+                     jobs::JobSystem &jobSystem = jobs::getJobSystem()) const {
+
+    CPU_PROFILE_ZONE("AsteroidBelt::updateCompact");
+
+    forEachBlock(jobSystem, [&](size_t begin, size_t end) {
+      computeCompactInstances(time, begin, end, out);
+    });
+  }
+
+  /**
+   * Model matrices of the rocks [begin, end), 4 at a time on sse: the 16
+   * components are computed for 4 rocks in the lanes of 16 registers, then
+   * each column is transposed back into the 4 matrices.
+   */
+  void computeMatrices(float time, size_t begin, size_t end,
+                       glm::mat4 *out) const {
+
+#ifdef ASTEROID_BELT_SSE
+    // streaming stores when the output allows it, the matrices are not read
+    // back by the cpu
+    bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+
+    __m128 t = _mm_set1_ps(time);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+
+    size_t i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+
+      __m128 orbitAngle = _mm_add_ps(
+          _mm_loadu_ps(&m_orbitAngles[i]),
+          _mm_mul_ps(_mm_loadu_ps(&m_orbitSpeeds[i]), t));
+      __m128 spinAngle =
+          _mm_add_ps(_mm_loadu_ps(&m_spinAngles[i]),
+                     _mm_mul_ps(_mm_loadu_ps(&m_spinSpeeds[i]), t));
+
+      __m128 sinOrbit, cosOrbit, s, c;
+      sinCos(orbitAngle, sinOrbit, cosOrbit);
+      sinCos(spinAngle, s, c);
+
+      __m128 radius = _mm_loadu_ps(&m_orbitRadii[i]);
+      __m128 scale = _mm_loadu_ps(&m_scales[i]);
+
+      __m128 ax = _mm_loadu_ps(&m_axesX[i]);
+      __m128 ay = _mm_loadu_ps(&m_axesY[i]);
+      __m128 az = _mm_loadu_ps(&m_axesZ[i]);
+
+      // rotation, times the scale: c + (1 - c) * a * a^T + s * [a]x
+      __m128 oneMinusC = _mm_sub_ps(one, c);
+
+      __m128 tx = _mm_mul_ps(oneMinusC, ax);
+      __m128 ty = _mm_mul_ps(oneMinusC, ay);
+      __m128 tz = _mm_mul_ps(oneMinusC, az);
+
+      __m128 sx = _mm_mul_ps(s, ax);
+      __m128 sy = _mm_mul_ps(s, ay);
+      __m128 sz = _mm_mul_ps(s, az);
+
+      __m128 txy = _mm_mul_ps(tx, ay);
+      __m128 txz = _mm_mul_ps(tx, az);
+      __m128 tyz = _mm_mul_ps(ty, az);
+
+      __m128 columns[4][4] = {
+          {_mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(tx, ax)), scale),
+           _mm_mul_ps(_mm_add_ps(txy, sz), scale),
+           _mm_mul_ps(_mm_sub_ps(txz, sy), scale), zero},
+          {_mm_mul_ps(_mm_sub_ps(txy, sz), scale),
+           _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(ty, ay)), scale),
+           _mm_mul_ps(_mm_add_ps(tyz, sx), scale), zero},
+          {_mm_mul_ps(_mm_add_ps(txz, sy), scale),
+           _mm_mul_ps(_mm_sub_ps(tyz, sx), scale),
+           _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(tz, az)), scale), zero},
+          {_mm_mul_ps(sinOrbit, radius), _mm_loadu_ps(&m_heights[i]),
+           _mm_mul_ps(cosOrbit, radius), one}};
+
+      for (int col = 0; col < 4; ++col) {
+
+        __m128 *v = columns[col];
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+
+        for (int lane = 0; lane < 4; ++lane) {
+          float *dst = &out[i + lane][col][0];
+          if (aligned) {
+            _mm_stream_ps(dst, v[lane]);
+          } else {
+            _mm_storeu_ps(dst, v[lane]);
+          }
+        }
+      }
+    }
+
+    _mm_sfence();
+
+    computeMatricesScalar(time, i, end, out);
+#else
+    computeMatricesScalar(time, begin, end, out);
+#endif
+  }
+
+  /**
+   * Compact instances of the rocks [begin, end), 4 at a time on sse: orbit
+   * position, scale and spin quaternion in the lanes, transposed to one
+   * register per rock, converted and packed to 16 bits, then the
+   * position/scale and rotation halves of 2 rocks interleaved.
+   */
+  void computeCompactInstances(float time, size_t begin, size_t end,
+                               gpu::CompactInstance *out) const {
+
+#ifdef ASTEROID_BELT_SSE
+    bool aligned = (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+
+    __m128 t = _mm_set1_ps(time);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+
+    // unorm16 - 32768 fits the signed saturating pack, the xor gives the
+    // unsigned value back
+    __m128 unormScale = _mm_set1_ps(65535.0f);
+    __m128 unormBias = _mm_set1_ps(32768.0f);
+    __m128i unormFlip = _mm_set1_epi16(static_cast<short>(0x8000));
+    __m128 snormScale = _mm_set1_ps(32767.0f);
+
+    __m128 min[4];
+    __m128 invExtent[4];
+
+    for (int c = 0; c < 4; ++c) {
+      min[c] = _mm_set1_ps(m_quantization.min[c]);
+      invExtent[c] = _mm_set1_ps(1.0f / m_quantization.extent[c]);
+    }
+
+    size_t i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+
+      __m128 orbitAngle = _mm_add_ps(
+          _mm_loadu_ps(&m_orbitAngles[i]),
+          _mm_mul_ps(_mm_loadu_ps(&m_orbitSpeeds[i]), t));
+      __m128 halfSpinAngle = _mm_mul_ps(
+          _mm_add_ps(_mm_loadu_ps(&m_spinAngles[i]),
+                     _mm_mul_ps(_mm_loadu_ps(&m_spinSpeeds[i]), t)),
+          half);
+
+      __m128 sinOrbit, cosOrbit, s, c;
+      sinCos(orbitAngle, sinOrbit, cosOrbit);
+      sinCos(halfSpinAngle, s, c);
+
+      __m128 radius = _mm_loadu_ps(&m_orbitRadii[i]);
+
+      __m128 p[4] = {_mm_mul_ps(sinOrbit, radius), _mm_loadu_ps(&m_heights[i]),
+                     _mm_mul_ps(cosOrbit, radius), _mm_loadu_ps(&m_scales[i])};
+
+      for (int k = 0; k < 4; ++k) {
+        __m128 normalized = _mm_mul_ps(_mm_sub_ps(p[k], min[k]), invExtent[k]);
+        normalized = _mm_min_ps(_mm_max_ps(normalized, zero), one);
+        p[k] = _mm_sub_ps(_mm_mul_ps(normalized, unormScale), unormBias);
+      }
+
+      __m128 q[4] = {_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&m_axesX[i]), s),
+                                snormScale),
+                     _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&m_axesY[i]), s),
+                                snormScale),
+                     _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&m_axesZ[i]), s),
+                                snormScale),
+                     _mm_mul_ps(c, snormScale)};
+
+      _MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+      _MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+
+      for (int pair = 0; pair < 2; ++pair) {
+
+        __m128i positionScale = _mm_xor_si128(
+            _mm_packs_epi32(_mm_cvtps_epi32(p[2 * pair]),
+                            _mm_cvtps_epi32(p[2 * pair + 1])),
+            unormFlip);
+        __m128i rotation = _mm_packs_epi32(_mm_cvtps_epi32(q[2 * pair]),
+                                           _mm_cvtps_epi32(q[2 * pair + 1]));
+
+        __m128i first = _mm_unpacklo_epi64(positionScale, rotation);
+        __m128i second = _mm_unpackhi_epi64(positionScale, rotation);
+
+        __m128i *dst = reinterpret_cast<__m128i *>(&out[i + 2 * pair]);
+
+        if (aligned) {
+          _mm_stream_si128(dst, first);
+          _mm_stream_si128(dst + 1, second);
+        } else {
+          _mm_storeu_si128(dst, first);
+          _mm_storeu_si128(dst + 1, second);
+        }
+      }
+    }
+
+    _mm_sfence();
+
+    computeCompactInstancesScalar(time, i, end, out);
+#else
+    computeCompactInstancesScalar(time, begin, end, out);
+#endif
+  }
+
+  // with gpu::encodeInstance, the reference for computeCompactInstances()
+  void computeCompactInstancesScalar(float time, size_t begin, size_t end,
+                                     gpu::CompactInstance *out) const {
+
+    for (size_t i = begin; i < end; ++i) {
+
+      float orbitAngle = m_orbitAngles[i] + m_orbitSpeeds[i] * time;
+      float halfSpinAngle = 0.5f * (m_spinAngles[i] + m_spinSpeeds[i] * time);
+
+      glm::vec3 position{std::sin(orbitAngle) * m_orbitRadii[i], m_heights[i],
+                         std::cos(orbitAngle) * m_orbitRadii[i]};
+
+      glm::vec4 rotation{
+          glm::vec3{m_axesX[i], m_axesY[i], m_axesZ[i]} *
+              std::sin(halfSpinAngle),
+          std::cos(halfSpinAngle)};
+
+      out[i] = gpu::encodeInstance(m_quantization, position, rotation,
+                                   m_scales[i]);
+    }
+  }
+
+  // with glm, the reference for computeMatrices()
+  void computeMatricesScalar(float time, size_t begin, size_t end,
+                             glm::mat4 *out) const {
+
+    for (size_t i = begin; i < end; ++i) {
+
+      float orbitAngle = m_orbitAngles[i] + m_orbitSpeeds[i] * time;
+
+      glm::vec3 position{std::sin(orbitAngle) * m_orbitRadii[i], m_heights[i],
+                         std::cos(orbitAngle) * m_orbitRadii[i]};
+
+      glm::mat4 model = glm::translate(glm::mat4{1.0f}, position);
+      model = glm::scale(model, glm::vec3{m_scales[i]});
+      model = glm::rotate(model, m_spinAngles[i] + m_spinSpeeds[i] * time,
+                          glm::vec3{m_axesX[i], m_axesY[i], m_axesZ[i]});
+
+      out[i] = model;
+    }
+  }
+
+private:
+  gpu::InstanceQuantization m_quantization;
+
+  std::vector<float> m_orbitAngles;
+  std::vector<float> m_orbitSpeeds;
+  std::vector<float> m_orbitRadii;
+  std::vector<float> m_heights;
+  std::vector<float> m_axesX;
+  std::vector<float> m_axesY;
+  std::vector<float> m_axesZ;
+  std::vector<float> m_spinAngles;
+  std::vector<float> m_spinSpeeds;
+  std::vector<float> m_scales;
+
+  // fn(begin, end) on the blocks of rocks, across the job system
+  template <typename Fn>
+  void forEachBlock(jobs::JobSystem &jobSystem, Fn &&fn) const {
+
+    size_t n = getNumInstances();
+    size_t nBlocks = (n + ASTEROID_BLOCK_SIZE - 1) / ASTEROID_BLOCK_SIZE;
+
+    jobSystem.parallelFor(nBlocks, 1, [&](size_t beginBlock, size_t endBlock) {
+      fn(beginBlock * ASTEROID_BLOCK_SIZE,
+         std::min(endBlock * ASTEROID_BLOCK_SIZE, n));
+    });
+  }
+
+  // integer hash, the same belt whatever the platform's rand()
+  static float random(uint32_t index, uint32_t stream, float min, float max) {
+
+    uint32_t x = index * 8 + stream;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+
+    float t = static_cast<float>(x & 0xffffff) / static_cast<float>(0x1000000);
+
+    return min + (max - min) * t;
+  }
+
+#ifdef ASTEROID_BELT_SSE
+  /**
+   * sin and cos of 4 angles (cephes sinf/cosf): reduced to [-pi/4, pi/4] by
+   * the nearest multiple of pi/2 (in 3 parts to keep the precision), both
+   * polynomials, then swapped and negated according to the quadrant.
+   */
+  static void sinCos(__m128 x, __m128 &sinX, __m128 &cosX) {
+
+    __m128i quadrant =
+        _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+    __m128 k = _mm_cvtepi32_ps(quadrant);
+
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(1.5703125f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(4.837512969970703125e-4f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(7.54978995489188216e-8f)));
+
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 sinR = _mm_set1_ps(-1.9515295891e-4f);
+    sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(8.3321608736e-3f));
+    sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, z), r), r);
+
+    __m128 cosR = _mm_set1_ps(2.443315711809948e-5f);
+    cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosR = _mm_mul_ps(_mm_mul_ps(cosR, z), z);
+    cosR = _mm_add_ps(_mm_sub_ps(cosR, _mm_mul_ps(z, _mm_set1_ps(0.5f))),
+                      _mm_set1_ps(1.0f));
+
+    // odd quadrants: sin and cos swapped
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+
+    __m128 s = _mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR));
+    __m128 c = _mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR));
+
+    // sin negated in quadrants 2, 3 and cos in 1, 2
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)),
+                      _mm_set1_epi32(2)),
+        30));
+
+    sinX = _mm_xor_ps(s, sinSign);
+    cosX = _mm_xor_ps(c, cosSign);
+  }
+#endif
+};
+
+} // namespace scene
+
+#endif // ASTEROID_BELT_H
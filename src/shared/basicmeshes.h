@@ -132,7 +132,7 @@ void manipulateData(MeshData &meshData, const MeshCreateInfo &createInfo) {
 
 } // namespace
 
-Mesh createQuad(const MeshCreateInfo &createInfo = {}) {
+MeshData createQuadMeshData(const MeshCreateInfo &createInfo = {}) {
 
   // clang-format off
 
@@ -151,10 +151,10 @@ Mesh createQuad(const MeshCreateInfo &createInfo = {}) {
   MeshData meshData = createMeshData(vertexData);
   manipulateData(meshData, createInfo);
 
-  return Mesh{meshData};
+  return meshData;
 }
 
-Mesh createCube(const MeshCreateInfo &createInfo = {}) {
+MeshData createCubeMeshData(const MeshCreateInfo &createInfo = {}) {
 
   // clang-format off
 
@@ -220,7 +220,15 @@ Mesh createCube(const MeshCreateInfo &createInfo = {}) {
   MeshData meshData = createMeshData(vertexData);
   manipulateData(meshData, createInfo);
 
-  return Mesh{meshData};
+  return meshData;
+}
+
+Mesh createQuad(const MeshCreateInfo &createInfo = {}) {
+  return Mesh{createQuadMeshData(createInfo)};
+}
+
+Mesh createCube(const MeshCreateInfo &createInfo = {}) {
+  return Mesh{createCubeMeshData(createInfo)};
 }
 
 #endif // BASIC_MESHES_H
\ No newline at end of file
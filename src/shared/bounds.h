@@ -0,0 +1,176 @@
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "mesh.h"
+#include "model.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+
+struct AABB {
+
+  AABB()
+      : min(glm::vec3{std::numeric_limits<float>::max()}),
+        max(glm::vec3{std::numeric_limits<float>::lowest()}) {}
+
+  AABB(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {}
+
+  glm::vec3 min;
+  glm::vec3 max;
+
+  inline bool isEmpty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+
+  inline glm::vec3 getCenter() const { return 0.5f * (min + max); }
+  inline glm::vec3 getExtents() const { return 0.5f * (max - min); }
+
+  inline void expand(const glm::vec3 &point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  inline void expand(const AABB &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+
+  inline bool intersects(const AABB &other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+  }
+
+  inline bool intersectsSphere(const glm::vec3 &center, float radius) const {
+    glm::vec3 closest = glm::clamp(center, min, max);
+    glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+  }
+
+  inline bool operator==(const AABB &other) const {
+    return min == other.min && max == other.max;
+  }
+
+  inline bool operator!=(const AABB &other) const { return !(*this == other); }
+};
+
+/**
+ * World-space AABB of a transformed box (Arvo's method: the extents are
+ * transformed by the absolute value of the rotation/scale part).
+ */
+inline AABB transformAABB(const AABB &aabb, const glm::mat4 &transform) {
+
+  if (aabb.isEmpty()) {
+    return aabb;
+  }
+
+  glm::vec3 center = glm::vec3{transform * glm::vec4{aabb.getCenter(), 1.0f}};
+  glm::vec3 extents = aabb.getExtents();
+
+  glm::vec3 newExtents{0.0f};
+
+  for (int col = 0; col < 3; ++col) {
+    for (int row = 0; row < 3; ++row) {
+      newExtents[row] += std::abs(transform[col][row]) * extents[col];
+    }
+  }
+
+  return AABB{center - newExtents, center + newExtents};
+}
+
+inline AABB computeAABB(const Mesh &mesh) {
+  AABB aabb;
+  for (const Vertex &vertex : mesh.m_vertices) {
+    aabb.expand(vertex.position);
+  }
+  return aabb;
+}
+
+// model space: each mesh placed by the transforms of its nodes
+inline AABB computeAABB(const Model &model) {
+  AABB aabb;
+  for (size_t i = 0; i < model.m_meshes.size(); ++i) {
+    aabb.expand(transformAABB(computeAABB(model.m_meshes[i]),
+                              model.getMeshTransform(i)));
+  }
+  return aabb;
+}
+
+/**
+ * Six planes extracted from a (projection * view) matrix. The normals point
+ * inside the frustum.
+ */
+struct Frustum {
+
+  Frustum() {}
+
+  Frustum(const glm::mat4 &viewProjection) {
+
+    // Gribb & Hartmann, rows of the clip matrix
+    glm::vec4 row0{viewProjection[0][0], viewProjection[1][0],
+                   viewProjection[2][0], viewProjection[3][0]};
+    glm::vec4 row1{viewProjection[0][1], viewProjection[1][1],
+                   viewProjection[2][1], viewProjection[3][1]};
+    glm::vec4 row2{viewProjection[0][2], viewProjection[1][2],
+                   viewProjection[2][2], viewProjection[3][2]};
+    glm::vec4 row3{viewProjection[0][3], viewProjection[1][3],
+                   viewProjection[2][3], viewProjection[3][3]};
+
+    planes[0] = row3 + row0; // left
+    planes[1] = row3 - row0; // right
+    planes[2] = row3 + row1; // bottom
+    planes[3] = row3 - row1; // top
+    planes[4] = row3 + row2; // near
+    planes[5] = row3 - row2; // far
+
+    for (glm::vec4 &plane : planes) {
+      plane /= glm::length(glm::vec3{plane});
+    }
+  }
+
+  glm::vec4 planes[6];
+
+  /**
+   * Conservative test, some boxes close to the frustum corners are reported
+   * as visible.
+   */
+  inline bool intersects(const AABB &aabb) const {
+
+    if (aabb.isEmpty()) {
+      return false;
+    }
+
+    glm::vec3 center = aabb.getCenter();
+    glm::vec3 extents = aabb.getExtents();
+
+    for (const glm::vec4 &plane : planes) {
+
+      glm::vec3 normal{plane};
+
+      float distance = glm::dot(normal, center) + plane.w;
+      float radius = glm::dot(glm::abs(normal), extents);
+
+      if (distance < -radius) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  inline bool intersectsSphere(const glm::vec3 &center, float radius) const {
+
+    for (const glm::vec4 &plane : planes) {
+      if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+#endif // BOUNDS_H
@@ -6,6 +6,8 @@
 
 #include <glad/glad.h>
 
+#include <vector>
+
 namespace gpu {
 
 class Buffer : public GpuObject {
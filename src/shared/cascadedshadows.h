@@ -0,0 +1,281 @@
+
+#ifndef CASCADED_SHADOWS_H
+#define CASCADED_SHADOWS_H
+
+#include "bounds.h"
+#include "flycamera.h"
+#include "framebuffer.h"
+#include "shader.h"
+#include "texture2darray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+
+namespace shadows {
+
+constexpr int MAX_CASCADES = 4;
+
+struct CascadedShadowsCreateInfo {
+
+  CascadedShadowsCreateInfo() {}
+
+  int nCascades = 4;
+
+  int size = 2048;
+  unsigned int depthFormat = GL_DEPTH_COMPONENT32F;
+
+  // shadows end here, even if the camera sees further
+  float maxDistance = 60.0f;
+
+  // 0 = uniform splits, 1 = logarithmic splits
+  float splitLambda = 0.75f;
+
+  // fraction of each cascade (at its far end) that fades into the next one
+  float blendFraction = 0.1f;
+
+  // cascade i is re-rendered every updateIntervals[i] frames
+  int updateIntervals[MAX_CASCADES] = {1, 1, 2, 4};
+};
+
+/**
+ * Draws the shadow casters of a cascade, 'frustum' is the cascade's light
+ * frustum so the casters outside of it can be culled.
+ */
+typedef std::function<void(const gpu::Shader &shader, const Frustum &frustum)>
+    DrawCascadeFn;
+
+/**
+ * Cascaded shadow maps for a directional light.
+ *
+ * The camera frustum (up to maxDistance) is split with the practical split
+ * scheme (a blend of uniform and logarithmic splits) and each slice gets its
+ * own layer of a depth texture array.
+ *
+ * Every cascade is fitted to the bounding sphere of its slice, so its size
+ * doesn't change when the camera rotates, and its origin is snapped to whole
+ * shadow map texels, so the edges don't shimmer when the camera moves.
+ *
+ * Far cascades cover a lot of texels per pixel and can be refreshed less
+ * often (updateIntervals); the updates are staggered so they don't all land
+ * on the same frame. A cascade keeps the matrix it was rendered with until it
+ * is refreshed again.
+ *
+ * The depth shader needs the 'lightSpaceMatrix' and 'model' uniforms.
+ */
+class CascadedShadows {
+
+public:
+  CascadedShadows() {}
+
+  CascadedShadows(const CascadedShadowsCreateInfo &createInfo)
+      : m_nCascades(std::clamp(createInfo.nCascades, 1, MAX_CASCADES)),
+        m_size(createInfo.size), m_maxDistance(createInfo.maxDistance),
+        m_splitLambda(createInfo.splitLambda),
+        m_blendFraction(createInfo.blendFraction) {
+
+    for (int i = 0; i < MAX_CASCADES; ++i) {
+      m_updateIntervals[i] = std::max(1, createInfo.updateIntervals[i]);
+    }
+
+    m_shadowMap = gpu::texture::Texture2DArray{m_size, m_size, m_nCascades,
+                                               createInfo.depthFormat};
+
+    m_shadowMap.setMinMagFilter(gpu::texture::Filter::LINEAR);
+    m_shadowMap.setWrapST(gpu::texture::Wrap::CLAMP_TO_BORDER);
+    m_shadowMap.setBorderColor(glm::vec4{1.0f});
+
+    // sampled with sampler2DArrayShadow (hardware 2x2 pcf)
+    m_shadowMap.setDepthCompare(true);
+  }
+
+  inline int getNumCascades() const { return m_nCascades; }
+
+  inline unsigned int getShadowMapID() const { return m_shadowMap.getID(); }
+
+  // number of cascades rendered by the last render() call
+  inline int getNumRendered() const { return m_nRendered; }
+
+  inline float getSplit(int cascade) const { return m_splits[cascade]; }
+
+  /**
+   * Computes the splits and fits the cascades that are due this frame.
+   */
+  void update(FlyCamera &camera, const glm::vec3 &lightDirection) {
+
+    float zNear = camera.getZNear();
+    float zFar = std::min(camera.getZFar(), m_maxDistance);
+
+    // practical split scheme (Zhang et al.)
+    for (int i = 0; i < m_nCascades; ++i) {
+
+      float p = static_cast<float>(i + 1) / m_nCascades;
+
+      float logSplit = zNear * std::pow(zFar / zNear, p);
+      float uniformSplit = zNear + (zFar - zNear) * p;
+
+      m_splits[i] =
+          m_splitLambda * logSplit + (1.0f - m_splitLambda) * uniformSplit;
+    }
+
+    // same orientation for all the cascades and all the frames, only the
+    // origin moves (snapped to texels)
+    glm::vec3 dir = glm::normalize(lightDirection);
+    glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f}
+                                           : glm::vec3{0.0f, 1.0f, 0.0f};
+
+    glm::mat4 lightView = glm::lookAt(glm::vec3{0.0f}, dir, up);
+
+    const glm::mat4 &invView = camera.getInverseViewMatrix();
+
+    float tanHalfY = std::tan(0.5f * camera.getFov());
+    float tanHalfX = tanHalfY * camera.getAspect();
+
+    for (int i = 0; i < m_nCascades; ++i) {
+
+      // everything is fitted on the first frame
+      size_t interval = m_updateIntervals[i];
+      m_due[i] = m_frame == 0 || m_frame % interval == i % interval;
+
+      if (!m_due[i]) {
+        continue;
+      }
+
+      float sliceNear = i == 0 ? zNear : m_splits[i - 1];
+      float sliceFar = m_splits[i];
+
+      // bounding sphere of the slice (view space, on the -z axis).
+      // center at depth c minimizes max(dist to near corners, far corners)
+      float nearR2 = (tanHalfX * tanHalfX + tanHalfY * tanHalfY) *
+                     sliceNear * sliceNear;
+      float farR2 =
+          (tanHalfX * tanHalfX + tanHalfY * tanHalfY) * sliceFar * sliceFar;
+
+      float center = 0.5f * (sliceNear + sliceFar) +
+                     0.5f * (farR2 - nearR2) / (sliceFar - sliceNear);
+      center = std::min(center, sliceFar);
+
+      float radius = std::sqrt(std::max(
+          (sliceFar - center) * (sliceFar - center) + farR2,
+          (center - sliceNear) * (center - sliceNear) + nearR2));
+
+      // round the radius up so float noise doesn't change the texel size
+      radius = std::ceil(radius * 16.0f) / 16.0f;
+
+      glm::vec3 centerWS =
+          glm::vec3{invView * glm::vec4{0.0f, 0.0f, -center, 1.0f}};
+
+      glm::vec3 centerLS = glm::vec3{lightView * glm::vec4{centerWS, 1.0f}};
+
+      // texel snapping
+      float texelSize = 2.0f * radius / m_size;
+      centerLS.x = std::floor(centerLS.x / texelSize) * texelSize;
+      centerLS.y = std::floor(centerLS.y / texelSize) * texelSize;
+
+      // light view looks down -z. Depth clamp is enabled during the shadow
+      // pass, casters behind the near plane are still rendered
+      glm::mat4 projection =
+          glm::ortho(centerLS.x - radius, centerLS.x + radius,
+                     centerLS.y - radius, centerLS.y + radius,
+                     -centerLS.z - radius, -centerLS.z + radius);
+
+      m_matrices[i] = projection * lightView;
+    }
+
+    m_frame++;
+  }
+
+  /**
+   * Renders the cascades that were refitted by the last update().
+   */
+  void render(const gpu::Shader &depthShader, const DrawCascadeFn &draw) {
+
+    m_nRendered = 0;
+
+    gpu::framebuffer::setViewport(0, 0, m_size, m_size);
+
+    glEnable(GL_DEPTH_CLAMP);
+
+    for (int i = 0; i < m_nCascades; ++i) {
+
+      if (!m_due[i]) {
+        continue;
+      }
+
+      m_framebuffer.setDepthAttachmentLayer(m_shadowMap, i);
+      m_framebuffer.bind();
+
+      gpu::framebuffer::clear(ClearFlagBits::DEPTH_BIT);
+
+      depthShader.setMat4("lightSpaceMatrix", m_matrices[i]);
+
+      Frustum frustum{m_matrices[i]};
+
+      // casters between the light and the near plane still cast shadows
+      // (depth clamp), don't cull them
+      frustum.planes[4] = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+
+      draw(depthShader, frustum);
+
+      m_nRendered++;
+    }
+
+    glDisable(GL_DEPTH_CLAMP);
+
+    gpu::framebuffer::bindDefault();
+  }
+
+  /**
+   * Uniforms used by the lighting shader to pick and blend the cascades.
+   */
+  void setUniforms(const gpu::Shader &shader) const {
+
+    shader.setInt("nCascades", m_nCascades);
+    shader.setFloat("cascadeBlendFraction", m_blendFraction);
+
+    for (int i = 0; i < m_nCascades; ++i) {
+
+      std::string idx = "[" + std::to_string(i) + "]";
+
+      shader.setFloat("cascadeSplits" + idx, m_splits[i]);
+      shader.setMat4("cascadeMatrices" + idx, m_matrices[i]);
+    }
+  }
+
+  void destroy() {
+    m_shadowMap.destroy();
+    m_framebuffer.destroy();
+  }
+
+private:
+  int m_nCascades;
+  int m_size;
+
+  float m_maxDistance;
+  float m_splitLambda;
+  float m_blendFraction;
+
+  int m_updateIntervals[MAX_CASCADES];
+
+  size_t m_frame = 0;
+  int m_nRendered = 0;
+
+  // view-space depth where each cascade ends
+  float m_splits[MAX_CASCADES];
+
+  glm::mat4 m_matrices[MAX_CASCADES];
+
+  bool m_due[MAX_CASCADES];
+
+  gpu::texture::Texture2DArray m_shadowMap;
+  gpu::framebuffer::Framebuffer m_framebuffer;
+};
+
+} // namespace shadows
+
+#endif // CASCADED_SHADOWS_H
@@ -0,0 +1,314 @@
+
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include "flycamera.h"
+#include "pointlight.h"
+#include "shader.h"
+#include "shaderstoragebuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace clustered {
+
+// std430 layout, must match the 'PointLight' struct in the shaders
+struct GpuPointLight {
+  glm::vec4 positionRadius;    // xyz = world position, w = radius
+  glm::vec4 ambientConstant;   // xyz = ambient, w = constant att.
+  glm::vec4 diffuseLinear;     // xyz = diffuse, w = linear att.
+  glm::vec4 specularQuadratic; // xyz = specular, w = quadratic att.
+};
+
+// std430 layout, must match the 'ClusterRange' struct in the shaders
+struct ClusterRange {
+  uint32_t offset;
+  uint32_t count;
+};
+
+struct ClusteredLightsCreateInfo {
+
+  ClusteredLightsCreateInfo() {}
+
+  // the frustum is split in tilesX * tilesY screen tiles and slicesZ
+  // exponentially distributed depth slices
+  size_t tilesX = 16;
+  size_t tilesY = 9;
+  size_t slicesZ = 24;
+
+  // shader storage binding points
+  size_t lightsBinding = 1;
+  size_t clustersBinding = 2;
+  size_t lightIndicesBinding = 3;
+
+  // the light radius is where its contribution falls below this value
+  float lightThreshold = 5.0f / 256.0f;
+};
+
+/**
+ * Clustered light assignment (done on the CPU).
+ *
+ * Every frame each light is converted to a view-space sphere (radius derived
+ * from the attenuation factors) and inserted in the clusters it overlaps.
+ * The result is uploaded to three SSBOs (lights, per-cluster ranges and a
+ * compact list of light indices) so each fragment only loops over the lights
+ * that can actually reach it.
+ */
+class ClusteredLights {
+
+public:
+  ClusteredLights() {}
+
+  ClusteredLights(const ClusteredLightsCreateInfo &createInfo)
+      : m_tilesX(createInfo.tilesX), m_tilesY(createInfo.tilesY),
+        m_slicesZ(createInfo.slicesZ),
+        m_lightThreshold(createInfo.lightThreshold),
+        m_lightsBuffer{sizeof(GpuPointLight) * 64, createInfo.lightsBinding},
+        m_clustersBuffer{sizeof(ClusterRange) * createInfo.tilesX *
+                             createInfo.tilesY * createInfo.slicesZ,
+                         createInfo.clustersBinding},
+        m_lightIndicesBuffer{sizeof(uint32_t) * 1024,
+                             createInfo.lightIndicesBinding} {
+
+    m_clusters.resize(getNumClusters());
+  }
+
+  inline size_t getNumClusters() const {
+    return m_tilesX * m_tilesY * m_slicesZ;
+  }
+
+  inline size_t getNumLightIndices() const { return m_lightIndices.size(); }
+
+  inline size_t getMaxLightsPerCluster() const {
+    return m_maxLightsPerCluster;
+  }
+
+  /**
+   * Assigns the first 'nLights' lights to the clusters of the camera frustum
+   * and uploads everything to the gpu.
+   */
+  void update(FlyCamera &camera, const std::vector<PointLight> &lights,
+              size_t nLights) {
+
+    nLights = std::min(nLights, lights.size());
+
+    const glm::mat4 &view = camera.getViewMatrix();
+    const glm::mat4 &projection = camera.getProjectionMatrix();
+
+    m_zNear = camera.getZNear();
+    m_zFar = camera.getZFar();
+
+    // maps view-space depth to slice: slice = log(z) * scale + bias
+    m_zScale = static_cast<float>(m_slicesZ) / std::log(m_zFar / m_zNear);
+    m_zBias = -static_cast<float>(m_slicesZ) * std::log(m_zNear) /
+              std::log(m_zFar / m_zNear);
+
+    m_projX = projection[0][0];
+    m_projY = projection[1][1];
+
+    m_gpuLights.resize(nLights);
+
+    m_pairClusters.clear();
+    m_pairLights.clear();
+
+    for (size_t i = 0; i < nLights; ++i) {
+
+      const PointLight &light = lights[i];
+
+      float radius = computeLightRadius(light, m_lightThreshold);
+
+      GpuPointLight &gpuLight = m_gpuLights[i];
+      gpuLight.positionRadius = glm::vec4{light.position, radius};
+      gpuLight.ambientConstant = glm::vec4{light.ambient, light.constantAtt};
+      gpuLight.diffuseLinear = glm::vec4{light.diffuse, light.linearAtt};
+      gpuLight.specularQuadratic =
+          glm::vec4{light.specular, light.quadraticAtt};
+
+      glm::vec3 center = glm::vec3{view * glm::vec4{light.position, 1.0f}};
+
+      assignLight(static_cast<uint32_t>(i), center, radius);
+    }
+
+    buildClusters();
+
+    m_lightsBuffer.update(m_gpuLights);
+    m_clustersBuffer.update(m_clusters);
+    m_lightIndicesBuffer.update(m_lightIndices);
+  }
+
+  /**
+   * Uniforms needed by the shader to find the cluster of a fragment.
+   */
+  void setUniforms(const gpu::Shader &shader, size_t viewportWidth,
+                   size_t viewportHeight) const {
+
+    shader.setInt("clusterTilesX", static_cast<int>(m_tilesX));
+    shader.setInt("clusterTilesY", static_cast<int>(m_tilesY));
+    shader.setInt("clusterSlicesZ", static_cast<int>(m_slicesZ));
+
+    shader.setVec2("clusterTileSize",
+                   static_cast<float>(viewportWidth) / m_tilesX,
+                   static_cast<float>(viewportHeight) / m_tilesY);
+
+    shader.setFloat("clusterZScale", m_zScale);
+    shader.setFloat("clusterZBias", m_zBias);
+  }
+
+  void destroy() {
+    m_lightsBuffer.destroy();
+    m_clustersBuffer.destroy();
+    m_lightIndicesBuffer.destroy();
+  }
+
+private:
+  size_t m_tilesX;
+  size_t m_tilesY;
+  size_t m_slicesZ;
+
+  float m_lightThreshold;
+
+  float m_zNear;
+  float m_zFar;
+  float m_zScale;
+  float m_zBias;
+
+  float m_projX;
+  float m_projY;
+
+  size_t m_maxLightsPerCluster = 0;
+
+  std::vector<GpuPointLight> m_gpuLights;
+  std::vector<ClusterRange> m_clusters;
+  std::vector<uint32_t> m_lightIndices;
+
+  // (cluster, light) pairs generated by the assignment
+  std::vector<uint32_t> m_pairClusters;
+  std::vector<uint32_t> m_pairLights;
+
+  gpu::ShaderStorageBuffer m_lightsBuffer;
+  gpu::ShaderStorageBuffer m_clustersBuffer;
+  gpu::ShaderStorageBuffer m_lightIndicesBuffer;
+
+  inline int sliceFromDepth(float depth) const {
+    return static_cast<int>(std::floor(std::log(depth) * m_zScale + m_zBias));
+  }
+
+  inline float depthFromSlice(int slice) const {
+    return m_zNear * std::pow(m_zFar / m_zNear,
+                              static_cast<float>(slice) / m_slicesZ);
+  }
+
+  // conservative [min, max] of coord / depth over a view-space box
+  static inline void projectedRange(float minCoord, float maxCoord,
+                                    float minDepth, float maxDepth,
+                                    float &outMin, float &outMax) {
+    outMin = minCoord >= 0.0f ? minCoord / maxDepth : minCoord / minDepth;
+    outMax = maxCoord >= 0.0f ? maxCoord / minDepth : maxCoord / maxDepth;
+  }
+
+  static inline int toTile(float ndc, size_t nTiles) {
+    int tile = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * nTiles));
+    return std::clamp(tile, 0, static_cast<int>(nTiles) - 1);
+  }
+
+  void assignLight(uint32_t lightIndex, const glm::vec3 &center,
+                   float radius) {
+
+    // view space looks down -z, work with positive depths
+    float depth = -center.z;
+
+    float minDepth = depth - radius;
+    float maxDepth = depth + radius;
+
+    if (maxDepth < m_zNear || minDepth > m_zFar || radius <= 0.0f) {
+      return;
+    }
+
+    minDepth = std::max(minDepth, m_zNear);
+    maxDepth = std::min(maxDepth, m_zFar);
+
+    int minSlice = std::clamp(sliceFromDepth(minDepth), 0,
+                              static_cast<int>(m_slicesZ) - 1);
+    int maxSlice = std::clamp(sliceFromDepth(maxDepth), 0,
+                              static_cast<int>(m_slicesZ) - 1);
+
+    for (int k = minSlice; k <= maxSlice; ++k) {
+
+      // the part of the sphere's bounding box inside this slice
+      float sliceNear = std::max(minDepth, depthFromSlice(k));
+      float sliceFar = std::min(maxDepth, depthFromSlice(k + 1));
+
+      float minX, maxX, minY, maxY;
+      projectedRange(center.x - radius, center.x + radius, sliceNear,
+                     sliceFar, minX, maxX);
+      projectedRange(center.y - radius, center.y + radius, sliceNear,
+                     sliceFar, minY, maxY);
+
+      if (minX * m_projX > 1.0f || maxX * m_projX < -1.0f ||
+          minY * m_projY > 1.0f || maxY * m_projY < -1.0f) {
+        continue;
+      }
+
+      int minTileX = toTile(minX * m_projX, m_tilesX);
+      int maxTileX = toTile(maxX * m_projX, m_tilesX);
+      int minTileY = toTile(minY * m_projY, m_tilesY);
+      int maxTileY = toTile(maxY * m_projY, m_tilesY);
+
+      for (int j = minTileY; j <= maxTileY; ++j) {
+        for (int i = minTileX; i <= maxTileX; ++i) {
+
+          uint32_t clusterIndex = static_cast<uint32_t>(
+              (k * m_tilesY + j) * m_tilesX + i);
+
+          m_pairClusters.push_back(clusterIndex);
+          m_pairLights.push_back(lightIndex);
+        }
+      }
+    }
+  }
+
+  /**
+   * Counting sort of the (cluster, light) pairs: one pass to count, a prefix
+   * sum for the offsets and a second pass to scatter the light indices.
+   */
+  void buildClusters() {
+
+    for (ClusterRange &cluster : m_clusters) {
+      cluster.offset = 0;
+      cluster.count = 0;
+    }
+
+    for (uint32_t cluster : m_pairClusters) {
+      m_clusters[cluster].count++;
+    }
+
+    uint32_t offset = 0;
+    m_maxLightsPerCluster = 0;
+
+    for (ClusterRange &cluster : m_clusters) {
+      cluster.offset = offset;
+      offset += cluster.count;
+
+      m_maxLightsPerCluster =
+          std::max(m_maxLightsPerCluster, static_cast<size_t>(cluster.count));
+
+      // reused as insertion cursor below
+      cluster.count = 0;
+    }
+
+    m_lightIndices.resize(m_pairClusters.size());
+
+    for (size_t i = 0; i < m_pairClusters.size(); ++i) {
+      ClusterRange &cluster = m_clusters[m_pairClusters[i]];
+      m_lightIndices[cluster.offset + cluster.count++] = m_pairLights[i];
+    }
+  }
+};
+
+} // namespace clustered
+
+#endif // CLUSTERED_LIGHTS_H
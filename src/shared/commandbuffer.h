@@ -0,0 +1,1466 @@
+#ifndef GPU_COMMAND_BUFFER_H
+#define GPU_COMMAND_BUFFER_H
+
+#include "cpuprofiler.h"
+#include "framebuffer.h"
+#include "gpuconstants.h"
+#include "mesh.h"
+#include "shader.h"
+#include "texture.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gpu {
+
+enum class CommandType : uint32_t {
+  BIND_FRAMEBUFFER = 0,
+  VIEWPORT,
+  CLEAR_COLOR,
+  CLEAR,
+  ENABLE,
+  DISABLE,
+  USE_PROGRAM,
+  BIND_TEXTURE,
+  BIND_VERTEX_ARRAY,
+  BIND_BUFFER_BASE,
+  UNIFORM_INT,
+  UNIFORM_FLOATS,
+  BUFFER_SUB_DATA,
+  DRAW_ARRAYS,
+  DRAW_ELEMENTS,
+  COUNT
+};
+
+// gl objects a stream can reference, in the order they are saved
+enum class ResourceKind : uint32_t {
+  BUFFER = 0,
+  TEXTURE,
+  RENDERBUFFER,
+  PROGRAM,
+  VERTEX_ARRAY,
+  FRAMEBUFFER,
+  COUNT
+};
+
+constexpr size_t N_RESOURCE_KINDS = static_cast<size_t>(ResourceKind::COUNT);
+
+// texture units whose bindings execute() tracks to skip redundant binds
+constexpr unsigned int MAX_TRACKED_TEXTURE_UNITS = 32;
+
+/**
+ * Draws, binds and uniform updates recorded into a linear stream of 32 bit
+ * words (a header with the command type and payload size, then the payload),
+ * to be executed later on the gl thread.
+ *
+ * Recording makes no gl calls (except drawMesh with textured meshes, see
+ * there), so command buffers can be filled on any thread and appended
+ * together. A recorded buffer can be executed any number of times, so
+ * static passes (eg. a baked shadow map) are recorded once instead of
+ * re-walking the scene every frame.
+ *
+ * Objects are referenced by their gl names, uniforms by their location:
+ * look them up once with Shader::getUniformLocation. Uniforms are set with
+ * glProgramUniform*, they don't depend on the program in use.
+ *
+ * execute() leaves the gl state as the last commands set it.
+ */
+class CommandBuffer {
+
+public:
+  CommandBuffer() {}
+
+  // state
+
+  inline void bindFramebuffer(GLuint framebuffer) {
+    push(CommandType::BIND_FRAMEBUFFER, 1)[0] = framebuffer;
+  }
+
+  // the framebuffer has to exist already (an attachment was set)
+  inline void bindFramebuffer(const framebuffer::Framebuffer &framebuffer) {
+    bindFramebuffer(framebuffer.getID());
+  }
+
+  inline void bindDefaultFramebuffer() { bindFramebuffer(0); }
+
+  inline void setViewport(int x, int y, int width, int height) {
+    uint32_t *payload = push(CommandType::VIEWPORT, 4);
+    payload[0] = static_cast<uint32_t>(x);
+    payload[1] = static_cast<uint32_t>(y);
+    payload[2] = static_cast<uint32_t>(width);
+    payload[3] = static_cast<uint32_t>(height);
+  }
+
+  inline void setClearColor(float r, float g, float b, float a = 1.0f) {
+    float color[] = {r, g, b, a};
+    std::memcpy(push(CommandType::CLEAR_COLOR, 4), color, sizeof(color));
+  }
+
+  inline void clear(ClearFlagBits flagBits) {
+    push(CommandType::CLEAR, 1)[0] = static_cast<uint32_t>(flagBits);
+  }
+
+  inline void enable(GLenum capability) {
+    push(CommandType::ENABLE, 1)[0] = capability;
+  }
+
+  inline void disable(GLenum capability) {
+    push(CommandType::DISABLE, 1)[0] = capability;
+  }
+
+  // bindings
+
+  inline void useProgram(const Shader &shader) {
+    push(CommandType::USE_PROGRAM, 1)[0] = shader.getID();
+  }
+
+  inline void bindTexture(unsigned int unit, GLuint texture) {
+    uint32_t *payload = push(CommandType::BIND_TEXTURE, 2);
+    payload[0] = unit;
+    payload[1] = texture;
+  }
+
+  inline void bindTexture(unsigned int unit, const texture::Texture &texture) {
+    bindTexture(unit, texture.getID());
+  }
+
+  inline void bindVertexArray(GLuint vertexArray) {
+    push(CommandType::BIND_VERTEX_ARRAY, 1)[0] = vertexArray;
+  }
+
+  // GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+  inline void bindBufferBase(GLenum target, unsigned int index,
+                             GLuint buffer) {
+    uint32_t *payload = push(CommandType::BIND_BUFFER_BASE, 3);
+    payload[0] = target;
+    payload[1] = index;
+    payload[2] = buffer;
+  }
+
+  // uniforms
+
+  inline void setInt(const Shader &shader, int location, int value) {
+    uint32_t *payload = push(CommandType::UNIFORM_INT, 3);
+    payload[0] = shader.getID();
+    payload[1] = static_cast<uint32_t>(location);
+    payload[2] = static_cast<uint32_t>(value);
+  }
+
+  inline void setFloat(const Shader &shader, int location, float value) {
+    setFloats(shader, location, &value, 1);
+  }
+
+  inline void setVec2(const Shader &shader, int location,
+                      const glm::vec2 &value) {
+    setFloats(shader, location, glm::value_ptr(value), 2);
+  }
+
+  inline void setVec3(const Shader &shader, int location,
+                      const glm::vec3 &value) {
+    setFloats(shader, location, glm::value_ptr(value), 3);
+  }
+
+  inline void setVec4(const Shader &shader, int location,
+                      const glm::vec4 &value) {
+    setFloats(shader, location, glm::value_ptr(value), 4);
+  }
+
+  inline void setMat3(const Shader &shader, int location,
+                      const glm::mat3 &value) {
+    setFloats(shader, location, glm::value_ptr(value), 9);
+  }
+
+  inline void setMat4(const Shader &shader, int location,
+                      const glm::mat4 &value) {
+    setFloats(shader, location, glm::value_ptr(value), 16);
+  }
+
+  /**
+   * glNamedBufferSubData, the data is copied into the stream. The buffer
+   * has to be mutable storage (or have GL_DYNAMIC_STORAGE_BIT).
+   */
+  void updateBuffer(GLuint buffer, size_t offsetBytes, const void *data,
+                    size_t sizeBytes) {
+
+    size_t nDataWords = (sizeBytes + 3) / 4;
+
+    uint32_t *payload = push(CommandType::BUFFER_SUB_DATA, 3 + nDataWords);
+    payload[0] = buffer;
+    payload[1] = static_cast<uint32_t>(offsetBytes);
+    payload[2] = static_cast<uint32_t>(sizeBytes);
+
+    std::memcpy(payload + 3, data, sizeBytes);
+  }
+
+  // draws
+
+  inline void drawArrays(GLenum mode, int first, int count,
+                         int nInstances = 1) {
+    uint32_t *payload = push(CommandType::DRAW_ARRAYS, 4);
+    payload[0] = mode;
+    payload[1] = static_cast<uint32_t>(first);
+    payload[2] = static_cast<uint32_t>(count);
+    payload[3] = static_cast<uint32_t>(nInstances);
+    ++m_nDraws;
+  }
+
+  // GL_UNSIGNED_INT indices of the bound vertex array
+  inline void drawElements(GLenum mode, int count, size_t offsetBytes = 0,
+                           int nInstances = 1) {
+    uint32_t *payload = push(CommandType::DRAW_ELEMENTS, 4);
+    payload[0] = mode;
+    payload[1] = static_cast<uint32_t>(count);
+    payload[2] = static_cast<uint32_t>(offsetBytes);
+    payload[3] = static_cast<uint32_t>(nInstances);
+    ++m_nDraws;
+  }
+
+  /**
+   * Same commands as Mesh::drawInstanced. The sampler uniforms of textured
+   * meshes are looked up by name here, so those have to be recorded on the
+   * gl thread.
+   */
+  void drawMesh(const Mesh &mesh, const Shader &shader,
+                size_t nInstances = 1) {
+
+    unsigned int diffuseNr = 0;
+    unsigned int specularNr = 0;
+
+    for (unsigned int i = 0; i < mesh.m_textures.size(); ++i) {
+
+      bindTexture(i, mesh.m_textures[i].texture);
+
+      const std::string &name = mesh.m_textures[i].type;
+      std::string number;
+
+      if (name == "texture_diffuse") {
+        number = std::to_string(diffuseNr++);
+      } else if (name == "texture_specular") {
+        number = std::to_string(specularNr++);
+      }
+
+      setInt(shader, shader.getUniformLocation("material." + name + number),
+             i);
+    }
+
+    bindVertexArray(mesh.getVAO());
+
+    int count = static_cast<int>(mesh.getNumVertices());
+
+    if (mesh.isIndexed()) {
+      drawElements(GL_TRIANGLES, count, 0, static_cast<int>(nInstances));
+    } else {
+      drawArrays(GL_TRIANGLES, 0, count, static_cast<int>(nInstances));
+    }
+  }
+
+  // the commands of 'other' after the ones of this buffer
+  void append(const CommandBuffer &other) {
+    m_words.insert(m_words.end(), other.m_words.begin(), other.m_words.end());
+    m_nCommands += other.m_nCommands;
+    m_nDraws += other.m_nDraws;
+  }
+
+  // removes the commands, keeps the memory
+  inline void reset() {
+    m_words.clear();
+    m_nCommands = 0;
+    m_nDraws = 0;
+  }
+
+  inline bool empty() const { return m_words.empty(); }
+
+  inline size_t getNumCommands() const { return m_nCommands; }
+  inline size_t getNumDraws() const { return m_nDraws; }
+  inline size_t getSizeBytes() const { return m_words.size() * 4; }
+
+  /**
+   * Runs the commands, gl thread only. Binds of the program, vertex array,
+   * framebuffer or texture that is already bound by an earlier command of
+   * this execution are skipped.
+   */
+  void execute() const {
+
+    CPU_PROFILE_ZONE("CommandBuffer::execute");
+
+    // ~0: unknown, the first bind of each kind always goes through
+    GLuint program = ~0u;
+    GLuint vertexArray = ~0u;
+    GLuint framebuffer = ~0u;
+
+    std::array<GLuint, MAX_TRACKED_TEXTURE_UNITS> textures;
+    textures.fill(~0u);
+
+    const uint32_t *word = m_words.data();
+    const uint32_t *end = word + m_words.size();
+
+    while (word < end) {
+
+      CommandType type = getType(*word);
+      const uint32_t *p = word + 1;
+
+      word = p + getPayloadSize(*word);
+
+      switch (type) {
+
+      case CommandType::BIND_FRAMEBUFFER:
+        if (p[0] != framebuffer) {
+          framebuffer = p[0];
+          glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+        break;
+
+      case CommandType::VIEWPORT:
+        glViewport(static_cast<GLint>(p[0]), static_cast<GLint>(p[1]),
+                   static_cast<GLsizei>(p[2]), static_cast<GLsizei>(p[3]));
+        break;
+
+      case CommandType::CLEAR_COLOR: {
+        float color[4];
+        std::memcpy(color, p, sizeof(color));
+        glClearColor(color[0], color[1], color[2], color[3]);
+        break;
+      }
+
+      case CommandType::CLEAR:
+        glClear(p[0]);
+        break;
+
+      case CommandType::ENABLE:
+        glEnable(p[0]);
+        break;
+
+      case CommandType::DISABLE:
+        glDisable(p[0]);
+        break;
+
+      case CommandType::USE_PROGRAM:
+        if (p[0] != program) {
+          program = p[0];
+          glUseProgram(program);
+        }
+        break;
+
+      case CommandType::BIND_TEXTURE:
+        if (p[0] >= MAX_TRACKED_TEXTURE_UNITS) {
+          glBindTextureUnit(p[0], p[1]);
+        } else if (textures[p[0]] != p[1]) {
+          textures[p[0]] = p[1];
+          glBindTextureUnit(p[0], p[1]);
+        }
+        break;
+
+      case CommandType::BIND_VERTEX_ARRAY:
+        if (p[0] != vertexArray) {
+          vertexArray = p[0];
+          glBindVertexArray(vertexArray);
+        }
+        break;
+
+      case CommandType::BIND_BUFFER_BASE:
+        glBindBufferBase(p[0], p[1], p[2]);
+        break;
+
+      case CommandType::UNIFORM_INT:
+        glProgramUniform1i(p[0], static_cast<GLint>(p[1]),
+                           static_cast<GLint>(p[2]));
+        break;
+
+      case CommandType::UNIFORM_FLOATS:
+        setProgramUniform(p[0], static_cast<GLint>(p[1]), p[2],
+                          reinterpret_cast<const GLfloat *>(p + 3));
+        break;
+
+      case CommandType::BUFFER_SUB_DATA:
+        glNamedBufferSubData(p[0], p[1], p[2], p + 3);
+        break;
+
+      case CommandType::DRAW_ARRAYS:
+        glDrawArraysInstanced(p[0], static_cast<GLint>(p[1]),
+                              static_cast<GLsizei>(p[2]),
+                              static_cast<GLsizei>(p[3]));
+        break;
+
+      case CommandType::DRAW_ELEMENTS:
+        glDrawElementsInstanced(
+            p[0], static_cast<GLsizei>(p[1]), GL_UNSIGNED_INT,
+            reinterpret_cast<const void *>(static_cast<uintptr_t>(p[2])),
+            static_cast<GLsizei>(p[3]));
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+
+  /**
+   * Writes the commands and the objects they reference to a file, so they
+   * can be replayed without the demo (CommandCapture::load). gl thread only.
+   *
+   * Saved objects: programs as driver binaries (replayable with the same
+   * driver only), buffers with their contents, vertex arrays, framebuffers
+   * and the storage of textures and renderbuffers (not their contents).
+   * Uniforms set outside of the stream keep their default values on replay,
+   * so the image differs but the commands and their cost don't.
+   */
+  bool save(const std::string &path) const;
+
+  /**
+   * Calls fn(ResourceKind, uint32_t &name) for every object referenced by
+   * the commands in 'words', the names can be rewritten in place.
+   */
+  template <typename Fn>
+  static void forEachReference(std::vector<uint32_t> &words, Fn fn) {
+
+    size_t i = 0;
+
+    while (i < words.size()) {
+
+      CommandType type = getType(words[i]);
+      uint32_t *p = words.data() + i + 1;
+
+      i += 1 + getPayloadSize(words[i]);
+
+      switch (type) {
+      case CommandType::BIND_FRAMEBUFFER:
+        fn(ResourceKind::FRAMEBUFFER, p[0]);
+        break;
+      case CommandType::USE_PROGRAM:
+      case CommandType::UNIFORM_INT:
+      case CommandType::UNIFORM_FLOATS:
+        fn(ResourceKind::PROGRAM, p[0]);
+        break;
+      case CommandType::BIND_TEXTURE:
+        fn(ResourceKind::TEXTURE, p[1]);
+        break;
+      case CommandType::BIND_VERTEX_ARRAY:
+        fn(ResourceKind::VERTEX_ARRAY, p[0]);
+        break;
+      case CommandType::BIND_BUFFER_BASE:
+        fn(ResourceKind::BUFFER, p[2]);
+        break;
+      case CommandType::BUFFER_SUB_DATA:
+        fn(ResourceKind::BUFFER, p[0]);
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+private:
+  friend class CommandCapture;
+
+  std::vector<uint32_t> m_words;
+
+  size_t m_nCommands = 0;
+  size_t m_nDraws = 0;
+
+  static inline CommandType getType(uint32_t header) {
+    return static_cast<CommandType>(header & 0xff);
+  }
+
+  static inline size_t getPayloadSize(uint32_t header) { return header >> 8; }
+
+  // header + nWords of payload, returns the payload
+  inline uint32_t *push(CommandType type, size_t nWords) {
+
+    size_t offset = m_words.size();
+
+    m_words.resize(offset + 1 + nWords);
+    m_words[offset] =
+        static_cast<uint32_t>(type) | static_cast<uint32_t>(nWords << 8);
+
+    ++m_nCommands;
+
+    return &m_words[offset + 1];
+  }
+
+  inline void setFloats(const Shader &shader, int location,
+                        const float *values, uint32_t count) {
+
+    uint32_t *payload = push(CommandType::UNIFORM_FLOATS, 3 + count);
+    payload[0] = shader.getID();
+    payload[1] = static_cast<uint32_t>(location);
+    payload[2] = count;
+
+    std::memcpy(payload + 3, values, count * sizeof(float));
+  }
+
+  // the counts setProgramUniform has a glProgramUniform* for
+  static inline bool isUniformFloatCount(uint32_t count) {
+    return count == 1 || count == 2 || count == 3 || count == 4 ||
+           count == 9 || count == 16;
+  }
+
+  static inline void setProgramUniform(GLuint program, GLint location,
+                                       uint32_t count, const GLfloat *values) {
+    switch (count) {
+    case 1:
+      glProgramUniform1fv(program, location, 1, values);
+      break;
+    case 2:
+      glProgramUniform2fv(program, location, 1, values);
+      break;
+    case 3:
+      glProgramUniform3fv(program, location, 1, values);
+      break;
+    case 4:
+      glProgramUniform4fv(program, location, 1, values);
+      break;
+    case 9:
+      glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, values);
+      break;
+    case 16:
+      glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, values);
+      break;
+    default:
+      break;
+    }
+  }
+};
+
+// command file helpers
+namespace commandfile {
+
+constexpr char COMMAND_FILE_MAGIC[8] = {'L', 'O', 'G', 'L', 'C', 'M', 'D', 'S'};
+constexpr uint32_t COMMAND_FILE_VERSION = 1;
+
+// vertex attributes and bindings saved per vertex array
+constexpr GLuint MAX_SAVED_VERTEX_ATTRIBS = 16;
+
+// color attachments saved per framebuffer
+constexpr int MAX_SAVED_COLOR_ATTACHMENTS = 8;
+
+inline void reportCommandFileError(const std::string &message) {
+  glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0,
+                       GL_DEBUG_SEVERITY_HIGH, message.length(),
+                       message.c_str());
+}
+
+inline void writeWord(std::ostream &out, uint32_t word) {
+  out.write(reinterpret_cast<const char *>(&word), sizeof(word));
+}
+
+inline void writeWords(std::ostream &out, const std::vector<uint32_t> &words) {
+  writeWord(out, static_cast<uint32_t>(words.size()));
+  out.write(reinterpret_cast<const char *>(words.data()), words.size() * 4);
+}
+
+inline uint32_t readWord(std::istream &in) {
+  uint32_t word = 0;
+  in.read(reinterpret_cast<char *>(&word), sizeof(word));
+  return word;
+}
+
+// bytes left after the read position, 0 once the stream failed
+inline uint64_t getRemainingBytes(std::istream &in) {
+
+  if (!in) {
+    return 0;
+  }
+
+  std::streampos position = in.tellg();
+  in.seekg(0, std::ios::end);
+  std::streampos end = in.tellg();
+  in.seekg(position);
+
+  return in && end > position ? static_cast<uint64_t>(end - position) : 0;
+}
+
+/**
+ * A count of items that take at least bytesPerItem each in the rest of the
+ * file. One the file can't hold fails the stream and returns 0, so a
+ * corrupt count doesn't turn into a huge allocation.
+ */
+inline uint32_t readCount(std::istream &in, uint64_t bytesPerItem) {
+
+  uint32_t count = readWord(in);
+
+  if (!in || count * bytesPerItem > getRemainingBytes(in)) {
+    in.setstate(std::ios::failbit);
+    return 0;
+  }
+
+  return count;
+}
+
+inline std::vector<uint32_t> readWords(std::istream &in) {
+
+  std::vector<uint32_t> words(readCount(in, 4));
+
+  in.read(reinterpret_cast<char *>(words.data()), words.size() * 4);
+
+  return words;
+}
+
+/**
+ * Gl names of one kind to indices in the saved tables. Index 0 is "no
+ * object" (name 0, eg. the default framebuffer).
+ */
+struct ResourceTable {
+
+  std::vector<GLuint> names;
+  std::unordered_map<GLuint, uint32_t> indices;
+
+  uint32_t add(GLuint name) {
+
+    if (name == 0) {
+      return 0;
+    }
+
+    auto it = indices.find(name);
+    if (it != indices.end()) {
+      return it->second;
+    }
+
+    names.push_back(name);
+
+    uint32_t index = static_cast<uint32_t>(names.size());
+    indices[name] = index;
+
+    return index;
+  }
+};
+
+inline bool isLayeredTarget(GLint target) {
+  return target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_3D ||
+         target == GL_TEXTURE_CUBE_MAP || target == GL_TEXTURE_CUBE_MAP_ARRAY ||
+         target == GL_TEXTURE_1D_ARRAY ||
+         target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+}
+
+/**
+ * Each object is saved as a list of words, the references to other objects
+ * are indices in their tables.
+ */
+inline std::vector<uint32_t> describeBuffer(GLuint buffer) {
+
+  GLint size = 0;
+  glGetNamedBufferParameteriv(buffer, GL_BUFFER_SIZE, &size);
+
+  std::vector<uint32_t> words(1 + (size + 3) / 4, 0);
+  words[0] = static_cast<uint32_t>(size);
+
+  glGetNamedBufferSubData(buffer, 0, size, words.data() + 1);
+
+  return words;
+}
+
+inline std::vector<uint32_t> describeTexture(GLuint texture) {
+
+  GLint target = 0;
+  glGetTextureParameteriv(texture, GL_TEXTURE_TARGET, &target);
+
+  GLint width = 0;
+  GLint height = 0;
+  GLint depth = 0;
+  GLint internalFormat = 0;
+  GLint samples = 0;
+
+  glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+  glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_DEPTH, &depth);
+  glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT,
+                               &internalFormat);
+  glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_SAMPLES, &samples);
+
+  GLint immutable = 0;
+  GLint nLevels = 0;
+  glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+
+  if (immutable) {
+    glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &nLevels);
+  } else {
+
+    // mutable storage, count the defined levels
+    GLint levelWidth = width;
+    while (levelWidth > 0 && nLevels < 16) {
+      ++nLevels;
+      glGetTextureLevelParameteriv(texture, nLevels, GL_TEXTURE_WIDTH,
+                                   &levelWidth);
+    }
+  }
+
+  return {static_cast<uint32_t>(target),        static_cast<uint32_t>(width),
+          static_cast<uint32_t>(height),        static_cast<uint32_t>(depth),
+          static_cast<uint32_t>(internalFormat), static_cast<uint32_t>(samples),
+          static_cast<uint32_t>(std::max(nLevels, 1))};
+}
+
+inline std::vector<uint32_t> describeRenderbuffer(GLuint renderbuffer) {
+
+  GLint width = 0;
+  GLint height = 0;
+  GLint internalFormat = 0;
+  GLint samples = 0;
+
+  glGetNamedRenderbufferParameteriv(renderbuffer, GL_RENDERBUFFER_WIDTH,
+                                    &width);
+  glGetNamedRenderbufferParameteriv(renderbuffer, GL_RENDERBUFFER_HEIGHT,
+                                    &height);
+  glGetNamedRenderbufferParameteriv(
+      renderbuffer, GL_RENDERBUFFER_INTERNAL_FORMAT, &internalFormat);
+  glGetNamedRenderbufferParameteriv(renderbuffer, GL_RENDERBUFFER_SAMPLES,
+                                    &samples);
+
+  return {static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+          static_cast<uint32_t>(internalFormat),
+          static_cast<uint32_t>(samples)};
+}
+
+inline std::vector<uint32_t> describeProgram(GLuint program) {
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  // format, length, binary
+  std::vector<uint32_t> words(2 + (length + 3) / 4, 0);
+
+  if (length > 0) {
+
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, words.data() + 2);
+
+    words[0] = format;
+    words[1] = static_cast<uint32_t>(length);
+
+  } else {
+    reportCommandFileError("Program " + std::to_string(program) +
+                           " has no binary, it is not saved");
+  }
+
+  return words;
+}
+
+// the vertex array is bound (and the previous one restored) to query it
+inline std::vector<uint32_t> describeVertexArray(GLuint vertexArray,
+                                                 ResourceTable &buffers) {
+
+  GLint previous = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+
+  glBindVertexArray(vertexArray);
+
+  std::vector<uint32_t> words;
+
+  GLint elementBuffer = 0;
+  glGetVertexArrayiv(vertexArray, GL_ELEMENT_ARRAY_BUFFER_BINDING,
+                     &elementBuffer);
+
+  words.push_back(buffers.add(static_cast<GLuint>(elementBuffer)));
+
+  // enabled attributes: index, size, type, normalized, integer,
+  // relative offset, binding
+  std::vector<uint32_t> attribs;
+
+  for (GLuint i = 0; i < MAX_SAVED_VERTEX_ATTRIBS; ++i) {
+
+    GLint enabled = 0;
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+
+    if (!enabled) {
+      continue;
+    }
+
+    GLint values[6];
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &values[0]);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &values[1]);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &values[2]);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &values[3]);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_RELATIVE_OFFSET, &values[4]);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_BINDING, &values[5]);
+
+    attribs.push_back(i);
+    for (GLint value : values) {
+      attribs.push_back(static_cast<uint32_t>(value));
+    }
+  }
+
+  // bindings with a buffer: index, buffer, offset, stride, divisor
+  std::vector<uint32_t> bindings;
+
+  for (GLuint i = 0; i < MAX_SAVED_VERTEX_ATTRIBS; ++i) {
+
+    GLint buffer = 0;
+    glGetIntegeri_v(GL_VERTEX_BINDING_BUFFER, i, &buffer);
+
+    if (buffer == 0) {
+      continue;
+    }
+
+    GLint64 offset = 0;
+    GLint stride = 0;
+    GLint divisor = 0;
+
+    glGetInteger64i_v(GL_VERTEX_BINDING_OFFSET, i, &offset);
+    glGetIntegeri_v(GL_VERTEX_BINDING_STRIDE, i, &stride);
+    glGetIntegeri_v(GL_VERTEX_BINDING_DIVISOR, i, &divisor);
+
+    bindings.insert(bindings.end(),
+                    {i, buffers.add(static_cast<GLuint>(buffer)),
+                     static_cast<uint32_t>(offset),
+                     static_cast<uint32_t>(stride),
+                     static_cast<uint32_t>(divisor)});
+  }
+
+  glBindVertexArray(static_cast<GLuint>(previous));
+
+  words.push_back(static_cast<uint32_t>(attribs.size() / 7));
+  words.insert(words.end(), attribs.begin(), attribs.end());
+
+  words.push_back(static_cast<uint32_t>(bindings.size() / 5));
+  words.insert(words.end(), bindings.begin(), bindings.end());
+
+  return words;
+}
+
+inline std::vector<uint32_t> describeFramebuffer(GLuint framebuffer,
+                                                 ResourceTable &textures,
+                                                 ResourceTable &renderbuffers) {
+
+  std::vector<GLenum> attachmentPoints;
+  for (int i = 0; i < MAX_SAVED_COLOR_ATTACHMENTS; ++i) {
+    attachmentPoints.push_back(GL_COLOR_ATTACHMENT0 + i);
+  }
+  attachmentPoints.push_back(GL_DEPTH_ATTACHMENT);
+  attachmentPoints.push_back(GL_STENCIL_ATTACHMENT);
+
+  // attachments: point, type, object, level, layer (~0: all layers)
+  std::vector<uint32_t> attachments;
+
+  for (GLenum point : attachmentPoints) {
+
+    GLint type = GL_NONE;
+    glGetNamedFramebufferAttachmentParameteriv(
+        framebuffer, point, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+
+    if (type != GL_TEXTURE && type != GL_RENDERBUFFER) {
+      continue;
+    }
+
+    GLint name = 0;
+    glGetNamedFramebufferAttachmentParameteriv(
+        framebuffer, point, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &name);
+
+    uint32_t object = 0;
+    uint32_t level = 0;
+    uint32_t layer = ~0u;
+
+    if (type == GL_TEXTURE) {
+
+      object = textures.add(static_cast<GLuint>(name));
+
+      GLint value = 0;
+
+      glGetNamedFramebufferAttachmentParameteriv(
+          framebuffer, point, GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LEVEL, &value);
+      level = static_cast<uint32_t>(value);
+
+      GLint layered = 0;
+      glGetNamedFramebufferAttachmentParameteriv(
+          framebuffer, point, GL_FRAMEBUFFER_ATTACHMENT_LAYERED, &layered);
+
+      GLint target = 0;
+      glGetTextureParameteriv(static_cast<GLuint>(name), GL_TEXTURE_TARGET,
+                              &target);
+
+      if (!layered && isLayeredTarget(target)) {
+        glGetNamedFramebufferAttachmentParameteriv(
+            framebuffer, point, GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LAYER,
+            &value);
+        layer = static_cast<uint32_t>(value);
+      }
+
+    } else {
+      object = renderbuffers.add(static_cast<GLuint>(name));
+    }
+
+    attachments.insert(attachments.end(), {point, static_cast<uint32_t>(type),
+                                           object, level, layer});
+  }
+
+  // draw buffers, queried through the binding
+  GLint previous = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+  std::vector<uint32_t> words;
+  words.push_back(static_cast<uint32_t>(attachments.size() / 5));
+  words.insert(words.end(), attachments.begin(), attachments.end());
+
+  for (int i = 0; i < MAX_SAVED_COLOR_ATTACHMENTS; ++i) {
+    GLint drawBuffer = GL_NONE;
+    glGetIntegerv(GL_DRAW_BUFFER0 + i, &drawBuffer);
+    words.push_back(static_cast<uint32_t>(drawBuffer));
+  }
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+  return words;
+}
+
+} // namespace commandfile
+
+inline bool CommandBuffer::save(const std::string &path) const {
+
+  CPU_PROFILE_ZONE("CommandBuffer::save");
+
+  using namespace commandfile;
+
+  std::array<ResourceTable, N_RESOURCE_KINDS> tables;
+
+  auto table = [&](ResourceKind kind) -> ResourceTable & {
+    return tables[static_cast<size_t>(kind)];
+  };
+
+  // names to table indices
+  std::vector<uint32_t> words = m_words;
+
+  forEachReference(words, [&](ResourceKind kind, uint32_t &name) {
+    name = table(kind).add(name);
+  });
+
+  // vertex arrays and framebuffers add the objects they reference, so they
+  // are described first
+  std::array<std::vector<std::vector<uint32_t>>, N_RESOURCE_KINDS>
+      descriptions;
+
+  for (GLuint name : table(ResourceKind::VERTEX_ARRAY).names) {
+    descriptions[static_cast<size_t>(ResourceKind::VERTEX_ARRAY)].push_back(
+        describeVertexArray(name, table(ResourceKind::BUFFER)));
+  }
+
+  for (GLuint name : table(ResourceKind::FRAMEBUFFER).names) {
+    descriptions[static_cast<size_t>(ResourceKind::FRAMEBUFFER)].push_back(
+        describeFramebuffer(name, table(ResourceKind::TEXTURE),
+                            table(ResourceKind::RENDERBUFFER)));
+  }
+
+  for (GLuint name : table(ResourceKind::BUFFER).names) {
+    descriptions[static_cast<size_t>(ResourceKind::BUFFER)].push_back(
+        describeBuffer(name));
+  }
+
+  for (GLuint name : table(ResourceKind::TEXTURE).names) {
+    descriptions[static_cast<size_t>(ResourceKind::TEXTURE)].push_back(
+        describeTexture(name));
+  }
+
+  for (GLuint name : table(ResourceKind::RENDERBUFFER).names) {
+    descriptions[static_cast<size_t>(ResourceKind::RENDERBUFFER)].push_back(
+        describeRenderbuffer(name));
+  }
+
+  for (GLuint name : table(ResourceKind::PROGRAM).names) {
+    descriptions[static_cast<size_t>(ResourceKind::PROGRAM)].push_back(
+        describeProgram(name));
+  }
+
+  std::ofstream out{path, std::ios::binary};
+
+  if (!out) {
+    reportCommandFileError("Could not write the command file " + path);
+    return false;
+  }
+
+  out.write(COMMAND_FILE_MAGIC, sizeof(COMMAND_FILE_MAGIC));
+  writeWord(out, COMMAND_FILE_VERSION);
+
+  for (const std::vector<std::vector<uint32_t>> &kind : descriptions) {
+
+    writeWord(out, static_cast<uint32_t>(kind.size()));
+
+    for (const std::vector<uint32_t> &description : kind) {
+      writeWords(out, description);
+    }
+  }
+
+  writeWord(out, static_cast<uint32_t>(m_nCommands));
+  writeWord(out, static_cast<uint32_t>(m_nDraws));
+  writeWords(out, words);
+
+  return static_cast<bool>(out);
+}
+
+/**
+ * A command file loaded back: the objects it references, recreated, and
+ * the commands rewritten to use them. Replaying it needs nothing from the
+ * demo that saved it.
+ */
+class CommandCapture {
+
+public:
+  CommandCapture() {}
+
+  static CommandCapture load(const std::string &path) {
+
+    CPU_PROFILE_ZONE("CommandCapture::load");
+
+    using namespace commandfile;
+
+    CommandCapture capture;
+
+    std::ifstream in{path, std::ios::binary};
+
+    char magic[sizeof(COMMAND_FILE_MAGIC)] = {};
+    in.read(magic, sizeof(magic));
+
+    if (!in ||
+        std::memcmp(magic, COMMAND_FILE_MAGIC, sizeof(COMMAND_FILE_MAGIC)) !=
+            0 ||
+        readWord(in) != COMMAND_FILE_VERSION) {
+      reportCommandFileError("Not a command file: " + path);
+      return capture;
+    }
+
+    std::array<std::vector<std::vector<uint32_t>>, N_RESOURCE_KINDS>
+        descriptions;
+
+    for (std::vector<std::vector<uint32_t>> &kind : descriptions) {
+
+      // each description is at least its word count
+      kind.resize(readCount(in, 4));
+
+      for (std::vector<uint32_t> &description : kind) {
+        description = readWords(in);
+      }
+    }
+
+    size_t nCommands = readWord(in);
+    size_t nDraws = readWord(in);
+
+    std::vector<uint32_t> words = readWords(in);
+
+    bool valid = static_cast<bool>(in) && isValidStream(words);
+
+    for (size_t kind = 0; kind < N_RESOURCE_KINDS; ++kind) {
+      for (const std::vector<uint32_t> &description : descriptions[kind]) {
+        valid = valid && isValidDescription(static_cast<ResourceKind>(kind),
+                                            description);
+      }
+    }
+
+    if (!valid) {
+      reportCommandFileError("Truncated or corrupt command file: " + path);
+      return capture;
+    }
+
+    // in dependency order, the descriptions refer to earlier kinds
+    for (size_t kind = 0; kind < N_RESOURCE_KINDS; ++kind) {
+      for (const std::vector<uint32_t> &description : descriptions[kind]) {
+        capture.m_names[kind].push_back(capture.createObject(
+            static_cast<ResourceKind>(kind), description, valid));
+      }
+    }
+
+    if (!valid) {
+      reportCommandFileError("Command file objects could not be recreated: " +
+                             path);
+      capture.destroy();
+      return capture;
+    }
+
+    CommandBuffer::forEachReference(
+        words, [&](ResourceKind kind, uint32_t &index) {
+          index = capture.getName(kind, index, valid);
+        });
+
+    if (!valid) {
+      reportCommandFileError("Command file references missing objects: " +
+                             path);
+      capture.destroy();
+      return capture;
+    }
+
+    capture.m_commands.m_words = std::move(words);
+    capture.m_commands.m_nCommands = nCommands;
+    capture.m_commands.m_nDraws = nDraws;
+
+    capture.m_valid = true;
+
+    return capture;
+  }
+
+  inline bool isValid() const { return m_valid; }
+
+  inline const CommandBuffer &getCommands() const { return m_commands; }
+
+  inline size_t getNumObjects(ResourceKind kind) const {
+    return m_names[static_cast<size_t>(kind)].size();
+  }
+
+  void destroy() {
+
+    using Kind = ResourceKind;
+
+    std::vector<GLuint> &framebuffers = names(Kind::FRAMEBUFFER);
+    std::vector<GLuint> &vertexArrays = names(Kind::VERTEX_ARRAY);
+    std::vector<GLuint> &renderbuffers = names(Kind::RENDERBUFFER);
+    std::vector<GLuint> &textures = names(Kind::TEXTURE);
+    std::vector<GLuint> &buffers = names(Kind::BUFFER);
+
+    glDeleteFramebuffers(framebuffers.size(), framebuffers.data());
+    glDeleteVertexArrays(vertexArrays.size(), vertexArrays.data());
+    glDeleteRenderbuffers(renderbuffers.size(), renderbuffers.data());
+    glDeleteTextures(textures.size(), textures.data());
+    glDeleteBuffers(buffers.size(), buffers.data());
+
+    for (GLuint program : names(Kind::PROGRAM)) {
+      glDeleteProgram(program);
+    }
+
+    for (std::vector<GLuint> &kind : m_names) {
+      kind.clear();
+    }
+
+    m_commands.reset();
+    m_valid = false;
+  }
+
+private:
+  CommandBuffer m_commands;
+
+  // gl names of the recreated objects, by kind and saved index - 1
+  std::array<std::vector<GLuint>, N_RESOURCE_KINDS> m_names;
+
+  bool m_valid = false;
+
+  inline std::vector<GLuint> &names(ResourceKind kind) {
+    return m_names[static_cast<size_t>(kind)];
+  }
+
+  // 0 stays 0, out of range indices clear 'valid'
+  inline GLuint getName(ResourceKind kind, uint32_t index, bool &valid) const {
+
+    const std::vector<GLuint> &kindNames = m_names[static_cast<size_t>(kind)];
+
+    if (index == 0) {
+      return 0;
+    }
+
+    if (index > kindNames.size()) {
+      valid = false;
+      return 0;
+    }
+
+    return kindNames[index - 1];
+  }
+
+  /**
+   * Known commands, each with the payload execute() reads: a fixed size, or
+   * the size its counts give for the uniform floats and buffer data.
+   */
+  static bool isValidStream(const std::vector<uint32_t> &words) {
+
+    size_t i = 0;
+
+    while (i < words.size()) {
+
+      CommandType type = CommandBuffer::getType(words[i]);
+      uint64_t size = CommandBuffer::getPayloadSize(words[i]);
+
+      if (i + 1 + size > words.size()) {
+        return false;
+      }
+
+      const uint32_t *p = words.data() + i + 1;
+
+      switch (type) {
+
+      case CommandType::BIND_FRAMEBUFFER:
+      case CommandType::CLEAR:
+      case CommandType::ENABLE:
+      case CommandType::DISABLE:
+      case CommandType::USE_PROGRAM:
+      case CommandType::BIND_VERTEX_ARRAY:
+        if (size != 1) {
+          return false;
+        }
+        break;
+
+      case CommandType::BIND_TEXTURE:
+        if (size != 2) {
+          return false;
+        }
+        break;
+
+      case CommandType::BIND_BUFFER_BASE:
+      case CommandType::UNIFORM_INT:
+        if (size != 3) {
+          return false;
+        }
+        break;
+
+      case CommandType::VIEWPORT:
+      case CommandType::CLEAR_COLOR:
+      case CommandType::DRAW_ARRAYS:
+      case CommandType::DRAW_ELEMENTS:
+        if (size != 4) {
+          return false;
+        }
+        break;
+
+      case CommandType::UNIFORM_FLOATS:
+        if (size < 3 || size != 3 + uint64_t{p[2]} ||
+            !CommandBuffer::isUniformFloatCount(p[2])) {
+          return false;
+        }
+        break;
+
+      case CommandType::BUFFER_SUB_DATA:
+        if (size < 3 || size != 3 + (uint64_t{p[2]} + 3) / 4) {
+          return false;
+        }
+        break;
+
+      default:
+        return false;
+      }
+
+      i += 1 + size;
+    }
+
+    return true;
+  }
+
+  // enough words for what createObject reads
+  static bool isValidDescription(ResourceKind kind,
+                                 const std::vector<uint32_t> &words) {
+
+    using commandfile::MAX_SAVED_COLOR_ATTACHMENTS;
+
+    // words needed to hold 'bytes'
+    auto wordsFor = [](uint64_t bytes) { return (bytes + 3) / 4; };
+
+    switch (kind) {
+
+    case ResourceKind::BUFFER:
+      return words.size() >= 1 && words.size() >= 1 + wordsFor(words[0]);
+
+    case ResourceKind::TEXTURE:
+      return words.size() >= 7;
+
+    case ResourceKind::RENDERBUFFER:
+      return words.size() >= 4;
+
+    case ResourceKind::PROGRAM:
+      return words.size() >= 2 && words.size() >= 2 + wordsFor(words[1]);
+
+    case ResourceKind::VERTEX_ARRAY: {
+
+      if (words.size() < 2) {
+        return false;
+      }
+
+      uint64_t nBindingsAt = 2 + 7 * static_cast<uint64_t>(words[1]);
+
+      return words.size() > nBindingsAt &&
+             words.size() >= nBindingsAt + 1 + 5 * uint64_t{words[nBindingsAt]};
+    }
+
+    case ResourceKind::FRAMEBUFFER:
+      return words.size() >= 1 &&
+             words.size() >= 1 + 5 * uint64_t{words[0]} +
+                                 MAX_SAVED_COLOR_ATTACHMENTS;
+
+    default:
+      return false;
+    }
+  }
+
+  // clears 'created' when the object can't be made as it was saved
+  GLuint createObject(ResourceKind kind, const std::vector<uint32_t> &words,
+                      bool &created) {
+
+    using namespace commandfile;
+
+    bool valid = true;
+    GLuint name = 0;
+
+    switch (kind) {
+
+    case ResourceKind::BUFFER:
+      glCreateBuffers(1, &name);
+      // dynamic, the stream may update it. Zero sized storage is an error
+      glNamedBufferStorage(name, std::max<uint32_t>(words[0], 4),
+                           words[0] > 0 ? words.data() + 1 : nullptr,
+                           GL_DYNAMIC_STORAGE_BIT);
+      break;
+
+    case ResourceKind::TEXTURE:
+      name = createTexture(words);
+      break;
+
+    case ResourceKind::RENDERBUFFER:
+      glCreateRenderbuffers(1, &name);
+      glNamedRenderbufferStorageMultisample(name, words[3], words[2], words[0],
+                                            words[1]);
+      break;
+
+    case ResourceKind::PROGRAM:
+      if (words[1] > 0) {
+        name = glCreateProgram();
+        glProgramBinary(name, words[0], words.data() + 2, words[1]);
+
+        // a binary of another driver (or version) is rejected
+        GLint linked = GL_FALSE;
+        glGetProgramiv(name, GL_LINK_STATUS, &linked);
+
+        if (!linked) {
+          reportCommandFileError("Saved program binary rejected by the driver");
+          created = false;
+        }
+      }
+      break;
+
+    case ResourceKind::VERTEX_ARRAY: {
+
+      glCreateVertexArrays(1, &name);
+
+      glVertexArrayElementBuffer(
+          name, getName(ResourceKind::BUFFER, words[0], valid));
+
+      size_t i = 1;
+
+      size_t nAttribs = words[i++];
+      for (size_t a = 0; a < nAttribs; ++a, i += 7) {
+
+        GLuint index = words[i];
+
+        glEnableVertexArrayAttrib(name, index);
+
+        if (words[i + 4]) {
+          glVertexArrayAttribIFormat(name, index, words[i + 1], words[i + 2],
+                                     words[i + 5]);
+        } else {
+          glVertexArrayAttribFormat(name, index, words[i + 1], words[i + 2],
+                                    words[i + 3] ? GL_TRUE : GL_FALSE,
+                                    words[i + 5]);
+        }
+
+        glVertexArrayAttribBinding(name, index, words[i + 6]);
+      }
+
+      size_t nBindings = words[i++];
+      for (size_t b = 0; b < nBindings; ++b, i += 5) {
+        glVertexArrayVertexBuffer(
+            name, words[i], getName(ResourceKind::BUFFER, words[i + 1], valid),
+            words[i + 2], words[i + 3]);
+        glVertexArrayBindingDivisor(name, words[i], words[i + 4]);
+      }
+
+      break;
+    }
+
+    case ResourceKind::FRAMEBUFFER: {
+
+      glCreateFramebuffers(1, &name);
+
+      size_t i = 1;
+
+      for (size_t a = 0; a < words[0]; ++a, i += 5) {
+
+        GLenum point = words[i];
+
+        if (words[i + 1] == GL_RENDERBUFFER) {
+          glNamedFramebufferRenderbuffer(
+              name, point, GL_RENDERBUFFER,
+              getName(ResourceKind::RENDERBUFFER, words[i + 2], valid));
+          continue;
+        }
+
+        GLuint texture = getName(ResourceKind::TEXTURE, words[i + 2], valid);
+
+        if (words[i + 4] == ~0u) {
+          glNamedFramebufferTexture(name, point, texture, words[i + 3]);
+        } else {
+          glNamedFramebufferTextureLayer(name, point, texture, words[i + 3],
+                                         words[i + 4]);
+        }
+      }
+
+      GLenum drawBuffers[MAX_SAVED_COLOR_ATTACHMENTS];
+      for (int d = 0; d < MAX_SAVED_COLOR_ATTACHMENTS; ++d) {
+        drawBuffers[d] = words[i + d];
+      }
+
+      glNamedFramebufferDrawBuffers(name, MAX_SAVED_COLOR_ATTACHMENTS,
+                                    drawBuffers);
+      break;
+    }
+
+    default:
+      break;
+    }
+
+    if (!valid) {
+      reportCommandFileError("Saved object references a missing object");
+      created = false;
+    }
+
+    return name;
+  }
+
+  // storage only, the contents aren't saved
+  static GLuint createTexture(const std::vector<uint32_t> &words) {
+
+    GLenum target = words[0];
+    GLsizei width = words[1];
+    GLsizei height = words[2];
+    GLsizei depth = words[3];
+    GLenum internalFormat = words[4];
+    GLsizei samples = words[5];
+    GLsizei nLevels = words[6];
+
+    GLuint name = 0;
+    glCreateTextures(target, 1, &name);
+
+    switch (target) {
+    case GL_TEXTURE_1D:
+      glTextureStorage1D(name, nLevels, internalFormat, width);
+      break;
+    case GL_TEXTURE_2D:
+    case GL_TEXTURE_1D_ARRAY:
+    case GL_TEXTURE_RECTANGLE:
+    case GL_TEXTURE_CUBE_MAP:
+      glTextureStorage2D(name, nLevels, internalFormat, width, height);
+      break;
+    case GL_TEXTURE_2D_ARRAY:
+    case GL_TEXTURE_3D:
+    case GL_TEXTURE_CUBE_MAP_ARRAY:
+      glTextureStorage3D(name, nLevels, internalFormat, width, height, depth);
+      break;
+    case GL_TEXTURE_2D_MULTISAMPLE:
+      glTextureStorage2DMultisample(name, samples, internalFormat, width,
+                                    height, GL_TRUE);
+      break;
+    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
+      glTextureStorage3DMultisample(name, samples, internalFormat, width,
+                                    height, depth, GL_TRUE);
+      break;
+    default:
+      commandfile::reportCommandFileError("Unsupported texture target " +
+                             std::to_string(target) + " in command file");
+      break;
+    }
+
+    return name;
+  }
+};
+
+} // namespace gpu
+
+#endif // GPU_COMMAND_BUFFER_H
@@ -0,0 +1,128 @@
+#ifndef GPU_COMPACT_INSTANCE_H
+#define GPU_COMPACT_INSTANCE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace gpu {
+
+/**
+ * The range the positions and scales of the instances are quantized over,
+ * instance = min + unorm16 * extent. The instanced shaders get it as 2 vec4
+ * uniforms (instanceMin, instanceExtent).
+ */
+struct InstanceQuantization {
+
+  InstanceQuantization() {}
+
+  // xyz: position, w: scale
+  glm::vec4 min{0.0f};
+  glm::vec4 extent{1.0f};
+};
+
+/**
+ * Translation, rotation and uniform scale of an instance in 16 bytes
+ * instead of a 64 bytes mat4:
+ *
+ *  location 8: x, y, z, scale   unorm16, over the InstanceQuantization
+ *  location 9: rotation         snorm16 quaternion (x, y, z, w)
+ *
+ * (gpu::InstanceBuffer<CompactInstance> sets these attributes up)
+ *
+ * decoded in the vertex shader, as decodeInstance() does:
+ *
+ *  p = q.xyz, v = scale * vertex
+ *  world = position + v + 2 * cross(p, cross(p, v) + q.w * v)
+ *
+ * With a 350 units wide range a position step is 0.005 units.
+ */
+struct CompactInstance {
+  uint16_t positionScale[4];
+  int16_t rotation[4];
+};
+
+static_assert(sizeof(CompactInstance) == 16, "CompactInstance is 16 bytes");
+
+inline uint16_t quantizeUnorm16(float value) {
+  return static_cast<uint16_t>(
+      std::nearbyint(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline int16_t quantizeSnorm16(float value) {
+  return static_cast<int16_t>(
+      std::nearbyint(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// rotation: unit quaternion (x, y, z, w), eg. (axis * sin(a/2), cos(a/2))
+inline CompactInstance encodeInstance(const InstanceQuantization &range,
+                                      const glm::vec3 &position,
+                                      const glm::vec4 &rotation,
+                                      float scale) {
+
+  glm::vec4 normalized = (glm::vec4{position, scale} - range.min) /
+                         glm::max(range.extent, glm::vec4{1e-20f});
+
+  CompactInstance instance;
+
+  for (int i = 0; i < 4; ++i) {
+    instance.positionScale[i] = quantizeUnorm16(normalized[i]);
+    instance.rotation[i] = quantizeSnorm16(rotation[i]);
+  }
+
+  return instance;
+}
+
+// the translation alone, eg. to sort or split instances by distance
+inline glm::vec3 decodePosition(const InstanceQuantization &range,
+                                const CompactInstance &instance) {
+
+  glm::vec3 position;
+
+  for (int i = 0; i < 3; ++i) {
+    position[i] = range.min[i] +
+                  range.extent[i] * (instance.positionScale[i] / 65535.0f);
+  }
+
+  return position;
+}
+
+// the model matrix the vertex shader ends up applying
+inline glm::mat4 decodeInstance(const InstanceQuantization &range,
+                                const CompactInstance &instance) {
+
+  glm::vec4 positionScale;
+  glm::vec4 q;
+
+  for (int i = 0; i < 4; ++i) {
+    positionScale[i] = range.min[i] + range.extent[i] *
+                                          (instance.positionScale[i] /
+                                           65535.0f);
+    q[i] = std::max(instance.rotation[i] / 32767.0f, -1.0f);
+  }
+
+  glm::vec3 p{q};
+
+  // columns: the rotated basis vectors, scaled
+  glm::mat4 model{1.0f};
+
+  for (int col = 0; col < 3; ++col) {
+
+    glm::vec3 v{0.0f};
+    v[col] = positionScale.w;
+
+    model[col] = glm::vec4{
+        v + 2.0f * glm::cross(p, glm::cross(p, v) + q.w * v), 0.0f};
+  }
+
+  model[3] = glm::vec4{glm::vec3{positionScale}, 1.0f};
+
+  return model;
+}
+
+} // namespace gpu
+
+#endif // GPU_COMPACT_INSTANCE_H
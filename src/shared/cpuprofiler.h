@@ -0,0 +1,415 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// the zone hot path stays inlined in unoptimized builds too
+#if defined(_MSC_VER)
+#define PROFILER_FORCE_INLINE __forceinline
+#else
+#define PROFILER_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace profiler {
+
+// zones kept per thread, the oldest are overwritten
+constexpr size_t CPU_RING_CAPACITY = 1 << 16;
+
+static_assert((CPU_RING_CAPACITY & (CPU_RING_CAPACITY - 1)) == 0,
+              "the ring capacity has to be a power of 2");
+
+inline int64_t getCpuNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Time stamp counter where available (a few ns to read), steady_clock
+ * nanoseconds otherwise. Converted to steady_clock nanoseconds on export.
+ */
+PROFILER_FORCE_INLINE uint64_t readTicks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(getCpuNanoseconds());
+#endif
+}
+
+// JSON string contents, quotes, backslashes and control characters escaped
+inline void writeJsonString(std::ostream &out, const std::string &value) {
+
+  for (char c : value) {
+
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      const char *digits = "0123456789abcdef";
+      out << "\\u00" << digits[(c >> 4) & 0xf] << digits[c & 0xf];
+    } else {
+      out << c;
+    }
+  }
+}
+
+/**
+ * Writes one complete ("X") event of the chrome trace event format
+ * (chrome://tracing, ui.perfetto.dev). Timestamps are in microseconds.
+ */
+inline void writeTraceEvent(std::ostream &out, bool &first,
+                            const std::string &name, const char *category,
+                            int tid, int64_t beginNs, int64_t durationNs) {
+
+  out << (first ? "\n" : ",\n");
+  first = false;
+
+  // fixed, the timestamps are too large for the default precision
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+
+  out << std::fixed << std::setprecision(3);
+
+  out << "{\"name\":\"";
+  writeJsonString(out, name);
+  out << "\",\"cat\":\"";
+  writeJsonString(out, category);
+  out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+      << ",\"ts\":" << static_cast<double>(beginNs) * 1e-3
+      << ",\"dur\":" << static_cast<double>(durationNs) * 1e-3 << "}";
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+inline void writeThreadName(std::ostream &out, bool &first, int tid,
+                            const std::string &name) {
+
+  out << (first ? "\n" : ",\n");
+  first = false;
+
+  out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+      << ",\"args\":{\"name\":\"";
+  writeJsonString(out, name);
+  out << "\"}}";
+}
+
+struct CpuZoneEvent {
+
+  uint64_t beginTicks;
+  uint64_t endTicks;
+
+  // CpuProfiler::internName
+  uint32_t nameID;
+};
+
+/**
+ * Zones of one thread, only the owner thread writes. Export and clear while
+ * the threads are not recording (eg. between frames, after the jobs of the
+ * frame were waited for): that wait is what makes the ring and its head
+ * visible to the exporter, the head is a plain counter so recording stays
+ * free of atomics.
+ */
+class CpuThreadBuffer {
+
+public:
+  CpuThreadBuffer(int tid, const std::string &name)
+      : m_tid(tid), m_name(name),
+        m_storage(std::make_unique<CpuZoneEvent[]>(CPU_RING_CAPACITY)),
+        m_events(m_storage.get()) {}
+
+  PROFILER_FORCE_INLINE void record(uint32_t nameID, uint64_t beginTicks,
+                                    uint64_t endTicks) {
+
+    m_events[m_head & (CPU_RING_CAPACITY - 1)] =
+        CpuZoneEvent{beginTicks, endTicks, nameID};
+
+    ++m_head;
+  }
+
+  inline int getTid() const { return m_tid; }
+
+  inline const std::string &getName() const { return m_name; }
+  inline void setName(const std::string &name) { m_name = name; }
+
+  // oldest first
+  template <typename Fn> void forEachEvent(Fn fn) const {
+
+    uint64_t head = m_head;
+    uint64_t first = head > CPU_RING_CAPACITY ? head - CPU_RING_CAPACITY : 0;
+
+    for (uint64_t i = first; i < head; ++i) {
+      fn(m_events[i & (CPU_RING_CAPACITY - 1)]);
+    }
+  }
+
+  inline void clear() { m_head = 0; }
+
+private:
+  int m_tid;
+  std::string m_name;
+
+  std::unique_ptr<CpuZoneEvent[]> m_storage;
+
+  // m_storage.get(), indexed without a call in unoptimized builds
+  CpuZoneEvent *m_events;
+
+  uint64_t m_head = 0;
+};
+
+/**
+ * The ring of the calling thread once it recorded a zone. At namespace
+ * scope, so a zone reads it without the guards of CpuProfiler::get() and
+ * of a function local thread_local.
+ */
+inline thread_local CpuThreadBuffer *t_threadBuffer = nullptr;
+
+/**
+ * Process wide cpu zone recorder, use it through the CPU_PROFILE_* macros
+ * so it's compiled out unless CPU_PROFILER_ENABLED is defined (cmake
+ * -DENABLE_CPU_PROFILER=ON).
+ *
+ * Every thread gets its own ring on its first zone. Zone names are interned
+ * once per call site, recording a zone is two tick reads, a thread local
+ * load and a 24 byte store in the ring of the thread, all inlined, no locks
+ * and no calls.
+ * GpuProfiler::exportChromeTrace writes these zones along with the gpu
+ * scopes.
+ */
+class CpuProfiler {
+
+public:
+  static CpuProfiler &get() {
+    static CpuProfiler instance;
+    return instance;
+  }
+
+  CpuProfiler(const CpuProfiler &) = delete;
+  CpuProfiler &operator=(const CpuProfiler &) = delete;
+
+  inline CpuThreadBuffer &getThreadBuffer() {
+
+    if (t_threadBuffer == nullptr) {
+      t_threadBuffer = registerThread();
+    }
+
+    return *t_threadBuffer;
+  }
+
+  inline void setThreadName(const std::string &name) {
+    getThreadBuffer().setName(name);
+  }
+
+  // same name, same id
+  uint32_t internName(const char *name) {
+
+    std::lock_guard<std::mutex> lock{m_threadsMutex};
+
+    auto it = m_nameIDs.find(name);
+
+    if (it != m_nameIDs.end()) {
+      return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_names.size());
+
+    m_names.push_back(name);
+    m_nameIDs[name] = id;
+
+    return id;
+  }
+
+  /**
+   * Frame boundary, call it from the thread that runs the frames. The time
+   * between two markers is recorded as a "frame" zone.
+   */
+  inline void markFrame() {
+
+    uint64_t now = readTicks();
+    uint64_t last = m_lastFrameTicks.exchange(now, std::memory_order_relaxed);
+
+    if (last != 0) {
+      getThreadBuffer().record(m_frameNameID, last, now);
+    }
+
+    m_nFrames.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inline uint64_t getNumFrames() const {
+    return m_nFrames.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Ticks to the steady_clock domain, the tick rate is measured between the
+   * creation of the profiler and the call (longer is more precise).
+   */
+  inline int64_t ticksToNanoseconds(uint64_t ticks) const {
+    return toNanoseconds(ticks, measureTickRate());
+  }
+
+  void writeTraceEvents(std::ostream &out, bool &first) const {
+
+    std::lock_guard<std::mutex> lock{m_threadsMutex};
+
+    double ticksPerNanosecond = measureTickRate();
+
+    for (const std::unique_ptr<CpuThreadBuffer> &thread : m_threads) {
+
+      writeThreadName(out, first, thread->getTid(), thread->getName());
+
+      thread->forEachEvent([&](const CpuZoneEvent &event) {
+        int64_t beginNs = toNanoseconds(event.beginTicks, ticksPerNanosecond);
+        int64_t endNs = toNanoseconds(event.endTicks, ticksPerNanosecond);
+
+        writeTraceEvent(out, first, m_names[event.nameID], "cpu",
+                        thread->getTid(), beginNs, endNs - beginNs);
+      });
+    }
+  }
+
+  void clear() {
+
+    std::lock_guard<std::mutex> lock{m_threadsMutex};
+
+    for (const std::unique_ptr<CpuThreadBuffer> &thread : m_threads) {
+      thread->clear();
+    }
+  }
+
+private:
+  CpuProfiler() : m_originTicks(readTicks()), m_originNs(getCpuNanoseconds()) {
+    m_frameNameID = internName("frame");
+  }
+
+  uint64_t m_originTicks;
+  int64_t m_originNs;
+
+  std::atomic<uint64_t> m_lastFrameTicks{0};
+  std::atomic<uint64_t> m_nFrames{0};
+
+  uint32_t m_frameNameID = 0;
+
+  // the buffers outlive their threads, so zones of finished workers are
+  // still exported
+  mutable std::mutex m_threadsMutex;
+  std::vector<std::unique_ptr<CpuThreadBuffer>> m_threads;
+
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, uint32_t> m_nameIDs;
+
+  CpuThreadBuffer *registerThread() {
+
+    std::lock_guard<std::mutex> lock{m_threadsMutex};
+
+    int tid = static_cast<int>(m_threads.size());
+
+    // the first thread to record is normally the main thread
+    std::string name = tid == 0 ? "main" : "thread " + std::to_string(tid);
+
+    m_threads.push_back(std::make_unique<CpuThreadBuffer>(tid, name));
+
+    return m_threads.back().get();
+  }
+
+  // signed, the first zone can begin before the profiler is created
+  inline int64_t toNanoseconds(uint64_t ticks,
+                               double ticksPerNanosecond) const {
+
+    int64_t elapsedTicks = static_cast<int64_t>(ticks - m_originTicks);
+
+    return m_originNs + static_cast<int64_t>(static_cast<double>(elapsedTicks) /
+                                             ticksPerNanosecond);
+  }
+
+  double measureTickRate() const {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    // too short an interval gives a poor estimate
+    while (getCpuNanoseconds() - m_originNs < 10000000) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint64_t ticks = readTicks();
+    int64_t ns = getCpuNanoseconds();
+
+    return static_cast<double>(ticks - m_originTicks) /
+           static_cast<double>(ns - m_originNs);
+#else
+    return 1.0;
+#endif
+  }
+};
+
+class CpuZone {
+
+public:
+  PROFILER_FORCE_INLINE explicit CpuZone(uint32_t nameID)
+      : m_nameID(nameID), m_begin(readTicks()) {}
+
+  PROFILER_FORCE_INLINE ~CpuZone() {
+
+    uint64_t end = readTicks();
+
+    CpuThreadBuffer *threadBuffer = t_threadBuffer;
+
+    // the first zone of the thread
+    if (threadBuffer == nullptr) {
+      threadBuffer = &CpuProfiler::get().getThreadBuffer();
+    }
+
+    threadBuffer->record(m_nameID, m_begin, end);
+  }
+
+  CpuZone(const CpuZone &) = delete;
+  CpuZone &operator=(const CpuZone &) = delete;
+
+private:
+  uint32_t m_nameID;
+  uint64_t m_begin;
+};
+
+} // namespace profiler
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#ifdef CPU_PROFILER_ENABLED
+
+// records the rest of the enclosing block, the name is interned on the first
+// pass through the call site
+#define CPU_PROFILE_ZONE(name)                                                 \
+  static const uint32_t PROFILER_CONCAT(cpuZoneName, __LINE__) =               \
+      profiler::CpuProfiler::get().internName(name);                           \
+  profiler::CpuZone PROFILER_CONCAT(cpuZone, __LINE__) {                       \
+    PROFILER_CONCAT(cpuZoneName, __LINE__)                                     \
+  }
+
+#define CPU_PROFILE_FRAME() profiler::CpuProfiler::get().markFrame()
+
+#define CPU_PROFILE_THREAD_NAME(name)                                          \
+  profiler::CpuProfiler::get().setThreadName(name)
+
+#else
+
+#define CPU_PROFILE_ZONE(name)
+#define CPU_PROFILE_FRAME()
+#define CPU_PROFILE_THREAD_NAME(name)
+
+#endif // CPU_PROFILER_ENABLED
+
+#endif // CPU_PROFILER_H
@@ -0,0 +1,486 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "bounds.h"
+#include "commandbuffer.h"
+#include "cpuprofiler.h"
+#include "jobsystem.h"
+#include "model.h"
+#include "radixsort.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drawlist {
+
+// the sort key keeps 8 bits for the drawable, 24 for the depth
+constexpr uint32_t MAX_DRAWABLES = 256;
+
+/**
+ * A model as the workers see it: vertex arrays, vertex counts, textures
+ * and uniform locations, all resolved on the gl thread by addDrawable so
+ * recording needs no gl call.
+ */
+struct Drawable {
+
+  struct Part {
+    GLuint vertexArray = 0;
+    int count = 0;
+    bool indexed = false;
+
+    // model space placement (Model::getMeshTransform)
+    glm::mat4 transform{1.0f};
+
+    // (unit, texture) and the (location, unit) of their samplers
+    std::vector<std::pair<unsigned int, GLuint>> textures;
+    std::vector<std::pair<int, int>> samplers;
+  };
+
+  const gpu::Shader *shader = nullptr;
+
+  // -1 when the shader doesn't use them
+  int modelLocation = -1;
+  int normalMatrixLocation = -1;
+
+  // local space
+  AABB bounds;
+
+  std::vector<Part> parts;
+
+  // some part is not at the model origin: model and normal matrix per part
+  bool hasPartTransforms = false;
+};
+
+struct SceneObject {
+
+  SceneObject() {}
+
+  SceneObject(const glm::mat4 &transform, uint32_t drawable)
+      : transform(transform), drawable(drawable) {}
+
+  // local to world, the "model" uniform
+  glm::mat4 transform{1.0f};
+
+  // index returned by DrawListBuilder::addDrawable
+  uint32_t drawable = 0;
+};
+
+struct DrawListBuilderCreateInfo {
+
+  DrawListBuilderCreateInfo() {}
+
+  // chunks of the parallel passes, 0 = threads of jobs::getJobSystem()
+  unsigned int nThreads = 0;
+
+  // fewer objects (or visible draws) per thread are handled by fewer threads
+  size_t minObjectsPerThread = 256;
+
+  // names of the per object uniforms, looked up by addDrawable
+  std::string modelUniform = "model";
+  std::string normalMatrixUniform = "normalMatrix";
+};
+
+struct DrawListStats {
+  size_t nObjects = 0;
+  size_t nVisible = 0;
+  size_t nDraws = 0;
+  size_t nCommands = 0;
+
+  // command lists recorded by the last build (one per worker)
+  size_t nLists = 0;
+};
+
+/**
+ * Builds the draw commands of a list of scene objects on several threads,
+ * the gl thread only submits them:
+ *
+ *  1. each thread takes a contiguous range of the objects: frustum culling
+ *     (world AABB of the drawable's bounds), normal matrix, and a sort key
+ *     (drawable, then front to back distance) per visible object,
+ *  2. the visible objects of all threads are radix sorted by their key,
+ *  3. each thread records a contiguous range of the sorted objects into its
+ *     own gpu::CommandBuffer: program, textures and vertex array whenever
+ *     the drawable changes, then the per object uniforms and the draw,
+ *  4. submit() executes the lists in order on the gl thread.
+ *
+ * The result doesn't depend on the number of threads: the lists are the
+ * sorted order cut in pieces, each starting with the full state of its
+ * first draw.
+ *
+ * build() blocks until the lists are recorded, the demo can prepare the rest
+ * of the frame meanwhile only from another thread. Objects and drawables
+ * must not change during build().
+ */
+class DrawListBuilder {
+
+public:
+  DrawListBuilder(const DrawListBuilderCreateInfo &createInfo =
+                      DrawListBuilderCreateInfo{})
+      : m_minObjectsPerThread(
+            std::max<size_t>(1, createInfo.minObjectsPerThread)),
+        m_modelUniform(createInfo.modelUniform),
+        m_normalMatrixUniform(createInfo.normalMatrixUniform) {
+
+    m_nThreads = createInfo.nThreads != 0
+                     ? createInfo.nThreads
+                     : jobs::getJobSystem().getNumThreads();
+
+    sorting::RadixSorterCreateInfo sorterCreateInfo;
+    sorterCreateInfo.nThreads = m_nThreads;
+
+    m_sorter = sorting::RadixSorter{sorterCreateInfo};
+
+    m_chunks.resize(m_nThreads);
+    m_lists.resize(m_nThreads);
+  }
+
+  /**
+   * Resolves the model for 'shader' (same sampler names as Mesh::draw),
+   * gl thread only. Returns the index for SceneObject::drawable, or
+   * MAX_DRAWABLES if there are too many drawables.
+   */
+  uint32_t addDrawable(const Model &model, const gpu::Shader &shader) {
+
+    if (m_drawables.size() >= MAX_DRAWABLES) {
+      return MAX_DRAWABLES;
+    }
+
+    Drawable drawable;
+    drawable.shader = &shader;
+    drawable.modelLocation = shader.getUniformLocation(m_modelUniform);
+    drawable.normalMatrixLocation =
+        shader.getUniformLocation(m_normalMatrixUniform);
+    drawable.bounds = computeAABB(model);
+
+    for (size_t m = 0; m < model.m_meshes.size(); ++m) {
+
+      const Mesh &mesh = model.m_meshes[m];
+
+      Drawable::Part part;
+      part.vertexArray = mesh.getVAO();
+      part.count = static_cast<int>(mesh.getNumVertices());
+      part.indexed = mesh.isIndexed();
+      part.transform = model.getMeshTransform(m);
+
+      if (part.transform != glm::mat4{1.0f}) {
+        drawable.hasPartTransforms = true;
+      }
+
+      unsigned int diffuseNr = 0;
+      unsigned int specularNr = 0;
+
+      for (unsigned int i = 0; i < mesh.m_textures.size(); ++i) {
+
+        const std::string &name = mesh.m_textures[i].type;
+        std::string number;
+
+        if (name == "texture_diffuse") {
+          number = std::to_string(diffuseNr++);
+        } else if (name == "texture_specular") {
+          number = std::to_string(specularNr++);
+        }
+
+        part.textures.emplace_back(i, mesh.m_textures[i].texture.getID());
+
+        int location = shader.getUniformLocation("material." + name + number);
+        if (location != -1) {
+          part.samplers.emplace_back(location, static_cast<int>(i));
+        }
+      }
+
+      drawable.parts.push_back(std::move(part));
+    }
+
+    m_drawables.push_back(std::move(drawable));
+
+    return static_cast<uint32_t>(m_drawables.size() - 1);
+  }
+
+  inline const Drawable &getDrawable(uint32_t index) const {
+    return m_drawables[index];
+  }
+
+  /**
+   * Culls, sorts and records the objects seen by 'view' and 'projection'.
+   * Objects with an unknown drawable are skipped.
+   */
+  void build(const SceneObject *objects, size_t nObjects,
+             const glm::mat4 &view, const glm::mat4 &projection) {
+
+    CPU_PROFILE_ZONE("DrawListBuilder::build");
+
+    Frustum frustum{projection * view};
+
+    m_normalMatrices.resize(nObjects);
+
+    // 1. cull, normal matrices, keys
+
+    unsigned int nCullChunks = getNumChunks(nObjects);
+
+    parallelFor(nObjects, nCullChunks,
+                [&](unsigned int chunk, size_t begin, size_t end) {
+                  cull(objects, begin, end, view, frustum, m_chunks[chunk]);
+                });
+
+    // 2. sort
+
+    m_visible.clear();
+    m_keys.clear();
+
+    for (unsigned int c = 0; c < nCullChunks; ++c) {
+      const Chunk &chunk = m_chunks[c];
+      m_visible.insert(m_visible.end(), chunk.visible.begin(),
+                       chunk.visible.end());
+      m_keys.insert(m_keys.end(), chunk.keys.begin(), chunk.keys.end());
+    }
+
+    {
+      CPU_PROFILE_ZONE("DrawListBuilder::sort");
+
+      // same objects as the last frame: the previous order is a good guess
+      bool coherent = m_visible == m_lastVisible;
+
+      m_sorter.sortKeys(m_keys.data(), m_keys.size(), coherent);
+      std::swap(m_lastVisible, m_visible);
+    }
+
+    const std::vector<uint32_t> &order = m_sorter.getOrder();
+
+    m_sorted.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      m_sorted[i] = m_lastVisible[order[i]];
+    }
+
+    // 3. record
+
+    m_nLists = getNumChunks(m_sorted.size());
+
+    parallelFor(m_sorted.size(), m_nLists,
+                [&](unsigned int chunk, size_t begin, size_t end) {
+                  record(objects, begin, end, m_lists[chunk]);
+                });
+
+    m_stats.nObjects = nObjects;
+    m_stats.nVisible = m_sorted.size();
+    m_stats.nDraws = 0;
+    m_stats.nCommands = 0;
+    m_stats.nLists = m_nLists;
+
+    for (unsigned int i = 0; i < m_nLists; ++i) {
+      m_stats.nDraws += m_lists[i].getNumDraws();
+      m_stats.nCommands += m_lists[i].getNumCommands();
+    }
+  }
+
+  /**
+   * Executes the lists of the last build, in order, gl thread only.
+   */
+  void submit() const {
+
+    CPU_PROFILE_ZONE("DrawListBuilder::submit");
+
+    for (unsigned int i = 0; i < m_nLists; ++i) {
+      m_lists[i].execute();
+    }
+  }
+
+  // the lists of the last build merged into 'commands' (eg. to save them)
+  void appendTo(gpu::CommandBuffer &commands) const {
+    for (unsigned int i = 0; i < m_nLists; ++i) {
+      commands.append(m_lists[i]);
+    }
+  }
+
+  inline const DrawListStats &getStats() const { return m_stats; }
+
+  inline unsigned int getNumThreads() const { return m_nThreads; }
+
+private:
+  // what one thread found in its range of objects
+  struct Chunk {
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> keys;
+  };
+
+  unsigned int m_nThreads;
+  size_t m_minObjectsPerThread;
+
+  std::string m_modelUniform;
+  std::string m_normalMatrixUniform;
+
+  std::vector<Drawable> m_drawables;
+
+  std::vector<Chunk> m_chunks;
+  std::vector<glm::mat3> m_normalMatrices;
+
+  std::vector<uint32_t> m_visible;
+  std::vector<uint32_t> m_lastVisible;
+  std::vector<uint32_t> m_keys;
+  std::vector<uint32_t> m_sorted;
+
+  sorting::RadixSorter m_sorter;
+
+  std::vector<gpu::CommandBuffer> m_lists;
+  unsigned int m_nLists = 0;
+
+  DrawListStats m_stats;
+
+  inline unsigned int getNumChunks(size_t n) const {
+    size_t nChunks = std::max<size_t>(1, n / m_minObjectsPerThread);
+    return static_cast<unsigned int>(
+        std::min<size_t>(nChunks, m_nThreads));
+  }
+
+  /**
+   * Calls fn(chunk, begin, end) on nChunks contiguous chunks of [0, n), one
+   * job per chunk on jobs::getJobSystem(). The calling thread runs chunks
+   * too.
+   */
+  static void
+  parallelFor(size_t n, unsigned int nChunks,
+              const std::function<void(unsigned int, size_t, size_t)> &fn) {
+
+    if (nChunks == 1) {
+      fn(0, 0, n);
+      return;
+    }
+
+    jobs::getJobSystem().parallelFor(
+        nChunks, 1, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            fn(static_cast<unsigned int>(c), n * c / nChunks,
+               n * (c + 1) / nChunks);
+          }
+        });
+  }
+
+  void cull(const SceneObject *objects, size_t begin, size_t end,
+            const glm::mat4 &view, const Frustum &frustum, Chunk &chunk) {
+
+    CPU_PROFILE_ZONE("DrawListBuilder::cull");
+
+    chunk.visible.clear();
+    chunk.keys.clear();
+
+    for (size_t i = begin; i < end; ++i) {
+
+      const SceneObject &object = objects[i];
+
+      if (object.drawable >= m_drawables.size()) {
+        continue;
+      }
+
+      const Drawable &drawable = m_drawables[object.drawable];
+
+      AABB bounds = transformAABB(drawable.bounds, object.transform);
+
+      if (!frustum.intersects(bounds)) {
+        continue;
+      }
+
+      if (drawable.normalMatrixLocation != -1) {
+        m_normalMatrices[i] = scene::computeNormalMatrix(object.transform);
+      }
+
+      // view space depth of the center, boxes crossing the near plane can
+      // have their center behind the camera. Positive floats sort as their
+      // bits, the 24 high ones are enough to order the draws
+      float depth = std::max(
+          0.0f, -(view * glm::vec4{bounds.getCenter(), 1.0f}).z);
+
+      uint32_t depthBits;
+      std::memcpy(&depthBits, &depth, sizeof(float));
+
+      chunk.visible.push_back(static_cast<uint32_t>(i));
+      chunk.keys.push_back((object.drawable << 24) | (depthBits >> 8));
+    }
+  }
+
+  static void setObjectUniforms(gpu::CommandBuffer &commands,
+                                const Drawable &drawable,
+                                const glm::mat4 &model,
+                                const glm::mat3 &normalMatrix) {
+
+    if (drawable.modelLocation != -1) {
+      commands.setMat4(*drawable.shader, drawable.modelLocation, model);
+    }
+
+    if (drawable.normalMatrixLocation != -1) {
+      commands.setMat3(*drawable.shader, drawable.normalMatrixLocation,
+                       normalMatrix);
+    }
+  }
+
+  void record(const SceneObject *objects, size_t begin, size_t end,
+              gpu::CommandBuffer &commands) const {
+
+    CPU_PROFILE_ZONE("DrawListBuilder::record");
+
+    commands.reset();
+
+    const gpu::Shader *shader = nullptr;
+
+    for (size_t i = begin; i < end; ++i) {
+
+      uint32_t index = m_sorted[i];
+      const SceneObject &object = objects[index];
+      const Drawable &drawable = m_drawables[object.drawable];
+
+      if (drawable.shader != shader) {
+        shader = drawable.shader;
+        commands.useProgram(*shader);
+      }
+
+      if (!drawable.hasPartTransforms) {
+        setObjectUniforms(commands, drawable, object.transform,
+                          m_normalMatrices[index]);
+      }
+
+      // a drawable of one part (the common case) binds its state only when
+      // the previous draw was another drawable, execute() skips the rest
+      bool sameDrawable =
+          i > begin && objects[m_sorted[i - 1]].drawable == object.drawable;
+
+      for (const Drawable::Part &part : drawable.parts) {
+
+        if (!sameDrawable || drawable.parts.size() > 1) {
+
+          for (const auto &[unit, texture] : part.textures) {
+            commands.bindTexture(unit, texture);
+          }
+
+          for (const auto &[location, unit] : part.samplers) {
+            commands.setInt(*shader, location, unit);
+          }
+
+          commands.bindVertexArray(part.vertexArray);
+        }
+
+        if (drawable.hasPartTransforms) {
+          glm::mat4 model = object.transform * part.transform;
+          setObjectUniforms(commands, drawable, model,
+                            scene::computeNormalMatrix(model));
+        }
+
+        if (part.indexed) {
+          commands.drawElements(GL_TRIANGLES, part.count);
+        } else {
+          commands.drawArrays(GL_TRIANGLES, 0, part.count);
+        }
+      }
+    }
+  }
+};
+
+} // namespace drawlist
+
+#endif // DRAW_LIST_H
@@ -0,0 +1,415 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include "framebuffer.h"
+#include "query.h"
+#include "renderbuffer.h"
+#include "shader.h"
+#include "texture2d.h"
+#include "vertexarray.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+namespace dynres {
+
+// render sizes are rounded to a multiple of this, so small scale changes
+// don't move the image by a fraction of a texel every adjustment
+constexpr int SIZE_GRANULARITY = 8;
+
+struct DynamicResolutionCreateInfo {
+
+  DynamicResolutionCreateInfo() {}
+
+  // output (window) size. The render targets are allocated once, at
+  // maxScale, lower scales render into a corner of them
+  int width = 800;
+  int height = 600;
+
+  unsigned int colorFormat = GL_RGBA8;
+  unsigned int depthFormat = GL_DEPTH24_STENCIL8;
+
+  // gpu time budget of the passes between beginScene and endScene
+  float targetMilliseconds = 8.0f;
+
+  float minScale = 0.5f;
+  float maxScale = 1.0f;
+
+  // hysteresis band: the scale goes down when the average is above
+  // target * upperThreshold, up when it's below target * lowerThreshold and
+  // is left alone in between
+  float upperThreshold = 1.0f;
+  float lowerThreshold = 0.8f;
+
+  // largest change of the scale in one adjustment
+  float maxScaleStep = 0.1f;
+
+  // frames averaged before each adjustment
+  int nAveragedFrames = 8;
+
+  // frames kept in the history (see getHistory)
+  size_t historySize = 300;
+
+  // upsample filter, 0 is a plain bilinear upsample
+  float sharpness = 0.5f;
+};
+
+struct FrameSample {
+
+  // gpu time of the scene passes and the scale they were rendered at
+  double milliseconds = 0.0;
+  float scale = 1.0f;
+};
+
+/**
+ * Renders the scene at a fraction of the output resolution and upsamples it,
+ * the fraction follows the gpu time of the scene passes.
+ *
+ * The scene is timed with a GpuTimer, so the samples arrive
+ * GpuTimer::LATENCY frames late: samples rendered before the last change of
+ * the scale are dropped, then nAveragedFrames samples are averaged and
+ * compared to the budget. The cost is assumed to be proportional to the
+ * number of pixels (scale^2), which undershoots when the scene is vertex
+ * bound: the next adjustments correct it.
+ *
+ *  dynamicResolution.beginScene();
+ *  ... clear and draw the scene ...
+ *  dynamicResolution.endScene();
+ *  dynamicResolution.present(); // upsamples into the default framebuffer
+ */
+class DynamicResolution {
+
+public:
+  DynamicResolution() {}
+
+  DynamicResolution(const DynamicResolutionCreateInfo &createInfo)
+      : m_createInfo(createInfo), m_scale(createInfo.maxScale) {
+
+    m_textureWidth = static_cast<int>(std::ceil(
+        static_cast<float>(m_createInfo.width) * m_createInfo.maxScale));
+    m_textureHeight = static_cast<int>(std::ceil(
+        static_cast<float>(m_createInfo.height) * m_createInfo.maxScale));
+
+    m_color = gpu::texture::Texture2D{m_textureWidth, m_textureHeight,
+                                      m_createInfo.colorFormat};
+    m_color.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+    m_color.setMinMagFilter(gpu::texture::Filter::LINEAR);
+
+    m_depth = gpu::Renderbuffer{m_textureWidth, m_textureHeight,
+                                m_createInfo.depthFormat};
+
+    m_framebuffer.setColorAttachment(m_color, 0);
+    m_framebuffer.setDepthStencilAttachment(m_depth);
+    m_framebuffer.checkStatus();
+
+    m_upsampleShader = gpu::Shader::fromSource(UPSAMPLE_VERTEX_SHADER,
+                                               UPSAMPLE_FRAGMENT_SHADER);
+    m_upsampleShader.setInt("sceneTexture", 0);
+
+    updateRenderSize();
+  }
+
+  inline float getScale() const { return m_scale; }
+
+  inline int getRenderWidth() const { return m_renderWidth; }
+  inline int getRenderHeight() const { return m_renderHeight; }
+
+  inline float getTargetMilliseconds() const {
+    return m_createInfo.targetMilliseconds;
+  }
+
+  inline void setTargetMilliseconds(float milliseconds) {
+    m_createInfo.targetMilliseconds = milliseconds;
+  }
+
+  inline void setThresholds(float lowerThreshold, float upperThreshold) {
+    m_createInfo.lowerThreshold = lowerThreshold;
+    m_createInfo.upperThreshold = upperThreshold;
+  }
+
+  inline void setSharpness(float sharpness) {
+    m_createInfo.sharpness = sharpness;
+  }
+
+  inline const DynamicResolutionCreateInfo &getSettings() const {
+    return m_createInfo;
+  }
+
+  /**
+   * With adaptation off the scale stays where setScale left it.
+   */
+  inline void setAdaptive(bool adaptive) {
+    m_adaptive = adaptive;
+    restartAveraging();
+  }
+
+  inline bool isAdaptive() const { return m_adaptive; }
+
+  void setScale(float scale) {
+
+    scale = std::clamp(scale, m_createInfo.minScale, m_createInfo.maxScale);
+
+    if (scale != m_scale) {
+      m_scale = scale;
+      updateRenderSize();
+      restartAveraging();
+    }
+  }
+
+  // oldest first
+  inline const std::deque<FrameSample> &getHistory() const {
+    return m_history;
+  }
+
+  // most recent gpu times of the scene passes and of the upsample
+  inline double getSceneMilliseconds() const {
+    return m_sceneTimer.getMilliseconds();
+  }
+  inline double getUpsampleMilliseconds() const {
+    return m_upsampleTimer.getMilliseconds();
+  }
+
+  /**
+   * Binds the offscreen framebuffer with the viewport set to the current
+   * render size. The camera's aspect ratio doesn't change.
+   */
+  void beginScene() {
+
+    m_framebuffer.bind();
+    glViewport(0, 0, m_renderWidth, m_renderHeight);
+
+    m_sceneTimer.begin();
+  }
+
+  void endScene() {
+
+    m_sceneTimer.end();
+
+    // the result read now is the one of GpuTimer::LATENCY frames ago
+    m_sampleScales.push_back(m_scale);
+
+    if (m_sampleScales.size() <= gpu::GpuTimer::LATENCY) {
+      return;
+    }
+
+    float sampleScale = m_sampleScales.front();
+    m_sampleScales.pop_front();
+
+    double milliseconds = m_sceneTimer.getMilliseconds();
+
+    m_history.push_back(FrameSample{milliseconds, sampleScale});
+    while (m_history.size() > m_createInfo.historySize) {
+      m_history.pop_front();
+    }
+
+    if (!m_adaptive) {
+      return;
+    }
+
+    // rendered before the last change of the scale
+    if (sampleScale != m_scale) {
+      return;
+    }
+
+    m_millisecondsSum += milliseconds;
+
+    if (++m_nAveragedSamples < m_createInfo.nAveragedFrames) {
+      return;
+    }
+
+    double average = m_millisecondsSum / m_nAveragedSamples;
+
+    m_millisecondsSum = 0.0;
+    m_nAveragedSamples = 0;
+
+    double target = m_createInfo.targetMilliseconds;
+
+    if (average <= 0.0 || (average <= target * m_createInfo.upperThreshold &&
+                           average >= target * m_createInfo.lowerThreshold)) {
+      return;
+    }
+
+    // aim for the middle of the band, otherwise the next adjustment tends
+    // to cross it again
+    double bandCenter =
+        target * 0.5 *
+        (m_createInfo.lowerThreshold + m_createInfo.upperThreshold);
+
+    float newScale =
+        m_scale * static_cast<float>(std::sqrt(bandCenter / average));
+
+    newScale = std::clamp(newScale, m_scale - m_createInfo.maxScaleStep,
+                          m_scale + m_createInfo.maxScaleStep);
+
+    setScale(newScale);
+  }
+
+  /**
+   * Upsamples the scene into the default framebuffer, over the whole output
+   * size. Depth testing is left disabled.
+   */
+  void present() {
+
+    m_upsampleTimer.begin();
+
+    gpu::framebuffer::bindDefault();
+    glViewport(0, 0, m_createInfo.width, m_createInfo.height);
+
+    glDisable(GL_DEPTH_TEST);
+
+    float texelWidth = 1.0f / static_cast<float>(m_textureWidth);
+    float texelHeight = 1.0f / static_cast<float>(m_textureHeight);
+
+    float uvScaleX = static_cast<float>(m_renderWidth) * texelWidth;
+    float uvScaleY = static_cast<float>(m_renderHeight) * texelHeight;
+
+    m_upsampleShader.setVec2("uvScale", uvScaleX, uvScaleY);
+    m_upsampleShader.setVec2("texelSize", texelWidth, texelHeight);
+
+    // keep the bilinear footprint inside the rendered area
+    m_upsampleShader.setVec2("minUv", 0.5f * texelWidth, 0.5f * texelHeight);
+    m_upsampleShader.setVec2("maxUv", uvScaleX - 0.5f * texelWidth,
+                             uvScaleY - 0.5f * texelHeight);
+
+    // upscaled images need more sharpening
+    float upscale = 1.0f / std::max(m_scale, 1e-3f);
+    m_upsampleShader.setFloat("sharpness",
+                              m_createInfo.sharpness * std::min(upscale, 2.0f));
+
+    m_upsampleShader.use();
+
+    glBindTextureUnit(0, m_color.getID());
+
+    m_emptyVAO.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    m_upsampleTimer.end();
+  }
+
+  void destroy() {
+
+    m_framebuffer.destroy();
+    m_color.destroy();
+    m_depth.destroy();
+
+    m_upsampleShader.destroy();
+    m_emptyVAO.destroy();
+
+    m_sceneTimer.destroy();
+    m_upsampleTimer.destroy();
+  }
+
+private:
+  DynamicResolutionCreateInfo m_createInfo;
+
+  bool m_adaptive = true;
+
+  float m_scale = 1.0f;
+
+  int m_textureWidth = 0;
+  int m_textureHeight = 0;
+
+  int m_renderWidth = 0;
+  int m_renderHeight = 0;
+
+  gpu::texture::Texture2D m_color;
+  gpu::Renderbuffer m_depth;
+  gpu::framebuffer::Framebuffer m_framebuffer;
+
+  gpu::Shader m_upsampleShader;
+  gpu::VertexArray m_emptyVAO;
+
+  gpu::GpuTimer m_sceneTimer;
+  gpu::GpuTimer m_upsampleTimer;
+
+  // scales of the frames still in flight in the timer, oldest first
+  std::deque<float> m_sampleScales;
+
+  std::deque<FrameSample> m_history;
+
+  int m_nAveragedSamples = 0;
+  double m_millisecondsSum = 0.0;
+
+  void updateRenderSize() {
+
+    auto scaledSize = [this](int size, int maxSize) {
+      int scaled = static_cast<int>(
+          std::round(static_cast<float>(size) * m_scale / SIZE_GRANULARITY));
+
+      return std::clamp(scaled * SIZE_GRANULARITY, SIZE_GRANULARITY, maxSize);
+    };
+
+    m_renderWidth = scaledSize(m_createInfo.width, m_textureWidth);
+    m_renderHeight = scaledSize(m_createInfo.height, m_textureHeight);
+  }
+
+  void restartAveraging() {
+    m_nAveragedSamples = 0;
+    m_millisecondsSum = 0.0;
+  }
+
+  static constexpr const char *UPSAMPLE_VERTEX_SHADER = R"(#version 450 core
+
+out vec2 TexCoords;
+
+void main() {
+  vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+  TexCoords = pos;
+  gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+})";
+
+  // bilinear upsample + contrast adaptive sharpening: the sharpening is
+  // reduced where the local contrast is already high and the result is
+  // clamped to the neighborhood, so edges don't ring
+  static constexpr const char *UPSAMPLE_FRAGMENT_SHADER = R"(#version 450 core
+
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D sceneTexture;
+
+uniform vec2 uvScale;
+uniform vec2 texelSize;
+
+uniform vec2 minUv;
+uniform vec2 maxUv;
+
+uniform float sharpness;
+
+vec3 fetch(vec2 uv) {
+  return textureLod(sceneTexture, clamp(uv, minUv, maxUv), 0.0).rgb;
+}
+
+void main() {
+
+  vec2 uv = TexCoords * uvScale;
+
+  vec3 center = fetch(uv);
+
+  vec3 up = fetch(uv + vec2(0.0, texelSize.y));
+  vec3 down = fetch(uv - vec2(0.0, texelSize.y));
+  vec3 left = fetch(uv - vec2(texelSize.x, 0.0));
+  vec3 right = fetch(uv + vec2(texelSize.x, 0.0));
+
+  vec3 minColor = min(center, min(min(up, down), min(left, right)));
+  vec3 maxColor = max(center, max(max(up, down), max(left, right)));
+
+  vec3 contrast = maxColor - minColor;
+  float amount =
+      sharpness * (1.0 - clamp(max(contrast.r, max(contrast.g, contrast.b)),
+                               0.0, 1.0));
+
+  vec3 neighbors = 0.25 * (up + down + left + right);
+  vec3 sharpened = center + amount * (center - neighbors);
+
+  FragColor = vec4(clamp(sharpened, minColor, maxColor), 1.0);
+})";
+};
+
+} // namespace dynres
+
+#endif // DYNAMIC_RESOLUTION_H
@@ -37,6 +37,7 @@ public:
   }
 
   inline float getFov() const { return m_fov; }
+  inline float getAspect() const { return m_aspect; }
 
   inline float getZFar() const { return m_zFar; }
   inline float getZNear() const { return m_zNear; }
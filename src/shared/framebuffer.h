@@ -27,14 +27,18 @@ public:
 
   inline void setColorAttachment(const texture::Texture &tex,
                                  int colorAttachmentIdx) {
+    setColorAttachment(tex.getID(), colorAttachmentIdx);
+  };
+
+  inline void setColorAttachment(unsigned int texID, int colorAttachmentIdx) {
 
     GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
 
     assert(colorAttachmentIdx < MAX_COLOR_ATTACHMENTS);
 
     glNamedFramebufferTexture(m_ID, GL_COLOR_ATTACHMENT0 + colorAttachmentIdx,
-                              tex.getID(), 0);
-    m_colorAttachmentIDs[colorAttachmentIdx] = tex.getID();
+                              texID, 0);
+    m_colorAttachmentIDs[colorAttachmentIdx] = texID;
   };
 
   inline void setColorAttachment(const Renderbuffer &rbo,
@@ -50,11 +54,15 @@ public:
   };
 
   inline void setDepthAttachment(const texture::Texture &tex) {
+    setDepthAttachment(tex.getID());
+  };
+
+  inline void setDepthAttachment(unsigned int texID) {
 
     GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
 
-    glNamedFramebufferTexture(m_ID, GL_DEPTH_ATTACHMENT, tex.getID(), 0);
-    m_depthAttachmentID = tex.getID();
+    glNamedFramebufferTexture(m_ID, GL_DEPTH_ATTACHMENT, texID, 0);
+    m_depthAttachmentID = texID;
   };
 
   inline void setDepthAttachment(const Renderbuffer &rbo) {
@@ -66,6 +74,21 @@ public:
     m_depthAttachmentID = rbo.getID();
   };
 
+  /**
+   * Attaches a single layer (or cube map face) of a layered texture.
+   */
+  inline void setDepthAttachmentLayer(const texture::Texture &tex, int layer) {
+    setDepthAttachmentLayer(tex.getID(), layer);
+  };
+
+  inline void setDepthAttachmentLayer(unsigned int texID, int layer) {
+
+    GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
+
+    glNamedFramebufferTextureLayer(m_ID, GL_DEPTH_ATTACHMENT, texID, 0, layer);
+    m_depthAttachmentID = texID;
+  };
+
   inline void setStencilAttachment(const texture::Texture &tex) {
 
     GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
@@ -84,13 +107,16 @@ public:
   };
 
   inline void setDepthStencilAttachment(const texture::Texture &tex) {
+    setDepthStencilAttachment(tex.getID());
+  };
+
+  inline void setDepthStencilAttachment(unsigned int texID) {
 
     GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
 
-    glNamedFramebufferTexture(m_ID, GL_DEPTH_STENCIL_ATTACHMENT, tex.getID(),
-                              0);
-    m_depthAttachmentID = tex.getID();
-    m_stencilAttachmentID = tex.getID();
+    glNamedFramebufferTexture(m_ID, GL_DEPTH_STENCIL_ATTACHMENT, texID, 0);
+    m_depthAttachmentID = texID;
+    m_stencilAttachmentID = texID;
   };
 
   inline void setDepthStencilAttachment(const Renderbuffer &rbo) {
@@ -103,6 +129,46 @@ public:
     m_stencilAttachmentID = rbo.getID();
   };
 
+  /**
+   * Enables the first nColorAttachments attachments as draw buffers (MRT).
+   */
+  inline void setDrawBuffers(int nColorAttachments) {
+
+    GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
+
+    assert(nColorAttachments <= MAX_COLOR_ATTACHMENTS);
+
+    GLenum drawBuffers[MAX_COLOR_ATTACHMENTS];
+    for (int i = 0; i < nColorAttachments; ++i) {
+      drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+
+    glNamedFramebufferDrawBuffers(m_ID, nColorAttachments, drawBuffers);
+  }
+
+  /**
+   * Clears a single color attachment, each one can have its own clear value
+   * (eg. the accumulation and revealage targets of weighted blended oit).
+   * Assumes the draw buffers were set with setDrawBuffers.
+   */
+  inline void clearColorAttachment(int colorAttachmentIdx, float r, float g,
+                                   float b, float a = 1.0f) {
+
+    GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
+
+    assert(colorAttachmentIdx < MAX_COLOR_ATTACHMENTS);
+
+    float value[] = {r, g, b, a};
+    glClearNamedFramebufferfv(m_ID, GL_COLOR, colorAttachmentIdx, value);
+  }
+
+  inline void clearDepthAttachment(float depth = 1.0f) {
+
+    GPU_OBJECT_CREATE_LAZY(glCreateFramebuffers)
+
+    glClearNamedFramebufferfv(m_ID, GL_DEPTH, 0, &depth);
+  }
+
   inline unsigned int getColorAttachmentID(int colorAttachmentIdx) const {
     assert(colorAttachmentIdx < MAX_COLOR_ATTACHMENTS);
     return m_colorAttachmentIDs[colorAttachmentIdx];
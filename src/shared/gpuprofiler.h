@@ -0,0 +1,442 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include "cpuprofiler.h"
+#include "query.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace profiler {
+
+// thread id of the gpu events in the exported traces
+constexpr int GPU_TRACE_TID = 1000;
+
+struct GpuProfilerCreateInfo {
+
+  GpuProfilerCreateInfo() {}
+
+  // frames in flight before the timestamps of a frame are read back
+  size_t latency = 4;
+
+  // scopes past this in a frame are labeled but not timed
+  size_t maxScopesPerFrame = 64;
+
+  // frames of the rolling statistics
+  size_t historySize = 300;
+
+  // frames kept for the trace export
+  size_t traceFrames = 120;
+};
+
+struct ScopeStats {
+
+  // frames the scope was seen in the history
+  size_t count = 0;
+
+  double lastMs = 0.0;
+  double minMs = 0.0;
+  double avgMs = 0.0;
+  double p99Ms = 0.0;
+};
+
+struct TraceEvent {
+
+  const char *name = nullptr;
+  int depth = 0;
+
+  uint64_t frame = 0;
+
+  // steady_clock domain (see GpuProfiler::toCpuNanoseconds)
+  int64_t beginNs = 0;
+  int64_t durationNs = 0;
+};
+
+/**
+ * Nested gpu timing scopes with GL_TIMESTAMP queries.
+ *
+ * Every scope records a timestamp when it's pushed and one when it's popped,
+ * and is wrapped in a debug group with the same name so it also shows up in
+ * RenderDoc/apitrace captures. The queries of a frame are read back
+ * 'latency' frames later, when its slot is reused, so reading never stalls
+ * unless the gpu is more than 'latency' frames behind.
+ *
+ * Each frame is a "frame" scope, the scopes pushed in it are children of it
+ * and are identified by their path ("frame/lighting/volumes"). Scopes with
+ * the same path in a frame are added up.
+ *
+ *  gpuProfiler.beginFrame();
+ *  {
+ *    GPU_PROFILE_SCOPE(gpuProfiler, "shadows");
+ *    ...
+ *  }
+ *  gpuProfiler.endFrame();
+ *
+ * Timestamp queries are core since 3.3 (llvmpipe included). If the
+ * implementation reports 0 counter bits the scopes are only labeled.
+ */
+class GpuProfiler {
+
+public:
+  GpuProfiler() {}
+
+  GpuProfiler(const GpuProfilerCreateInfo &createInfo)
+      : m_createInfo(createInfo), m_slots(createInfo.latency) {
+
+    int counterBits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counterBits);
+
+    m_timestampsSupported = counterBits > 0;
+
+    // the debug groups would send two messages per scope to the debug
+    // callback
+    glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP,
+                          GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP,
+                          GL_DONT_CARE, 0, nullptr, GL_FALSE);
+
+    calibrate();
+  }
+
+  inline bool areTimestampsSupported() const { return m_timestampsSupported; }
+
+  inline uint64_t getFrameIndex() const { return m_frameIndex; }
+
+  /**
+   * Reads back the oldest frame in flight (if any) and opens the "frame"
+   * scope.
+   */
+  void beginFrame() {
+
+    FrameSlot &slot = m_slots[m_current];
+
+    if (slot.pending) {
+      collect(slot);
+    }
+
+    slot.scopes.clear();
+    slot.nUsedQueries = 0;
+    slot.frame = m_frameIndex;
+
+    m_stack.clear();
+
+    pushScope("frame");
+  }
+
+  void endFrame() {
+
+    while (!m_stack.empty()) {
+      popScope();
+    }
+
+    m_slots[m_current].pending = true;
+
+    m_current = (m_current + 1) % m_slots.size();
+    ++m_frameIndex;
+  }
+
+  /**
+   * 'name' has to outlive the profiler (string literals), it's kept for the
+   * trace.
+   */
+  void pushScope(const char *name) {
+
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+
+    FrameSlot &slot = m_slots[m_current];
+
+    PendingScope scope;
+    scope.name = name;
+    scope.depth = static_cast<int>(m_stack.size());
+    scope.path = m_stack.empty()
+                     ? std::string{name}
+                     : slot.scopes[m_stack.back()].path + "/" + name;
+
+    if (m_timestampsSupported &&
+        slot.nUsedQueries / 2 < m_createInfo.maxScopesPerFrame) {
+
+      if (slot.queries.empty()) {
+        for (size_t i = 0; i < 2 * m_createInfo.maxScopesPerFrame; ++i) {
+          slot.queries.emplace_back(GL_TIMESTAMP);
+        }
+      }
+
+      scope.beginQuery = static_cast<int>(slot.nUsedQueries);
+      slot.nUsedQueries += 2;
+
+      slot.queries[scope.beginQuery].recordTimestamp();
+    }
+
+    m_stack.push_back(slot.scopes.size());
+    slot.scopes.push_back(scope);
+  }
+
+  void popScope() {
+
+    FrameSlot &slot = m_slots[m_current];
+
+    const PendingScope &scope = slot.scopes[m_stack.back()];
+    m_stack.pop_back();
+
+    if (scope.beginQuery >= 0) {
+      slot.queries[scope.beginQuery + 1].recordTimestamp();
+    }
+
+    glPopDebugGroup();
+  }
+
+  /**
+   * Paths of every scope seen so far, sorted (children after their parent).
+   */
+  std::vector<std::string> getScopePaths() const {
+
+    std::vector<std::string> paths;
+    for (const auto &entry : m_samples) {
+      paths.push_back(entry.first);
+    }
+
+    return paths;
+  }
+
+  ScopeStats getStats(const std::string &path) const {
+
+    ScopeStats stats;
+
+    auto it = m_samples.find(path);
+
+    if (it == m_samples.end() || it->second.empty()) {
+      return stats;
+    }
+
+    std::vector<double> sorted{it->second.begin(), it->second.end()};
+    std::sort(sorted.begin(), sorted.end());
+
+    stats.count = sorted.size();
+    stats.lastMs = it->second.back();
+    stats.minMs = sorted.front();
+
+    double sum = 0.0;
+    for (double ms : sorted) {
+      sum += ms;
+    }
+    stats.avgMs = sum / static_cast<double>(sorted.size());
+
+    size_t p99Index = static_cast<size_t>(
+        std::ceil(0.99 * static_cast<double>(sorted.size())));
+    stats.p99Ms = sorted[std::max<size_t>(p99Index, 1) - 1];
+
+    return stats;
+  }
+
+  inline const std::deque<TraceEvent> &getTraceEvents() const {
+    return m_trace;
+  }
+
+  /**
+   * Appends the events of the last 'traceFrames' read back frames, each
+   * nesting level on its own track.
+   */
+  void writeTraceEvents(std::ostream &out, bool &first) const {
+
+    int maxDepth = 0;
+
+    for (const TraceEvent &event : m_trace) {
+
+      maxDepth = std::max(maxDepth, event.depth);
+
+      writeTraceEvent(out, first, event.name, "gpu",
+                      GPU_TRACE_TID + event.depth, event.beginNs,
+                      event.durationNs);
+    }
+
+    for (int depth = 0; depth <= maxDepth; ++depth) {
+
+      std::stringstream name;
+      name << "gpu (depth " << depth << ")";
+
+      writeThreadName(out, first, GPU_TRACE_TID + depth, name.str());
+    }
+  }
+
+  /**
+   * Writes the gpu scopes and the cpu zones (CpuProfiler, empty unless it's
+   * enabled) on the same timeline.
+   */
+  bool exportChromeTrace(const std::string &filename) const {
+
+    std::ofstream out{filename};
+
+    if (!out) {
+
+      std::string message = "Could not open trace file " + filename;
+
+      glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0,
+                           GL_DEBUG_SEVERITY_MEDIUM, message.length(),
+                           message.c_str());
+      return false;
+    }
+
+    bool first = true;
+
+    out << "{\"traceEvents\":[";
+    writeTraceEvents(out, first);
+    CpuProfiler::get().writeTraceEvents(out, first);
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return true;
+  }
+
+  /**
+   * Gpu timestamp to the steady_clock domain of the cpu events.
+   */
+  inline int64_t toCpuNanoseconds(uint64_t gpuNanoseconds) const {
+    return static_cast<int64_t>(gpuNanoseconds) + m_gpuToCpuOffsetNs;
+  }
+
+  /**
+   * Measures the offset between the gpu and the cpu clocks. Done once on
+   * creation, call it again if the clocks drift over long captures.
+   */
+  void calibrate() {
+
+    if (!m_timestampsSupported) {
+      return;
+    }
+
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+
+    m_gpuToCpuOffsetNs = getCpuNanoseconds() - static_cast<int64_t>(gpuNow);
+  }
+
+  void destroy() {
+
+    for (FrameSlot &slot : m_slots) {
+      for (gpu::Query &query : slot.queries) {
+        query.destroy();
+      }
+      slot.queries.clear();
+    }
+  }
+
+private:
+  struct PendingScope {
+
+    const char *name = nullptr;
+    std::string path;
+
+    int depth = 0;
+
+    // timestamp pair (beginQuery, beginQuery + 1), -1 if not timed
+    int beginQuery = -1;
+  };
+
+  struct FrameSlot {
+
+    std::vector<gpu::Query> queries;
+    size_t nUsedQueries = 0;
+
+    std::vector<PendingScope> scopes;
+
+    uint64_t frame = 0;
+    bool pending = false;
+  };
+
+  GpuProfilerCreateInfo m_createInfo;
+
+  bool m_timestampsSupported = false;
+
+  int64_t m_gpuToCpuOffsetNs = 0;
+
+  std::vector<FrameSlot> m_slots;
+  size_t m_current = 0;
+
+  uint64_t m_frameIndex = 0;
+
+  // open scopes of the current frame, indices in its slot
+  std::vector<size_t> m_stack;
+
+  // per path, one (summed) duration per frame, oldest first
+  std::map<std::string, std::deque<double>> m_samples;
+
+  std::deque<TraceEvent> m_trace;
+
+  void collect(FrameSlot &slot) {
+
+    slot.pending = false;
+
+    std::map<std::string, double> frameTotals;
+
+    for (const PendingScope &scope : slot.scopes) {
+
+      if (scope.beginQuery < 0) {
+        continue;
+      }
+
+      uint64_t begin = slot.queries[scope.beginQuery].getResult();
+      uint64_t end = slot.queries[scope.beginQuery + 1].getResult();
+
+      int64_t duration = static_cast<int64_t>(end - begin);
+
+      frameTotals[scope.path] += static_cast<double>(duration) * 1e-6;
+
+      TraceEvent event;
+      event.name = scope.name;
+      event.depth = scope.depth;
+      event.frame = slot.frame;
+      event.beginNs = toCpuNanoseconds(begin);
+      event.durationNs = duration;
+
+      m_trace.push_back(event);
+    }
+
+    for (const auto &entry : frameTotals) {
+
+      std::deque<double> &samples = m_samples[entry.first];
+
+      samples.push_back(entry.second);
+      while (samples.size() > m_createInfo.historySize) {
+        samples.pop_front();
+      }
+    }
+
+    while (!m_trace.empty() &&
+           m_trace.front().frame + m_createInfo.traceFrames <= slot.frame) {
+      m_trace.pop_front();
+    }
+  }
+};
+
+class GpuScope {
+
+public:
+  GpuScope(GpuProfiler &gpuProfiler, const char *name)
+      : m_gpuProfiler(gpuProfiler) {
+    m_gpuProfiler.pushScope(name);
+  }
+
+  ~GpuScope() { m_gpuProfiler.popScope(); }
+
+  GpuScope(const GpuScope &) = delete;
+  GpuScope &operator=(const GpuScope &) = delete;
+
+private:
+  GpuProfiler &m_gpuProfiler;
+};
+
+} // namespace profiler
+
+// times (and labels) the rest of the enclosing block
+#define GPU_PROFILE_SCOPE(gpuProfiler, name)                                   \
+  profiler::GpuScope PROFILER_CONCAT(gpuScope, __LINE__) { gpuProfiler, name }
+
+#endif // GPU_PROFILER_H
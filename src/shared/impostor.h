@@ -0,0 +1,802 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include "compactinstance.h"
+#include "framebuffer.h"
+#include "instancebuffer.h"
+#include "jobsystem.h"
+#include "model.h"
+#include "renderbuffer.h"
+#include "shader.h"
+#include "texture2d.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace impostors {
+
+// instances per job system task when splitting by distance
+constexpr size_t IMPOSTOR_SPLIT_BLOCK_SIZE = 4096;
+
+// "IMPO", then the version of the cache file layout
+constexpr uint32_t IMPOSTOR_CACHE_MAGIC = 0x4f504d49;
+constexpr uint32_t IMPOSTOR_CACHE_VERSION = 1;
+
+/**
+ * Octahedral mapping of the unit sphere to [0, 1]^2, with +y at the center
+ * of the square and -y at its corners.
+ */
+inline glm::vec2 octahedralEncode(const glm::vec3 &direction) {
+
+  glm::vec3 n = direction / (std::abs(direction.x) + std::abs(direction.y) +
+                             std::abs(direction.z));
+
+  glm::vec2 p{n.x, n.z};
+
+  if (n.y < 0.0f) {
+    p = glm::vec2{(1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                  (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)};
+  }
+
+  return p * 0.5f + 0.5f;
+}
+
+inline glm::vec3 octahedralDecode(const glm::vec2 &uv) {
+
+  glm::vec2 p = uv * 2.0f - 1.0f;
+  glm::vec3 n{p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y};
+
+  if (n.y < 0.0f) {
+    n = glm::vec3{(1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), n.y,
+                  (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)};
+  }
+
+  return glm::normalize(n);
+}
+
+/**
+ * The axes of the view baked looking from direction towards the center,
+ * the runtime shader rebuilds them the same way.
+ */
+inline void frameBasis(const glm::vec3 &direction, glm::vec3 &right,
+                       glm::vec3 &up) {
+
+  glm::vec3 worldUp = std::abs(direction.y) < 0.999f
+                          ? glm::vec3{0.0f, 1.0f, 0.0f}
+                          : glm::vec3{0.0f, 0.0f, -1.0f};
+
+  right = glm::normalize(glm::cross(worldUp, direction));
+  up = glm::cross(direction, right);
+}
+
+struct ImpostorAtlasCreateInfo {
+
+  ImpostorAtlasCreateInfo() {}
+
+  // views per side of the octahedral grid, frames * frames in all (>= 2)
+  int frames = 8;
+
+  // texels per side of a view
+  int frameSize = 64;
+
+  // the baked atlas is saved there and loaded instead of baking when it
+  // matches frames, frameSize and the vertex count of the model. Delete it
+  // when the model changes otherwise. Empty: baked every time
+  std::string cachePath;
+};
+
+/**
+ * A model rendered from frames * frames directions spread over the sphere
+ * (octahedral grid: view (i, j) looks from octahedralDecode((i, j) /
+ * (frames - 1)) towards the center of the bounding sphere), into 2 atlases:
+ *
+ *  albedo        rgb: diffuse texture, a: coverage
+ *  normal depth  rgb: model space normal, a: depth along the view direction
+ *                over the bounding sphere ([-radius, radius] as [0, 1])
+ *
+ * both premultiplied by the coverage (empty texels are 0), so that the mips
+ * and the blend of neighbouring views stay correct once divided by it.
+ *
+ * createShader<T>() draws instances of T as camera facing quads that blend
+ * the 3 views closest to the direction each instance is seen from.
+ */
+class ImpostorAtlas {
+
+public:
+  ImpostorAtlas() {}
+
+  ImpostorAtlas(const Model &model, const ImpostorAtlasCreateInfo &createInfo)
+      : m_frames(std::max(createInfo.frames, 2)),
+        m_frameSize(createInfo.frameSize) {
+
+    CPU_PROFILE_ZONE("ImpostorAtlas::ImpostorAtlas");
+
+    computeBoundingSphere(model);
+
+    int size = m_frames * m_frameSize;
+
+    // down to a texel per view, the smaller mips would mix views
+    int levels = 1;
+    while ((1 << levels) <= m_frameSize) {
+      ++levels;
+    }
+
+    m_albedo = gpu::texture::Texture2D{size, size, GL_RGBA8, levels};
+    m_normalDepth = gpu::texture::Texture2D{size, size, GL_RGBA8, levels};
+
+    for (gpu::texture::Texture2D *atlas : {&m_albedo, &m_normalDepth}) {
+      atlas->setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+      atlas->setMinFilter(gpu::texture::Filter::LINEAR_MIPMAP_LINEAR);
+      atlas->setMagFilter(gpu::texture::Filter::LINEAR);
+    }
+
+    uint32_t nVertices = static_cast<uint32_t>(model.getNumVertices());
+
+    m_loadedFromCache = !createInfo.cachePath.empty() &&
+                        load(createInfo.cachePath, nVertices);
+
+    if (!m_loadedFromCache) {
+
+      bake(model);
+
+      if (!createInfo.cachePath.empty()) {
+        save(createInfo.cachePath, nVertices);
+      }
+    }
+
+    m_albedo.generateMipmap();
+    m_normalDepth.generateMipmap();
+  }
+
+  inline int getFrames() const { return m_frames; }
+  inline int getFrameSize() const { return m_frameSize; }
+
+  // model space, xyz: center, w: radius
+  inline const glm::vec4 &getBoundingSphere() const { return m_sphere; }
+
+  inline bool wasLoadedFromCache() const { return m_loadedFromCache; }
+
+  inline const gpu::texture::Texture2D &getAlbedo() const { return m_albedo; }
+
+  inline const gpu::texture::Texture2D &getNormalDepth() const {
+    return m_normalDepth;
+  }
+
+  /**
+   * The atlases on units firstUnit and firstUnit + 1 and the uniforms of the
+   * shaders of createShader().
+   */
+  void bind(const gpu::Shader &shader, unsigned int firstUnit = 0) const {
+
+    glBindTextureUnit(firstUnit, m_albedo.getID());
+    glBindTextureUnit(firstUnit + 1, m_normalDepth.getID());
+
+    shader.setInt("impostorAlbedo", firstUnit);
+    shader.setInt("impostorNormalDepth", firstUnit + 1);
+    shader.setInt("impostorFrames", m_frames);
+    shader.setVec4("impostorSphere", m_sphere);
+  }
+
+  void destroy() {
+    m_albedo.destroy();
+    m_normalDepth.destroy();
+  }
+
+private:
+  int m_frames = 0;
+  int m_frameSize = 0;
+
+  glm::vec4 m_sphere{0.0f, 0.0f, 0.0f, 1.0f};
+
+  bool m_loadedFromCache = false;
+
+  gpu::texture::Texture2D m_albedo;
+  gpu::texture::Texture2D m_normalDepth;
+
+  struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t frames;
+    int32_t frameSize;
+    uint32_t nVertices;
+  };
+
+  void computeBoundingSphere(const Model &model) {
+
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    for (size_t i = 0; i < model.m_meshes.size(); ++i) {
+
+      glm::mat4 transform = model.getMeshTransform(i);
+
+      for (const Vertex &vertex : model.m_meshes[i].m_vertices) {
+        glm::vec3 position{transform * glm::vec4{vertex.position, 1.0f}};
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+      }
+    }
+
+    glm::vec3 center = 0.5f * (min + max);
+    float radius = 0.0f;
+
+    for (size_t i = 0; i < model.m_meshes.size(); ++i) {
+
+      glm::mat4 transform = model.getMeshTransform(i);
+
+      for (const Vertex &vertex : model.m_meshes[i].m_vertices) {
+        glm::vec3 position{transform * glm::vec4{vertex.position, 1.0f}};
+        radius = std::max(radius, glm::length(position - center));
+      }
+    }
+
+    m_sphere = glm::vec4{center, std::max(radius, 1e-6f)};
+  }
+
+  void bake(const Model &model) {
+
+    CPU_PROFILE_ZONE("ImpostorAtlas::bake");
+
+    int size = m_frames * m_frameSize;
+
+    gpu::Shader shader =
+        gpu::Shader::fromSource(BAKE_VERTEX_SOURCE, BAKE_FRAGMENT_SOURCE);
+
+    gpu::Renderbuffer depth{size, size, GL_DEPTH_COMPONENT24};
+
+    gpu::framebuffer::Framebuffer framebuffer;
+    framebuffer.setColorAttachment(m_albedo, 0);
+    framebuffer.setColorAttachment(m_normalDepth, 1);
+    framebuffer.setDepthAttachment(depth);
+    framebuffer.setDrawBuffers(2);
+    framebuffer.checkStatus();
+
+    framebuffer.clearColorAttachment(0, 0.0f, 0.0f, 0.0f, 0.0f);
+    framebuffer.clearColorAttachment(1, 0.0f, 0.0f, 0.0f, 0.0f);
+    framebuffer.clearDepthAttachment();
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    framebuffer.bind();
+    glEnable(GL_DEPTH_TEST);
+
+    shader.use();
+
+    glm::vec3 center{m_sphere};
+    float radius = m_sphere.w;
+
+    shader.setVec4("sphere", m_sphere);
+
+    // orthographic, the bounding sphere fills the view
+    glm::mat4 projection =
+        glm::ortho(-radius, radius, -radius, radius, -radius, radius);
+
+    for (int j = 0; j < m_frames; ++j) {
+      for (int i = 0; i < m_frames; ++i) {
+
+        glm::vec3 direction = octahedralDecode(
+            glm::vec2{i, j} / static_cast<float>(m_frames - 1));
+
+        glm::vec3 right;
+        glm::vec3 up;
+        frameBasis(direction, right, up);
+
+        // rows: right, up, direction (the camera looks down -direction)
+        glm::mat4 view{1.0f};
+        for (int col = 0; col < 3; ++col) {
+          view[col][0] = right[col];
+          view[col][1] = up[col];
+          view[col][2] = direction[col];
+        }
+        view[3] = glm::vec4{-glm::dot(right, center), -glm::dot(up, center),
+                            -glm::dot(direction, center), 1.0f};
+
+        glViewport(i * m_frameSize, j * m_frameSize, m_frameSize,
+                   m_frameSize);
+
+        shader.setMat4("viewProjection", projection * view);
+        shader.setVec3("viewDirection", direction);
+
+        for (size_t m = 0; m < model.m_meshes.size(); ++m) {
+
+          glm::mat4 transform = model.getMeshTransform(m);
+
+          shader.setMat4("model", transform);
+          shader.setMat3("normalMatrix",
+                         glm::transpose(glm::inverse(glm::mat3{transform})));
+
+          model.m_meshes[m].draw(shader);
+        }
+      }
+    }
+
+    glUseProgram(0);
+
+    gpu::framebuffer::bindDefault();
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    if (!depthTest) {
+      glDisable(GL_DEPTH_TEST);
+    }
+
+    framebuffer.destroy();
+    depth.destroy();
+    shader.destroy();
+  }
+
+  bool load(const std::string &path, uint32_t nVertices) {
+
+    std::ifstream file{path, std::ios::binary};
+
+    if (!file) {
+      return false;
+    }
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    if (!file || header.magic != IMPOSTOR_CACHE_MAGIC ||
+        header.version != IMPOSTOR_CACHE_VERSION ||
+        header.frames != m_frames || header.frameSize != m_frameSize ||
+        header.nVertices != nVertices) {
+      return false;
+    }
+
+    size_t size = static_cast<size_t>(m_frames * m_frameSize);
+    std::vector<uint8_t> texels(size * size * 4);
+
+    for (gpu::texture::Texture2D *atlas : {&m_albedo, &m_normalDepth}) {
+
+      file.read(reinterpret_cast<char *>(texels.data()), texels.size());
+
+      if (!file) {
+        return false;
+      }
+
+      glTextureSubImage2D(atlas->getID(), 0, 0, 0, size, size, GL_RGBA,
+                          GL_UNSIGNED_BYTE, texels.data());
+    }
+
+    return true;
+  }
+
+  void save(const std::string &path, uint32_t nVertices) const {
+
+    std::ofstream file{path, std::ios::binary};
+
+    if (!file) {
+
+      std::string message = "Could not write impostor cache " + path;
+
+      glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_OTHER, 0,
+                           GL_DEBUG_SEVERITY_LOW, message.length(),
+                           message.c_str());
+      return;
+    }
+
+    CacheHeader header{IMPOSTOR_CACHE_MAGIC, IMPOSTOR_CACHE_VERSION, m_frames,
+                       m_frameSize, nVertices};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    size_t size = static_cast<size_t>(m_frames * m_frameSize);
+    std::vector<uint8_t> texels(size * size * 4);
+
+    for (const gpu::texture::Texture2D *atlas : {&m_albedo, &m_normalDepth}) {
+
+      glGetTextureImage(atlas->getID(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                        static_cast<GLsizei>(texels.size()), texels.data());
+
+      file.write(reinterpret_cast<const char *>(texels.data()), texels.size());
+    }
+  }
+
+  static constexpr const char *BAKE_VERTEX_SOURCE = R"(#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+
+uniform mat4 model;
+uniform mat3 normalMatrix;
+uniform mat4 viewProjection;
+
+out VS_OUT {
+  vec3 position;
+  vec3 normal;
+  vec2 texCoords;
+} vs_out;
+
+void main() {
+  vec4 position = model * vec4(aPos, 1.0);
+
+  vs_out.position = position.xyz;
+  vs_out.normal = normalMatrix * aNormal;
+  vs_out.texCoords = aTexCoords;
+
+  gl_Position = viewProjection * position;
+}
+)";
+
+  static constexpr const char *BAKE_FRAGMENT_SOURCE = R"(#version 450 core
+
+in VS_OUT {
+  vec3 position;
+  vec3 normal;
+  vec2 texCoords;
+} fs_in;
+
+layout(location = 0) out vec4 albedo;
+layout(location = 1) out vec4 normalDepth;
+
+struct Material {
+  sampler2D texture_diffuse0;
+};
+
+uniform Material material;
+
+uniform vec4 sphere;
+uniform vec3 viewDirection;
+
+void main() {
+  float depth = dot(fs_in.position - sphere.xyz, viewDirection) / sphere.w;
+
+  albedo = vec4(texture(material.texture_diffuse0, fs_in.texCoords).rgb, 1.0);
+  normalDepth = vec4(normalize(fs_in.normal) * 0.5 + 0.5, depth * 0.5 + 0.5);
+}
+)";
+};
+
+/**
+ * How the impostor vertex shader reads an instance of T (the attributes
+ * InstanceBuffer<T> sets up): its translation, rotation and uniform scale.
+ */
+template <typename T> struct ImpostorInstance;
+
+template <> struct ImpostorInstance<glm::mat4> {
+  static std::string getSource() {
+
+    std::stringstream ss;
+    ss << "layout(location = " << gpu::INSTANCE_ATTRIBUTE_LOCATION
+       << ") in mat4 instanceMatrix;\n";
+
+    ss << R"(
+void loadInstance(out vec3 position, out mat3 rotation, out float scale) {
+  scale = length(instanceMatrix[0].xyz);
+  rotation = mat3(instanceMatrix) / scale;
+  position = instanceMatrix[3].xyz;
+}
+)";
+
+    return ss.str();
+  }
+};
+
+// needs the instanceMin and instanceExtent uniforms (InstanceQuantization)
+template <> struct ImpostorInstance<gpu::CompactInstance> {
+  static std::string getSource() {
+
+    std::stringstream ss;
+    ss << "layout(location = " << gpu::INSTANCE_ATTRIBUTE_LOCATION
+       << ") in vec4 instancePositionScale;\n";
+    ss << "layout(location = " << gpu::INSTANCE_ATTRIBUTE_LOCATION + 1
+       << ") in vec4 instanceRotation;\n";
+
+    ss << R"(
+uniform vec4 instanceMin;
+uniform vec4 instanceExtent;
+
+void loadInstance(out vec3 position, out mat3 rotation, out float scale) {
+  vec4 positionScale = instanceMin + instancePositionScale * instanceExtent;
+  vec4 q = instanceRotation;
+
+  position = positionScale.xyz;
+  scale = positionScale.w;
+  rotation = mat3(1.0 - 2.0 * (q.y * q.y + q.z * q.z),
+                  2.0 * (q.x * q.y + q.w * q.z),
+                  2.0 * (q.x * q.z - q.w * q.y),
+                  2.0 * (q.x * q.y - q.w * q.z),
+                  1.0 - 2.0 * (q.x * q.x + q.z * q.z),
+                  2.0 * (q.y * q.z + q.w * q.x),
+                  2.0 * (q.x * q.z + q.w * q.y),
+                  2.0 * (q.y * q.z - q.w * q.x),
+                  1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+}
+)";
+
+    return ss.str();
+  }
+};
+
+// octahedralEncode, octahedralDecode and frameBasis
+constexpr const char *IMPOSTOR_FRAME_SOURCE = R"(
+vec2 signNotZero(vec2 v) {
+  return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 octahedralEncode(vec3 direction) {
+  vec3 n = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+  vec2 p = n.xz;
+  if (n.y < 0.0) {
+    p = (1.0 - abs(p.yx)) * signNotZero(p);
+  }
+  return p * 0.5 + 0.5;
+}
+
+vec3 octahedralDecode(vec2 uv) {
+  vec2 p = uv * 2.0 - 1.0;
+  vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+  if (n.y < 0.0) {
+    n.xz = (1.0 - abs(p.yx)) * signNotZero(p);
+  }
+  return normalize(n);
+}
+
+void frameBasis(vec3 direction, out vec3 right, out vec3 up) {
+  vec3 worldUp = abs(direction.y) < 0.999 ? vec3(0.0, 1.0, 0.0)
+                                          : vec3(0.0, 0.0, -1.0);
+  right = normalize(cross(worldUp, direction));
+  up = cross(direction, right);
+}
+)";
+
+constexpr const char *IMPOSTOR_VERTEX_SOURCE = R"(
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform int impostorFrames;
+uniform vec4 impostorSphere;
+
+out VS_OUT {
+  // where the quad corner falls in each of the 3 views, on the plane
+  // through the center
+  vec2 frameUVs[3];
+  // how far the view ray moves in a view per unit of baked depth
+  flat vec2 frameShifts[3];
+  flat ivec2 frames[3];
+  flat vec3 weights;
+  vec3 worldPos;
+  flat vec3 toEye;
+  flat float radius;
+} vs_out;
+
+void main() {
+  vec3 position;
+  mat3 rotation;
+  float scale;
+  loadInstance(position, rotation, scale);
+
+  vec3 center = position + rotation * (scale * impostorSphere.xyz);
+  float radius = scale * impostorSphere.w;
+
+  vec3 eye = -transpose(mat3(view)) * view[3].xyz;
+  vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+  vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+
+  // triangle strip over the bounding sphere, facing the screen
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+  vec3 worldPos = center + radius * (corner.x * cameraRight +
+                                     corner.y * cameraUp);
+
+  vec3 toEye = normalize(eye - center);
+
+  // model space, over the bounding sphere
+  vec3 direction = transpose(rotation) * toEye;
+  vec3 offset = transpose(rotation) * (worldPos - center) / radius;
+
+  // the grid triangle around the direction: its corners are the closest
+  // views, the barycentric coordinates their weights
+  float last = float(impostorFrames - 1);
+  vec2 grid = octahedralEncode(direction) * last;
+  vec2 cell = min(floor(grid), vec2(last - 1.0));
+  vec2 f = grid - cell;
+
+  bool lower = f.x > f.y;
+
+  vs_out.frames[0] = ivec2(cell);
+  vs_out.frames[1] = ivec2(cell) + (lower ? ivec2(1, 0) : ivec2(0, 1));
+  vs_out.frames[2] = ivec2(cell) + ivec2(1, 1);
+  vs_out.weights = lower ? vec3(1.0 - f.x, f.x - f.y, f.y)
+                         : vec3(1.0 - f.y, f.y - f.x, f.x);
+
+  for (int k = 0; k < 3; ++k) {
+    vec3 frameDirection = octahedralDecode(vec2(vs_out.frames[k]) / last);
+
+    vec3 right;
+    vec3 up;
+    frameBasis(frameDirection, right, up);
+
+    // the point of the plane of the view that is seen through this one
+    vec3 p = offset - direction * dot(offset, frameDirection) /
+                          max(dot(direction, frameDirection), 1e-3);
+
+    vs_out.frameUVs[k] = vec2(dot(p, right), dot(p, up)) * 0.5 + 0.5;
+    vs_out.frameShifts[k] = vec2(dot(direction, right), dot(direction, up)) *
+                            0.5 / max(dot(direction, frameDirection), 1e-3);
+  }
+
+  vs_out.worldPos = worldPos;
+  vs_out.toEye = toEye;
+  vs_out.radius = radius;
+
+  gl_Position = projection * view * vec4(worldPos, 1.0);
+}
+)";
+
+constexpr const char *IMPOSTOR_FRAGMENT_SOURCE = R"(#version 450 core
+
+in VS_OUT {
+  vec2 frameUVs[3];
+  flat vec2 frameShifts[3];
+  flat ivec2 frames[3];
+  flat vec3 weights;
+  vec3 worldPos;
+  flat vec3 toEye;
+  flat float radius;
+} fs_in;
+
+out vec4 FragColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform sampler2D impostorAlbedo;
+uniform sampler2D impostorNormalDepth;
+uniform int impostorFrames;
+
+vec2 atlasUV(int k, vec2 frameUV) {
+  return (vec2(fs_in.frames[k]) + clamp(frameUV, 0.0, 1.0)) /
+         float(impostorFrames);
+}
+
+void main() {
+  vec4 albedo = vec4(0.0);
+  vec4 normalDepth = vec4(0.0);
+
+  for (int k = 0; k < 3; ++k) {
+    // one parallax step: from the plane to the surface at the baked depth,
+    // so that the views agree on what the ray hits
+    vec2 uv = atlasUV(k, fs_in.frameUVs[k]);
+
+    float coverage = texture(impostorAlbedo, uv).a;
+    float depth = 0.0;
+
+    if (coverage > 0.0) {
+      depth = texture(impostorNormalDepth, uv).a / coverage * 2.0 - 1.0;
+    }
+
+    uv = atlasUV(k, fs_in.frameUVs[k] + depth * fs_in.frameShifts[k]);
+
+    albedo += fs_in.weights[k] * texture(impostorAlbedo, uv);
+    normalDepth += fs_in.weights[k] * texture(impostorNormalDepth, uv);
+  }
+
+  if (albedo.a < 0.5) {
+    discard;
+  }
+
+  // premultiplied by the coverage
+  float depth = normalDepth.a / albedo.a * 2.0 - 1.0;
+
+  vec3 surface = fs_in.worldPos + fs_in.toEye * depth * fs_in.radius;
+  vec4 clip = projection * view * vec4(surface, 1.0);
+
+  gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+  FragColor = vec4(albedo.rgb / albedo.a, 1.0);
+}
+)";
+
+/**
+ * Draws instances of T, read from an InstanceBuffer<T> attached to a vao
+ * without vertex attributes, as a 4 vertices triangle strip each:
+ *
+ *  glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, n, base);
+ *
+ * Needs the view and projection uniforms and ImpostorAtlas::bind(). The
+ * surface depth of the atlas is written to gl_FragDepth, so that impostors
+ * intersect each other and the meshes around them.
+ */
+template <typename T> gpu::Shader createShader() {
+
+  std::stringstream vertexSource;
+  vertexSource << "#version 450 core\n\n"
+               << ImpostorInstance<T>::getSource() << IMPOSTOR_FRAME_SOURCE
+               << IMPOSTOR_VERTEX_SOURCE;
+
+  return gpu::Shader::fromSource(vertexSource.str(),
+                                 IMPOSTOR_FRAGMENT_SOURCE);
+}
+
+struct DistanceSplit {
+  size_t nNear = 0;
+  size_t nFar = 0;
+};
+
+/**
+ * Copies the instances closer than distance to eye to nearInstances and the
+ * others to farInstances, in their order. In parallel over blocks of
+ * instances: a pass counts the near ones of each block, the second writes
+ * them from the offsets. The outputs can be mapped gpu memory, they are
+ * only written. position(instance) is the world position of an instance.
+ */
+template <typename T, typename PositionFn>
+DistanceSplit
+splitByDistance(const T *instances, size_t n, const glm::vec3 &eye,
+                float distance, PositionFn &&position, T *nearInstances,
+                T *farInstances,
+                jobs::JobSystem &jobSystem = jobs::getJobSystem()) {
+
+  CPU_PROFILE_ZONE("impostors::splitByDistance");
+
+  size_t nBlocks =
+      (n + IMPOSTOR_SPLIT_BLOCK_SIZE - 1) / IMPOSTOR_SPLIT_BLOCK_SIZE;
+
+  float distance2 = distance * distance;
+
+  auto isNear = [&](const T &instance) {
+    glm::vec3 d = position(instance) - eye;
+    return glm::dot(d, d) < distance2;
+  };
+
+  // near instances per block, then their exclusive prefix sum
+  std::vector<size_t> nearOffsets(nBlocks + 1, 0);
+
+  jobSystem.parallelFor(nBlocks, 1, [&](size_t beginBlock, size_t endBlock) {
+    for (size_t block = beginBlock; block < endBlock; ++block) {
+
+      size_t end = std::min((block + 1) * IMPOSTOR_SPLIT_BLOCK_SIZE, n);
+      size_t nNear = 0;
+
+      for (size_t i = block * IMPOSTOR_SPLIT_BLOCK_SIZE; i < end; ++i) {
+        nNear += isNear(instances[i]) ? 1 : 0;
+      }
+
+      nearOffsets[block + 1] = nNear;
+    }
+  });
+
+  for (size_t block = 0; block < nBlocks; ++block) {
+    nearOffsets[block + 1] += nearOffsets[block];
+  }
+
+  jobSystem.parallelFor(nBlocks, 1, [&](size_t beginBlock, size_t endBlock) {
+    for (size_t block = beginBlock; block < endBlock; ++block) {
+
+      size_t begin = block * IMPOSTOR_SPLIT_BLOCK_SIZE;
+      size_t end = std::min(begin + IMPOSTOR_SPLIT_BLOCK_SIZE, n);
+
+      size_t nearIndex = nearOffsets[block];
+      size_t farIndex = begin - nearOffsets[block];
+
+      for (size_t i = begin; i < end; ++i) {
+        if (isNear(instances[i])) {
+          nearInstances[nearIndex++] = instances[i];
+        } else {
+          farInstances[farIndex++] = instances[i];
+        }
+      }
+    }
+  });
+
+  DistanceSplit split;
+  split.nNear = nearOffsets[nBlocks];
+  split.nFar = n - split.nNear;
+
+  return split;
+}
+
+} // namespace impostors
+
+#endif // IMPOSTOR_H
@@ -0,0 +1,347 @@
+#ifndef GPU_INSTANCE_BUFFER_H
+#define GPU_INSTANCE_BUFFER_H
+
+#include "compactinstance.h"
+#include "gpuobject.h"
+#include "mesh.h"
+#include "streambuffer.h"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace gpu {
+
+/**
+ * Per-instance vertex attributes start at this location by default, after
+ * the ones of Mesh (0-4 for position, normal, texcoords, tangent,
+ * bitangent). 5-7 stay free for mesh attributes.
+ */
+constexpr GLuint INSTANCE_ATTRIBUTE_LOCATION = 8;
+
+// one vertex attribute of an instance struct
+struct InstanceAttribute {
+  GLint size;
+  GLenum type;
+  GLboolean normalized;
+  GLuint relativeOffset;
+};
+
+/**
+ * The vertex attributes an instance of T is read as, at consecutive
+ * locations. Specialized for the glm vectors, glm::mat4 (4 vec4 columns)
+ * and gpu::CompactInstance.
+ */
+template <typename T> struct InstanceLayout;
+
+template <> struct InstanceLayout<float> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    return {{1, GL_FLOAT, GL_FALSE, 0}};
+  }
+};
+
+template <> struct InstanceLayout<glm::vec2> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    return {{2, GL_FLOAT, GL_FALSE, 0}};
+  }
+};
+
+template <> struct InstanceLayout<glm::vec3> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    return {{3, GL_FLOAT, GL_FALSE, 0}};
+  }
+};
+
+template <> struct InstanceLayout<glm::vec4> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    return {{4, GL_FLOAT, GL_FALSE, 0}};
+  }
+};
+
+template <> struct InstanceLayout<glm::mat4> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    std::vector<InstanceAttribute> columns;
+    for (GLuint i = 0; i < 4; ++i) {
+      columns.push_back({4, GL_FLOAT, GL_FALSE,
+                         static_cast<GLuint>(i * sizeof(glm::vec4))});
+    }
+    return columns;
+  }
+};
+
+template <> struct InstanceLayout<CompactInstance> {
+  static std::vector<InstanceAttribute> getAttributes() {
+    return {{4, GL_UNSIGNED_SHORT, GL_TRUE,
+             offsetof(CompactInstance, positionScale)},
+            {4, GL_SHORT, GL_TRUE, offsetof(CompactInstance, rotation)}};
+  }
+};
+
+enum class InstanceBufferMode {
+  // mutable storage: update() orphans it and uploads, update(first, ...)
+  // rewrites a sub-range
+  DYNAMIC,
+  // immutable storage mapped once, one region per frame in flight: all the
+  // instances are written every frame between beginFrame() and endFrame()
+  PERSISTENT
+};
+
+struct InstanceBufferCreateInfo {
+
+  InstanceBufferCreateInfo() {}
+
+  InstanceBufferMode mode = InstanceBufferMode::DYNAMIC;
+
+  // instances allocated up front, the buffer grows when more are written
+  size_t capacity = 0;
+
+  // of the first attribute, also the vertex buffer binding index used
+  GLuint location = INSTANCE_ATTRIBUTE_LOCATION;
+};
+
+/**
+ * Instances of T fed to instanced draws as vertex attributes (divisor 1)
+ * from createInfo.location on, with the formats of InstanceLayout<T>.
+ *
+ * attach(vao) adds the instance attributes to a vao, createVertexArray(mesh)
+ * creates a vao with the vertices of the mesh plus the instances, the mesh's
+ * own vao is left as it is. When the buffer is reallocated (it grows
+ * geometrically), the attached vaos are pointed to the new one.
+ *
+ * Draws have to use getBaseInstance() as base instance, in the persistent
+ * mode it selects the region of the current frame:
+ *
+ *  T *instances = buffer.beginFrame(count);
+ *  ... write count instances ...
+ *  glDrawElementsInstancedBaseInstance(..., count,
+ *                                      buffer.getBaseInstance());
+ *  buffer.endFrame();
+ */
+template <typename T> class InstanceBuffer : public GpuObject {
+
+public:
+  InstanceBuffer() {}
+
+  InstanceBuffer(const InstanceBufferCreateInfo &createInfo)
+      : m_mode(createInfo.mode), m_location(createInfo.location),
+        m_attributes(InstanceLayout<T>::getAttributes()) {
+
+    allocate(std::max<size_t>(createInfo.capacity, 1));
+  }
+
+  /**
+   * Instance attributes of vao read from this buffer, vao stays owned by the
+   * caller and has to outlive the buffer or be detached.
+   */
+  void attach(GLuint vao) {
+
+    for (GLuint i = 0; i < m_attributes.size(); ++i) {
+
+      const InstanceAttribute &attribute = m_attributes[i];
+
+      glEnableVertexArrayAttrib(vao, m_location + i);
+      glVertexArrayAttribFormat(vao, m_location + i, attribute.size,
+                                attribute.type, attribute.normalized,
+                                attribute.relativeOffset);
+      glVertexArrayAttribBinding(vao, m_location + i, m_location);
+    }
+
+    glVertexArrayVertexBuffer(vao, m_location, m_ID, 0, sizeof(T));
+    glVertexArrayBindingDivisor(vao, m_location, 1);
+
+    m_vertexArrays.push_back(vao);
+  }
+
+  void detach(GLuint vao) {
+
+    for (GLuint i = 0; i < m_attributes.size(); ++i) {
+      glDisableVertexArrayAttrib(vao, m_location + i);
+    }
+
+    glVertexArrayVertexBuffer(vao, m_location, 0, 0, sizeof(T));
+
+    m_vertexArrays.erase(
+        std::remove(m_vertexArrays.begin(), m_vertexArrays.end(), vao),
+        m_vertexArrays.end());
+  }
+
+  /**
+   * A new vao with the vertex attributes of the mesh and the instances,
+   * deleted with the buffer.
+   */
+  GLuint createVertexArray(const Mesh &mesh) {
+
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+
+    mesh.setVertexAttributes(vao);
+    attach(vao);
+
+    m_ownedVertexArrays.push_back(vao);
+
+    return vao;
+  }
+
+  // dynamic mode: replaces all the instances
+  void update(const T *instances, size_t count) {
+
+    if (count > m_capacity) {
+      m_capacity = std::max(count, 2 * m_capacity);
+    }
+
+    // orphaning: new storage for the same buffer, the draws still reading
+    // the previous one don't stall the upload
+    glNamedBufferData(m_ID, m_capacity * sizeof(T), nullptr,
+                      GL_DYNAMIC_DRAW);
+
+    if (count > 0) {
+      glNamedBufferSubData(m_ID, 0, count * sizeof(T), instances);
+    }
+
+    m_count = count;
+  }
+
+  void update(const std::vector<T> &instances) {
+    update(instances.data(), instances.size());
+  }
+
+  /**
+   * Dynamic mode: rewrites the instances [first, first + count), the others
+   * are kept (also when the buffer has to grow).
+   */
+  void update(size_t first, const T *instances, size_t count) {
+
+    if (count == 0) {
+      return;
+    }
+
+    if (first + count > m_capacity) {
+      grow(first + count);
+    }
+
+    glNamedBufferSubData(m_ID, first * sizeof(T), count * sizeof(T),
+                         instances);
+
+    m_count = std::max(m_count, first + count);
+  }
+
+  /**
+   * Persistent mode: where to write the count instances of this frame, once
+   * the gpu is done with the region. nullptr if the buffer couldn't be
+   * mapped: skip the writes and the draws of the frame.
+   */
+  T *beginFrame(size_t count) {
+
+    if (count > m_capacity) {
+      m_stream.destroy();
+      allocate(std::max(count, 2 * m_capacity));
+    }
+
+    T *instances = static_cast<T *>(m_stream.beginRegion());
+
+    m_count = instances != nullptr ? count : 0;
+
+    return instances;
+  }
+
+  // persistent mode: after the draws reading the instances of this frame
+  void endFrame() { m_stream.endRegion(); }
+
+  // the first instance of the current frame, 0 in the dynamic mode
+  inline GLuint getBaseInstance() const {
+    return m_mode == InstanceBufferMode::PERSISTENT
+               ? static_cast<GLuint>(m_stream.getRegionIndex() * m_capacity)
+               : 0;
+  }
+
+  inline size_t getCount() const { return m_count; }
+
+  inline size_t getCapacity() const { return m_capacity; }
+
+  inline InstanceBufferMode getMode() const { return m_mode; }
+
+  // persistent mode: beginFrame() calls that had to wait for the gpu
+  inline size_t getNumStalls() const { return m_stream.getNumStalls(); }
+
+  virtual void destroy() override {
+
+    if (!m_ownedVertexArrays.empty()) {
+      glDeleteVertexArrays(static_cast<GLsizei>(m_ownedVertexArrays.size()),
+                           m_ownedVertexArrays.data());
+    }
+
+    m_ownedVertexArrays.clear();
+    m_vertexArrays.clear();
+
+    if (m_mode == InstanceBufferMode::PERSISTENT) {
+      m_stream.destroy();
+    } else {
+      glDeleteBuffers(1, &m_ID);
+    }
+
+    m_ID = 0;
+    m_capacity = 0;
+    m_count = 0;
+  }
+
+private:
+  InstanceBufferMode m_mode = InstanceBufferMode::DYNAMIC;
+  GLuint m_location = INSTANCE_ATTRIBUTE_LOCATION;
+
+  std::vector<InstanceAttribute> m_attributes;
+
+  size_t m_capacity = 0;
+  size_t m_count = 0;
+
+  // persistent mode, m_ID is its buffer
+  StreamBuffer m_stream;
+
+  // attached, and created by createVertexArray()
+  std::vector<GLuint> m_vertexArrays;
+  std::vector<GLuint> m_ownedVertexArrays;
+
+  void allocate(size_t capacity) {
+
+    m_capacity = capacity;
+
+    if (m_mode == InstanceBufferMode::PERSISTENT) {
+      m_stream = StreamBuffer{m_capacity * sizeof(T)};
+      m_ID = m_stream.getID();
+    } else {
+      glCreateBuffers(1, &m_ID);
+      glNamedBufferData(m_ID, m_capacity * sizeof(T), nullptr,
+                        GL_DYNAMIC_DRAW);
+    }
+
+    rebind();
+  }
+
+  // dynamic mode: a bigger buffer with the instances of the current one
+  void grow(size_t capacity) {
+
+    GLuint previous = m_ID;
+    size_t previousCount = m_count;
+
+    allocate(std::max(capacity, 2 * m_capacity));
+
+    if (previousCount > 0) {
+      glCopyNamedBufferSubData(previous, m_ID, 0, 0,
+                               previousCount * sizeof(T));
+    }
+
+    glDeleteBuffers(1, &previous);
+  }
+
+  void rebind() {
+    for (GLuint vao : m_vertexArrays) {
+      glVertexArrayVertexBuffer(vao, m_location, m_ID, 0, sizeof(T));
+    }
+  }
+};
+
+} // namespace gpu
+
+#endif // GPU_INSTANCE_BUFFER_H
@@ -0,0 +1,807 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "cpuprofiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jobs {
+
+// callables up to this size are stored in the job, bigger ones on the heap
+constexpr size_t JOB_STORAGE_SIZE = 48;
+
+// jobs are allocated and recycled between threads in blocks of this size
+constexpr size_t JOB_BLOCK_SIZE = 256;
+
+// jobs a worker can queue before the next ones go to the shared queue
+constexpr size_t DEQUE_CAPACITY = 4096;
+
+constexpr unsigned int NO_WORKER = ~0u;
+
+enum class JobAffinity {
+  // any worker, or the main thread while it waits
+  ANY = 0,
+  // only the main thread (the gl context), in wait() or runMainThreadJobs()
+  MAIN_THREAD
+};
+
+struct Job;
+
+/**
+ * Counts the unfinished jobs spawned with it. wait() on it, or chain jobs
+ * after it with spawnAfter. A counter can be reused once it is done, and
+ * must outlive the jobs and continuations that reference it.
+ */
+class Counter {
+
+public:
+  Counter() {}
+
+  Counter(const Counter &) = delete;
+  Counter &operator=(const Counter &) = delete;
+
+  // no job left, and no continuation waiting to be queued
+  inline bool isDone() const {
+    return m_state.load(std::memory_order_acquire) == 0;
+  }
+
+  inline uint32_t getNumPending() const {
+    return static_cast<uint32_t>(m_state.load(std::memory_order_acquire) &
+                                 PENDING_MASK);
+  }
+
+private:
+  friend class JobSystem;
+
+  // pending jobs, and two flags. The flags keep the state non zero while
+  // continuations are attached, so a waiter doesn't see the counter done
+  // (and destroy it) before the last job has queued them
+  static constexpr uint64_t PENDING_MASK = 0xffffffffull;
+  static constexpr uint64_t HAS_CONTINUATIONS = 1ull << 32;
+  static constexpr uint64_t LOCKED = 1ull << 33;
+
+  std::atomic<uint64_t> m_state{0};
+
+  // guarded by LOCKED
+  std::vector<Job *> m_continuations;
+
+  inline void lock() {
+    while (m_state.fetch_or(LOCKED, std::memory_order_acquire) & LOCKED) {
+      std::this_thread::yield();
+    }
+  }
+};
+
+struct Job {
+
+  alignas(std::max_align_t) unsigned char storage[JOB_STORAGE_SIZE];
+
+  void (*invoke)(Job &job) = nullptr;
+  void (*destroy)(Job &job) = nullptr;
+
+  Counter *counter = nullptr;
+  JobAffinity affinity = JobAffinity::ANY;
+
+  // free list
+  Job *next = nullptr;
+};
+
+/**
+ * Chase-Lev deque of a fixed capacity (Le, Pop, Cohen, Zappa Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models", 2013): the
+ * owner pushes and pops at the bottom (LIFO, cache friendly), the other
+ * threads steal from the top (FIFO, the oldest and usually biggest jobs).
+ */
+class WorkStealingDeque {
+
+public:
+  // capacity is rounded up to a power of two
+  explicit WorkStealingDeque(size_t capacity) {
+
+    size_t size = 1;
+    while (size < capacity) {
+      size *= 2;
+    }
+
+    m_buffer = std::vector<std::atomic<Job *>>(size);
+    m_mask = static_cast<int64_t>(size - 1);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // owner only, false when full
+  bool push(Job *job) {
+
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top = m_top.load(std::memory_order_acquire);
+
+    if (bottom - top > m_mask) {
+      return false;
+    }
+
+    m_buffer[bottom & m_mask].store(job, std::memory_order_relaxed);
+
+    // publishes the job to the thieves (acquire load of m_bottom in steal)
+    m_bottom.store(bottom + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // owner only, nullptr when empty
+  Job *pop() {
+
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Job *job = m_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+
+    if (top == bottom) {
+
+      // last item, race against the thieves
+      if (!m_top.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+        job = nullptr;
+      }
+
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+  }
+
+  // any thread, nullptr when empty or when another thread won the race
+  Job *steal() {
+
+    int64_t top = m_top.load(std::memory_order_acquire);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+      return nullptr;
+    }
+
+    Job *job = m_buffer[top & m_mask].load(std::memory_order_relaxed);
+
+    if (!m_top.compare_exchange_strong(top, top + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+      return nullptr;
+    }
+
+    return job;
+  }
+
+private:
+  alignas(64) std::atomic<int64_t> m_top{0};
+  alignas(64) std::atomic<int64_t> m_bottom{0};
+
+  std::vector<std::atomic<Job *>> m_buffer;
+  int64_t m_mask = 0;
+};
+
+struct JobSystemCreateInfo {
+
+  JobSystemCreateInfo() {}
+
+  // main thread included, 0 = std::thread::hardware_concurrency()
+  unsigned int nThreads = 0;
+
+  // failed attempts to find a job before an idle worker goes to sleep
+  unsigned int nSpinsBeforeSleep = 64;
+};
+
+/**
+ * Work-stealing job scheduler. The thread that creates the JobSystem is the
+ * main thread (worker 0), nThreads - 1 workers are started.
+ *
+ * Every thread of the system has a WorkStealingDeque: spawned jobs go to the
+ * deque of the spawning thread, idle threads steal from the others. Jobs
+ * spawned from threads outside of the system (or when a deque is full) go
+ * to a shared queue, with a single thread they only run when the main
+ * thread waits.
+ *
+ * Jobs with JobAffinity::MAIN_THREAD (anything that touches the gl context)
+ * only run on the main thread, while it waits or in runMainThreadJobs().
+ *
+ * wait() runs jobs until its counter is done, so jobs can wait on the jobs
+ * they spawn without blocking a worker.
+ *
+ *  jobs::Counter counter;
+ *  jobSystem.spawn([&] { decode(image); }, &counter);
+ *  jobSystem.spawnAfter(counter, [&] { upload(image); }, nullptr,
+ *                       jobs::JobAffinity::MAIN_THREAD);
+ *
+ *  jobSystem.parallelFor(n, 0, [&](size_t begin, size_t end) { ... });
+ *
+ * Counters have to be done before the JobSystem is destroyed.
+ */
+class JobSystem {
+
+public:
+  JobSystem(const JobSystemCreateInfo &createInfo = JobSystemCreateInfo{})
+      : m_nSpinsBeforeSleep(createInfo.nSpinsBeforeSleep),
+        m_mainThreadId(std::this_thread::get_id()) {
+
+    unsigned int nThreads =
+        createInfo.nThreads != 0
+            ? createInfo.nThreads
+            : std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < nThreads; ++i) {
+      m_workers.push_back(std::make_unique<Worker>());
+      m_workers.back()->random = 0x9e3779b9u * (i + 1);
+    }
+
+    for (unsigned int i = 1; i < nThreads; ++i) {
+      m_workers[i]->thread = std::thread{[this, i] { work(i); }};
+    }
+  }
+
+  ~JobSystem() {
+
+    {
+      std::lock_guard<std::mutex> lock{m_sleepMutex};
+      m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+      m_workers[i]->thread.join();
+    }
+  }
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  inline unsigned int getNumThreads() const {
+    return static_cast<unsigned int>(m_workers.size());
+  }
+
+  // index of the calling thread in this system, NO_WORKER for other threads
+  inline unsigned int getWorkerIndex() const {
+
+    const ThreadSlot &slot = getThreadSlot();
+
+    if (slot.system == this) {
+      return slot.index;
+    }
+
+    return std::this_thread::get_id() == m_mainThreadId ? 0 : NO_WORKER;
+  }
+
+  inline bool isMainThread() const {
+    return std::this_thread::get_id() == m_mainThreadId;
+  }
+
+  /**
+   * Queues fn() (copied or moved into the job). The counter, if any, is
+   * incremented now and decremented when fn returns.
+   */
+  template <typename Fn>
+  void spawn(Fn &&fn, Counter *counter = nullptr,
+             JobAffinity affinity = JobAffinity::ANY) {
+
+    Job *job = createJob(std::forward<Fn>(fn), counter, affinity);
+
+    if (counter != nullptr) {
+      counter->m_state.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    enqueue(job);
+  }
+
+  /**
+   * Queues fn() once 'dependency' is done (right away if it is). The
+   * counter, if any, is incremented now.
+   */
+  template <typename Fn>
+  void spawnAfter(Counter &dependency, Fn &&fn, Counter *counter = nullptr,
+                  JobAffinity affinity = JobAffinity::ANY) {
+
+    Job *job = createJob(std::forward<Fn>(fn), counter, affinity);
+
+    if (counter != nullptr) {
+      counter->m_state.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    dependency.lock();
+
+    // setting the flag and reading the pending jobs in one operation: the
+    // last job either finished before (nothing pending) or sees the flag
+    uint64_t state = dependency.m_state.fetch_or(Counter::HAS_CONTINUATIONS,
+                                                 std::memory_order_acq_rel);
+
+    if ((state & Counter::PENDING_MASK) == 0) {
+
+      if (dependency.m_continuations.empty()) {
+        dependency.m_state.fetch_and(
+            ~(Counter::HAS_CONTINUATIONS | Counter::LOCKED),
+            std::memory_order_release);
+      } else {
+        dependency.m_state.fetch_and(~Counter::LOCKED,
+                                     std::memory_order_release);
+      }
+
+      enqueue(job);
+      return;
+    }
+
+    dependency.m_continuations.push_back(job);
+    dependency.m_state.fetch_and(~Counter::LOCKED, std::memory_order_release);
+  }
+
+  /**
+   * Runs jobs until the counter is done. The main thread also runs its
+   * MAIN_THREAD jobs, threads outside of the system only yield.
+   */
+  void wait(const Counter &counter) {
+
+    unsigned int index = getWorkerIndex();
+
+    while (!counter.isDone()) {
+
+      Job *job = nullptr;
+
+      if (index == 0) {
+        job = popMainThreadJob();
+      }
+
+      if (job == nullptr && index != NO_WORKER) {
+        job = findJob(index);
+      }
+
+      if (job != nullptr) {
+        run(job, index);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /**
+   * Runs the MAIN_THREAD jobs queued so far (eg. once per frame), main
+   * thread only. Returns how many ran.
+   */
+  size_t runMainThreadJobs() {
+
+    size_t nJobs = 0;
+
+    while (Job *job = popMainThreadJob()) {
+      run(job, 0);
+      ++nJobs;
+    }
+
+    return nJobs;
+  }
+
+  /**
+   * fn(begin, end) on chunks of at most 'grain' items of [0, n), returns
+   * when they are all done. The range is split in halves, the calling
+   * thread keeps the first half and the other halves can be stolen, so
+   * chunks spread over the threads in log(n / grain) steps.
+   *
+   * grain 0: n / (4 * threads), enough chunks to balance uneven work.
+   */
+  template <typename Fn>
+  void parallelFor(size_t n, size_t grain, const Fn &fn) {
+
+    if (n == 0) {
+      return;
+    }
+
+    if (grain == 0) {
+      grain = std::max<size_t>(1, n / (4 * m_workers.size()));
+    }
+
+    if (n <= grain || m_workers.size() == 1) {
+      fn(0, n);
+      return;
+    }
+
+    Counter counter;
+    splitRange(0, n, grain, fn, counter);
+    wait(counter);
+  }
+
+private:
+  struct alignas(64) Worker {
+    WorkStealingDeque deque{DEQUE_CAPACITY};
+
+    // recycled jobs, only touched by this worker
+    Job *freeJobs = nullptr;
+    size_t nFreeJobs = 0;
+
+    // victim selection
+    uint32_t random = 0;
+
+    std::thread thread;
+  };
+
+  struct ThreadSlot {
+    const JobSystem *system = nullptr;
+    unsigned int index = NO_WORKER;
+  };
+
+  unsigned int m_nSpinsBeforeSleep;
+  std::thread::id m_mainThreadId;
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  // jobs spawned from other threads, or when a deque is full
+  std::mutex m_sharedMutex;
+  std::deque<Job *> m_sharedJobs;
+
+  std::mutex m_mainMutex;
+  std::deque<Job *> m_mainJobs;
+
+  // jobs in the deques and the shared queue, idle workers sleep when 0
+  std::atomic<int64_t> m_nQueued{0};
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  std::atomic<unsigned int> m_nSleeping{0};
+  bool m_stop = false;
+
+  // job storage: blocks that are never freed before the system, and chains
+  // of JOB_BLOCK_SIZE recycled jobs handed back by the threads that ran them
+  std::mutex m_poolMutex;
+  std::vector<std::unique_ptr<Job[]>> m_jobBlocks;
+  std::vector<Job *> m_freeChains;
+
+  // what is left of the chain the threads outside of the system allocate
+  // from, one job at a time. Guarded by m_poolMutex
+  Job *m_foreignFreeJobs = nullptr;
+
+  static ThreadSlot &getThreadSlot() {
+    static thread_local ThreadSlot slot;
+    return slot;
+  }
+
+  template <typename Fn>
+  Job *createJob(Fn &&fn, Counter *counter, JobAffinity affinity) {
+
+    typedef typename std::decay<Fn>::type Callable;
+
+    Job *job = allocateJob();
+
+    if constexpr (sizeof(Callable) <= JOB_STORAGE_SIZE &&
+                  alignof(Callable) <= alignof(std::max_align_t)) {
+
+      new (job->storage) Callable(std::forward<Fn>(fn));
+
+      job->invoke = [](Job &j) {
+        (*std::launder(reinterpret_cast<Callable *>(j.storage)))();
+      };
+      job->destroy = [](Job &j) {
+        std::launder(reinterpret_cast<Callable *>(j.storage))->~Callable();
+      };
+
+    } else {
+
+      Callable *callable = new Callable(std::forward<Fn>(fn));
+      new (job->storage) Callable *(callable);
+
+      job->invoke = [](Job &j) {
+        (**std::launder(reinterpret_cast<Callable **>(j.storage)))();
+      };
+      job->destroy = [](Job &j) {
+        delete *std::launder(reinterpret_cast<Callable **>(j.storage));
+      };
+    }
+
+    job->counter = counter;
+    job->affinity = affinity;
+
+    return job;
+  }
+
+  Job *allocateJob() {
+
+    unsigned int index = getWorkerIndex();
+
+    if (index == NO_WORKER) {
+
+      std::lock_guard<std::mutex> lock{m_poolMutex};
+
+      if (m_foreignFreeJobs == nullptr) {
+        m_foreignFreeJobs = takeChain();
+      }
+
+      Job *job = m_foreignFreeJobs;
+      m_foreignFreeJobs = job->next;
+
+      return job;
+    }
+
+    Worker &worker = *m_workers[index];
+
+    if (worker.freeJobs == nullptr) {
+      std::lock_guard<std::mutex> lock{m_poolMutex};
+      worker.freeJobs = takeChain();
+      worker.nFreeJobs = JOB_BLOCK_SIZE;
+    }
+
+    Job *job = worker.freeJobs;
+    worker.freeJobs = job->next;
+    --worker.nFreeJobs;
+
+    return job;
+  }
+
+  // a chain of JOB_BLOCK_SIZE free jobs, m_poolMutex locked
+  Job *takeChain() {
+
+    if (!m_freeChains.empty()) {
+      Job *chain = m_freeChains.back();
+      m_freeChains.pop_back();
+      return chain;
+    }
+
+    m_jobBlocks.push_back(std::make_unique<Job[]>(JOB_BLOCK_SIZE));
+
+    Job *block = m_jobBlocks.back().get();
+
+    for (size_t i = 0; i + 1 < JOB_BLOCK_SIZE; ++i) {
+      block[i].next = &block[i + 1];
+    }
+    block[JOB_BLOCK_SIZE - 1].next = nullptr;
+
+    return block;
+  }
+
+  // into the free list of the thread that ran the job. A thread that mostly
+  // consumes jobs hands chains back so the spawning threads can reuse them
+  void freeJob(Job *job, unsigned int index) {
+
+    Worker &worker = *m_workers[index];
+
+    job->next = worker.freeJobs;
+    worker.freeJobs = job;
+
+    if (++worker.nFreeJobs < 2 * JOB_BLOCK_SIZE) {
+      return;
+    }
+
+    Job *chain = worker.freeJobs;
+
+    Job *last = chain;
+    for (size_t i = 1; i < JOB_BLOCK_SIZE; ++i) {
+      last = last->next;
+    }
+
+    worker.freeJobs = last->next;
+    worker.nFreeJobs -= JOB_BLOCK_SIZE;
+    last->next = nullptr;
+
+    std::lock_guard<std::mutex> lock{m_poolMutex};
+    m_freeChains.push_back(chain);
+  }
+
+  void enqueue(Job *job) {
+
+    if (job->affinity == JobAffinity::MAIN_THREAD) {
+      std::lock_guard<std::mutex> lock{m_mainMutex};
+      m_mainJobs.push_back(job);
+      return;
+    }
+
+    unsigned int index = getWorkerIndex();
+
+    if (index == NO_WORKER || !m_workers[index]->deque.push(job)) {
+      std::lock_guard<std::mutex> lock{m_sharedMutex};
+      m_sharedJobs.push_back(job);
+    }
+
+    m_nQueued.fetch_add(1, std::memory_order_seq_cst);
+
+    if (m_nSleeping.load(std::memory_order_seq_cst) > 0) {
+
+      // taking the mutex orders this with a worker that is about to sleep:
+      // it either sees m_nQueued or is already waiting
+      { std::lock_guard<std::mutex> lock{m_sleepMutex}; }
+
+      m_wake.notify_one();
+    }
+  }
+
+  Job *popMainThreadJob() {
+
+    std::lock_guard<std::mutex> lock{m_mainMutex};
+
+    if (m_mainJobs.empty()) {
+      return nullptr;
+    }
+
+    Job *job = m_mainJobs.front();
+    m_mainJobs.pop_front();
+
+    return job;
+  }
+
+  // own deque first, then the shared queue, then the other deques
+  Job *findJob(unsigned int index) {
+
+    Worker &worker = *m_workers[index];
+
+    Job *job = worker.deque.pop();
+
+    if (job == nullptr) {
+      std::lock_guard<std::mutex> lock{m_sharedMutex};
+      if (!m_sharedJobs.empty()) {
+        job = m_sharedJobs.front();
+        m_sharedJobs.pop_front();
+      }
+    }
+
+    if (job == nullptr) {
+
+      size_t nWorkers = m_workers.size();
+
+      // xorshift, a random first victim so thieves don't all pile on one
+      worker.random ^= worker.random << 13;
+      worker.random ^= worker.random >> 17;
+      worker.random ^= worker.random << 5;
+
+      size_t first = worker.random % nWorkers;
+
+      for (size_t i = 0; i < nWorkers && job == nullptr; ++i) {
+        size_t victim = (first + i) % nWorkers;
+        if (victim != index) {
+          job = m_workers[victim]->deque.steal();
+        }
+      }
+    }
+
+    if (job != nullptr) {
+      m_nQueued.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return job;
+  }
+
+  void run(Job *job, unsigned int index) {
+
+    job->invoke(*job);
+    job->destroy(*job);
+
+    Counter *counter = job->counter;
+
+    freeJob(job, index);
+
+    if (counter != nullptr) {
+      finish(*counter);
+    }
+  }
+
+  void finish(Counter &counter) {
+
+    uint64_t state =
+        counter.m_state.fetch_sub(1, std::memory_order_acq_rel);
+
+    // not the last job, or the last one without continuations: the counter
+    // may be gone already, don't touch it
+    if ((state & Counter::PENDING_MASK) != 1 ||
+        (state & Counter::HAS_CONTINUATIONS) == 0) {
+      return;
+    }
+
+    counter.lock();
+
+    std::vector<Job *> continuations;
+    continuations.swap(counter.m_continuations);
+
+    // last access, the counter is done from here
+    counter.m_state.fetch_and(~(Counter::HAS_CONTINUATIONS | Counter::LOCKED),
+                              std::memory_order_release);
+
+    for (Job *continuation : continuations) {
+      enqueue(continuation);
+    }
+  }
+
+  template <typename Fn>
+  void splitRange(size_t begin, size_t end, size_t grain, const Fn &fn,
+                  Counter &counter) {
+
+    while (end - begin > grain) {
+
+      size_t middle = begin + (end - begin) / 2;
+
+      spawn(
+          [this, middle, end, grain, &fn, &counter] {
+            splitRange(middle, end, grain, fn, counter);
+          },
+          &counter);
+
+      end = middle;
+    }
+
+    fn(begin, end);
+  }
+
+  void work(unsigned int index) {
+
+    getThreadSlot() = ThreadSlot{this, index};
+
+    CPU_PROFILE_THREAD_NAME("job worker " + std::to_string(index));
+
+    unsigned int nSpins = 0;
+
+    while (true) {
+
+      Job *job = findJob(index);
+
+      if (job != nullptr) {
+        run(job, index);
+        nSpins = 0;
+        continue;
+      }
+
+      if (++nSpins < m_nSpinsBeforeSleep) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      nSpins = 0;
+
+      std::unique_lock<std::mutex> lock{m_sleepMutex};
+
+      if (m_stop) {
+        return;
+      }
+
+      m_nSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+      m_wake.wait(lock, [this] {
+        return m_stop || m_nQueued.load(std::memory_order_seq_cst) > 0;
+      });
+
+      m_nSleeping.fetch_sub(1, std::memory_order_relaxed);
+
+      if (m_stop) {
+        return;
+      }
+    }
+  }
+};
+
+/**
+ * Job system shared by the helpers of src/shared (culling, sorting), with
+ * one thread per core. Created by the first call, which should come from
+ * the main thread.
+ */
+inline JobSystem &getJobSystem() {
+  static JobSystem jobSystem;
+  return jobSystem;
+}
+
+} // namespace jobs
+
+#endif // JOB_SYSTEM_H
@@ -1,6 +1,7 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include "cpuprofiler.h"
 #include "shader.h"
 #include "texture2d.h"
 #include "vertex.h"
@@ -13,6 +14,11 @@
 struct MeshTexture {
   std::string type;
   gpu::texture::Texture2D texture;
+  // as referenced by the material, the key of textures_loaded (empty for
+  // textures made by hand)
+  std::string path;
+  // the file it was loaded from, next to the model
+  std::string file;
 };
 
 struct MeshData {
@@ -43,7 +49,64 @@ public:
 
   inline GLuint getVAO() const { return m_VAO; }
 
-  void draw(const gpu::Shader &shader) const {
+  /**
+   * Sets up vao to read the vertices (and indices) of the mesh, as the
+   * mesh's own vao: for vaos that add other attributes (eg. instances)
+   * without changing the mesh.
+   */
+  void setVertexAttributes(GLuint vao) const {
+
+    if (m_indexed) {
+      glVertexArrayElementBuffer(vao, m_EBO);
+    }
+
+    // positions
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayVertexBuffer(vao, 0, m_VBO, 0, sizeof(Vertex));
+    glVertexArrayAttribBinding(vao, 0, 0);
+
+    // normals
+    glEnableVertexArrayAttrib(vao, 1);
+    glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayVertexBuffer(vao, 1, m_VBO, offsetof(Vertex, normal),
+                              sizeof(Vertex));
+    glVertexArrayAttribBinding(vao, 1, 1);
+
+    // texcoords
+    glEnableVertexArrayAttrib(vao, 2);
+    glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayVertexBuffer(vao, 2, m_VBO, offsetof(Vertex, texCoords),
+                              sizeof(Vertex));
+    glVertexArrayAttribBinding(vao, 2, 2);
+
+    // tangent
+    glEnableVertexArrayAttrib(vao, 3);
+    glVertexArrayAttribFormat(vao, 3, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayVertexBuffer(vao, 3, m_VBO, offsetof(Vertex, tangent),
+                              sizeof(Vertex));
+    glVertexArrayAttribBinding(vao, 3, 3);
+
+    // bitangent
+    glEnableVertexArrayAttrib(vao, 4);
+    glVertexArrayAttribFormat(vao, 4, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayVertexBuffer(vao, 4, m_VBO, offsetof(Vertex, bitangent),
+                              sizeof(Vertex));
+    glVertexArrayAttribBinding(vao, 4, 4);
+  }
+
+  inline bool isIndexed() const { return m_indexed; }
+
+  // vertices fed to the vertex shader by one draw
+  inline size_t getNumVertices() const {
+    return m_indexed ? m_indices.size() : m_vertices.size();
+  }
+
+  void draw(const gpu::Shader &shader) const { drawInstanced(shader, 1); }
+
+  void drawInstanced(const gpu::Shader &shader, size_t nInstances) const {
+
+    CPU_PROFILE_ZONE("Mesh::draw");
 
     unsigned int diffuseNr = 0;
     unsigned int specularNr = 0;
@@ -71,9 +134,10 @@ public:
     glBindVertexArray(m_VAO);
 
     if (m_indexed) {
-      glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+      glDrawElementsInstanced(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT,
+                              0, nInstances);
     } else {
-      glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
+      glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertices.size(), nInstances);
     }
 
     glBindVertexArray(0);
@@ -92,51 +156,17 @@ private:
     glNamedBufferData(m_VBO, m_vertices.size() * sizeof(Vertex), &m_vertices[0],
                       GL_STATIC_DRAW);
 
-    glCreateVertexArrays(1, &m_VAO);
-
     // indices
 
     if (m_indexed) {
       glCreateBuffers(1, &m_EBO);
       glNamedBufferData(m_EBO, m_indices.size() * sizeof(unsigned int),
                         &m_indices[0], GL_STATIC_DRAW);
-
-      glVertexArrayElementBuffer(m_VAO, m_EBO);
     }
 
-    // positions
-    glEnableVertexArrayAttrib(m_VAO, 0);
-    glVertexArrayAttribFormat(m_VAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, sizeof(Vertex));
-    glVertexArrayAttribBinding(m_VAO, 0, 0);
-
-    // normals
-    glEnableVertexArrayAttrib(m_VAO, 1);
-    glVertexArrayAttribFormat(m_VAO, 1, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayVertexBuffer(m_VAO, 1, m_VBO, offsetof(Vertex, normal),
-                              sizeof(Vertex));
-    glVertexArrayAttribBinding(m_VAO, 1, 1);
-
-    // texcoords
-    glEnableVertexArrayAttrib(m_VAO, 2);
-    glVertexArrayAttribFormat(m_VAO, 2, 2, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayVertexBuffer(m_VAO, 2, m_VBO, offsetof(Vertex, texCoords),
-                              sizeof(Vertex));
-    glVertexArrayAttribBinding(m_VAO, 2, 2);
-
-    // tangent
-    glEnableVertexArrayAttrib(m_VAO, 3);
-    glVertexArrayAttribFormat(m_VAO, 3, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayVertexBuffer(m_VAO, 3, m_VBO, offsetof(Vertex, tangent),
-                              sizeof(Vertex));
-    glVertexArrayAttribBinding(m_VAO, 3, 3);
+    glCreateVertexArrays(1, &m_VAO);
 
-    // bitangent
-    glEnableVertexArrayAttrib(m_VAO, 4);
-    glVertexArrayAttribFormat(m_VAO, 4, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayVertexBuffer(m_VAO, 4, m_VBO, offsetof(Vertex, bitangent),
-                              sizeof(Vertex));
-    glVertexArrayAttribBinding(m_VAO, 4, 4);
+    setVertexAttributes(m_VAO);
 
     glBindVertexArray(0);
   }
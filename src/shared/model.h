@@ -1,15 +1,18 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "cpuprofiler.h"
 #include "mesh.h"
 #include "resources.h"
 #include "shader.h"
 #include "texture2d.h"
+#include "transformhierarchy.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <glm/common.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <stb_image.h>
 
 #include <filesystem>
@@ -22,12 +25,28 @@ std::map<std::string, MeshTexture> textures_loaded;
 gpu::texture::Texture2D textureFromFile(const std::string &path,
                                         const std::string &directory);
 
+// an aiNode: its transform relative to its parent and the meshes it places
+struct ModelNode
+{
+  std::string name;
+
+  // index in Model::m_nodes, scene::NO_PARENT for the root
+  uint32_t parent = scene::NO_PARENT;
+
+  glm::mat4 transform{1.0f};
+
+  std::vector<uint32_t> meshes;
+};
+
 class Model
 {
 
 public:
   std::vector<Mesh> m_meshes;
 
+  // the node tree of the file, parents before their children
+  std::vector<ModelNode> m_nodes;
+
   Model() {}
 
   Model(const std::string &path) { loadModel(path); }
@@ -40,11 +59,100 @@ public:
     }
   }
 
+  void drawInstanced(const gpu::Shader &shader, size_t nInstances)
+  {
+    for (unsigned int i = 0; i < m_meshes.size(); ++i)
+    {
+      m_meshes[i].drawInstanced(shader, nInstances);
+    }
+  }
+
+  /**
+   * Draws every mesh with "model" and "normalMatrix" set to the world and
+   * normal matrices of its node. firstNode is what addToHierarchy
+   * returned, the hierarchy has to be updated.
+   */
+  void draw(const gpu::Shader &shader,
+            const scene::TransformHierarchy &hierarchy, uint32_t firstNode)
+  {
+    int modelLocation = shader.getUniformLocation("model");
+    int normalMatrixLocation = shader.getUniformLocation("normalMatrix");
+
+    for (unsigned int i = 0; i < m_meshes.size(); ++i)
+    {
+      uint32_t node = firstNode + getMeshNode(i);
+
+      glProgramUniformMatrix4fv(shader.getID(), modelLocation, 1, GL_FALSE,
+                                glm::value_ptr(hierarchy.getWorld(node)));
+      glProgramUniformMatrix3fv(
+          shader.getID(), normalMatrixLocation, 1, GL_FALSE,
+          glm::value_ptr(hierarchy.getNormalMatrix(node)));
+
+      m_meshes[i].draw(shader);
+    }
+  }
+
+  /**
+   * Adds the nodes of the model below 'parent' (the placement of this
+   * instance) and returns the index of the first one, node i of m_nodes is
+   * firstNode + i. Can be called once per instance of the model.
+   */
+  uint32_t addToHierarchy(scene::TransformHierarchy &hierarchy,
+                          uint32_t parent = scene::NO_PARENT) const
+  {
+    uint32_t firstNode = static_cast<uint32_t>(hierarchy.getNumNodes());
+
+    // a model built from meshes has no file nodes, it gets a single one
+    if (m_nodes.empty())
+    {
+      hierarchy.addNode(glm::mat4{1.0f}, parent);
+      return firstNode;
+    }
+
+    for (const ModelNode &node : m_nodes)
+    {
+      hierarchy.addNode(node.transform, node.parent == scene::NO_PARENT
+                                            ? parent
+                                            : firstNode + node.parent);
+    }
+
+    return firstNode;
+  }
+
+  // index in m_nodes of the node that places the mesh (0 for meshes added
+  // to m_meshes by hand)
+  inline uint32_t getMeshNode(size_t mesh) const
+  {
+    return mesh < m_meshNodes.size() ? m_meshNodes[mesh] : 0;
+  }
+
+  // the mesh in model space, the transforms of its node chain
+  inline glm::mat4 getMeshTransform(size_t mesh) const
+  {
+    return mesh < m_meshTransforms.size() ? m_meshTransforms[mesh]
+                                          : glm::mat4{1.0f};
+  }
+
+  size_t getNumVertices() const
+  {
+    size_t nVertices = 0;
+    for (const Mesh &mesh : m_meshes)
+    {
+      nVertices += mesh.getNumVertices();
+    }
+    return nVertices;
+  }
+
 private:
   std::string m_directory;
 
+  // one per mesh
+  std::vector<uint32_t> m_meshNodes;
+  std::vector<glm::mat4> m_meshTransforms;
+
   void loadModel(const std::string &path)
   {
+    CPU_PROFILE_ZONE("Model::loadModel");
 
     Assimp::Importer importer;
 
@@ -72,24 +180,49 @@ private:
     std::filesystem::path dirPath(path);
     m_directory = dirPath.parent_path().string();
 
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, scene::NO_PARENT, glm::mat4{1.0f});
   }
 
-  void processNode(aiNode *node, const aiScene *scene)
+  void processNode(aiNode *node, const aiScene *scene, uint32_t parent,
+                   const glm::mat4 &parentTransform)
   {
+    uint32_t index = static_cast<uint32_t>(m_nodes.size());
+
+    ModelNode modelNode;
+    modelNode.name = node->mName.C_Str();
+    modelNode.parent = parent;
+    modelNode.transform = toMat4(node->mTransformation);
+
+    glm::mat4 transform = parentTransform * modelNode.transform;
 
     for (unsigned int i = 0; i < node->mNumMeshes; ++i)
     {
       aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+
+      modelNode.meshes.push_back(static_cast<uint32_t>(m_meshes.size()));
+
       m_meshes.push_back(processMesh(mesh, scene));
+      m_meshNodes.push_back(index);
+      m_meshTransforms.push_back(transform);
     }
 
+    m_nodes.push_back(std::move(modelNode));
+
     for (unsigned int i = 0; i < node->mNumChildren; ++i)
     {
-      processNode(node->mChildren[i], scene);
+      processNode(node->mChildren[i], scene, index, transform);
     }
   }
 
+  // assimp matrices are row major
+  static glm::mat4 toMat4(const aiMatrix4x4 &m)
+  {
+    return glm::mat4{glm::vec4{m.a1, m.b1, m.c1, m.d1},
+                     glm::vec4{m.a2, m.b2, m.c2, m.d2},
+                     glm::vec4{m.a3, m.b3, m.c3, m.d3},
+                     glm::vec4{m.a4, m.b4, m.c4, m.d4}};
+  }
+
   Mesh processMesh(aiMesh *mesh, const aiScene *scene) const
   {
 
@@ -195,6 +328,8 @@ private:
         gpu::texture::Texture2D tex = textureFromFile(texPath, m_directory);
         meshTexture.texture = tex;
         meshTexture.type = typeName;
+        meshTexture.path = texPath;
+        meshTexture.file = m_directory + separator + texPath;
 
         textures_loaded[texPath] = meshTexture;
 
@@ -216,7 +351,8 @@ gpu::texture::Texture2D textureFromFile(const std::string &path,
 
   std::string filename = directory + separator + path;
 
-  gpu::texture::Texture2D tex{path};
+  // an absolute filename replaces the textures directory
+  gpu::texture::Texture2D tex{filename};
   tex.generateMipmap();
   tex.setMinFilter(gpu::texture::Filter::LINEAR_MIPMAP_LINEAR);
 
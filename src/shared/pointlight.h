@@ -4,6 +4,9 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 struct PointLight {
 
   glm::vec3 position;
@@ -17,4 +20,31 @@ struct PointLight {
   float quadraticAtt;
 };
 
-#endif // POINT_LIGHT_H
\ No newline at end of file
+/**
+ * Distance at which the light contribution drops below 'threshold' (in
+ * 0..1 color units, by default 5/256 = a couple of 8-bit steps). Solves
+ * maxIntensity / (c + l * d + q * d^2) = threshold for d.
+ */
+inline float computeLightRadius(const PointLight &light,
+                                float threshold = 5.0f / 256.0f) {
+
+  float maxIntensity = std::max(
+      {light.diffuse.x, light.diffuse.y, light.diffuse.z, light.specular.x,
+       light.specular.y, light.specular.z, light.ambient.x, light.ambient.y,
+       light.ambient.z});
+
+  float c = light.constantAtt - maxIntensity / threshold;
+  float l = light.linearAtt;
+  float q = light.quadraticAtt;
+
+  if (q <= 0.0f) {
+    // linear attenuation only (or no attenuation at all)
+    return l > 0.0f ? std::max(0.0f, -c / l) : 0.0f;
+  }
+
+  float discriminant = std::max(0.0f, l * l - 4.0f * q * c);
+
+  return std::max(0.0f, (-l + std::sqrt(discriminant)) / (2.0f * q));
+}
+
+#endif // POINT_LIGHT_H
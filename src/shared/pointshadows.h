@@ -0,0 +1,78 @@
+
+#ifndef POINT_SHADOWS_H
+#define POINT_SHADOWS_H
+
+#include "bounds.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+
+namespace shadows {
+
+constexpr int CUBE_FACES = 6;
+
+/**
+ * Light-space matrices (projection * view) of the six cube map faces, in
+ * the GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order.
+ */
+inline std::array<glm::mat4, CUBE_FACES>
+pointShadowMatrices(const glm::vec3 &lightPos, float zNear, float zFar) {
+
+  glm::mat4 projection =
+      glm::perspective(glm::radians(90.0f), 1.0f, zNear, zFar);
+
+  // clang-format off
+  return {
+    // right face (+x)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{ 1.0f,  0.0f,  0.0f}, glm::vec3{0.0f, -1.0f,  0.0f}),
+    // left face (-x)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{-1.0f,  0.0f,  0.0f}, glm::vec3{0.0f, -1.0f,  0.0f}),
+    // up face (+y)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{ 0.0f,  1.0f,  0.0f}, glm::vec3{0.0f,  0.0f,  1.0f}),
+    // down face (-y)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{ 0.0f, -1.0f,  0.0f}, glm::vec3{0.0f,  0.0f, -1.0f}),
+    // front face (+z)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{ 0.0f,  0.0f,  1.0f}, glm::vec3{0.0f, -1.0f,  0.0f}),
+    // back face (-z)
+    projection * glm::lookAt(lightPos, lightPos + glm::vec3{ 0.0f,  0.0f, -1.0f}, glm::vec3{0.0f, -1.0f,  0.0f})
+  };
+  // clang-format on
+}
+
+inline std::array<Frustum, CUBE_FACES>
+pointShadowFrusta(const glm::vec3 &lightPos, float zNear, float zFar) {
+
+  std::array<glm::mat4, CUBE_FACES> matrices =
+      pointShadowMatrices(lightPos, zNear, zFar);
+
+  std::array<Frustum, CUBE_FACES> frusta;
+  for (int face = 0; face < CUBE_FACES; ++face) {
+    frusta[face] = Frustum{matrices[face]};
+  }
+
+  return frusta;
+}
+
+/**
+ * Bit i is set if the box is (conservatively) visible from cube face i.
+ */
+inline unsigned int
+cubeFaceMask(const std::array<Frustum, CUBE_FACES> &faceFrusta,
+             const AABB &bounds) {
+
+  unsigned int mask = 0;
+
+  for (int face = 0; face < CUBE_FACES; ++face) {
+    if (faceFrusta[face].intersects(bounds)) {
+      mask |= 1u << face;
+    }
+  }
+
+  return mask;
+}
+
+} // namespace shadows
+
+#endif // POINT_SHADOWS_H
@@ -0,0 +1,631 @@
+
+#ifndef POST_STACK_H
+#define POST_STACK_H
+
+#include "shader.h"
+#include "texture2d.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace post {
+
+// the neighborhood filters read MAX_RADIUS texels on each side of the tile
+constexpr int MAX_RADIUS = 16;
+constexpr int TILE_SIZE = 128;
+
+// per-pixel only pass
+constexpr int PIXEL_GROUP_SIZE = 16;
+
+enum class Effect {
+  // per-pixel, fused in the order they were added
+  TONEMAP = 0,
+  GRADE,
+  INVERT,
+  GRAYSCALE,
+
+  // neighborhood, run first on the input of the stack
+  BLUR,
+  SHARPEN,
+  EDGE_DETECTION,
+
+  COUNT
+};
+
+inline const char *getEffectName(Effect effect) {
+
+  switch (effect) {
+  case Effect::TONEMAP:
+    return "tonemap";
+  case Effect::GRADE:
+    return "grade";
+  case Effect::INVERT:
+    return "invert";
+  case Effect::GRAYSCALE:
+    return "grayscale";
+  case Effect::BLUR:
+    return "blur";
+  case Effect::SHARPEN:
+    return "sharpen";
+  case Effect::EDGE_DETECTION:
+    return "edge detection";
+  default:
+    return "???";
+  }
+}
+
+inline bool isNeighborhoodEffect(Effect effect) {
+  return effect == Effect::BLUR || effect == Effect::SHARPEN ||
+         effect == Effect::EDGE_DETECTION;
+}
+
+struct PostSettings {
+
+  PostSettings() {}
+
+  // TONEMAP (Reinhard on exposed color)
+  float exposure = 1.0f;
+
+  // GRADE
+  float saturation = 1.2f;
+  float contrast = 1.1f;
+  glm::vec3 tint = glm::vec3{1.0f, 0.95f, 0.9f};
+
+  // BLUR, SHARPEN (gaussian, sigma = radius / 2)
+  int blurRadius = 4;
+  float sharpenAmount = 1.5f;
+};
+
+struct PostStackCreateInfo {
+
+  PostStackCreateInfo() {}
+
+  int width = 800;
+  int height = 600;
+
+  // the output is written with imageStore, the format needs a matching
+  // image format qualifier (see getImageFormatQualifier)
+  unsigned int outputFormat = GL_RGBA8;
+};
+
+struct PostStackStats {
+
+  int nDispatches = 0;
+
+  // full-screen sized reads and writes of the last apply()
+  int nFullscreenReads = 0;
+  int nFullscreenWrites = 0;
+};
+
+inline const char *getImageFormatQualifier(unsigned int format) {
+
+  switch (format) {
+  case GL_RGBA16F:
+    return "rgba16f";
+  case GL_RGBA32F:
+    return "rgba32f";
+  case GL_R16F:
+    return "r16f";
+  default:
+    return "rgba8";
+  }
+}
+
+/**
+ * Post-processing chain with a constant cost per frame.
+ *
+ * The per-pixel effects (tonemap, grade, invert, grayscale) are fused into a
+ * single generated function, applied in the order the effects were added.
+ *
+ * The neighborhood effects (blur, sharpen, edge detection) all read the
+ * input of the stack (not each other), so they share one separable pair of
+ * compute passes: the horizontal pass loads a row tile in shared memory and
+ * writes the horizontal gaussian and sobel terms, the vertical pass loads a
+ * column tile of those, finishes the filters and runs the fused per-pixel
+ * effects before writing the output.
+ *
+ * No effect: nothing runs (getOutputID returns the input).
+ * Per-pixel effects only: 1 dispatch, 1 read and 1 write.
+ * Any neighborhood effect: 2 dispatches, 4 reads and 3 writes.
+ *
+ * Programs are generated for each combination of effects and cached.
+ */
+class PostStack {
+
+public:
+  PostStack() {}
+
+  PostStack(const PostStackCreateInfo &createInfo)
+      : m_width(createInfo.width), m_height(createInfo.height),
+        m_outputFormat(createInfo.outputFormat) {
+
+    m_output = gpu::texture::Texture2D{m_width, m_height, m_outputFormat};
+    m_output.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+    m_output.setMinMagFilter(gpu::texture::Filter::LINEAR);
+
+    // horizontal pass results: gaussian (rgb) + sobel derivative (a), and
+    // the sobel smoothing term
+    m_horizontalColor =
+        gpu::texture::Texture2D{m_width, m_height, GL_RGBA16F};
+    m_horizontalSmooth = gpu::texture::Texture2D{m_width, m_height, GL_R16F};
+
+    for (gpu::texture::Texture2D *texture :
+         {&m_horizontalColor, &m_horizontalSmooth}) {
+      texture->setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+      texture->setMinMagFilter(gpu::texture::Filter::NEAREST);
+    }
+  }
+
+  inline PostSettings &getSettings() { return m_settings; }
+
+  inline const std::vector<Effect> &getEffects() const { return m_effects; }
+
+  inline bool hasEffect(Effect effect) const {
+    return std::find(m_effects.begin(), m_effects.end(), effect) !=
+           m_effects.end();
+  }
+
+  inline const PostStackStats &getStats() const { return m_stats; }
+
+  inline unsigned int getOutputID() const { return m_outputID; }
+
+  void setEffects(const std::vector<Effect> &effects) { m_effects = effects; }
+
+  void addEffect(Effect effect) {
+    if (!hasEffect(effect)) {
+      m_effects.push_back(effect);
+    }
+  }
+
+  void removeEffect(Effect effect) {
+    m_effects.erase(std::remove(m_effects.begin(), m_effects.end(), effect),
+                    m_effects.end());
+  }
+
+  /**
+   * Runs the stack on 'inputTexture' (same size as the stack). The output is
+   * ready to be sampled when this returns.
+   */
+  void apply(unsigned int inputTexture) {
+
+    m_stats = PostStackStats{};
+
+    bool neighborhood = std::any_of(m_effects.begin(), m_effects.end(),
+                                    isNeighborhoodEffect);
+
+    if (m_effects.empty()) {
+      m_outputID = inputTexture;
+      return;
+    }
+
+    m_outputID = m_output.getID();
+
+    glBindTextureUnit(0, inputTexture);
+
+    if (!neighborhood) {
+
+      const gpu::Shader &pixelShader = getProgram(PIXEL_PASS);
+      setUniforms(pixelShader);
+
+      glBindImageTexture(0, m_output.getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                         m_outputFormat);
+
+      pixelShader.dispatch(divUp(m_width, PIXEL_GROUP_SIZE),
+                           divUp(m_height, PIXEL_GROUP_SIZE));
+
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                      GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+      m_stats.nDispatches = 1;
+      m_stats.nFullscreenReads = 1;
+      m_stats.nFullscreenWrites = 1;
+
+      return;
+    }
+
+    // horizontal
+    {
+      const gpu::Shader &horizontalShader = getProgram(HORIZONTAL_PASS);
+      setUniforms(horizontalShader);
+
+      glBindImageTexture(0, m_horizontalColor.getID(), 0, GL_FALSE, 0,
+                         GL_WRITE_ONLY, GL_RGBA16F);
+      glBindImageTexture(1, m_horizontalSmooth.getID(), 0, GL_FALSE, 0,
+                         GL_WRITE_ONLY, GL_R16F);
+
+      horizontalShader.dispatch(divUp(m_width, TILE_SIZE), m_height);
+
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    // vertical + per-pixel effects
+    {
+      const gpu::Shader &verticalShader = getProgram(VERTICAL_PASS);
+      setUniforms(verticalShader);
+
+      glBindTextureUnit(1, m_horizontalColor.getID());
+      glBindTextureUnit(2, m_horizontalSmooth.getID());
+
+      glBindImageTexture(0, m_output.getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                         m_outputFormat);
+
+      verticalShader.dispatch(m_width, divUp(m_height, TILE_SIZE));
+
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                      GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    m_stats.nDispatches = 2;
+
+    // horizontal: input / 2 intermediates, vertical: 2 intermediates + input
+    // center texel / output
+    m_stats.nFullscreenReads = 4;
+    m_stats.nFullscreenWrites = 3;
+  }
+
+  void destroy() {
+
+    m_output.destroy();
+    m_horizontalColor.destroy();
+    m_horizontalSmooth.destroy();
+
+    for (auto &entry : m_programs) {
+      entry.second.destroy();
+    }
+    m_programs.clear();
+  }
+
+private:
+  enum PassType { PIXEL_PASS, HORIZONTAL_PASS, VERTICAL_PASS };
+
+  int m_width = 0;
+  int m_height = 0;
+  unsigned int m_outputFormat = GL_RGBA8;
+
+  PostSettings m_settings;
+  std::vector<Effect> m_effects;
+
+  PostStackStats m_stats;
+
+  unsigned int m_outputID = 0;
+
+  gpu::texture::Texture2D m_output;
+  gpu::texture::Texture2D m_horizontalColor;
+  gpu::texture::Texture2D m_horizontalSmooth;
+
+  // generated programs, keyed by the pass and the effects compiled in
+  std::map<std::string, gpu::Shader> m_programs;
+
+  static inline unsigned int divUp(int value, int divisor) {
+    return static_cast<unsigned int>((value + divisor - 1) / divisor);
+  }
+
+  const gpu::Shader &getProgram(PassType pass) {
+
+    std::stringstream key;
+    key << pass;
+
+    // the horizontal pass only depends on the neighborhood effects
+    for (Effect effect : m_effects) {
+      if (pass != HORIZONTAL_PASS || isNeighborhoodEffect(effect)) {
+        key << "," << static_cast<int>(effect);
+      }
+    }
+
+    auto it = m_programs.find(key.str());
+
+    if (it != m_programs.end()) {
+      return it->second;
+    }
+
+    std::string source;
+
+    switch (pass) {
+    case PIXEL_PASS:
+      source = generatePixelPass();
+      break;
+    case HORIZONTAL_PASS:
+      source = generateHorizontalPass();
+      break;
+    case VERTICAL_PASS:
+      source = generateVerticalPass();
+      break;
+    }
+
+    return m_programs[key.str()] = gpu::Shader::fromComputeSource(source);
+  }
+
+  void setUniforms(const gpu::Shader &shader) const {
+
+    shader.setInt("inputImage", 0);
+
+    shader.setFloat("exposure", m_settings.exposure);
+    shader.setFloat("saturation", m_settings.saturation);
+    shader.setFloat("contrast", m_settings.contrast);
+    shader.setVec3("tint", m_settings.tint);
+    shader.setFloat("sharpenAmount", m_settings.sharpenAmount);
+
+    int radius = std::clamp(m_settings.blurRadius, 1, MAX_RADIUS);
+    shader.setInt("radius", radius);
+
+    // normalized gaussian weights, weights[0] is the center
+    float sigma = 0.5f * radius;
+    float weights[MAX_RADIUS + 1];
+    float sum = 0.0f;
+
+    for (int i = 0; i <= radius; ++i) {
+      weights[i] = std::exp(-0.5f * i * i / (sigma * sigma));
+      sum += i == 0 ? weights[i] : 2.0f * weights[i];
+    }
+
+    for (int i = 0; i <= radius; ++i) {
+      shader.setFloat("weights[" + std::to_string(i) + "]", weights[i] / sum);
+    }
+  }
+
+  std::string generateHeader(int localSizeX, int localSizeY) const {
+
+    std::stringstream ss;
+
+    ss << "#version 450 core\n\n";
+
+    ss << "#define MAX_RADIUS " << MAX_RADIUS << "\n";
+    ss << "#define TILE_SIZE " << TILE_SIZE << "\n";
+
+    for (Effect effect : m_effects) {
+      switch (effect) {
+      case Effect::BLUR:
+        ss << "#define BLUR\n";
+        break;
+      case Effect::SHARPEN:
+        ss << "#define SHARPEN\n";
+        break;
+      case Effect::EDGE_DETECTION:
+        ss << "#define EDGE_DETECTION\n";
+        break;
+      default:
+        break;
+      }
+    }
+
+    ss << "\nlayout(local_size_x = " << localSizeX
+       << ", local_size_y = " << localSizeY << ") in;\n\n";
+
+    ss << R"(uniform sampler2D inputImage;
+
+uniform float exposure;
+uniform float saturation;
+uniform float contrast;
+uniform vec3 tint;
+uniform float sharpenAmount;
+
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+float luminance(vec3 color) { return dot(color, vec3(0.2126, 0.7152, 0.0722)); }
+
+)";
+
+    return ss.str();
+  }
+
+  /**
+   * The fused per-pixel effects, in the order they were added.
+   */
+  std::string generatePixelFunction() const {
+
+    std::stringstream ss;
+
+    ss << "vec3 applyPixelEffects(vec3 color) {\n";
+
+    for (Effect effect : m_effects) {
+      switch (effect) {
+      case Effect::TONEMAP:
+        ss << "  // tonemap\n"
+              "  color *= exposure;\n"
+              "  color = color / (1.0 + color);\n";
+        break;
+      case Effect::GRADE:
+        ss << "  // grade\n"
+              "  color = mix(vec3(luminance(color)), color, saturation);\n"
+              "  color = (color - 0.5) * contrast + 0.5;\n"
+              "  color *= tint;\n";
+        break;
+      case Effect::INVERT:
+        ss << "  // invert\n"
+              "  color = 1.0 - color;\n";
+        break;
+      case Effect::GRAYSCALE:
+        ss << "  // grayscale\n"
+              "  color = vec3(luminance(color));\n";
+        break;
+      default:
+        break;
+      }
+    }
+
+    ss << "  return clamp(color, 0.0, 1.0);\n}\n\n";
+
+    return ss.str();
+  }
+
+  std::string generatePixelPass() const {
+
+    std::stringstream ss;
+
+    ss << generateHeader(PIXEL_GROUP_SIZE, PIXEL_GROUP_SIZE);
+    ss << "layout(" << getImageFormatQualifier(m_outputFormat)
+       << ", binding = 0) writeonly uniform image2D outputImage;\n\n";
+    ss << generatePixelFunction();
+
+    ss << R"(void main() {
+
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+
+  if (any(greaterThanEqual(pixel, textureSize(inputImage, 0)))) {
+    return;
+  }
+
+  vec3 color = texelFetch(inputImage, pixel, 0).rgb;
+
+  imageStore(outputImage, pixel, vec4(applyPixelEffects(color), 1.0));
+})";
+
+    return ss.str();
+  }
+
+  std::string generateHorizontalPass() const {
+
+    std::stringstream ss;
+
+    ss << generateHeader(TILE_SIZE, 1);
+
+    ss << R"(layout(rgba16f, binding = 0) writeonly uniform image2D horizontalColor;
+layout(r16f, binding = 1) writeonly uniform image2D horizontalSmooth;
+
+// row tile + apron, every texel of the row is fetched once per group
+shared vec3 tile[TILE_SIZE + 2 * MAX_RADIUS];
+
+void main() {
+
+  ivec2 size = textureSize(inputImage, 0);
+
+  int row = int(gl_WorkGroupID.y);
+  int tileStart = int(gl_WorkGroupID.x) * TILE_SIZE - MAX_RADIUS;
+
+  for (int i = int(gl_LocalInvocationID.x); i < TILE_SIZE + 2 * MAX_RADIUS;
+       i += TILE_SIZE) {
+    int x = clamp(tileStart + i, 0, size.x - 1);
+    tile[i] = texelFetch(inputImage, ivec2(x, row), 0).rgb;
+  }
+
+  barrier();
+
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.x, row);
+
+  if (pixel.x >= size.x) {
+    return;
+  }
+
+  int center = int(gl_LocalInvocationID.x) + MAX_RADIUS;
+
+  vec3 blurred = vec3(0.0);
+
+#if defined(BLUR) || defined(SHARPEN)
+  blurred = tile[center] * weights[0];
+  for (int i = 1; i <= radius; ++i) {
+    blurred += (tile[center - i] + tile[center + i]) * weights[i];
+  }
+#endif
+
+  float derivative = 0.0;
+  float smoothed = 0.0;
+
+#ifdef EDGE_DETECTION
+  // sobel = (1 2 1) x (-1 0 1), each half here
+  float left = luminance(tile[center - 1]);
+  float right = luminance(tile[center + 1]);
+
+  derivative = right - left;
+  smoothed = left + 2.0 * luminance(tile[center]) + right;
+#endif
+
+  imageStore(horizontalColor, pixel, vec4(blurred, derivative));
+  imageStore(horizontalSmooth, pixel, vec4(smoothed));
+})";
+
+    return ss.str();
+  }
+
+  std::string generateVerticalPass() const {
+
+    std::stringstream ss;
+
+    ss << generateHeader(1, TILE_SIZE);
+
+    // units fixed here: in the horizontal pass the same names are images
+    ss << R"(layout(binding = 1) uniform sampler2D horizontalColor;
+layout(binding = 2) uniform sampler2D horizontalSmooth;
+
+)";
+
+    ss << "layout(" << getImageFormatQualifier(m_outputFormat)
+       << ", binding = 0) writeonly uniform image2D outputImage;\n\n";
+
+    ss << R"(// column tile + apron
+shared vec4 tileColor[TILE_SIZE + 2 * MAX_RADIUS];
+shared float tileSmooth[TILE_SIZE + 2 * MAX_RADIUS];
+
+)";
+
+    ss << generatePixelFunction();
+
+    ss << R"(void main() {
+
+  ivec2 size = textureSize(inputImage, 0);
+
+  int column = int(gl_WorkGroupID.x);
+  int tileStart = int(gl_WorkGroupID.y) * TILE_SIZE - MAX_RADIUS;
+
+  for (int i = int(gl_LocalInvocationID.y); i < TILE_SIZE + 2 * MAX_RADIUS;
+       i += TILE_SIZE) {
+    ivec2 texel = ivec2(column, clamp(tileStart + i, 0, size.y - 1));
+    tileColor[i] = texelFetch(horizontalColor, texel, 0);
+    tileSmooth[i] = texelFetch(horizontalSmooth, texel, 0).r;
+  }
+
+  barrier();
+
+  ivec2 pixel = ivec2(column, gl_GlobalInvocationID.y);
+
+  if (pixel.y >= size.y) {
+    return;
+  }
+
+  int center = int(gl_LocalInvocationID.y) + MAX_RADIUS;
+
+  vec3 source = texelFetch(inputImage, pixel, 0).rgb;
+  vec3 color = source;
+
+#if defined(BLUR) || defined(SHARPEN)
+  vec3 blurred = tileColor[center].rgb * weights[0];
+  for (int i = 1; i <= radius; ++i) {
+    blurred += (tileColor[center - i].rgb + tileColor[center + i].rgb) *
+               weights[i];
+  }
+#endif
+
+#ifdef BLUR
+  color = blurred;
+#endif
+
+#ifdef SHARPEN
+  // unsharp mask
+  color += sharpenAmount * (source - blurred);
+#endif
+
+#ifdef EDGE_DETECTION
+  float gx = tileColor[center - 1].a + 2.0 * tileColor[center].a +
+             tileColor[center + 1].a;
+  float gy = tileSmooth[center + 1] - tileSmooth[center - 1];
+
+  color = vec3(length(vec2(gx, gy)));
+#endif
+
+  imageStore(outputImage, pixel, vec4(applyPixelEffects(color), 1.0));
+})";
+
+    return ss.str();
+  }
+};
+
+} // namespace post
+
+#endif // POST_STACK_H
@@ -0,0 +1,121 @@
+
+#ifndef GPU_QUERY_H
+#define GPU_QUERY_H
+
+#include "gpuobject.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+namespace gpu {
+
+/**
+ * Asynchronous query object (GL_PRIMITIVES_GENERATED, GL_SAMPLES_PASSED,
+ * GL_TIME_ELAPSED...).
+ *
+ * Reading the result right after end() stalls until the gpu has caught up,
+ * check isResultAvailable() first or read it a few frames later.
+ */
+class Query : public GpuObject {
+
+public:
+  Query() {}
+
+  Query(unsigned int target) : m_target(target) {
+    glCreateQueries(target, 1, &m_ID);
+  }
+
+  inline unsigned int getTarget() const { return m_target; }
+
+  inline void begin() const { glBeginQuery(m_target, m_ID); }
+  inline void end() const { glEndQuery(m_target); }
+
+  /**
+   * GL_TIMESTAMP queries only: the result is the gpu time (ns) at which all
+   * the previous commands have completed.
+   */
+  inline void recordTimestamp() const { glQueryCounter(m_ID, GL_TIMESTAMP); }
+
+  inline bool isResultAvailable() const {
+    int available = 0;
+    glGetQueryObjectiv(m_ID, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != 0;
+  }
+
+  inline uint64_t getResult() const {
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(m_ID, GL_QUERY_RESULT, &result);
+    return result;
+  }
+
+  virtual void destroy() override {
+    glDeleteQueries(1, &m_ID);
+    m_ID = 0;
+  }
+
+private:
+  unsigned int m_target = 0;
+};
+
+/**
+ * Measures the gpu time between begin() and end() (GL_TIME_ELAPSED).
+ *
+ * A ring of queries is used and each result is read when its query is about
+ * to be reused, LATENCY frames later, so measuring never stalls the pipeline.
+ * getMilliseconds() returns the most recent result read.
+ */
+class GpuTimer {
+
+public:
+  static constexpr size_t LATENCY = 4;
+
+  GpuTimer() {}
+
+  void begin() {
+
+    Query &query = m_queries[m_current];
+
+    if (query.getID() == 0) {
+      query = Query{GL_TIME_ELAPSED};
+    }
+
+    if (m_pending[m_current]) {
+      m_lastNanoseconds = query.getResult();
+      m_pending[m_current] = false;
+    }
+
+    query.begin();
+  }
+
+  void end() {
+
+    m_queries[m_current].end();
+    m_pending[m_current] = true;
+
+    m_current = (m_current + 1) % LATENCY;
+  }
+
+  inline double getMilliseconds() const {
+    return static_cast<double>(m_lastNanoseconds) * 1e-6;
+  }
+
+  void destroy() {
+    for (Query &query : m_queries) {
+      query.destroy();
+    }
+  }
+
+private:
+  std::array<Query, LATENCY> m_queries;
+  std::array<bool, LATENCY> m_pending{};
+
+  size_t m_current = 0;
+
+  uint64_t m_lastNanoseconds = 0;
+};
+
+} // namespace gpu
+
+#endif // GPU_QUERY_H
@@ -0,0 +1,367 @@
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "jobsystem.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RADIX_SORT_SSE 1
+#endif
+
+namespace sorting {
+
+/**
+ * Maps a float to an unsigned int with the same ordering (negative floats
+ * have their bits flipped, positive ones only their sign bit), so floats can
+ * be radix sorted as integers.
+ */
+inline uint32_t floatToSortableKey(float value) {
+
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(float));
+
+  uint32_t mask = (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+  return bits ^ mask;
+}
+
+enum class SortOrder { FRONT_TO_BACK, BACK_TO_FRONT };
+
+/**
+ * keys[i] = bits of the squared distance of positions[i] to eye, xor flip,
+ * for i in [begin, end). Squared distances are never negative, their bits
+ * already sort (no floatToSortableKey needed).
+ */
+inline void computeDistanceKeys(const glm::vec3 *positions, size_t begin,
+                                size_t end, const glm::vec3 &eye,
+                                uint32_t flip, uint32_t *keys) {
+
+  size_t i = begin;
+
+#ifdef RADIX_SORT_SSE
+  static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+                "glm::vec3 must be packed");
+
+  __m128 eyeX = _mm_set1_ps(eye.x);
+  __m128 eyeY = _mm_set1_ps(eye.y);
+  __m128 eyeZ = _mm_set1_ps(eye.z);
+  __m128i flip4 = _mm_set1_epi32(static_cast<int>(flip));
+
+  size_t simdEnd = begin + (end - begin) / 4 * 4;
+
+  // 4 positions = 3 loads: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+  for (; i < simdEnd; i += 4) {
+
+    const float *p = &positions[i].x;
+
+    __m128 a = _mm_loadu_ps(p);
+    __m128 b = _mm_loadu_ps(p + 4);
+    __m128 c = _mm_loadu_ps(p + 8);
+
+    __m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128 x = _mm_shuffle_ps(a, bc, _MM_SHUFFLE(3, 0, 3, 0));
+
+    __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+    bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+    __m128 y = _mm_shuffle_ps(ab, bc, _MM_SHUFFLE(2, 0, 2, 0));
+
+    ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+    __m128 cc = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+    __m128 z = _mm_shuffle_ps(ab, cc, _MM_SHUFFLE(2, 0, 2, 0));
+
+    __m128 dx = _mm_sub_ps(x, eyeX);
+    __m128 dy = _mm_sub_ps(y, eyeY);
+    __m128 dz = _mm_sub_ps(z, eyeZ);
+
+    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                           _mm_mul_ps(dz, dz));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(keys + i),
+                     _mm_xor_si128(_mm_castps_si128(d2), flip4));
+  }
+#endif
+
+  for (; i < end; ++i) {
+
+    float dx = positions[i].x - eye.x;
+    float dy = positions[i].y - eye.y;
+    float dz = positions[i].z - eye.z;
+
+    float d2 = dx * dx + dy * dy + dz * dz;
+
+    uint32_t bits;
+    std::memcpy(&bits, &d2, sizeof(float));
+
+    keys[i] = bits ^ flip;
+  }
+}
+
+struct RadixSorterCreateInfo {
+
+  RadixSorterCreateInfo() {}
+
+  // chunks of the parallel passes, 0 = threads of jobs::getJobSystem()
+  unsigned int nThreads = 0;
+
+  // smaller lists are sorted on the calling thread
+  size_t parallelThreshold = 1 << 16;
+
+  // a re-sort falls back to a full radix sort once the insertion sort of the
+  // previous order has moved more than maxCoherentMoves * n items
+  size_t maxCoherentMoves = 4;
+};
+
+/**
+ * LSD radix sort of 32 bit keys and their indices (4 passes of 8 bits).
+ *
+ * Keys are computed once per item instead of once per comparison. Passes in
+ * which every key has the same digit are skipped, lists larger than
+ * parallelThreshold are histogrammed and scattered by several threads (each
+ * thread owns a contiguous chunk, so the sort stays stable).
+ *
+ * With 'coherent' set, the previous order is tried first: keys are gathered
+ * in that order and insertion sorted, which is close to linear when only a
+ * few items moved since the last frame (eg. depth sorting with a slowly
+ * moving camera).
+ *
+ * getOrder()[i] is the index of the i-th item in sorted order.
+ */
+class RadixSorter {
+
+public:
+  static constexpr int RADIX_BITS = 8;
+  static constexpr int RADIX_SIZE = 1 << RADIX_BITS;
+  static constexpr int N_PASSES = 32 / RADIX_BITS;
+
+  RadixSorter(const RadixSorterCreateInfo &createInfo = RadixSorterCreateInfo{})
+      : m_parallelThreshold(createInfo.parallelThreshold),
+        m_maxCoherentMoves(createInfo.maxCoherentMoves) {
+
+    m_nThreads = createInfo.nThreads != 0
+                     ? createInfo.nThreads
+                     : jobs::getJobSystem().getNumThreads();
+  }
+
+  inline const std::vector<uint32_t> &getOrder() const { return m_order; }
+
+  inline const std::vector<uint32_t> &getKeys() const { return m_keys; }
+
+  // true if the last sort could reuse the previous order
+  inline bool wasCoherent() const { return m_wasCoherent; }
+
+  inline unsigned int getNumThreads() const { return m_nThreads; }
+
+  /**
+   * Sorts positions by their (squared) distance to 'eye'.
+   */
+  void sortByDistance(const glm::vec3 *positions, size_t n,
+                      const glm::vec3 &eye, SortOrder order,
+                      bool coherent = false) {
+
+    m_inputKeys.resize(n);
+
+    // back to front = descending distance, the keys are inverted instead of
+    // sorting in reverse
+    uint32_t flip = order == SortOrder::BACK_TO_FRONT ? 0xffffffffu : 0u;
+
+    uint32_t *keys = m_inputKeys.data();
+
+    parallelFor(n, [=](unsigned int chunk, size_t begin, size_t end) {
+      computeDistanceKeys(positions, begin, end, eye, flip, keys);
+    });
+
+    sortKeys(m_inputKeys.data(), n, coherent);
+  }
+
+  /**
+   * Sorts n keys in ascending order (use floatToSortableKey for floats).
+   */
+  void sortKeys(const uint32_t *keys, size_t n, bool coherent = false) {
+
+    m_wasCoherent = false;
+
+    if (coherent && m_order.size() == n && n > 0 && sortCoherent(keys, n)) {
+      m_wasCoherent = true;
+      return;
+    }
+
+    m_keys.assign(keys, keys + n);
+
+    m_order.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      m_order[i] = static_cast<uint32_t>(i);
+    }
+
+    radixSort(n);
+  }
+
+private:
+  unsigned int m_nThreads;
+  size_t m_parallelThreshold;
+  size_t m_maxCoherentMoves;
+
+  bool m_wasCoherent = false;
+
+  std::vector<uint32_t> m_inputKeys;
+
+  // sorted keys and indices, and the scratch buffers of the passes
+  std::vector<uint32_t> m_keys;
+  std::vector<uint32_t> m_order;
+  std::vector<uint32_t> m_tmpKeys;
+  std::vector<uint32_t> m_tmpOrder;
+
+  typedef std::array<size_t, RADIX_SIZE> Histogram;
+
+  std::vector<Histogram> m_histograms;
+
+  inline unsigned int getNumChunks(size_t n) const {
+    return n < m_parallelThreshold ? 1 : m_nThreads;
+  }
+
+  /**
+   * Calls fn(chunk, begin, end) on contiguous chunks of [0, n), one job per
+   * chunk on jobs::getJobSystem(). The calling thread runs chunks too.
+   */
+  template <typename Fn> void parallelFor(size_t n, const Fn &fn) const {
+
+    unsigned int nChunks = getNumChunks(n);
+
+    if (nChunks == 1) {
+      fn(0, 0, n);
+      return;
+    }
+
+    jobs::getJobSystem().parallelFor(
+        nChunks, 1, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            fn(static_cast<unsigned int>(c), n * c / nChunks,
+               n * (c + 1) / nChunks);
+          }
+        });
+  }
+
+  bool sortCoherent(const uint32_t *keys, size_t n) {
+
+    m_keys.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      m_keys[i] = keys[m_order[i]];
+    }
+
+    size_t maxMoves = m_maxCoherentMoves * n;
+    size_t moves = 0;
+
+    for (size_t i = 1; i < n; ++i) {
+
+      uint32_t key = m_keys[i];
+
+      if (m_keys[i - 1] <= key) {
+        continue;
+      }
+
+      uint32_t index = m_order[i];
+
+      size_t j = i;
+      while (j > 0 && m_keys[j - 1] > key) {
+        m_keys[j] = m_keys[j - 1];
+        m_order[j] = m_order[j - 1];
+        --j;
+      }
+
+      m_keys[j] = key;
+      m_order[j] = index;
+
+      moves += i - j;
+
+      // too far from the previous order, a full sort is cheaper
+      if (moves > maxMoves) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void radixSort(size_t n) {
+
+    m_tmpKeys.resize(n);
+    m_tmpOrder.resize(n);
+
+    unsigned int nChunks = getNumChunks(n);
+    m_histograms.resize(nChunks);
+
+    for (int pass = 0; pass < N_PASSES; ++pass) {
+
+      int shift = pass * RADIX_BITS;
+
+      const uint32_t *srcKeys = m_keys.data();
+      Histogram *histograms = m_histograms.data();
+
+      parallelFor(n, [=](unsigned int chunk, size_t begin, size_t end) {
+        Histogram &histogram = histograms[chunk];
+        histogram.fill(0);
+
+        for (size_t i = begin; i < end; ++i) {
+          histogram[(srcKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+        }
+      });
+
+      // chunk c writes digit d after every smaller digit and after the
+      // chunks before it with the same digit
+      size_t offset = 0;
+      bool skip = false;
+
+      for (int digit = 0; digit < RADIX_SIZE; ++digit) {
+
+        size_t count = 0;
+
+        for (unsigned int c = 0; c < nChunks; ++c) {
+          size_t chunkCount = m_histograms[c][digit];
+          m_histograms[c][digit] = offset + count;
+          count += chunkCount;
+        }
+
+        // all the keys share this digit, the pass wouldn't move anything
+        if (count == n) {
+          skip = true;
+          break;
+        }
+
+        offset += count;
+      }
+
+      if (skip) {
+        continue;
+      }
+
+      const uint32_t *srcOrder = m_order.data();
+      uint32_t *dstKeys = m_tmpKeys.data();
+      uint32_t *dstOrder = m_tmpOrder.data();
+
+      parallelFor(n, [=](unsigned int chunk, size_t begin, size_t end) {
+        Histogram offsets = histograms[chunk];
+
+        for (size_t i = begin; i < end; ++i) {
+          size_t dst = offsets[(srcKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+          dstKeys[dst] = srcKeys[i];
+          dstOrder[dst] = srcOrder[i];
+        }
+      });
+
+      m_keys.swap(m_tmpKeys);
+      m_order.swap(m_tmpOrder);
+    }
+  }
+};
+
+} // namespace sorting
+
+#endif // RADIX_SORT_H
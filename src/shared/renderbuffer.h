@@ -11,11 +11,23 @@ namespace gpu {
 class Renderbuffer : public GpuObject {
 
 public:
+  Renderbuffer() {}
+
   Renderbuffer(int width, int height, unsigned int internalFormat) {
     glCreateRenderbuffers(1, &m_ID);
     glNamedRenderbufferStorage(m_ID, internalFormat, width, height);
   }
 
+  /**
+   * Multisampled storage, resolve it with glBlitNamedFramebuffer.
+   */
+  Renderbuffer(int width, int height, unsigned int internalFormat,
+               int nSamples) {
+    glCreateRenderbuffers(1, &m_ID);
+    glNamedRenderbufferStorageMultisample(m_ID, nSamples, internalFormat,
+                                          width, height);
+  }
+
   virtual void destroy() override {
     glDeleteRenderbuffers(1, &m_ID);
     m_ID = 0;
@@ -0,0 +1,680 @@
+
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include "framebuffer.h"
+#include "texture2d.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rendergraph {
+
+typedef int ResourceHandle;
+
+constexpr ResourceHandle INVALID_RESOURCE = -1;
+
+// pooled textures that were not used by this many compiles are deleted
+constexpr size_t POOL_MAX_IDLE_FRAMES = 60;
+
+struct TextureDesc {
+
+  TextureDesc() {}
+
+  TextureDesc(int width, int height, unsigned int format)
+      : width(width), height(height), format(format) {}
+
+  int width = 0;
+  int height = 0;
+  unsigned int format = GL_RGBA8;
+
+  inline bool operator==(const TextureDesc &other) const {
+    return width == other.width && height == other.height &&
+           format == other.format;
+  }
+
+  inline bool isDepth() const {
+    return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 ||
+           format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH24_STENCIL8;
+  }
+
+  inline size_t getSizeInBytes() const {
+    return static_cast<size_t>(width) * height *
+           gpu::texture::bytesPerTexel(format);
+  }
+};
+
+struct RenderGraphStats {
+
+  size_t nPasses = 0;
+  size_t nCulledPasses = 0;
+
+  size_t nTransientTextures = 0;
+  size_t nPhysicalTextures = 0;
+
+  // render target memory if every transient texture had its own storage
+  size_t unaliasedBytes = 0;
+
+  // render target memory actually used by this graph (aliased)
+  size_t aliasedBytes = 0;
+};
+
+class RenderGraph;
+
+/**
+ * Given to the setup function of a pass to declare what it reads and writes.
+ */
+class PassBuilder {
+
+public:
+  /**
+   * New transient texture, its storage comes from the pool and may be shared
+   * with other transient textures whose lifetimes don't overlap.
+   */
+  ResourceHandle create(const std::string &name, const TextureDesc &desc);
+
+  // sampled by the pass
+  void read(ResourceHandle resource);
+
+  // attached as the next color attachment
+  void writeColor(ResourceHandle resource);
+
+  // attached as the depth (or depth-stencil) attachment
+  void writeDepth(ResourceHandle resource);
+
+  /**
+   * The pass has effects the graph can't see (eg. it draws to the default
+   * framebuffer) and is never culled.
+   */
+  void setSideEffect();
+
+private:
+  friend class RenderGraph;
+
+  PassBuilder(RenderGraph &graph, int pass) : m_graph(graph), m_pass(pass) {}
+
+  RenderGraph &m_graph;
+  int m_pass;
+};
+
+/**
+ * Given to the execute function of a pass, maps handles to gl textures.
+ */
+class PassResources {
+
+public:
+  unsigned int getTexture(ResourceHandle resource) const;
+  const TextureDesc &getDesc(ResourceHandle resource) const;
+
+private:
+  friend class RenderGraph;
+
+  PassResources(const RenderGraph &graph) : m_graph(graph) {}
+
+  const RenderGraph &m_graph;
+};
+
+typedef std::function<void(PassBuilder &builder)> SetupPassFn;
+typedef std::function<void(const PassResources &resources)> ExecutePassFn;
+
+/**
+ * Frame graph of render passes and the textures they exchange.
+ *
+ * Passes are added in execution order and declare the virtual textures they
+ * read and write. compile():
+ * - culls the passes whose outputs are never read (unless they have side
+ *   effects or write imported textures),
+ * - computes the first and last pass that use each transient texture,
+ * - assigns storage from a pool keyed by size and format, a texture is
+ *   returned to the pool after its last pass so a later texture with the
+ *   same description can alias it.
+ *
+ * execute() binds a framebuffer with the attachments of each pass and sets
+ * the viewport to their size (passes without attachments render to whatever
+ * is bound, usually the default framebuffer). The contents of a transient
+ * texture are invalidated before its first pass and after its last one, so
+ * the driver doesn't have to preserve them.
+ *
+ * The graph can be rebuilt every frame (reset, addPass..., compile); pooled
+ * textures and framebuffers are kept between frames.
+ */
+class RenderGraph {
+
+public:
+  RenderGraph() {}
+
+  /**
+   * Drops the passes and resources, pooled textures are kept.
+   */
+  void reset() {
+    m_passes.clear();
+    m_resources.clear();
+    m_compiled = false;
+  }
+
+  /**
+   * Texture owned by the caller (never aliased, never invalidated). Passes
+   * writing an imported texture are never culled.
+   */
+  ResourceHandle importTexture(const std::string &name,
+                               const gpu::texture::Texture &texture) {
+
+    Resource resource;
+    resource.name = name;
+    resource.desc = TextureDesc{static_cast<int>(texture.getWidth()),
+                                static_cast<int>(texture.getHeight()),
+                                texture.getInternalFormat()};
+    resource.imported = true;
+    resource.textureID = texture.getID();
+
+    m_resources.push_back(resource);
+    return static_cast<ResourceHandle>(m_resources.size() - 1);
+  }
+
+  void addPass(const std::string &name, const SetupPassFn &setup,
+               const ExecutePassFn &execute) {
+
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+
+    m_passes.push_back(pass);
+
+    PassBuilder builder{*this, static_cast<int>(m_passes.size() - 1)};
+    setup(builder);
+  }
+
+  void compile() {
+
+    cull();
+    computeLifetimes();
+    allocate();
+
+    m_compiled = true;
+  }
+
+  void execute() {
+
+    if (!m_compiled) {
+      compile();
+    }
+
+    PassResources resources{*this};
+
+    for (size_t p = 0; p < m_passes.size(); ++p) {
+
+      Pass &pass = m_passes[p];
+
+      if (pass.culled) {
+        continue;
+      }
+
+      if (pass.colorWrites.empty() && pass.depthWrite == INVALID_RESOURCE) {
+
+        pass.execute(resources);
+
+      } else {
+
+        gpu::framebuffer::Framebuffer &framebuffer = getFramebuffer(pass);
+        framebuffer.bind();
+
+        const TextureDesc &desc =
+            m_resources[pass.colorWrites.empty() ? pass.depthWrite
+                                                 : pass.colorWrites[0]]
+                .desc;
+
+        gpu::framebuffer::setViewport(0, 0, desc.width, desc.height);
+
+        // previous contents of aliased storage are garbage
+        invalidateAttachments(framebuffer, pass, static_cast<int>(p), true);
+
+        pass.execute(resources);
+
+        // written but never read again
+        invalidateAttachments(framebuffer, pass, static_cast<int>(p), false);
+
+        gpu::framebuffer::bindDefault();
+      }
+
+      // sampled for the last time
+      for (ResourceHandle handle : pass.reads) {
+
+        const Resource &resource = m_resources[handle];
+
+        if (!resource.imported && resource.lastPass == static_cast<int>(p) &&
+            !isWrittenBy(pass, handle)) {
+          glInvalidateTexImage(resource.textureID, 0);
+        }
+      }
+    }
+  }
+
+  inline const RenderGraphStats &getStats() const { return m_stats; }
+
+  inline bool isCulled(const std::string &passName) const {
+    for (const Pass &pass : m_passes) {
+      if (pass.name == passName) {
+        return pass.culled;
+      }
+    }
+    return false;
+  }
+
+  void destroy() {
+
+    for (PooledTexture &pooled : m_pool) {
+      pooled.texture.destroy();
+    }
+    m_pool.clear();
+
+    for (auto &entry : m_framebuffers) {
+      entry.second.destroy();
+    }
+    m_framebuffers.clear();
+
+    reset();
+  }
+
+private:
+  friend class PassBuilder;
+  friend class PassResources;
+
+  struct Resource {
+
+    std::string name;
+    TextureDesc desc;
+
+    bool imported = false;
+    unsigned int textureID = 0;
+
+    std::vector<int> writers;
+    int refCount = 0;
+
+    int firstPass = -1;
+    int lastPass = -1;
+  };
+
+  struct Pass {
+
+    std::string name;
+    ExecutePassFn execute;
+
+    std::vector<ResourceHandle> reads;
+    std::vector<ResourceHandle> colorWrites;
+    ResourceHandle depthWrite = INVALID_RESOURCE;
+
+    bool sideEffect = false;
+    bool culled = false;
+
+    int refCount = 0;
+  };
+
+  struct PooledTexture {
+
+    TextureDesc desc;
+    gpu::texture::Texture2D texture;
+
+    bool inUse = false;
+    size_t lastUsedFrame = 0;
+  };
+
+  std::vector<Pass> m_passes;
+  std::vector<Resource> m_resources;
+
+  std::vector<PooledTexture> m_pool;
+
+  // keyed by the attached texture ids (colors, then depth)
+  std::map<std::vector<unsigned int>, gpu::framebuffer::Framebuffer>
+      m_framebuffers;
+
+  size_t m_frame = 0;
+  bool m_compiled = false;
+
+  RenderGraphStats m_stats;
+
+  static inline bool isWrittenBy(const Pass &pass, ResourceHandle handle) {
+    return pass.depthWrite == handle ||
+           std::find(pass.colorWrites.begin(), pass.colorWrites.end(),
+                     handle) != pass.colorWrites.end();
+  }
+
+  static inline std::vector<ResourceHandle> getWrites(const Pass &pass) {
+    std::vector<ResourceHandle> writes = pass.colorWrites;
+    if (pass.depthWrite != INVALID_RESOURCE) {
+      writes.push_back(pass.depthWrite);
+    }
+    return writes;
+  }
+
+  /**
+   * Reference counting (as in Frostbite's frame graph): a pass is alive while
+   * one of its outputs is read, a resource while a live pass reads it.
+   */
+  void cull() {
+
+    for (Resource &resource : m_resources) {
+      resource.refCount = resource.imported ? 1 : 0;
+    }
+
+    for (Pass &pass : m_passes) {
+
+      pass.culled = false;
+      pass.refCount = static_cast<int>(getWrites(pass).size());
+
+      if (pass.sideEffect) {
+        pass.refCount++;
+      }
+
+      for (ResourceHandle handle : pass.reads) {
+        m_resources[handle].refCount++;
+      }
+    }
+
+    std::vector<ResourceHandle> unreferenced;
+
+    for (size_t r = 0; r < m_resources.size(); ++r) {
+      if (m_resources[r].refCount == 0) {
+        unreferenced.push_back(static_cast<ResourceHandle>(r));
+      }
+    }
+
+    while (!unreferenced.empty()) {
+
+      ResourceHandle handle = unreferenced.back();
+      unreferenced.pop_back();
+
+      for (int writer : m_resources[handle].writers) {
+
+        Pass &pass = m_passes[writer];
+
+        if (pass.culled || --pass.refCount > 0) {
+          continue;
+        }
+
+        pass.culled = true;
+
+        for (ResourceHandle read : pass.reads) {
+          if (--m_resources[read].refCount == 0) {
+            unreferenced.push_back(read);
+          }
+        }
+      }
+    }
+  }
+
+  void computeLifetimes() {
+
+    for (Resource &resource : m_resources) {
+      resource.firstPass = -1;
+      resource.lastPass = -1;
+    }
+
+    for (size_t p = 0; p < m_passes.size(); ++p) {
+
+      const Pass &pass = m_passes[p];
+
+      if (pass.culled) {
+        continue;
+      }
+
+      std::vector<ResourceHandle> used = getWrites(pass);
+      used.insert(used.end(), pass.reads.begin(), pass.reads.end());
+
+      for (ResourceHandle handle : used) {
+
+        Resource &resource = m_resources[handle];
+
+        if (resource.firstPass == -1) {
+          resource.firstPass = static_cast<int>(p);
+        }
+        resource.lastPass = static_cast<int>(p);
+      }
+    }
+  }
+
+  void allocate() {
+
+    m_frame++;
+
+    m_stats = RenderGraphStats{};
+
+    for (PooledTexture &pooled : m_pool) {
+      pooled.inUse = false;
+    }
+
+    std::vector<bool> usedThisFrame(m_pool.size(), false);
+
+    for (size_t p = 0; p < m_passes.size(); ++p) {
+
+      if (m_passes[p].culled) {
+        m_stats.nCulledPasses++;
+        continue;
+      }
+
+      m_stats.nPasses++;
+
+      for (Resource &resource : m_resources) {
+        if (!resource.imported && resource.firstPass == static_cast<int>(p)) {
+
+          size_t pooled = acquire(resource.desc);
+
+          if (pooled >= usedThisFrame.size()) {
+            usedThisFrame.resize(pooled + 1, false);
+          }
+
+          if (!usedThisFrame[pooled]) {
+            usedThisFrame[pooled] = true;
+            m_stats.nPhysicalTextures++;
+            m_stats.aliasedBytes += resource.desc.getSizeInBytes();
+          }
+
+          resource.textureID = m_pool[pooled].texture.getID();
+
+          m_stats.nTransientTextures++;
+          m_stats.unaliasedBytes += resource.desc.getSizeInBytes();
+        }
+      }
+
+      // free after the pass, the next pass can reuse the storage
+      for (const Resource &resource : m_resources) {
+        if (!resource.imported && resource.lastPass == static_cast<int>(p)) {
+          release(resource.textureID);
+        }
+      }
+    }
+
+    trimPool();
+  }
+
+  size_t acquire(const TextureDesc &desc) {
+
+    for (size_t i = 0; i < m_pool.size(); ++i) {
+
+      PooledTexture &pooled = m_pool[i];
+
+      if (!pooled.inUse && pooled.desc == desc) {
+        pooled.inUse = true;
+        pooled.lastUsedFrame = m_frame;
+        return i;
+      }
+    }
+
+    PooledTexture pooled;
+    pooled.desc = desc;
+    pooled.texture =
+        gpu::texture::Texture2D{desc.width, desc.height, desc.format};
+    pooled.texture.setWrapST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+    pooled.texture.setMinMagFilter(desc.isDepth()
+                                       ? gpu::texture::Filter::NEAREST
+                                       : gpu::texture::Filter::LINEAR);
+    pooled.inUse = true;
+    pooled.lastUsedFrame = m_frame;
+
+    m_pool.push_back(pooled);
+    return m_pool.size() - 1;
+  }
+
+  void release(unsigned int textureID) {
+    for (PooledTexture &pooled : m_pool) {
+      if (pooled.texture.getID() == textureID) {
+        pooled.inUse = false;
+      }
+    }
+  }
+
+  void trimPool() {
+
+    for (size_t i = 0; i < m_pool.size();) {
+
+      if (m_frame - m_pool[i].lastUsedFrame > POOL_MAX_IDLE_FRAMES) {
+
+        unsigned int textureID = m_pool[i].texture.getID();
+
+        // framebuffers referencing it can't be reused either
+        for (auto it = m_framebuffers.begin(); it != m_framebuffers.end();) {
+          if (std::find(it->first.begin(), it->first.end(), textureID) !=
+              it->first.end()) {
+            it->second.destroy();
+            it = m_framebuffers.erase(it);
+          } else {
+            ++it;
+          }
+        }
+
+        m_pool[i].texture.destroy();
+        m_pool.erase(m_pool.begin() + i);
+
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  gpu::framebuffer::Framebuffer &getFramebuffer(const Pass &pass) {
+
+    std::vector<unsigned int> key;
+
+    for (ResourceHandle handle : pass.colorWrites) {
+      key.push_back(m_resources[handle].textureID);
+    }
+
+    key.push_back(pass.depthWrite != INVALID_RESOURCE
+                      ? m_resources[pass.depthWrite].textureID
+                      : 0);
+
+    auto it = m_framebuffers.find(key);
+
+    if (it != m_framebuffers.end()) {
+      return it->second;
+    }
+
+    gpu::framebuffer::Framebuffer &framebuffer = m_framebuffers[key];
+
+    for (size_t i = 0; i < pass.colorWrites.size(); ++i) {
+      framebuffer.setColorAttachment(
+          m_resources[pass.colorWrites[i]].textureID, static_cast<int>(i));
+    }
+
+    framebuffer.setDrawBuffers(static_cast<int>(pass.colorWrites.size()));
+
+    if (pass.depthWrite != INVALID_RESOURCE) {
+
+      const Resource &depth = m_resources[pass.depthWrite];
+
+      if (depth.desc.format == GL_DEPTH24_STENCIL8) {
+        framebuffer.setDepthStencilAttachment(depth.textureID);
+      } else {
+        framebuffer.setDepthAttachment(depth.textureID);
+      }
+    }
+
+    framebuffer.checkStatus();
+
+    return framebuffer;
+  }
+
+  /**
+   * Invalidates the transient attachments that start (before the pass) or
+   * end (after the pass) their lifetime in pass p.
+   */
+  void invalidateAttachments(gpu::framebuffer::Framebuffer &framebuffer,
+                             const Pass &pass, int p, bool starting) {
+
+    std::vector<GLenum> attachments;
+
+    for (size_t i = 0; i < pass.colorWrites.size(); ++i) {
+
+      const Resource &resource = m_resources[pass.colorWrites[i]];
+
+      if (!resource.imported &&
+          (starting ? resource.firstPass : resource.lastPass) == p) {
+        attachments.push_back(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i));
+      }
+    }
+
+    if (pass.depthWrite != INVALID_RESOURCE) {
+
+      const Resource &resource = m_resources[pass.depthWrite];
+
+      if (!resource.imported &&
+          (starting ? resource.firstPass : resource.lastPass) == p) {
+        attachments.push_back(resource.desc.format == GL_DEPTH24_STENCIL8
+                                  ? GL_DEPTH_STENCIL_ATTACHMENT
+                                  : GL_DEPTH_ATTACHMENT);
+      }
+    }
+
+    if (!attachments.empty()) {
+      glInvalidateNamedFramebufferData(framebuffer.getID(),
+                                       static_cast<GLsizei>(attachments.size()),
+                                       attachments.data());
+    }
+  }
+};
+
+inline ResourceHandle PassBuilder::create(const std::string &name,
+                                          const TextureDesc &desc) {
+
+  RenderGraph::Resource resource;
+  resource.name = name;
+  resource.desc = desc;
+
+  m_graph.m_resources.push_back(resource);
+  return static_cast<ResourceHandle>(m_graph.m_resources.size() - 1);
+}
+
+inline void PassBuilder::read(ResourceHandle resource) {
+  m_graph.m_passes[m_pass].reads.push_back(resource);
+}
+
+inline void PassBuilder::writeColor(ResourceHandle resource) {
+  m_graph.m_passes[m_pass].colorWrites.push_back(resource);
+  m_graph.m_resources[resource].writers.push_back(m_pass);
+}
+
+inline void PassBuilder::writeDepth(ResourceHandle resource) {
+  m_graph.m_passes[m_pass].depthWrite = resource;
+  m_graph.m_resources[resource].writers.push_back(m_pass);
+}
+
+inline void PassBuilder::setSideEffect() {
+  m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+inline unsigned int PassResources::getTexture(ResourceHandle resource) const {
+  return m_graph.m_resources[resource].textureID;
+}
+
+inline const TextureDesc &
+PassResources::getDesc(ResourceHandle resource) const {
+  return m_graph.m_resources[resource].desc;
+}
+
+} // namespace rendergraph
+
+#endif // RENDER_GRAPH_H
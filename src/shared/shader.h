@@ -62,12 +62,70 @@ public:
     }
   }
 
+  /**
+   * Program built from source strings instead of files (generated shaders).
+   */
+  static Shader fromSource(const std::string &vertexCode,
+                           const std::string &fragmentCode) {
+
+    Shader shader;
+
+    GLuint shaderIds[2];
+
+    shader.createShader(vertexCode.c_str(), GL_VERTEX_SHADER, shaderIds[0]);
+    shader.createShader(fragmentCode.c_str(), GL_FRAGMENT_SHADER,
+                        shaderIds[1]);
+
+    shader.linkProgram(shaderIds, 2);
+
+    glDeleteShader(shaderIds[0]);
+    glDeleteShader(shaderIds[1]);
+
+    return shader;
+  }
+
+  /**
+   * Compute program, run with dispatch().
+   */
+  static Shader compute(const std::string &computeFile) {
+    return fromComputeSource(readShaderFile(computeFile));
+  }
+
+  static Shader fromComputeSource(const std::string &computeCode) {
+
+    Shader shader;
+
+    GLuint shaderId;
+    shader.createShader(computeCode.c_str(), GL_COMPUTE_SHADER, shaderId);
+
+    shader.linkProgram(&shaderId, 1);
+
+    glDeleteShader(shaderId);
+
+    return shader;
+  }
+
   inline void use() const { glUseProgram(m_ID); }
 
+  /**
+   * Compute programs only. Image and storage writes are visible to later
+   * commands only after the matching glMemoryBarrier.
+   */
+  inline void dispatch(unsigned int nGroupsX, unsigned int nGroupsY = 1,
+                       unsigned int nGroupsZ = 1) const {
+    glUseProgram(m_ID);
+    glDispatchCompute(nGroupsX, nGroupsY, nGroupsZ);
+  }
+
   inline void setInt(const std::string &name, int value) const {
     glProgramUniform1i(m_ID, getUniformLocation(name), value);
   }
 
+  inline void setIntArray(const std::string &name, const int *values,
+                          size_t count) const {
+    glProgramUniform1iv(m_ID, getUniformLocation(name), count, values);
+  }
+
   inline void setFloat(const std::string &name, float value) const {
     glProgramUniform1f(m_ID, getUniformLocation(name), value);
   }
@@ -94,18 +152,55 @@ public:
     glProgramUniform4f(m_ID, getUniformLocation(name), x, y, z, w);
   }
 
+  inline void setVec4(const std::string &name, const glm::vec4 &vec) const {
+    glProgramUniform4f(m_ID, getUniformLocation(name), vec.x, vec.y, vec.z,
+                       vec.w);
+  }
+
+  inline void setMat3(const std::string &name, const glm::mat3 &value) const {
+    glProgramUniformMatrix3fv(m_ID, getUniformLocation(name), 1, GL_FALSE,
+                              glm::value_ptr(value));
+  }
+
   inline void setMat4(const std::string &name, const glm::mat4 &value) const {
     glProgramUniformMatrix4fv(m_ID, getUniformLocation(name), 1, GL_FALSE,
                               glm::value_ptr(value));
   }
 
+  /**
+   * -1 if the program has no such (active) uniform. Look it up once and pass
+   * the location to CommandBuffer.
+   */
+  int getUniformLocation(const std::string &name) const {
+
+    int loc = glGetUniformLocation(m_ID, name.c_str());
+
+    /*
+        // this method creates a lot of errors when the glsl compiler decides to
+        // remove a variable. for now i'm going to disable it
+
+        if (loc == -1) {
+
+          std::stringstream ss;
+          ss << "Undefined uniform in shader " << m_ID << ": " << name;
+
+          std::string message = ss.str();
+
+          glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR,
+                               m_ID, GL_DEBUG_SEVERITY_MEDIUM, message.length(),
+                               message.c_str());
+        }
+    */
+    return loc;
+  }
+
   inline void destroy() override {
     glDeleteProgram(m_ID);
     m_ID = 0;
   }
 
 private:
-  std::string readShaderFile(const std::string &filename) const {
+  static std::string readShaderFile(const std::string &filename) {
 
     std::string code;
 
@@ -171,6 +266,9 @@ private:
       case GL_FRAGMENT_SHADER:
         strType = "fragment";
         break;
+      case GL_COMPUTE_SHADER:
+        strType = "compute";
+        break;
       default:
         strType = "???";
       }
@@ -193,15 +291,23 @@ private:
   bool createProgram(GLuint vertexShaderId, GLuint fragmentShaderId,
                      std::optional<GLuint> geometryShaderId) {
 
-    m_ID = glCreateProgram();
+    GLuint shaderIds[] = {vertexShaderId, fragmentShaderId,
+                          geometryShaderId.value_or(0)};
 
-    glAttachShader(m_ID, vertexShaderId);
-    glAttachShader(m_ID, fragmentShaderId);
+    return linkProgram(shaderIds, geometryShaderId.has_value() ? 3 : 2);
+  }
 
-    if (geometryShaderId.has_value()) {
-      glAttachShader(m_ID, geometryShaderId.value());
+  bool linkProgram(const GLuint *shaderIds, size_t nShaders) {
+
+    m_ID = glCreateProgram();
+
+    for (size_t i = 0; i < nShaders; ++i) {
+      glAttachShader(m_ID, shaderIds[i]);
     }
 
+    // so glGetProgramBinary returns a binary (saved command files)
+    glProgramParameteri(m_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(m_ID);
 
     int success;
@@ -226,29 +332,6 @@ private:
 
     return true;
   }
-
-  int getUniformLocation(const std::string &name) const {
-
-    int loc = glGetUniformLocation(m_ID, name.c_str());
-
-    /*
-        // this method creates a lot of errors when the glsl compiler decides to
-        // remove a variable. for now i'm going to disable it
-
-        if (loc == -1) {
-
-          std::stringstream ss;
-          ss << "Undefined uniform in shader " << m_ID << ": " << name;
-
-          std::string message = ss.str();
-
-          glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR,
-                               m_ID, GL_DEBUG_SEVERITY_MEDIUM, message.length(),
-                               message.c_str());
-        }
-    */
-    return loc;
-  }
 };
 
 } // namespace gpu
@@ -0,0 +1,72 @@
+
+#ifndef GPU_SHADER_STORAGE_BUFFER_H
+#define GPU_SHADER_STORAGE_BUFFER_H
+
+#include "buffer.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace gpu {
+
+class ShaderStorageBuffer : public Buffer {
+
+public:
+  ShaderStorageBuffer() {}
+
+  ShaderStorageBuffer(size_t sizeBytes, size_t bindingIndex)
+      : m_bindingIndex(bindingIndex) {
+
+    m_size = sizeBytes;
+
+    glCreateBuffers(1, &m_ID);
+    glNamedBufferData(m_ID, m_size, nullptr, GL_DYNAMIC_DRAW);
+
+    bindBase();
+  }
+
+  inline size_t getSize() const { return m_size; }
+
+  inline void bindBase() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_bindingIndex, m_ID);
+  }
+
+  /**
+   * Uploads the whole vector at the start of the buffer. If it doesn't fit
+   * the storage is reallocated (the old contents are discarded anyway, so
+   * this doubles as orphaning).
+   */
+  template <typename T> void update(const std::vector<T> &data) {
+    update(data.data(), sizeof(T) * data.size());
+  }
+
+  void update(const void *data, size_t sizeBytes) {
+
+    if (sizeBytes == 0) {
+      return;
+    }
+
+    if (sizeBytes > m_size) {
+
+      // grow geometrically so a slowly increasing count doesn't realloc
+      // every frame
+      m_size = std::max(sizeBytes, 2 * m_size);
+
+      glNamedBufferData(m_ID, m_size, nullptr, GL_DYNAMIC_DRAW);
+
+      // buffer storage changed, the binding has to be refreshed
+      bindBase();
+    }
+
+    glNamedBufferSubData(m_ID, 0, sizeBytes, data);
+  }
+
+private:
+  size_t m_bindingIndex;
+};
+
+} // namespace gpu
+
+#endif // GPU_SHADER_STORAGE_BUFFER_H
@@ -0,0 +1,277 @@
+
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include "bounds.h"
+#include "cubemap.h"
+#include "framebuffer.h"
+#include "pointshadows.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace shadows {
+
+struct PointShadowCacheCreateInfo {
+
+  PointShadowCacheCreateInfo() {}
+
+  size_t nLights = 1;
+
+  int size = 1024;
+  unsigned int depthFormat = GL_DEPTH_COMPONENT16;
+
+  float zNear = 0.1f;
+  float zFar = 25.0f;
+};
+
+struct PointShadowCacheStats {
+  // faces where the static casters were re-rendered
+  size_t staticFaces = 0;
+  // faces where the static layer was copied & the dynamic casters drawn
+  size_t dynamicFaces = 0;
+};
+
+/**
+ * Draws a set of shadow casters into the currently bound cube face. The
+ * frustum of the face is given so the casters can be culled.
+ */
+typedef std::function<void(const gpu::Shader &shader, const Frustum &frustum)>
+    DrawCastersFn;
+
+/**
+ * Omnidirectional shadow maps that are only re-rendered where something
+ * changed.
+ *
+ * Each light has two cube maps: a cached one with the static casters and the
+ * one used for lighting, which is the static layer + the dynamic casters on
+ * top. Faces are processed independently:
+ *
+ *  - a static face is re-rendered when the light moves or when a static
+ *    caster changes inside the face frustum (invalidateStatic).
+ *  - a final face is recomposited (static face copy + dynamic casters) when
+ *    its static face changed or a dynamic caster touches the face now or
+ *    touched it in the previous frame (it has to be erased).
+ *
+ * Faces with no changes keep last frame's contents and cost nothing.
+ *
+ * The depth shader renders one face at a time and needs the 'model',
+ * 'faceMatrix', 'lightPos', 'zNear' and 'zFar' uniforms.
+ */
+class PointShadowCache {
+
+public:
+  PointShadowCache() {}
+
+  PointShadowCache(const PointShadowCacheCreateInfo &createInfo)
+      : m_size(createInfo.size), m_zNear(createInfo.zNear),
+        m_zFar(createInfo.zFar) {
+
+    m_lights.resize(createInfo.nLights);
+
+    for (LightState &light : m_lights) {
+
+      light.staticMap = gpu::texture::Cubemap{m_size, m_size,
+                                              createInfo.depthFormat};
+      light.finalMap =
+          gpu::texture::Cubemap{m_size, m_size, createInfo.depthFormat};
+
+      for (gpu::texture::Cubemap *map : {&light.staticMap, &light.finalMap}) {
+        map->setMinMagFilter(gpu::texture::Filter::NEAREST);
+        map->setWrapRST(gpu::texture::Wrap::CLAMP_TO_EDGE);
+      }
+    }
+  }
+
+  inline size_t getNumLights() const { return m_lights.size(); }
+
+  inline unsigned int getShadowMapID(size_t lightIdx) const {
+    return m_lights[lightIdx].finalMap.getID();
+  }
+
+  inline const PointShadowCacheStats &getStats() const { return m_stats; }
+
+  inline float getZNear() const { return m_zNear; }
+  inline float getZFar() const { return m_zFar; }
+
+  /**
+   * Moving a light invalidates all of its faces.
+   */
+  void setLightPosition(size_t lightIdx, const glm::vec3 &position) {
+
+    LightState &light = m_lights[lightIdx];
+
+    if (light.valid && light.position == position) {
+      return;
+    }
+
+    light.valid = true;
+    light.position = position;
+
+    light.faceMatrices = pointShadowMatrices(position, m_zNear, m_zFar);
+
+    for (int face = 0; face < CUBE_FACES; ++face) {
+      light.faceFrusta[face] = Frustum{light.faceMatrices[face]};
+      light.staticDirty[face] = true;
+    }
+  }
+
+  /**
+   * A static caster was added, removed or moved. Call it with both the old
+   * and the new bounds when moving something.
+   */
+  void invalidateStatic(const AABB &bounds) {
+
+    for (LightState &light : m_lights) {
+
+      if (!light.valid) {
+        continue;
+      }
+
+      for (int face = 0; face < CUBE_FACES; ++face) {
+        if (light.faceFrusta[face].intersects(bounds)) {
+          light.staticDirty[face] = true;
+        }
+      }
+    }
+  }
+
+  /**
+   * Registers the bounds of a dynamic caster for this frame.
+   */
+  void addDynamicCaster(const AABB &bounds) { m_dynamicBounds.push_back(bounds); }
+
+  /**
+   * Brings the first nActiveLights shadow maps up to date.
+   */
+  void update(size_t nActiveLights, const gpu::Shader &depthShader,
+              const DrawCastersFn &drawStatic,
+              const DrawCastersFn &drawDynamic) {
+
+    m_stats = PointShadowCacheStats{};
+
+    depthShader.setFloat("zNear", m_zNear);
+    depthShader.setFloat("zFar", m_zFar);
+
+    gpu::framebuffer::setViewport(0, 0, m_size, m_size);
+
+    for (size_t i = 0; i < nActiveLights && i < m_lights.size(); ++i) {
+
+      LightState &light = m_lights[i];
+
+      if (!light.valid) {
+        continue;
+      }
+
+      depthShader.setVec3("lightPos", light.position);
+
+      for (int face = 0; face < CUBE_FACES; ++face) {
+
+        const Frustum &frustum = light.faceFrusta[face];
+
+        bool dynamicNow = false;
+        for (const AABB &bounds : m_dynamicBounds) {
+          if (frustum.intersects(bounds)) {
+            dynamicNow = true;
+            break;
+          }
+        }
+
+        bool staticChanged = light.staticDirty[face];
+
+        bool recomposite =
+            staticChanged || dynamicNow || light.dynamicLastFrame[face];
+
+        light.dynamicLastFrame[face] = dynamicNow;
+
+        if (!recomposite) {
+          continue;
+        }
+
+        depthShader.setMat4("faceMatrix", light.faceMatrices[face]);
+
+        if (staticChanged) {
+
+          m_framebuffer.setDepthAttachmentLayer(light.staticMap, face);
+          m_framebuffer.bind();
+
+          gpu::framebuffer::clear(ClearFlagBits::DEPTH_BIT);
+
+          drawStatic(depthShader, frustum);
+
+          light.staticDirty[face] = false;
+          m_stats.staticFaces++;
+        }
+
+        // final = static layer + dynamic casters
+
+        glCopyImageSubData(light.staticMap.getID(), GL_TEXTURE_CUBE_MAP, 0, 0,
+                           0, face, light.finalMap.getID(),
+                           GL_TEXTURE_CUBE_MAP, 0, 0, 0, face, m_size, m_size,
+                           1);
+
+        if (dynamicNow) {
+
+          m_framebuffer.setDepthAttachmentLayer(light.finalMap, face);
+          m_framebuffer.bind();
+
+          drawDynamic(depthShader, frustum);
+
+          m_stats.dynamicFaces++;
+        }
+      }
+    }
+
+    m_dynamicBounds.clear();
+
+    gpu::framebuffer::bindDefault();
+  }
+
+  void destroy() {
+
+    for (LightState &light : m_lights) {
+      light.staticMap.destroy();
+      light.finalMap.destroy();
+    }
+
+    m_framebuffer.destroy();
+  }
+
+private:
+  struct LightState {
+
+    bool valid = false;
+
+    glm::vec3 position;
+
+    std::array<glm::mat4, CUBE_FACES> faceMatrices;
+    std::array<Frustum, CUBE_FACES> faceFrusta;
+
+    std::array<bool, CUBE_FACES> staticDirty{};
+    std::array<bool, CUBE_FACES> dynamicLastFrame{};
+
+    gpu::texture::Cubemap staticMap;
+    gpu::texture::Cubemap finalMap;
+  };
+
+  int m_size;
+
+  float m_zNear;
+  float m_zFar;
+
+  std::vector<LightState> m_lights;
+  std::vector<AABB> m_dynamicBounds;
+
+  gpu::framebuffer::Framebuffer m_framebuffer;
+
+  PointShadowCacheStats m_stats;
+};
+
+} // namespace shadows
+
+#endif // SHADOW_CACHE_H
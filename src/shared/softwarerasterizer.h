@@ -0,0 +1,1730 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include "cpuprofiler.h"
+#include "mesh.h"
+#include "model.h"
+#include "texture2d.h"
+#include "vertex.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * Cpu rendering backend for machines without a gpu: draws the vertices of
+ * Mesh/MeshData/Model with C++ shader functors into a RenderTarget.
+ *
+ * Draws are queued and rasterized by flush():
+ *
+ *  1. vertices are transformed, each thread takes a contiguous range,
+ *  2. triangles are culled, clipped, set up and binned into 64x64 tiles,
+ *     each thread into its own bins (a thread's triangles are contiguous, so
+ *     the submission order is kept),
+ *  3. the threads take the tiles one by one and rasterize their triangles in
+ *     8x8 blocks: blocks outside an edge or behind the farthest depth of the
+ *     block (hierarchical depth) are skipped, the others are tested 4 pixels
+ *     at a time (SSE2) and the visible pixels are shaded.
+ *
+ * The output doesn't depend on the number of threads.
+ *
+ * Conventions are the gl ones: counter-clockwise front faces, [0, 1] depth
+ * with a LESS test, texture rows bottom to top. RenderTarget rows are top to
+ * bottom (like an image file).
+ */
+namespace swr {
+
+// pixels, a multiple of BLOCK_SIZE
+constexpr int TILE_SIZE = 64;
+
+// pixels, granularity of the hierarchical depth test
+constexpr int BLOCK_SIZE = 8;
+
+// screen positions are snapped to 1/SUBPIXEL_STEPS of a pixel, so the edge
+// functions are exact near the edges and shared edges are not drawn twice
+constexpr float SUBPIXEL_STEPS = 16.0f;
+
+// clip space |x|, |y| (in w) past which triangles are clipped, so snapped
+// positions stay in the float precision
+constexpr float GUARD_BAND = 64.0f;
+
+static_assert(TILE_SIZE % BLOCK_SIZE == 0,
+              "tiles have to be made of whole blocks");
+
+static_assert(BLOCK_SIZE % 4 == 0, "blocks are processed 4 pixels at a time");
+
+/**
+ * 4 floats processed together, with a scalar fallback.
+ */
+#ifdef SWR_SSE2
+
+struct Float4 {
+
+  __m128 v;
+
+  Float4() {}
+  Float4(__m128 value) : v(value) {}
+  explicit Float4(float f) : v(_mm_set1_ps(f)) {}
+  Float4(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)) {}
+
+  static inline Float4 load(const float *p) { return _mm_loadu_ps(p); }
+
+  inline void store(float *p) const { _mm_storeu_ps(p, v); }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+
+// bit i of the result is lane i
+inline int greaterMask(Float4 a, Float4 b) {
+  return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v));
+}
+
+inline int lessMask(Float4 a, Float4 b) {
+  return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v));
+}
+
+#else
+
+struct Float4 {
+
+  float v[4];
+
+  Float4() {}
+  explicit Float4(float f) : v{f, f, f, f} {}
+  Float4(float a, float b, float c, float d) : v{a, b, c, d} {}
+
+  static inline Float4 load(const float *p) {
+    return Float4{p[0], p[1], p[2], p[3]};
+  }
+
+  inline void store(float *p) const {
+    for (int i = 0; i < 4; ++i) {
+      p[i] = v[i];
+    }
+  }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) {
+  return Float4{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2],
+                a.v[3] + b.v[3]};
+}
+
+inline Float4 operator*(Float4 a, Float4 b) {
+  return Float4{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2],
+                a.v[3] * b.v[3]};
+}
+
+inline int greaterMask(Float4 a, Float4 b) {
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    mask |= (a.v[i] > b.v[i]) << i;
+  }
+  return mask;
+}
+
+inline int lessMask(Float4 a, Float4 b) {
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    mask |= (a.v[i] < b.v[i]) << i;
+  }
+  return mask;
+}
+
+#endif // SWR_SSE2
+
+inline uint32_t packColor(const glm::vec4 &color) {
+
+  glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+  return static_cast<uint32_t>(c.r) | (static_cast<uint32_t>(c.g) << 8) |
+         (static_cast<uint32_t>(c.b) << 16) |
+         (static_cast<uint32_t>(c.a) << 24);
+}
+
+inline glm::vec4 unpackColor(uint32_t color) {
+
+#ifdef SWR_SSE2
+  // bytes -> 32 bit ints -> floats
+  __m128i zero = _mm_setzero_si128();
+  __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(color));
+  __m128i ints =
+      _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+
+  glm::vec4 unpacked;
+  _mm_storeu_ps(&unpacked.x, _mm_mul_ps(_mm_cvtepi32_ps(ints),
+                                        _mm_set1_ps(1.0f / 255.0f)));
+  return unpacked;
+#else
+  return glm::vec4{static_cast<float>(color & 0xff),
+                   static_cast<float>((color >> 8) & 0xff),
+                   static_cast<float>((color >> 16) & 0xff),
+                   static_cast<float>(color >> 24)} *
+         (1.0f / 255.0f);
+#endif
+}
+
+/**
+ * RGBA8 texture with its mip chain, repeat wrapping, bilinear filtering
+ * within a level and linear between levels.
+ */
+class Texture {
+
+public:
+  Texture() {}
+
+  // rows bottom to top, like glTextureSubImage2D
+  Texture(int width, int height, const unsigned char *rgba) {
+
+    Level level;
+    level.width = width;
+    level.height = height;
+    level.texels.resize(static_cast<size_t>(width) * height);
+
+    for (size_t i = 0; i < level.texels.size(); ++i) {
+      const unsigned char *texel = rgba + 4 * i;
+      level.texels[i] = texel[0] | (texel[1] << 8) | (texel[2] << 16) |
+                        (static_cast<uint32_t>(texel[3]) << 24);
+    }
+
+    m_levels.push_back(std::move(level));
+
+    generateMipmap();
+  }
+
+  /**
+   * Loads an image file, stb_image only (no gl context needed).
+   */
+  static Texture load(const std::string &path) {
+
+    CPU_PROFILE_ZONE("swr::Texture::load");
+
+    stbi_set_flip_vertically_on_load(true);
+
+    int width = 0;
+    int height = 0;
+    int nrChannels = 0;
+
+    unsigned char *data =
+        stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
+
+    if (!data) {
+      std::cout << "Could not load texture data from : " << path << std::endl;
+      return Texture{};
+    }
+
+    Texture texture{width, height, data};
+
+    stbi_image_free(data);
+
+    return texture;
+  }
+
+  /**
+   * Copy of level 0 of a gl texture, its context has to be current.
+   */
+  static Texture readBack(const gpu::texture::Texture2D &texture) {
+
+    int width = static_cast<int>(texture.getWidth());
+    int height = static_cast<int>(texture.getHeight());
+
+    std::vector<unsigned char> data(static_cast<size_t>(width) * height * 4);
+
+    glGetTextureImage(texture.getID(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                      static_cast<GLsizei>(data.size()), data.data());
+
+    return Texture{width, height, data.data()};
+  }
+
+  inline bool isEmpty() const { return m_levels.empty(); }
+
+  inline int getWidth() const { return isEmpty() ? 0 : m_levels[0].width; }
+  inline int getHeight() const { return isEmpty() ? 0 : m_levels[0].height; }
+
+  inline size_t getNumLevels() const { return m_levels.size(); }
+
+  /**
+   * Trilinear sample, the level comes from the screen space derivatives of
+   * the texture coordinates (like texture() in a fragment shader). White if
+   * the texture is empty.
+   */
+  glm::vec4 sample(const glm::vec2 &uv, const glm::vec2 &dUvDx,
+                   const glm::vec2 &dUvDy) const {
+
+    if (isEmpty()) {
+      return glm::vec4{1.0f};
+    }
+
+    glm::vec2 size{static_cast<float>(m_levels[0].width),
+                   static_cast<float>(m_levels[0].height)};
+
+    glm::vec2 dx = dUvDx * size;
+    glm::vec2 dy = dUvDy * size;
+
+    float rho = std::max(glm::dot(dx, dx), glm::dot(dy, dy));
+
+    // log2(sqrt(rho))
+    float lod = rho > 1.0f ? 0.5f * std::log2(rho) : 0.0f;
+    lod = std::min(lod, static_cast<float>(m_levels.size() - 1));
+
+    int level = static_cast<int>(lod);
+    float t = lod - static_cast<float>(level);
+
+    glm::vec4 color = sampleLevel(uv, level);
+
+    if (t > 0.0f) {
+      color = glm::mix(color, sampleLevel(uv, level + 1), t);
+    }
+
+    return color;
+  }
+
+  glm::vec4 sampleLevel(const glm::vec2 &uv, int levelIndex) const {
+
+    const Level &level = m_levels[levelIndex];
+
+    float x = uv.x * static_cast<float>(level.width) - 0.5f;
+    float y = uv.y * static_cast<float>(level.height) - 0.5f;
+
+    float floorX = std::floor(x);
+    float floorY = std::floor(y);
+
+    float tx = x - floorX;
+    float ty = y - floorY;
+
+    int x0 = wrap(static_cast<int>(floorX), level.width);
+    int y0 = wrap(static_cast<int>(floorY), level.height);
+    int x1 = wrap(x0 + 1, level.width);
+    int y1 = wrap(y0 + 1, level.height);
+
+    const uint32_t *row0 = &level.texels[static_cast<size_t>(y0) * level.width];
+    const uint32_t *row1 = &level.texels[static_cast<size_t>(y1) * level.width];
+
+    glm::vec4 bottom =
+        glm::mix(unpackColor(row0[x0]), unpackColor(row0[x1]), tx);
+    glm::vec4 top = glm::mix(unpackColor(row1[x0]), unpackColor(row1[x1]), tx);
+
+    return glm::mix(bottom, top, ty);
+  }
+
+private:
+  struct Level {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> texels;
+  };
+
+  std::vector<Level> m_levels;
+
+  static inline int wrap(int i, int size) {
+    i %= size;
+    return i < 0 ? i + size : i;
+  }
+
+  // 2x2 box filter, the last row/column is repeated on odd sizes
+  void generateMipmap() {
+
+    while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+
+      const Level &previous = m_levels.back();
+
+      Level level;
+      level.width = std::max(1, previous.width / 2);
+      level.height = std::max(1, previous.height / 2);
+      level.texels.resize(static_cast<size_t>(level.width) * level.height);
+
+      for (int y = 0; y < level.height; ++y) {
+
+        int y0 = std::min(2 * y, previous.height - 1);
+        int y1 = std::min(2 * y + 1, previous.height - 1);
+
+        for (int x = 0; x < level.width; ++x) {
+
+          int x0 = std::min(2 * x, previous.width - 1);
+          int x1 = std::min(2 * x + 1, previous.width - 1);
+
+          const uint32_t *row0 = &previous.texels[y0 * previous.width];
+          const uint32_t *row1 = &previous.texels[y1 * previous.width];
+
+          glm::vec4 sum = unpackColor(row0[x0]) + unpackColor(row0[x1]) +
+                          unpackColor(row1[x0]) + unpackColor(row1[x1]);
+
+          level.texels[y * level.width + x] = packColor(sum * 0.25f);
+        }
+      }
+
+      m_levels.push_back(std::move(level));
+    }
+  }
+};
+
+/**
+ * Color and depth buffers. Rows are top to bottom, the storage is padded to
+ * whole blocks. Depth only targets (shadow maps) have no color buffer.
+ */
+class RenderTarget {
+
+public:
+  RenderTarget() {}
+
+  RenderTarget(int width, int height, bool hasColor = true)
+      : m_width(width), m_height(height) {
+
+    m_stride = (width + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    m_paddedHeight = (height + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+
+    size_t nPixels = static_cast<size_t>(m_stride) * m_paddedHeight;
+
+    if (hasColor) {
+      m_color.resize(nPixels, 0);
+    }
+
+    m_depth.resize(nPixels, 1.0f);
+
+    m_blocksX = m_stride / BLOCK_SIZE;
+    m_blockMaxDepth.resize(static_cast<size_t>(m_blocksX) *
+                               (m_paddedHeight / BLOCK_SIZE),
+                           1.0f);
+
+    m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+  }
+
+  inline int getWidth() const { return m_width; }
+  inline int getHeight() const { return m_height; }
+  inline int getStride() const { return m_stride; }
+
+  inline bool hasColor() const { return !m_color.empty(); }
+
+  inline int getNumTiles() const { return m_tilesX * m_tilesY; }
+
+  inline uint32_t getColor(int x, int y) const {
+    return m_color[static_cast<size_t>(y) * m_stride + x];
+  }
+
+  // clamped to the edges
+  inline float getDepth(int x, int y) const {
+    x = std::clamp(x, 0, m_width - 1);
+    y = std::clamp(y, 0, m_height - 1);
+    return m_depth[static_cast<size_t>(y) * m_stride + x];
+  }
+
+  inline const std::vector<uint32_t> &getColorBuffer() const {
+    return m_color;
+  }
+
+  inline const std::vector<float> &getDepthBuffer() const { return m_depth; }
+
+  /**
+   * Binary PPM of the color buffer.
+   */
+  bool writePPM(const std::string &path) const {
+
+    std::ofstream out{path, std::ios::binary};
+
+    if (!out || !hasColor()) {
+      return false;
+    }
+
+    out << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+    std::vector<unsigned char> row(static_cast<size_t>(m_width) * 3);
+
+    for (int y = 0; y < m_height; ++y) {
+
+      for (int x = 0; x < m_width; ++x) {
+        uint32_t color = getColor(x, y);
+        row[3 * x] = color & 0xff;
+        row[3 * x + 1] = (color >> 8) & 0xff;
+        row[3 * x + 2] = (color >> 16) & 0xff;
+      }
+
+      out.write(reinterpret_cast<const char *>(row.data()), row.size());
+    }
+
+    return static_cast<bool>(out);
+  }
+
+private:
+  friend class Rasterizer;
+
+  int m_width = 0;
+  int m_height = 0;
+  int m_stride = 0;
+  int m_paddedHeight = 0;
+
+  std::vector<uint32_t> m_color;
+  std::vector<float> m_depth;
+
+  // farthest depth of every block, rescanned when a triangle writes to it
+  int m_blocksX = 0;
+  std::vector<float> m_blockMaxDepth;
+
+  int m_tilesX = 0;
+  int m_tilesY = 0;
+};
+
+struct Material {
+
+  // white if null
+  const Texture *diffuse = nullptr;
+
+  // specularColor if null
+  const Texture *specular = nullptr;
+
+  // multiplies the diffuse map
+  glm::vec3 color = glm::vec3{1.0f};
+  glm::vec3 specularColor = glm::vec3{0.5f};
+
+  float shininess = 32.0f;
+};
+
+/**
+ * Materials of meshes loaded on the gpu (Model), their textures are read back
+ * once. Needs the gl context of the textures.
+ */
+class MaterialCache {
+
+public:
+  const Material &getMaterial(const Mesh &mesh) {
+
+    const gpu::texture::Texture2D *diffuse = nullptr;
+    const gpu::texture::Texture2D *specular = nullptr;
+
+    for (const MeshTexture &texture : mesh.m_textures) {
+
+      if (texture.type == "texture_diffuse" && diffuse == nullptr) {
+        diffuse = &texture.texture;
+      } else if (texture.type == "texture_specular" && specular == nullptr) {
+        specular = &texture.texture;
+      }
+    }
+
+    std::pair<GLuint, GLuint> key{diffuse ? diffuse->getID() : 0,
+                                  specular ? specular->getID() : 0};
+
+    auto it = m_materials.find(key);
+
+    if (it != m_materials.end()) {
+      return it->second;
+    }
+
+    Material material;
+    material.diffuse = diffuse ? getTexture(*diffuse) : nullptr;
+    material.specular = specular ? getTexture(*specular) : nullptr;
+
+    return m_materials.emplace(key, material).first->second;
+  }
+
+private:
+  std::unordered_map<GLuint, std::unique_ptr<Texture>> m_textures;
+  std::map<std::pair<GLuint, GLuint>, Material> m_materials;
+
+  const Texture *getTexture(const gpu::texture::Texture2D &texture) {
+
+    std::unique_ptr<Texture> &cached = m_textures[texture.getID()];
+
+    if (!cached) {
+      cached = std::make_unique<Texture>(Texture::readBack(texture));
+    }
+
+    return cached.get();
+  }
+};
+
+/**
+ * Interpolated inputs of a shader functor.
+ */
+struct Fragment {
+
+  // world space
+  glm::vec3 position;
+
+  // world space, not normalized
+  glm::vec3 normal;
+
+  glm::vec2 texCoords;
+
+  // screen space derivatives of texCoords (mip selection)
+  glm::vec2 dTexCoordsDx;
+  glm::vec2 dTexCoordsDy;
+};
+
+/**
+ * Depth only: shadow maps and depth pre-passes.
+ */
+struct DepthShader {
+
+  static constexpr bool WRITES_COLOR = false;
+
+  inline glm::vec3 operator()(const Fragment &, const Material &) const {
+    return glm::vec3{0.0f};
+  }
+};
+
+/**
+ * Point light with diffuse and specular maps, the chapter 2 lighting maps
+ * shader with the blinn-phong specular of 5.1.1.
+ */
+struct BlinnPhongShader {
+
+  static constexpr bool WRITES_COLOR = true;
+
+  glm::vec3 viewPos = glm::vec3{0.0f};
+
+  glm::vec3 lightPos = glm::vec3{0.0f};
+
+  glm::vec3 ambient = glm::vec3{0.2f};
+  glm::vec3 diffuse = glm::vec3{0.5f};
+  glm::vec3 specular = glm::vec3{1.0f};
+
+  glm::vec3 operator()(const Fragment &fragment,
+                       const Material &material) const {
+
+    glm::vec3 diffuseColor =
+        material.color *
+        glm::vec3{sampleOrWhite(material.diffuse, fragment)};
+
+    glm::vec3 specularColor =
+        material.specular
+            ? glm::vec3{sampleOrWhite(material.specular, fragment)}
+            : material.specularColor;
+
+    glm::vec3 n = glm::normalize(fragment.normal);
+
+    glm::vec3 lightDir = glm::normalize(lightPos - fragment.position);
+    glm::vec3 viewDir = glm::normalize(viewPos - fragment.position);
+    glm::vec3 halfwayDir = glm::normalize(lightDir + viewDir);
+
+    float diff = std::max(0.0f, glm::dot(n, lightDir));
+    float spec = std::pow(std::max(0.0f, glm::dot(n, halfwayDir)),
+                          material.shininess);
+
+    return ambient * diffuseColor + diff * diffuse * diffuseColor +
+           spec * specular * specularColor;
+  }
+
+  static inline glm::vec4 sampleOrWhite(const Texture *texture,
+                                        const Fragment &fragment) {
+    return texture ? texture->sample(fragment.texCoords, fragment.dTexCoordsDx,
+                                     fragment.dTexCoordsDy)
+                   : glm::vec4{1.0f};
+  }
+};
+
+/**
+ * Directional light with a 3x3 PCF shadow map lookup, lit-shadows.fs of
+ * 5.3.3.shadow-mapping. shadowMap is a depth target drawn with DepthShader and
+ * the lightSpaceMatrix view projection.
+ */
+struct ShadowShader {
+
+  static constexpr bool WRITES_COLOR = true;
+
+  glm::vec3 viewPos = glm::vec3{0.0f};
+
+  glm::vec3 direction = glm::vec3{0.0f, -1.0f, 0.0f};
+
+  glm::vec3 ambient = glm::vec3{0.2f};
+  glm::vec3 diffuse = glm::vec3{0.7f};
+  glm::vec3 specular = glm::vec3{0.4f};
+
+  glm::mat4 lightSpaceMatrix = glm::mat4{1.0f};
+
+  const RenderTarget *shadowMap = nullptr;
+
+  glm::vec3 operator()(const Fragment &fragment,
+                       const Material &material) const {
+
+    glm::vec3 diffuseColor =
+        material.color *
+        glm::vec3{BlinnPhongShader::sampleOrWhite(material.diffuse, fragment)};
+
+    glm::vec3 specularColor =
+        material.specular ? glm::vec3{BlinnPhongShader::sampleOrWhite(
+                                material.specular, fragment)}
+                          : material.specularColor;
+
+    glm::vec3 n = glm::normalize(fragment.normal);
+
+    glm::vec3 lightDir = -glm::normalize(direction);
+    glm::vec3 viewDir = glm::normalize(viewPos - fragment.position);
+    glm::vec3 halfwayDir = glm::normalize(lightDir + viewDir);
+
+    float diff = std::max(0.0f, glm::dot(lightDir, n));
+    float spec = std::pow(std::max(0.0f, glm::dot(halfwayDir, n)),
+                          material.shininess);
+
+    float shadow = calculateShadow(fragment.position, n, lightDir);
+
+    return ambient * diffuseColor +
+           (1.0f - shadow) * (diff * diffuse * diffuseColor +
+                              spec * specular * specularColor);
+  }
+
+  float calculateShadow(const glm::vec3 &position, const glm::vec3 &normal,
+                        const glm::vec3 &lightDir) const {
+
+    if (shadowMap == nullptr) {
+      return 0.0f;
+    }
+
+    glm::vec4 lightSpace = lightSpaceMatrix * glm::vec4{position, 1.0f};
+    glm::vec3 projCoords = glm::vec3{lightSpace} / lightSpace.w;
+
+    float currentDepth = projCoords.z * 0.5f + 0.5f;
+
+    if (currentDepth > 1.0f) {
+      // outside of the light frustum
+      return 0.0f;
+    }
+
+    float bias = std::max(0.001f, 0.05f * (1.0f - glm::dot(normal, lightDir)));
+
+    // texel of the fragment, the shadow map rows are top to bottom
+    int x = static_cast<int>((projCoords.x * 0.5f + 0.5f) *
+                             static_cast<float>(shadowMap->getWidth()));
+    int y = static_cast<int>((0.5f - projCoords.y * 0.5f) *
+                             static_cast<float>(shadowMap->getHeight()));
+
+    float shadow = 0.0f;
+
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        shadow += currentDepth - bias > shadowMap->getDepth(x + dx, y + dy)
+                      ? 1.0f
+                      : 0.0f;
+      }
+    }
+
+    return shadow / 9.0f;
+  }
+};
+
+/**
+ * Runs a function on a fixed set of threads, the calling thread included.
+ */
+class ThreadPool {
+
+public:
+  explicit ThreadPool(unsigned int nThreads) {
+
+    for (unsigned int i = 1; i < nThreads; ++i) {
+      m_threads.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ~ThreadPool() {
+
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  inline unsigned int getNumThreads() const {
+    return static_cast<unsigned int>(m_threads.size()) + 1;
+  }
+
+  /**
+   * fn(threadIndex) on every thread, the calling thread is 0. Returns when
+   * they are all done.
+   */
+  void run(const std::function<void(unsigned int)> &fn) {
+
+    if (m_threads.empty()) {
+      fn(0);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_fn = &fn;
+      m_nRunning = m_threads.size();
+      ++m_generation;
+    }
+
+    m_wake.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_done.wait(lock, [this] { return m_nRunning == 0; });
+
+    m_fn = nullptr;
+  }
+
+private:
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+
+  const std::function<void(unsigned int)> *m_fn = nullptr;
+  uint64_t m_generation = 0;
+  size_t m_nRunning = 0;
+  bool m_stop = false;
+
+  void work(unsigned int index) {
+
+    CPU_PROFILE_THREAD_NAME("swr " + std::to_string(index));
+
+    uint64_t generation = 0;
+
+    while (true) {
+
+      const std::function<void(unsigned int)> *fn = nullptr;
+
+      {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_wake.wait(lock,
+                    [&] { return m_stop || m_generation != generation; });
+
+        if (m_stop) {
+          return;
+        }
+
+        generation = m_generation;
+        fn = m_fn;
+      }
+
+      (*fn)(index);
+
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (--m_nRunning == 0) {
+          m_done.notify_one();
+        }
+      }
+    }
+  }
+};
+
+struct RasterizerCreateInfo {
+
+  RasterizerCreateInfo() {}
+
+  // 0 = std::thread::hardware_concurrency()
+  unsigned int nThreads = 0;
+
+  bool cullBackFaces = true;
+};
+
+struct RasterizerStats {
+
+  // submitted
+  uint64_t nTriangles = 0;
+
+  // after culling and clipping
+  uint64_t nRasterizedTriangles = 0;
+
+  // passed the depth test
+  uint64_t nShadedPixels = 0;
+
+  // 8x8 blocks overlapping a triangle
+  uint64_t nTestedBlocks = 0;
+
+  // tested blocks skipped by the hierarchical depth test
+  uint64_t nCulledBlocks = 0;
+
+  RasterizerStats &operator+=(const RasterizerStats &other) {
+    nTriangles += other.nTriangles;
+    nRasterizedTriangles += other.nRasterizedTriangles;
+    nShadedPixels += other.nShadedPixels;
+    nTestedBlocks += other.nTestedBlocks;
+    nCulledBlocks += other.nCulledBlocks;
+    return *this;
+  }
+};
+
+/**
+ *  swr::Rasterizer rasterizer;
+ *
+ *  rasterizer.clear(target, glm::vec4{0.1f, 0.1f, 0.1f, 1.0f});
+ *  rasterizer.setViewProjection(projection * view);
+ *  rasterizer.draw(cubeData, model, shader, material);
+ *  rasterizer.flush(target);
+ *
+ * The vertices, indices, textures and shadow maps used by the draws have to
+ * stay alive until flush().
+ */
+class Rasterizer {
+
+public:
+  Rasterizer(const RasterizerCreateInfo &createInfo = {})
+      : m_createInfo(createInfo) {
+
+    unsigned int nThreads =
+        createInfo.nThreads > 0
+            ? createInfo.nThreads
+            : std::max(1u, std::thread::hardware_concurrency());
+
+    m_threadPool = std::make_unique<ThreadPool>(nThreads);
+    m_workers.resize(nThreads);
+  }
+
+  inline unsigned int getNumThreads() const {
+    return m_threadPool->getNumThreads();
+  }
+
+  inline const RasterizerStats &getStats() const { return m_stats; }
+  inline void resetStats() { m_stats = RasterizerStats{}; }
+
+  // used by the next draws
+  inline void setViewProjection(const glm::mat4 &viewProjection) {
+    m_viewProjection = viewProjection;
+  }
+
+  void clear(RenderTarget &target, const glm::vec4 &color,
+             float depth = 1.0f) {
+
+    CPU_PROFILE_ZONE("swr::clear");
+
+    uint32_t packedColor = packColor(color);
+
+    int nBlockRows = target.m_paddedHeight / BLOCK_SIZE;
+    unsigned int nThreads = getNumThreads();
+
+    m_threadPool->run([&](unsigned int thread) {
+      int begin = nBlockRows * static_cast<int>(thread) / nThreads;
+      int end = nBlockRows * static_cast<int>(thread + 1) / nThreads;
+
+      size_t first = static_cast<size_t>(begin) * BLOCK_SIZE * target.m_stride;
+      size_t last = static_cast<size_t>(end) * BLOCK_SIZE * target.m_stride;
+
+      if (target.hasColor()) {
+        std::fill(target.m_color.begin() + first,
+                  target.m_color.begin() + last, packedColor);
+      }
+
+      std::fill(target.m_depth.begin() + first, target.m_depth.begin() + last,
+                depth);
+
+      std::fill(target.m_blockMaxDepth.begin() + begin * target.m_blocksX,
+                target.m_blockMaxDepth.begin() + end * target.m_blocksX,
+                depth);
+    });
+  }
+
+  /**
+   * Queues a draw of triangles (nIndices / 3 of them if indices isn't null,
+   * nVertices / 3 otherwise).
+   */
+  template <typename Shader>
+  void draw(const Vertex *vertices, size_t nVertices,
+            const unsigned int *indices, size_t nIndices,
+            const glm::mat4 &model, const Shader &shader,
+            const Material &material = {}) {
+
+    DrawRecord draw;
+    draw.vertices = vertices;
+    draw.nVertices = nVertices;
+    draw.indices = indices;
+    draw.nTriangles = (indices ? nIndices : nVertices) / 3;
+    draw.model = model;
+    draw.normalMatrix = glm::transpose(glm::inverse(glm::mat3{model}));
+    draw.viewProjection = m_viewProjection;
+    draw.material = material;
+    draw.shader = std::make_shared<Shader>(shader);
+    draw.rasterize = &Rasterizer::rasterizeTriangle<Shader>;
+
+    m_draws.push_back(std::move(draw));
+  }
+
+  template <typename Shader>
+  void draw(const MeshData &meshData, const glm::mat4 &model,
+            const Shader &shader, const Material &material = {}) {
+
+    const unsigned int *indices =
+        meshData.indices ? meshData.indices->data() : nullptr;
+    size_t nIndices = meshData.indices ? meshData.indices->size() : 0;
+
+    draw(meshData.vertices.data(), meshData.vertices.size(), indices,
+         nIndices, model, shader, material);
+  }
+
+  template <typename Shader>
+  void draw(const Mesh &mesh, const glm::mat4 &model, const Shader &shader,
+            const Material &material = {}) {
+
+    const unsigned int *indices =
+        mesh.m_indices.empty() ? nullptr : mesh.m_indices.data();
+
+    draw(mesh.m_vertices.data(), mesh.m_vertices.size(), indices,
+         mesh.m_indices.size(), model, shader, material);
+  }
+
+  /**
+   * Every mesh with the material of its textures.
+   */
+  template <typename Shader>
+  void draw(const Model &model, const glm::mat4 &modelMatrix,
+            const Shader &shader, MaterialCache &materials) {
+
+    for (const Mesh &mesh : model.m_meshes) {
+      draw(mesh, modelMatrix, shader, materials.getMaterial(mesh));
+    }
+  }
+
+  /**
+   * Rasterizes the queued draws.
+   */
+  void flush(RenderTarget &target) {
+
+    CPU_PROFILE_ZONE("swr::flush");
+
+    if (m_draws.empty()) {
+      return;
+    }
+
+    size_t nVertices = 0;
+    size_t nTriangles = 0;
+
+    for (DrawRecord &draw : m_draws) {
+      draw.firstVertex = nVertices;
+      draw.firstTriangle = nTriangles;
+      nVertices += draw.nVertices;
+      nTriangles += draw.nTriangles;
+    }
+
+    m_clipVertices.resize(nVertices);
+
+    unsigned int nThreads = getNumThreads();
+    int nTiles = target.getNumTiles();
+
+    m_threadPool->run([&](unsigned int thread) {
+      CPU_PROFILE_ZONE("swr::vertices");
+
+      transformVertices(nVertices * thread / nThreads,
+                        nVertices * (thread + 1) / nThreads);
+    });
+
+    m_threadPool->run([&](unsigned int thread) {
+      CPU_PROFILE_ZONE("swr::setup");
+
+      Worker &worker = m_workers[thread];
+      worker.triangles.clear();
+      worker.bins.resize(nTiles);
+      for (std::vector<uint32_t> &bin : worker.bins) {
+        bin.clear();
+      }
+
+      setupTriangles(target, worker, nTriangles * thread / nThreads,
+                     nTriangles * (thread + 1) / nThreads);
+    });
+
+    std::atomic<int> nextTile{0};
+
+    m_threadPool->run([&](unsigned int thread) {
+      CPU_PROFILE_ZONE("swr::tiles");
+
+      RasterizerStats &stats = m_workers[thread].stats;
+
+      for (int tile = nextTile++; tile < nTiles; tile = nextTile++) {
+        rasterizeTile(target, tile, stats);
+      }
+    });
+
+    for (Worker &worker : m_workers) {
+      m_stats += worker.stats;
+      worker.stats = RasterizerStats{};
+    }
+
+    m_stats.nTriangles += nTriangles;
+
+    m_draws.clear();
+  }
+
+private:
+  struct ClipVertex {
+    glm::vec4 clip;
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+  };
+
+  struct SetupTriangle {
+
+    // snapped screen positions
+    float x[3];
+    float y[3];
+
+    // edge i (opposite to vertex i): E = a * (px - x[j]) + b * (py - y[j]),
+    // j = i + 1, positive inside
+    float a[3];
+    float b[3];
+
+    // pixels exactly on an edge are inside if it's a top or left edge
+    // (threshold -epsilon) and outside otherwise (threshold 0)
+    float threshold[3];
+
+    float invArea;
+
+    // [0, 1] depth and 1/w of the vertices
+    float z[3];
+    float invW[3];
+    float zMin;
+
+    // pixel centers covered by the bounding box, inclusive
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+
+    uint32_t draw;
+
+    glm::vec3 position[3];
+    glm::vec3 normal[3];
+    glm::vec2 texCoords[3];
+  };
+
+  struct DrawRecord;
+
+  typedef void (*RasterizeFn)(RenderTarget &, const SetupTriangle &,
+                              const DrawRecord &, int tileX, int tileY,
+                              RasterizerStats &);
+
+  struct DrawRecord {
+
+    const Vertex *vertices = nullptr;
+    size_t nVertices = 0;
+    const unsigned int *indices = nullptr;
+    size_t nTriangles = 0;
+
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    glm::mat4 viewProjection;
+
+    Material material;
+
+    std::shared_ptr<const void> shader;
+    RasterizeFn rasterize = nullptr;
+
+    size_t firstVertex = 0;
+    size_t firstTriangle = 0;
+  };
+
+  struct Worker {
+
+    std::vector<SetupTriangle> triangles;
+
+    // per tile, indices in triangles
+    std::vector<std::vector<uint32_t>> bins;
+
+    RasterizerStats stats;
+  };
+
+  RasterizerCreateInfo m_createInfo;
+
+  std::unique_ptr<ThreadPool> m_threadPool;
+  std::vector<Worker> m_workers;
+
+  glm::mat4 m_viewProjection = glm::mat4{1.0f};
+
+  std::vector<DrawRecord> m_draws;
+  std::vector<ClipVertex> m_clipVertices;
+
+  RasterizerStats m_stats;
+
+  // range of the vertices of all the draws
+  void transformVertices(size_t begin, size_t end) {
+
+    for (const DrawRecord &draw : m_draws) {
+
+      size_t first = std::max(begin, draw.firstVertex);
+      size_t last = std::min(end, draw.firstVertex + draw.nVertices);
+
+      for (size_t i = first; i < last; ++i) {
+
+        const Vertex &vertex = draw.vertices[i - draw.firstVertex];
+        ClipVertex &out = m_clipVertices[i];
+
+        glm::vec4 world = draw.model * glm::vec4{vertex.position, 1.0f};
+
+        out.clip = draw.viewProjection * world;
+        out.position = glm::vec3{world};
+        out.normal = draw.normalMatrix * vertex.normal;
+        out.texCoords = vertex.texCoords;
+      }
+    }
+  }
+
+  // range of the triangles of all the draws, in submission order
+  void setupTriangles(const RenderTarget &target, Worker &worker,
+                      size_t begin, size_t end) {
+
+    for (size_t d = 0; d < m_draws.size(); ++d) {
+
+      const DrawRecord &draw = m_draws[d];
+
+      size_t first = std::max(begin, draw.firstTriangle);
+      size_t last = std::min(end, draw.firstTriangle + draw.nTriangles);
+
+      for (size_t t = first; t < last; ++t) {
+
+        size_t local = 3 * (t - draw.firstTriangle);
+
+        const ClipVertex *v[3];
+
+        for (size_t k = 0; k < 3; ++k) {
+          size_t index = draw.indices ? draw.indices[local + k] : local + k;
+          v[k] = &m_clipVertices[draw.firstVertex + index];
+        }
+
+        clipTriangle(target, worker, static_cast<uint32_t>(d), *v[0], *v[1],
+                     *v[2]);
+      }
+    }
+  }
+
+  enum Outcode {
+    CLIP_LEFT = 1,
+    CLIP_RIGHT = 2,
+    CLIP_BOTTOM = 4,
+    CLIP_TOP = 8,
+    CLIP_NEAR = 16,
+    CLIP_FAR = 32,
+    CLIP_GUARD_BAND_X = 64,
+    CLIP_GUARD_BAND_Y = 128,
+
+    CLIP_FRUSTUM =
+        CLIP_LEFT | CLIP_RIGHT | CLIP_BOTTOM | CLIP_TOP | CLIP_NEAR | CLIP_FAR,
+    CLIP_NEEDED = CLIP_NEAR | CLIP_GUARD_BAND_X | CLIP_GUARD_BAND_Y
+  };
+
+  static inline int computeOutcode(const glm::vec4 &c) {
+    return (c.x < -c.w ? CLIP_LEFT : 0) | (c.x > c.w ? CLIP_RIGHT : 0) |
+           (c.y < -c.w ? CLIP_BOTTOM : 0) | (c.y > c.w ? CLIP_TOP : 0) |
+           (c.z < -c.w ? CLIP_NEAR : 0) | (c.z > c.w ? CLIP_FAR : 0) |
+           (std::abs(c.x) > GUARD_BAND * c.w ? CLIP_GUARD_BAND_X : 0) |
+           (std::abs(c.y) > GUARD_BAND * c.w ? CLIP_GUARD_BAND_Y : 0);
+  }
+
+  static inline ClipVertex lerp(const ClipVertex &a, const ClipVertex &b,
+                                float t) {
+    ClipVertex v;
+    v.clip = glm::mix(a.clip, b.clip, t);
+    v.position = glm::mix(a.position, b.position, t);
+    v.normal = glm::mix(a.normal, b.normal, t);
+    v.texCoords = glm::mix(a.texCoords, b.texCoords, t);
+    return v;
+  }
+
+  /**
+   * Trivial rejection against the frustum, clipping against the near plane
+   * and the guard band when needed (the other planes are handled by the
+   * bounding boxes and the depth test).
+   */
+  void clipTriangle(const RenderTarget &target, Worker &worker, uint32_t draw,
+                    const ClipVertex &v0, const ClipVertex &v1,
+                    const ClipVertex &v2) {
+
+    int o0 = computeOutcode(v0.clip);
+    int o1 = computeOutcode(v1.clip);
+    int o2 = computeOutcode(v2.clip);
+
+    if (o0 & o1 & o2 & CLIP_FRUSTUM) {
+      return;
+    }
+
+    if (((o0 | o1 | o2) & CLIP_NEEDED) == 0) {
+      setupTriangle(target, worker, draw, v0, v1, v2);
+      return;
+    }
+
+    // signed distances to the clip planes, inside if >= 0
+    const glm::vec4 planes[] = {
+        glm::vec4{0.0f, 0.0f, 1.0f, 1.0f},
+        glm::vec4{-1.0f, 0.0f, 0.0f, GUARD_BAND},
+        glm::vec4{1.0f, 0.0f, 0.0f, GUARD_BAND},
+        glm::vec4{0.0f, -1.0f, 0.0f, GUARD_BAND},
+        glm::vec4{0.0f, 1.0f, 0.0f, GUARD_BAND},
+    };
+
+    // a triangle clipped by 5 planes has at most 8 vertices
+    std::vector<ClipVertex> polygon{v0, v1, v2};
+    std::vector<ClipVertex> clipped;
+
+    for (const glm::vec4 &plane : planes) {
+
+      clipped.clear();
+
+      for (size_t i = 0; i < polygon.size(); ++i) {
+
+        const ClipVertex &a = polygon[i];
+        const ClipVertex &b = polygon[(i + 1) % polygon.size()];
+
+        float da = glm::dot(plane, a.clip);
+        float db = glm::dot(plane, b.clip);
+
+        if (da >= 0.0f) {
+          clipped.push_back(a);
+        }
+
+        if ((da >= 0.0f) != (db >= 0.0f)) {
+          clipped.push_back(lerp(a, b, da / (da - db)));
+        }
+      }
+
+      std::swap(polygon, clipped);
+
+      if (polygon.size() < 3) {
+        return;
+      }
+    }
+
+    for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+      setupTriangle(target, worker, draw, polygon[0], polygon[i],
+                    polygon[i + 1]);
+    }
+  }
+
+  void setupTriangle(const RenderTarget &target, Worker &worker,
+                     uint32_t draw, const ClipVertex &c0, const ClipVertex &c1,
+                     const ClipVertex &c2) {
+
+    const ClipVertex *v[3] = {&c0, &c1, &c2};
+
+    float x[3];
+    float y[3];
+    float z[3];
+    float invW[3];
+
+    float width = static_cast<float>(target.m_width);
+    float height = static_cast<float>(target.m_height);
+
+    for (int i = 0; i < 3; ++i) {
+
+      invW[i] = 1.0f / v[i]->clip.w;
+
+      glm::vec3 ndc = glm::vec3{v[i]->clip} * invW[i];
+
+      x[i] = std::round((ndc.x * 0.5f + 0.5f) * width * SUBPIXEL_STEPS) /
+             SUBPIXEL_STEPS;
+      y[i] = std::round((0.5f - ndc.y * 0.5f) * height * SUBPIXEL_STEPS) /
+             SUBPIXEL_STEPS;
+      z[i] = ndc.z * 0.5f + 0.5f;
+    }
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+    if (area == 0.0f) {
+      return;
+    }
+
+    // y points down, counter-clockwise triangles have a negative area
+    bool frontFacing = area < 0.0f;
+
+    if (m_createInfo.cullBackFaces && !frontFacing) {
+      return;
+    }
+
+    // positive area from here on
+    int order[3] = {0, 1, 2};
+
+    if (area < 0.0f) {
+      std::swap(order[1], order[2]);
+      area = -area;
+    }
+
+    SetupTriangle tri;
+
+    for (int i = 0; i < 3; ++i) {
+      int k = order[i];
+      tri.x[i] = x[k];
+      tri.y[i] = y[k];
+      tri.z[i] = z[k];
+      tri.invW[i] = invW[k];
+      tri.position[i] = v[k]->position;
+      tri.normal[i] = v[k]->normal;
+      tri.texCoords[i] = v[k]->texCoords;
+    }
+
+    float minX = std::min({tri.x[0], tri.x[1], tri.x[2]});
+    float maxX = std::max({tri.x[0], tri.x[1], tri.x[2]});
+    float minY = std::min({tri.y[0], tri.y[1], tri.y[2]});
+    float maxY = std::max({tri.y[0], tri.y[1], tri.y[2]});
+
+    // pixel i has its center at i + 0.5
+    tri.minX = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+    tri.maxX =
+        std::min(target.m_width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+    tri.minY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+    tri.maxY = std::min(target.m_height - 1,
+                        static_cast<int>(std::floor(maxY - 0.5f)));
+
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+      return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+
+      int j = (i + 1) % 3;
+      int k = (i + 2) % 3;
+
+      tri.a[i] = tri.y[j] - tri.y[k];
+      tri.b[i] = tri.x[k] - tri.x[j];
+
+      bool topLeft = tri.a[i] > 0.0f || (tri.a[i] == 0.0f && tri.b[i] > 0.0f);
+
+      // the edge functions are multiples of 1 / SUBPIXEL_STEPS^2
+      tri.threshold[i] =
+          topLeft ? -0.5f / (SUBPIXEL_STEPS * SUBPIXEL_STEPS) : 0.0f;
+    }
+
+    tri.invArea = 1.0f / area;
+    tri.zMin = std::min({tri.z[0], tri.z[1], tri.z[2]});
+    tri.draw = draw;
+
+    uint32_t index = static_cast<uint32_t>(worker.triangles.size());
+    worker.triangles.push_back(tri);
+    ++worker.stats.nRasterizedTriangles;
+
+    int tileMinX = tri.minX / TILE_SIZE;
+    int tileMaxX = tri.maxX / TILE_SIZE;
+    int tileMinY = tri.minY / TILE_SIZE;
+    int tileMaxY = tri.maxY / TILE_SIZE;
+
+    bool singleTile = tileMinX == tileMaxX && tileMinY == tileMaxY;
+
+    for (int tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+      for (int tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+
+        if (singleTile || overlapsRect(tri, tileX * TILE_SIZE,
+                                       tileY * TILE_SIZE, TILE_SIZE)) {
+          worker.bins[tileY * target.m_tilesX + tileX].push_back(index);
+        }
+      }
+    }
+  }
+
+  // edge function at the pixel center (px + 0.5, py + 0.5), exact
+  static inline double evaluateEdge(const SetupTriangle &tri, int i, int px,
+                                    int py) {
+    int j = (i + 1) % 3;
+    return static_cast<double>(tri.a[i]) * (px + 0.5 - tri.x[j]) +
+           static_cast<double>(tri.b[i]) * (py + 0.5 - tri.y[j]);
+  }
+
+  // false if a size x size rect of pixels is outside of an edge
+  static inline bool overlapsRect(const SetupTriangle &tri, int px, int py,
+                                  int size) {
+
+    for (int i = 0; i < 3; ++i) {
+
+      double e = evaluateEdge(tri, i, px, py);
+      double maxE = e + std::max(tri.a[i], 0.0f) * (size - 1) +
+                    std::max(tri.b[i], 0.0f) * (size - 1);
+
+      if (maxE <= tri.threshold[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void rasterizeTile(RenderTarget &target, int tile, RasterizerStats &stats) {
+
+    int tileX = tile % target.m_tilesX;
+    int tileY = tile / target.m_tilesX;
+
+    for (const Worker &worker : m_workers) {
+      for (uint32_t index : worker.bins[tile]) {
+
+        const SetupTriangle &tri = worker.triangles[index];
+        const DrawRecord &draw = m_draws[tri.draw];
+
+        draw.rasterize(target, tri, draw, tileX, tileY, stats);
+      }
+    }
+  }
+
+  template <typename Shader>
+  static void rasterizeTriangle(RenderTarget &target, const SetupTriangle &tri,
+                                const DrawRecord &draw, int tileX, int tileY,
+                                RasterizerStats &stats) {
+
+    const Shader &shader = *static_cast<const Shader *>(draw.shader.get());
+
+    int x0 = std::max(tri.minX, tileX * TILE_SIZE);
+    int x1 = std::min(tri.maxX, tileX * TILE_SIZE + TILE_SIZE - 1);
+    int y0 = std::max(tri.minY, tileY * TILE_SIZE);
+    int y1 = std::min(tri.maxY, tileY * TILE_SIZE + TILE_SIZE - 1);
+
+    // depth gradients
+    float dzdx = (tri.a[0] * tri.z[0] + tri.a[1] * tri.z[1] +
+                  tri.a[2] * tri.z[2]) *
+                 tri.invArea;
+    float dzdy = (tri.b[0] * tri.z[0] + tri.b[1] * tri.z[1] +
+                  tri.b[2] * tri.z[2]) *
+                 tri.invArea;
+
+    constexpr int LAST = BLOCK_SIZE - 1;
+
+    for (int by = y0 / BLOCK_SIZE * BLOCK_SIZE; by <= y1; by += BLOCK_SIZE) {
+      for (int bx = x0 / BLOCK_SIZE * BLOCK_SIZE; bx <= x1; bx += BLOCK_SIZE) {
+
+        float e[3];
+        bool covered = true;
+        bool outside = false;
+
+        for (int i = 0; i < 3; ++i) {
+
+          double edge = evaluateEdge(tri, i, bx, by);
+
+          double minE = edge + std::min(tri.a[i], 0.0f) * LAST +
+                        std::min(tri.b[i], 0.0f) * LAST;
+          double maxE = edge + std::max(tri.a[i], 0.0f) * LAST +
+                        std::max(tri.b[i], 0.0f) * LAST;
+
+          outside = outside || maxE <= tri.threshold[i];
+          covered = covered && minE > tri.threshold[i];
+
+          e[i] = static_cast<float>(edge);
+        }
+
+        if (outside) {
+          continue;
+        }
+
+        ++stats.nTestedBlocks;
+
+        // nearest depth of the triangle in the block
+        float z = (e[0] * tri.z[0] + e[1] * tri.z[1] + e[2] * tri.z[2]) *
+                  tri.invArea;
+        float zNear = std::max(tri.zMin, z + std::min(dzdx, 0.0f) * LAST +
+                                             std::min(dzdy, 0.0f) * LAST);
+
+        float &blockMaxDepth =
+            target.m_blockMaxDepth[(by / BLOCK_SIZE) * target.m_blocksX +
+                                   bx / BLOCK_SIZE];
+
+        if (zNear >= blockMaxDepth) {
+          ++stats.nCulledBlocks;
+          continue;
+        }
+
+        rasterizeBlock(target, tri, draw, shader, e, covered, bx, by,
+                       std::max(x0, bx), std::min(x1, bx + LAST),
+                       std::max(y0, by), std::min(y1, by + LAST),
+                       blockMaxDepth, stats);
+      }
+    }
+  }
+
+  /**
+   * The pixels [minX, maxX] x [minY, maxY] of the block at (bx, by), e are
+   * the edge functions at its first pixel. 'covered' if the block is inside
+   * the three edges.
+   */
+  template <typename Shader>
+  static void rasterizeBlock(RenderTarget &target, const SetupTriangle &tri,
+                             const DrawRecord &draw, const Shader &shader,
+                             const float e[3], bool covered, int bx, int by,
+                             int minX, int maxX, int minY, int maxY,
+                             float &blockMaxDepth, RasterizerStats &stats) {
+
+    const Float4 steps{0.0f, 1.0f, 2.0f, 3.0f};
+
+    Float4 stepA[3];
+    Float4 threshold[3];
+
+    for (int i = 0; i < 3; ++i) {
+      stepA[i] = Float4{tri.a[i]} * steps;
+      threshold[i] = Float4{tri.threshold[i]};
+    }
+
+    Float4 invArea{tri.invArea};
+
+    bool written = false;
+
+    for (int py = minY; py <= maxY; ++py) {
+
+      float *depthRow = &target.m_depth[static_cast<size_t>(py) *
+                                        target.m_stride];
+      uint32_t *colorRow = target.hasColor()
+                               ? &target.m_color[static_cast<size_t>(py) *
+                                                 target.m_stride]
+                               : nullptr;
+
+      for (int gx = bx; gx < bx + BLOCK_SIZE; gx += 4) {
+
+        if (gx + 3 < minX || gx > maxX) {
+          continue;
+        }
+
+        // the group's pixels inside [minX, maxX]
+        int mask = 0xf;
+        if (gx < minX) {
+          mask &= 0xf << (minX - gx);
+        }
+        if (gx + 3 > maxX) {
+          mask &= 0xf >> (gx + 3 - maxX);
+        }
+
+        Float4 edge[3];
+
+        for (int i = 0; i < 3; ++i) {
+
+          // exact: small multiples of 1 / SUBPIXEL_STEPS^2 near the edges
+          float origin = e[i] + tri.a[i] * static_cast<float>(gx - bx) +
+                         tri.b[i] * static_cast<float>(py - by);
+
+          edge[i] = Float4{origin} + stepA[i];
+
+          if (!covered) {
+            mask &= greaterMask(edge[i], threshold[i]);
+          }
+        }
+
+        if (mask == 0) {
+          continue;
+        }
+
+        Float4 l0 = edge[0] * invArea;
+        Float4 l1 = edge[1] * invArea;
+        Float4 l2 = edge[2] * invArea;
+
+        Float4 z = l0 * Float4{tri.z[0]} + l1 * Float4{tri.z[1]} +
+                   l2 * Float4{tri.z[2]};
+
+        mask &= lessMask(z, Float4::load(depthRow + gx));
+
+        if (mask == 0) {
+          continue;
+        }
+
+        float zs[4];
+        float lambda[3][4];
+
+        z.store(zs);
+        l0.store(lambda[0]);
+        l1.store(lambda[1]);
+        l2.store(lambda[2]);
+
+        for (int lane = 0; lane < 4; ++lane) {
+
+          if ((mask & (1 << lane)) == 0) {
+            continue;
+          }
+
+          int px = gx + lane;
+
+          depthRow[px] = zs[lane];
+          written = true;
+          ++stats.nShadedPixels;
+
+          if constexpr (Shader::WRITES_COLOR) {
+
+            Fragment fragment = interpolate(
+                tri, lambda[0][lane], lambda[1][lane], lambda[2][lane]);
+
+            glm::vec3 color = shader(fragment, draw.material);
+
+            colorRow[px] = packColor(glm::vec4{color, 1.0f});
+          }
+        }
+      }
+    }
+
+    if (written) {
+
+      float maxDepth = 0.0f;
+
+      for (int py = by; py < by + BLOCK_SIZE; ++py) {
+        const float *depthRow =
+            &target.m_depth[static_cast<size_t>(py) * target.m_stride];
+        for (int px = bx; px < bx + BLOCK_SIZE; ++px) {
+          maxDepth = std::max(maxDepth, depthRow[px]);
+        }
+      }
+
+      blockMaxDepth = maxDepth;
+    }
+  }
+
+  /**
+   * Perspective correct attributes at the screen space barycentrics l, and
+   * the derivatives of the texture coordinates one pixel to the right and
+   * down.
+   */
+  static inline Fragment interpolate(const SetupTriangle &tri, float l0,
+                                     float l1, float l2) {
+
+    auto perspective = [&tri](float s0, float s1, float s2, glm::vec3 &w) {
+      float p0 = s0 * tri.invW[0];
+      float p1 = s1 * tri.invW[1];
+      float p2 = s2 * tri.invW[2];
+      float invSum = 1.0f / (p0 + p1 + p2);
+      w = glm::vec3{p0, p1, p2} * invSum;
+    };
+
+    glm::vec3 w;
+    perspective(l0, l1, l2, w);
+
+    glm::vec3 wx;
+    perspective(l0 + tri.a[0] * tri.invArea, l1 + tri.a[1] * tri.invArea,
+                l2 + tri.a[2] * tri.invArea, wx);
+
+    glm::vec3 wy;
+    perspective(l0 + tri.b[0] * tri.invArea, l1 + tri.b[1] * tri.invArea,
+                l2 + tri.b[2] * tri.invArea, wy);
+
+    Fragment fragment;
+
+    fragment.position = w.x * tri.position[0] + w.y * tri.position[1] +
+                        w.z * tri.position[2];
+    fragment.normal =
+        w.x * tri.normal[0] + w.y * tri.normal[1] + w.z * tri.normal[2];
+    fragment.texCoords = w.x * tri.texCoords[0] + w.y * tri.texCoords[1] +
+                         w.z * tri.texCoords[2];
+
+    glm::vec2 texCoordsX = wx.x * tri.texCoords[0] + wx.y * tri.texCoords[1] +
+                           wx.z * tri.texCoords[2];
+    glm::vec2 texCoordsY = wy.x * tri.texCoords[0] + wy.y * tri.texCoords[1] +
+                           wy.z * tri.texCoords[2];
+
+    fragment.dTexCoordsDx = texCoordsX - fragment.texCoords;
+    fragment.dTexCoordsDy = texCoordsY - fragment.texCoords;
+
+    return fragment;
+  }
+};
+
+} // namespace swr
+
+#endif // SOFTWARE_RASTERIZER_H
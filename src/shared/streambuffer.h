@@ -0,0 +1,147 @@
+#ifndef GPU_STREAM_BUFFER_H
+#define GPU_STREAM_BUFFER_H
+
+#include "buffer.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gpu {
+
+// the cpu writes one region while the gpu may still read the previous ones
+constexpr unsigned int STREAM_BUFFER_REGIONS = 3;
+
+/**
+ * Buffer for data rewritten every frame: immutable storage mapped once,
+ * persistent and coherent, split in regions used in turn. Per frame:
+ *
+ *  void *data = buffer.beginRegion();    waits for the gpu to be done
+ *  ... write the region ...               with this region, if needed
+ *  ... draw reading getRegionOffset() ...
+ *  buffer.endRegion();                   fence, next region
+ *
+ * No glBufferSubData copy and no orphaning: the cpu writes straight into
+ * memory the gpu reads, the fences only stall when the cpu is more than
+ * nRegions - 1 frames ahead (getNumStalls()).
+ */
+class StreamBuffer : public Buffer {
+
+public:
+  StreamBuffer() {}
+
+  StreamBuffer(size_t regionSizeBytes,
+               unsigned int nRegions = STREAM_BUFFER_REGIONS)
+      : m_regionSize(regionSizeBytes), m_nRegions(nRegions),
+        m_fences(nRegions, nullptr) {
+
+    m_size = m_regionSize * m_nRegions;
+
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &m_ID);
+    glNamedBufferStorage(m_ID, m_size, nullptr, flags);
+
+    m_mapped =
+        static_cast<uint8_t *>(glMapNamedBufferRange(m_ID, 0, m_size, flags));
+
+    if (m_mapped == nullptr) {
+
+      std::string message = "Could not map stream buffer of " +
+                            std::to_string(m_size) + " bytes";
+
+      glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0,
+                           GL_DEBUG_SEVERITY_HIGH, message.length(),
+                           message.c_str());
+    }
+  }
+
+  /**
+   * Pointer to the current region, once the commands that read it the last
+   * time it was used have completed. nullptr if the buffer couldn't be
+   * mapped, there is nothing to write to.
+   */
+  void *beginRegion() {
+
+    if (m_mapped == nullptr) {
+      return nullptr;
+    }
+
+    GLsync &fence = m_fences[m_region];
+
+    if (fence != nullptr) {
+
+      GLenum result = glClientWaitSync(fence, 0, 0);
+
+      if (result == GL_TIMEOUT_EXPIRED) {
+
+        ++m_nStalls;
+
+        // the flush makes sure the fence is eventually signaled
+        do {
+          result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+      }
+
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+
+    return m_mapped + getRegionOffset();
+  }
+
+  // after the commands reading the current region
+  void endRegion() {
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % m_nRegions;
+  }
+
+  inline size_t getRegionOffset() const { return m_region * m_regionSize; }
+
+  inline unsigned int getRegionIndex() const { return m_region; }
+
+  inline size_t getRegionSize() const { return m_regionSize; }
+
+  inline size_t getSize() const { return m_size; }
+
+  inline bool isMapped() const { return m_mapped != nullptr; }
+
+  // beginRegion() calls that had to wait for the gpu
+  inline size_t getNumStalls() const { return m_nStalls; }
+
+  virtual void destroy() override {
+
+    for (GLsync &fence : m_fences) {
+      if (fence != nullptr) {
+        glDeleteSync(fence);
+        fence = nullptr;
+      }
+    }
+
+    if (m_mapped != nullptr) {
+      glUnmapNamedBuffer(m_ID);
+      m_mapped = nullptr;
+    }
+
+    Buffer::destroy();
+  }
+
+private:
+  size_t m_regionSize = 0;
+  unsigned int m_nRegions = 0;
+  unsigned int m_region = 0;
+
+  uint8_t *m_mapped = nullptr;
+
+  std::vector<GLsync> m_fences;
+
+  size_t m_nStalls = 0;
+};
+
+} // namespace gpu
+
+#endif // GPU_STREAM_BUFFER_H
@@ -1,6 +1,7 @@
 #ifndef GPU_TEXTURE_H
 #define GPU_TEXTURE_H
 
+#include "cpuprofiler.h"
 #include "gpuconstants.h"
 #include "gpuobject.h"
 #include "resources.h"
@@ -76,8 +77,22 @@ public:
                          glm::value_ptr(borderColor));
   }
 
+  /**
+   * Depth textures only: sampled through a shadow sampler, texture() returns
+   * the (filtered) result of the depth comparison instead of the depth.
+   */
+  inline void setDepthCompare(bool enabled) {
+    glTextureParameteri(m_ID, GL_TEXTURE_COMPARE_MODE,
+                        enabled ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE);
+    glTextureParameteri(m_ID, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  }
+
   inline void generateMipmap() { glGenerateTextureMipmap(m_ID); }
 
+  inline size_t getWidth() const { return m_width; }
+  inline size_t getHeight() const { return m_height; }
+  inline GLuint getInternalFormat() const { return m_internalFormat; }
+
   virtual void destroy() override {
     glDeleteTextures(1, &m_ID);
     m_ID = 0;
@@ -88,6 +103,8 @@ protected:
 
   UniqueTextureData loadTexture(const std::string &path, bool flipY) {
 
+    CPU_PROFILE_ZONE("Texture::loadTexture");
+
     stbi_set_flip_vertically_on_load(flipY);
 
     int nrChannels;
@@ -151,7 +168,31 @@ GLuint internalFormatFromFormat(GLuint format) {
   case GL_RGBA:
     return GL_RGBA8;
   case GL_R:
+  case GL_RED:
     return GL_R8;
+  case GL_RG:
+    return GL_RG8;
+
+  // already sized (render targets), nothing to translate
+  case GL_R8:
+  case GL_RG8:
+  case GL_RGB8:
+  case GL_RGBA8:
+  case GL_RG16_SNORM:
+  case GL_R16F:
+  case GL_RG16F:
+  case GL_RGBA16F:
+  case GL_R32F:
+  case GL_RG32F:
+  case GL_RGBA32F:
+  case GL_R11F_G11F_B10F:
+  case GL_RGB10_A2:
+  case GL_DEPTH_COMPONENT16:
+  case GL_DEPTH_COMPONENT24:
+  case GL_DEPTH_COMPONENT32F:
+  case GL_DEPTH24_STENCIL8:
+    return format;
+
   default:
 
     std::stringstream ss;
@@ -168,6 +209,40 @@ GLuint internalFormatFromFormat(GLuint format) {
   }
 }
 
+/**
+ * Approximate size of a texel of a sized internal format, used to report
+ * render target memory. 3 component formats are assumed to be padded to 4.
+ */
+inline size_t bytesPerTexel(GLuint internalFormat) {
+
+  switch (internalFormat) {
+  case GL_R8:
+    return 1;
+  case GL_RG8:
+  case GL_R16F:
+  case GL_DEPTH_COMPONENT16:
+    return 2;
+  case GL_RGB8:
+  case GL_RGBA8:
+  case GL_RG16_SNORM:
+  case GL_RG16F:
+  case GL_R32F:
+  case GL_R11F_G11F_B10F:
+  case GL_RGB10_A2:
+  case GL_DEPTH_COMPONENT24:
+  case GL_DEPTH_COMPONENT32F:
+  case GL_DEPTH24_STENCIL8:
+    return 4;
+  case GL_RGBA16F:
+  case GL_RG32F:
+    return 8;
+  case GL_RGBA32F:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
 } // namespace texture
 
 } // namespace gpu
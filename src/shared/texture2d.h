@@ -1,6 +1,7 @@
 #ifndef GPU_TEXTURE_2D_H
 #define GPU_TEXTURE_2D_H
 
+#include "cpuprofiler.h"
 #include "gpuconstants.h"
 #include "resources.h"
 #include "texture.h"
@@ -23,6 +24,8 @@ public:
 
   Texture2D(const std::string &textureName) {
 
+    CPU_PROFILE_ZONE("Texture2D::Texture2D");
+
     glCreateTextures(GL_TEXTURE_2D, 1, &m_ID);
 
     UniqueTextureData texData = loadTexture(getTexturePath(textureName), true);
@@ -40,7 +43,8 @@ public:
     }
   }
 
-  Texture2D(int width, int height, unsigned int format) {
+  // levels > 1: storage for the mip chain, eg. filled with generateMipmap()
+  Texture2D(int width, int height, unsigned int format, int levels = 1) {
 
     m_width = width;
     m_height = height;
@@ -48,7 +52,7 @@ public:
     m_internalFormat = internalFormatFromFormat(format);
 
     glCreateTextures(GL_TEXTURE_2D, 1, &m_ID);
-    glTextureStorage2D(m_ID, 1, m_internalFormat, width, height);
+    glTextureStorage2D(m_ID, levels, m_internalFormat, width, height);
   }
 
   void subImage(size_t x, size_t y, size_t width, size_t height,
@@ -0,0 +1,40 @@
+#ifndef GPU_TEXTURE_2D_ARRAY_H
+#define GPU_TEXTURE_2D_ARRAY_H
+
+#include "gpuconstants.h"
+#include "texture.h"
+
+#include <glad/glad.h>
+
+namespace gpu {
+
+namespace texture {
+
+class Texture2DArray : public Texture {
+
+public:
+  Texture2DArray() {}
+
+  Texture2DArray(int width, int height, int layers, unsigned int format)
+      : m_layers(layers) {
+
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    m_internalFormat = internalFormatFromFormat(format);
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_ID);
+    glTextureStorage3D(m_ID, 1, m_internalFormat, width, height, layers);
+  }
+
+  inline int getLayers() const { return m_layers; }
+
+private:
+  int m_layers = 0;
+};
+
+} // namespace texture
+
+} // namespace gpu
+
+#endif // GPU_TEXTURE_2D_ARRAY_H
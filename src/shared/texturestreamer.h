@@ -0,0 +1,853 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "bounds.h"
+#include "filesystem.h"
+#include "flycamera.h"
+#include "jobsystem.h"
+#include "mesh.h"
+#include "model.h"
+#include "resources.h"
+#include "texture2d.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace streaming {
+
+// "MIPS", then the version of the cache file layout
+constexpr uint32_t MIP_CACHE_MAGIC = 0x5350494d;
+constexpr uint32_t MIP_CACHE_VERSION = 1;
+
+// streamed textures are RGBA8, whatever the format of the source
+constexpr size_t STREAMED_TEXEL_SIZE = 4;
+
+// of the budget pass: textures outside of the frustum are evicted first
+constexpr float OFFSCREEN_PRIORITY_SCALE = 0.01f;
+
+inline int levelSize(int size, int level) {
+  return std::max(1, size >> level);
+}
+
+inline int countLevels(int width, int height) {
+  int nLevels = 1;
+  while ((std::max(width, height) >> nLevels) > 0) {
+    ++nLevels;
+  }
+  return nLevels;
+}
+
+inline size_t levelBytes(int width, int height, int level) {
+  return static_cast<size_t>(levelSize(width, level)) *
+         static_cast<size_t>(levelSize(height, level)) * STREAMED_TEXEL_SIZE;
+}
+
+// levels [first, last) of the chain
+inline size_t levelRangeBytes(int width, int height, int first, int last) {
+  size_t bytes = 0;
+  for (int level = first; level < last; ++level) {
+    bytes += levelBytes(width, height, level);
+  }
+  return bytes;
+}
+
+/**
+ * A mip chain cache file: the header, then the levels from 0 to nLevels - 1
+ * tightly packed, so any range of levels is one contiguous read.
+ */
+struct MipCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t nLevels;
+  int32_t padding;
+  // of the source image, a change rebuilds the cache
+  int64_t sourceTime;
+};
+
+/**
+ * Box filtered mip chain of an RGBA8 image, level 0 included. Odd sizes
+ * clamp the last row and column.
+ */
+inline std::vector<uint8_t> buildMipChain(const uint8_t *texels, int width,
+                                          int height) {
+
+  int nLevels = countLevels(width, height);
+
+  std::vector<uint8_t> chain(levelRangeBytes(width, height, 0, nLevels));
+  std::copy(texels, texels + levelBytes(width, height, 0), chain.begin());
+
+  size_t srcOffset = 0;
+
+  for (int level = 1; level < nLevels; ++level) {
+
+    int srcWidth = levelSize(width, level - 1);
+    int srcHeight = levelSize(height, level - 1);
+    int dstWidth = levelSize(width, level);
+    int dstHeight = levelSize(height, level);
+
+    size_t dstOffset = srcOffset + levelBytes(width, height, level - 1);
+
+    const uint8_t *src = chain.data() + srcOffset;
+    uint8_t *dst = chain.data() + dstOffset;
+
+    for (int y = 0; y < dstHeight; ++y) {
+
+      int y0 = std::min(2 * y, srcHeight - 1);
+      int y1 = std::min(2 * y + 1, srcHeight - 1);
+
+      for (int x = 0; x < dstWidth; ++x) {
+
+        int x0 = std::min(2 * x, srcWidth - 1);
+        int x1 = std::min(2 * x + 1, srcWidth - 1);
+
+        for (int c = 0; c < 4; ++c) {
+
+          unsigned int sum = src[(y0 * srcWidth + x0) * 4 + c] +
+                             src[(y0 * srcWidth + x1) * 4 + c] +
+                             src[(y1 * srcWidth + x0) * 4 + c] +
+                             src[(y1 * srcWidth + x1) * 4 + c];
+
+          dst[(y * dstWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+        }
+      }
+    }
+
+    srcOffset = dstOffset;
+  }
+
+  return chain;
+}
+
+/**
+ * Reads the levels [first, last) of a cache file into texels, false if the
+ * file doesn't match the expected size. Safe to call from any thread.
+ */
+inline bool readMipLevels(const std::string &path, int width, int height,
+                          int first, int last, std::vector<uint8_t> &texels) {
+
+  std::ifstream file{path, std::ios::binary};
+
+  if (!file) {
+    return false;
+  }
+
+  MipCacheHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  if (!file || header.magic != MIP_CACHE_MAGIC ||
+      header.version != MIP_CACHE_VERSION || header.width != width ||
+      header.height != height || last > header.nLevels) {
+    return false;
+  }
+
+  texels.resize(levelRangeBytes(width, height, first, last));
+
+  file.seekg(sizeof(header) + levelRangeBytes(width, height, 0, first));
+  file.read(reinterpret_cast<char *>(texels.data()), texels.size());
+
+  return static_cast<bool>(file);
+}
+
+struct TextureStreamerCreateInfo {
+
+  TextureStreamerCreateInfo() {}
+
+  // of all the streamed levels, the tails are kept even over the budget
+  size_t budget = 64 * 1024 * 1024;
+
+  // levels of this size and below are always resident
+  int tailSize = 64;
+
+  // > 0: sharper than the screen footprint asks for
+  float lodBias = 0.0f;
+
+  // cache file reads queued on the job system at a time
+  size_t maxLoadsInFlight = 2;
+
+  // where the mip chain caches are written, next to the executable if empty
+  std::string cacheDirectory;
+};
+
+struct TextureStreamerStats {
+  // of the resident levels of the streamed textures
+  size_t residentBytes = 0;
+  // if all their levels were resident
+  size_t fullBytes = 0;
+  // what the screen footprints ask for, before the budget
+  size_t wantedBytes = 0;
+
+  size_t nLoading = 0;
+  size_t nLoads = 0;
+  size_t nEvictions = 0;
+};
+
+/**
+ * Keeps the mip levels of model textures resident as far as their screen
+ * footprint needs them, within a memory budget.
+ *
+ * addModel() registers the textures of a model: a mip chain cache file is
+ * written for each of them (once, from the texture Model loaded), and the
+ * texture is replaced by one with the tail of its chain only. The
+ * MeshTextures of the model are pointed to the streamed textures from then
+ * on, so the model has to outlive the streamer and keep its meshes.
+ *
+ * update() once per frame:
+ *
+ *  - the level each texture needs is estimated from the uv density of the
+ *    meshes using it (texels per world unit) and their distance to the
+ *    camera (pixels per world unit), the finest over its meshes.
+ *  - while the levels needed go over the budget, the texture that loses
+ *    the least drops a level: the one with the smallest screen area, scaled
+ *    down outside the frustum and up for each level already dropped.
+ *  - finer levels are read from the cache files by jobs, and uploaded once
+ *    read. Coarser ones are dropped right away.
+ *
+ * Immutable storage can't grow or shrink, and neither GL_TEXTURE_BASE_LEVEL
+ * nor a texture view frees the levels they hide: a residency change creates
+ * a texture with the new chain, copies the levels both have on the gpu
+ * (glCopyImageSubData) and deletes the previous one.
+ */
+class TextureStreamer {
+
+public:
+  TextureStreamer(
+      const TextureStreamerCreateInfo &createInfo = TextureStreamerCreateInfo{},
+      jobs::JobSystem &jobSystem = jobs::getJobSystem())
+      : m_budget(createInfo.budget), m_tailSize(createInfo.tailSize),
+        m_lodBias(createInfo.lodBias),
+        m_maxLoadsInFlight(std::max<size_t>(createInfo.maxLoadsInFlight, 1)),
+        m_cacheDirectory(createInfo.cacheDirectory), m_jobSystem(jobSystem) {
+
+    if (m_cacheDirectory.empty()) {
+      m_cacheDirectory = getExecPath().append("texturecache").string();
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_cacheDirectory, error);
+  }
+
+  TextureStreamer(const TextureStreamer &) = delete;
+  TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+  /**
+   * Streams the textures of the meshes of model, placed by transform. A
+   * texture shared with a model added before is streamed once.
+   */
+  void addModel(Model &model, const glm::mat4 &transform = glm::mat4{1.0f}) {
+
+    CPU_PROFILE_ZONE("TextureStreamer::addModel");
+
+    for (size_t i = 0; i < model.m_meshes.size(); ++i) {
+
+      Mesh &mesh = model.m_meshes[i];
+      glm::mat4 meshTransform = transform * model.getMeshTransform(i);
+
+      StreamedMesh streamedMesh;
+      streamedMesh.bounds =
+          transformAABB(computeAABB(mesh), meshTransform);
+      computeDensity(mesh, meshTransform, streamedMesh);
+
+      for (MeshTexture &meshTexture : mesh.m_textures) {
+
+        size_t index = findOrAddTexture(meshTexture);
+
+        if (index == NOT_STREAMED) {
+          continue;
+        }
+
+        StreamedTexture &texture = *m_textures[index];
+
+        texture.users.push_back(&meshTexture);
+        meshTexture.texture = texture.texture;
+
+        streamedMesh.textures.push_back(index);
+      }
+
+      if (!streamedMesh.textures.empty()) {
+        m_meshes.push_back(streamedMesh);
+      }
+    }
+  }
+
+  // viewportHeight: in pixels, of the view the camera renders
+  void update(FlyCamera &camera, int viewportHeight) {
+
+    CPU_PROFILE_ZONE("TextureStreamer::update");
+
+    computeWantedLevels(camera, viewportHeight);
+    applyBudget();
+
+    // finished loads first, they free their slots for the new ones
+    for (std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      if (texture->load && texture->load->counter.isDone()) {
+        finishLoad(*texture);
+      }
+    }
+
+    for (std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      if (!texture->load && texture->targetLevel > texture->residentLevel) {
+        reallocate(*texture, texture->targetLevel, nullptr);
+        ++m_stats.nEvictions;
+      }
+    }
+
+    startLoads();
+
+    m_stats.residentBytes = 0;
+    m_stats.nLoading = 0;
+
+    for (const std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      m_stats.residentBytes += texture->getBytes(texture->residentLevel);
+      m_stats.nLoading += texture->load ? 1 : 0;
+    }
+  }
+
+  inline void setBudget(size_t budget) { m_budget = budget; }
+  inline size_t getBudget() const { return m_budget; }
+
+  inline size_t getNumTextures() const { return m_textures.size(); }
+
+  inline const TextureStreamerStats &getStats() const { return m_stats; }
+
+  // waits for the loads in flight, the model textures are deleted
+  void destroy() {
+
+    for (std::unique_ptr<StreamedTexture> &texture : m_textures) {
+
+      if (texture->load) {
+        m_jobSystem.wait(texture->load->counter);
+      }
+
+      texture->texture.destroy();
+    }
+
+    m_textures.clear();
+    m_meshes.clear();
+    m_texturesByPath.clear();
+  }
+
+private:
+  static constexpr size_t NOT_STREAMED = static_cast<size_t>(-1);
+
+  struct LoadRequest {
+    // levels [firstLevel, lastLevel) read from the cache file
+    int firstLevel = 0;
+    int lastLevel = 0;
+
+    std::vector<uint8_t> texels;
+    bool succeeded = false;
+
+    jobs::Counter counter;
+  };
+
+  struct StreamedTexture {
+    std::string path;
+    std::string file;
+    std::string cachePath;
+
+    int width = 0;
+    int height = 0;
+    int nLevels = 0;
+
+    // first level of the tail, always resident
+    int tailLevel = 0;
+
+    // the texture holds the levels [residentLevel, nLevels)
+    int residentLevel = 0;
+    // what the screen footprint asks for, and what the budget allows
+    int wantedLevel = 0;
+    int targetLevel = 0;
+
+    float priority = 0.0f;
+
+    gpu::texture::Texture2D texture;
+
+    // the MeshTextures drawn with it
+    std::vector<MeshTexture *> users;
+
+    std::unique_ptr<LoadRequest> load;
+
+    inline size_t getBytes(int firstLevel) const {
+      return levelRangeBytes(width, height, firstLevel, nLevels);
+    }
+  };
+
+  struct StreamedMesh {
+    // world space
+    AABB bounds;
+    float area = 0.0f;
+    // uv units per world unit
+    float uvDensity = 0.0f;
+
+    std::vector<size_t> textures;
+  };
+
+  size_t m_budget;
+  int m_tailSize;
+  float m_lodBias;
+  size_t m_maxLoadsInFlight;
+
+  std::string m_cacheDirectory;
+
+  jobs::JobSystem &m_jobSystem;
+
+  // the loads point into them, they don't move
+  std::vector<std::unique_ptr<StreamedTexture>> m_textures;
+  std::map<std::string, size_t> m_texturesByPath;
+
+  std::vector<StreamedMesh> m_meshes;
+
+  TextureStreamerStats m_stats;
+
+  // sqrt(uv area / world area) over the triangles of the mesh
+  static void computeDensity(const Mesh &mesh, const glm::mat4 &transform,
+                             StreamedMesh &streamedMesh) {
+
+    size_t nVertices = mesh.getNumVertices();
+
+    double worldArea = 0.0;
+    double uvArea = 0.0;
+
+    for (size_t v = 0; v + 2 < nVertices; v += 3) {
+
+      const Vertex *triangle[3];
+
+      for (size_t k = 0; k < 3; ++k) {
+        size_t index = mesh.isIndexed() ? mesh.m_indices[v + k] : v + k;
+        triangle[k] = &mesh.m_vertices[index];
+      }
+
+      glm::vec3 p0 = glm::vec3{transform * glm::vec4{triangle[0]->position, 1}};
+      glm::vec3 p1 = glm::vec3{transform * glm::vec4{triangle[1]->position, 1}};
+      glm::vec3 p2 = glm::vec3{transform * glm::vec4{triangle[2]->position, 1}};
+
+      glm::vec2 uv1 = triangle[1]->texCoords - triangle[0]->texCoords;
+      glm::vec2 uv2 = triangle[2]->texCoords - triangle[0]->texCoords;
+
+      worldArea += 0.5 * glm::length(glm::cross(p1 - p0, p2 - p0));
+      uvArea += 0.5 * std::abs(uv1.x * uv2.y - uv1.y * uv2.x);
+    }
+
+    streamedMesh.area = static_cast<float>(worldArea);
+    streamedMesh.uvDensity =
+        worldArea > 0.0 ? static_cast<float>(std::sqrt(uvArea / worldArea))
+                        : 0.0f;
+  }
+
+  // hashed on the source file, two models can use the same texture name
+  std::string getCachePath(const std::string &file) const {
+
+    std::stringstream ss;
+    ss << std::filesystem::path{file}.stem().string() << "-" << std::hex
+       << std::hash<std::string>{}(file) << ".mips";
+
+    return (std::filesystem::path{m_cacheDirectory} / ss.str()).string();
+  }
+
+  static int64_t getSourceTime(const std::string &file) {
+
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(file, error);
+
+    return error ? 0
+                 : static_cast<int64_t>(time.time_since_epoch().count());
+  }
+
+  // true if the cache file of texture is there and up to date
+  static bool isCacheValid(const StreamedTexture &texture,
+                           int64_t sourceTime) {
+
+    std::ifstream file{texture.cachePath, std::ios::binary};
+
+    if (!file) {
+      return false;
+    }
+
+    MipCacheHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    return file && header.magic == MIP_CACHE_MAGIC &&
+           header.version == MIP_CACHE_VERSION &&
+           header.width == texture.width && header.height == texture.height &&
+           header.nLevels == texture.nLevels && header.sourceTime == sourceTime;
+  }
+
+  // the chain of the texture Model loaded (level 0 only)
+  static bool writeCache(const StreamedTexture &texture, GLuint source,
+                         int64_t sourceTime) {
+
+    CPU_PROFILE_ZONE("TextureStreamer::writeCache");
+
+    std::vector<uint8_t> texels(levelBytes(texture.width, texture.height, 0));
+
+    glGetTextureImage(source, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                      static_cast<GLsizei>(texels.size()), texels.data());
+
+    std::vector<uint8_t> chain =
+        buildMipChain(texels.data(), texture.width, texture.height);
+
+    std::ofstream file{texture.cachePath, std::ios::binary};
+
+    if (!file) {
+      return false;
+    }
+
+    MipCacheHeader header{MIP_CACHE_MAGIC, MIP_CACHE_VERSION, texture.width,
+                          texture.height, texture.nLevels, 0, sourceTime};
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(chain.data()), chain.size());
+
+    return static_cast<bool>(file);
+  }
+
+  size_t findOrAddTexture(MeshTexture &meshTexture) {
+
+    if (meshTexture.path.empty() || meshTexture.file.empty()) {
+      return NOT_STREAMED;
+    }
+
+    auto it = m_texturesByPath.find(meshTexture.path);
+
+    if (it != m_texturesByPath.end()) {
+      return it->second;
+    }
+
+    std::unique_ptr<StreamedTexture> texture =
+        std::make_unique<StreamedTexture>();
+
+    texture->path = meshTexture.path;
+    texture->file = meshTexture.file;
+    texture->cachePath = getCachePath(meshTexture.file);
+    texture->width = static_cast<int>(meshTexture.texture.getWidth());
+    texture->height = static_cast<int>(meshTexture.texture.getHeight());
+    texture->nLevels = countLevels(texture->width, texture->height);
+
+    while (texture->tailLevel < texture->nLevels - 1 &&
+           std::max(levelSize(texture->width, texture->tailLevel),
+                    levelSize(texture->height, texture->tailLevel)) >
+               m_tailSize) {
+      ++texture->tailLevel;
+    }
+
+    int64_t sourceTime = getSourceTime(texture->file);
+
+    std::vector<uint8_t> tail;
+
+    bool ready = texture->width > 0 && texture->height > 0 &&
+                 (isCacheValid(*texture, sourceTime) ||
+                  writeCache(*texture, meshTexture.texture.getID(),
+                             sourceTime)) &&
+                 readMipLevels(texture->cachePath, texture->width,
+                               texture->height, texture->tailLevel,
+                               texture->nLevels, tail);
+
+    // the texture stays as it was loaded, and isn't tried again
+    if (!ready) {
+
+      std::string message = "No mip cache for " + texture->file + " in " +
+                            texture->cachePath + ", it is not streamed";
+
+      glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_OTHER, 0,
+                           GL_DEBUG_SEVERITY_LOW, message.length(),
+                           message.c_str());
+
+      m_texturesByPath[meshTexture.path] = NOT_STREAMED;
+      return NOT_STREAMED;
+    }
+
+    // the one Model loaded, shared by the meshes (pointed to the streamed
+    // texture as they are added) and textures_loaded
+    gpu::texture::Texture2D loaded = meshTexture.texture;
+
+    texture->residentLevel = texture->nLevels;
+    reallocate(*texture, texture->tailLevel, tail.data());
+
+    auto loadedIt = textures_loaded.find(texture->path);
+    if (loadedIt != textures_loaded.end()) {
+      loadedIt->second.texture = texture->texture;
+    }
+
+    loaded.destroy();
+
+    size_t index = m_textures.size();
+
+    m_texturesByPath[texture->path] = index;
+    m_textures.push_back(std::move(texture));
+
+    return index;
+  }
+
+  void computeWantedLevels(FlyCamera &camera, int viewportHeight) {
+
+    Frustum frustum{camera.getViewProjectionMatrix()};
+
+    // at a distance of 1
+    float pixelsPerUnit = static_cast<float>(viewportHeight) /
+                          (2.0f * std::tan(0.5f * camera.getFov()));
+
+    for (std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      texture->wantedLevel = texture->tailLevel;
+      texture->priority = 0.0f;
+    }
+
+    for (const StreamedMesh &mesh : m_meshes) {
+
+      glm::vec3 closest =
+          glm::clamp(camera.getPosition(), mesh.bounds.min, mesh.bounds.max);
+
+      float distance = std::max(glm::length(closest - camera.getPosition()),
+                                camera.getZNear());
+
+      float pixelsPerWorldUnit = pixelsPerUnit / distance;
+
+      // the area the mesh covers, at most the viewport
+      float screenArea =
+          std::min(mesh.area * pixelsPerWorldUnit * pixelsPerWorldUnit,
+                   pixelsPerUnit * pixelsPerUnit * camera.getAspect());
+
+      if (!frustum.intersects(mesh.bounds)) {
+        screenArea *= OFFSCREEN_PRIORITY_SCALE;
+      }
+
+      for (size_t index : mesh.textures) {
+
+        StreamedTexture &texture = *m_textures[index];
+
+        float texelsPerWorldUnit =
+            mesh.uvDensity *
+            std::sqrt(static_cast<float>(texture.width) * texture.height);
+
+        float texelsPerPixel = texelsPerWorldUnit / pixelsPerWorldUnit;
+
+        int level = texelsPerPixel > 0.0f
+                        ? static_cast<int>(std::floor(
+                              std::log2(texelsPerPixel) - m_lodBias))
+                        : texture.tailLevel;
+
+        texture.wantedLevel =
+            std::min(texture.wantedLevel, std::clamp(level, 0,
+                                                     texture.tailLevel));
+        texture.priority += screenArea;
+      }
+    }
+  }
+
+  void applyBudget() {
+
+    size_t bytes = 0;
+
+    for (std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      texture->targetLevel = texture->wantedLevel;
+      bytes += texture->getBytes(texture->targetLevel);
+    }
+
+    m_stats.wantedBytes = bytes;
+    m_stats.fullBytes = 0;
+
+    for (const std::unique_ptr<StreamedTexture> &texture : m_textures) {
+      m_stats.fullBytes += texture->getBytes(0);
+    }
+
+    if (bytes <= m_budget) {
+      return;
+    }
+
+    // what dropping the next level costs: the screen area of the texture,
+    // 4 times more for each level dropped already
+    typedef std::pair<float, size_t> Candidate;
+
+    std::priority_queue<Candidate, std::vector<Candidate>,
+                        std::greater<Candidate>>
+        candidates;
+
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+      if (m_textures[i]->targetLevel < m_textures[i]->tailLevel) {
+        candidates.push({m_textures[i]->priority, i});
+      }
+    }
+
+    while (bytes > m_budget && !candidates.empty()) {
+
+      Candidate candidate = candidates.top();
+      candidates.pop();
+
+      StreamedTexture &texture = *m_textures[candidate.second];
+
+      bytes -= levelBytes(texture.width, texture.height, texture.targetLevel);
+      ++texture.targetLevel;
+
+      if (texture.targetLevel < texture.tailLevel) {
+        candidates.push({4.0f * candidate.first, candidate.second});
+      }
+    }
+  }
+
+  // the finest levels missing first, for the textures covering the most
+  void startLoads() {
+
+    std::vector<size_t> requests;
+    size_t nInFlight = 0;
+
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+
+      const StreamedTexture &texture = *m_textures[i];
+
+      if (texture.load) {
+        ++nInFlight;
+      } else if (texture.targetLevel < texture.residentLevel) {
+        requests.push_back(i);
+      }
+    }
+
+    std::sort(requests.begin(), requests.end(), [&](size_t a, size_t b) {
+      return m_textures[a]->priority > m_textures[b]->priority;
+    });
+
+    for (size_t index : requests) {
+
+      if (nInFlight >= m_maxLoadsInFlight) {
+        break;
+      }
+
+      StreamedTexture &texture = *m_textures[index];
+
+      texture.load = std::make_unique<LoadRequest>();
+
+      LoadRequest *load = texture.load.get();
+      load->firstLevel = texture.targetLevel;
+      load->lastLevel = texture.residentLevel;
+
+      std::string path = texture.cachePath;
+      int width = texture.width;
+      int height = texture.height;
+
+      m_jobSystem.spawn(
+          [load, path, width, height]() {
+            load->succeeded =
+                readMipLevels(path, width, height, load->firstLevel,
+                              load->lastLevel, load->texels);
+          },
+          &load->counter);
+
+      // without worker threads the job only runs when the main thread
+      // waits: one load per update then, read here
+      if (m_jobSystem.getNumThreads() == 1) {
+        m_jobSystem.wait(load->counter);
+        break;
+      }
+
+      ++nInFlight;
+    }
+  }
+
+  void finishLoad(StreamedTexture &texture) {
+
+    std::unique_ptr<LoadRequest> load = std::move(texture.load);
+
+    if (!load->succeeded) {
+
+      std::string message = "Could not read the mip levels of " +
+                            texture.path + " from " + texture.cachePath;
+
+      glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0,
+                           GL_DEBUG_SEVERITY_MEDIUM, message.length(),
+                           message.c_str());
+
+      // not asked for again
+      texture.tailLevel = texture.residentLevel;
+      return;
+    }
+
+    // the budget may have shrunk since, the levels below the target are
+    // skipped
+    int firstLevel = std::max(load->firstLevel, texture.targetLevel);
+
+    if (firstLevel >= texture.residentLevel) {
+      return;
+    }
+
+    size_t skipped = levelRangeBytes(texture.width, texture.height,
+                                     load->firstLevel, firstLevel);
+
+    reallocate(texture, firstLevel, load->texels.data() + skipped);
+    ++m_stats.nLoads;
+  }
+
+  /**
+   * Replaces the texture by one with the levels [firstLevel, nLevels): the
+   * ones the previous texture has are copied, the ones it doesn't come from
+   * texels (levels firstLevel to residentLevel - 1, packed).
+   */
+  void reallocate(StreamedTexture &texture, int firstLevel,
+                  const uint8_t *texels) {
+
+    CPU_PROFILE_ZONE("TextureStreamer::reallocate");
+
+    gpu::texture::Texture2D previous = texture.texture;
+
+    gpu::texture::Texture2D streamed{
+        levelSize(texture.width, firstLevel),
+        levelSize(texture.height, firstLevel), GL_RGBA,
+        texture.nLevels - firstLevel};
+
+    streamed.setMinFilter(gpu::texture::Filter::LINEAR_MIPMAP_LINEAR);
+    streamed.setMagFilter(gpu::texture::Filter::LINEAR);
+
+    for (int level = firstLevel; level < texture.nLevels; ++level) {
+
+      int width = levelSize(texture.width, level);
+      int height = levelSize(texture.height, level);
+
+      if (level >= texture.residentLevel) {
+
+        glCopyImageSubData(previous.getID(), GL_TEXTURE_2D,
+                           level - texture.residentLevel, 0, 0, 0,
+                           streamed.getID(), GL_TEXTURE_2D, level - firstLevel,
+                           0, 0, 0, width, height, 1);
+      } else {
+
+        glTextureSubImage2D(streamed.getID(), level - firstLevel, 0, 0, width,
+                            height, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+
+        texels += levelBytes(texture.width, texture.height, level);
+      }
+    }
+
+    for (MeshTexture *user : texture.users) {
+      user->texture = streamed;
+    }
+
+    auto loadedIt = textures_loaded.find(texture.path);
+    if (loadedIt != textures_loaded.end() &&
+        loadedIt->second.texture.getID() == previous.getID()) {
+      loadedIt->second.texture = streamed;
+    }
+
+    if (previous.getID() != 0) {
+      previous.destroy();
+    }
+
+    texture.texture = streamed;
+    texture.residentLevel = firstLevel;
+  }
+};
+
+} // namespace streaming
+
+#endif // TEXTURE_STREAMER_H
@@ -0,0 +1,243 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include "cpuprofiler.h"
+#include "jobsystem.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_HIERARCHY_SSE 1
+#endif
+
+namespace scene {
+
+constexpr uint32_t NO_PARENT = ~0u;
+
+// changed nodes above which the normal matrices are split into jobs
+constexpr size_t PARALLEL_NORMAL_MATRICES = 4096;
+
+/**
+ * out = a * b. Each column of the result is the columns of a weighted by a
+ * column of b: 4 broadcast multiply-adds on sse, same operation order as
+ * glm's operator*.
+ */
+inline void multiplyMat4(const glm::mat4 &a, const glm::mat4 &b,
+                         glm::mat4 &out) {
+
+#ifdef TRANSFORM_HIERARCHY_SSE
+  __m128 a0 = _mm_loadu_ps(&a[0][0]);
+  __m128 a1 = _mm_loadu_ps(&a[1][0]);
+  __m128 a2 = _mm_loadu_ps(&a[2][0]);
+  __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+  for (int col = 0; col < 4; ++col) {
+
+    const float *column = &b[col][0];
+
+    __m128 result = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+    result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+    result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+    result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+
+    _mm_storeu_ps(&out[col][0], result);
+  }
+#else
+  out = a * b;
+#endif
+}
+
+/**
+ * transpose(inverse(mat3(world))) from the cross products of the columns
+ * (the rows of the inverse are c1 x c2, c2 x c0, c0 x c1 over the
+ * determinant), what the demos computed with glm::inverse for invModel.
+ */
+inline glm::mat3 computeNormalMatrix(const glm::mat4 &world) {
+
+  glm::vec3 c0{world[0]};
+  glm::vec3 c1{world[1]};
+  glm::vec3 c2{world[2]};
+
+  glm::vec3 r0 = glm::cross(c1, c2);
+  glm::vec3 r1 = glm::cross(c2, c0);
+  glm::vec3 r2 = glm::cross(c0, c1);
+
+  float det = glm::dot(c0, r0);
+  float invDet = det != 0.0f ? 1.0f / det : 0.0f;
+
+  return glm::mat3{r0 * invDet, r1 * invDet, r2 * invDet};
+}
+
+/**
+ * Parent-indexed transform tree stored as arrays of the same length (parent,
+ * local, world and normal matrices, dirty flag), one entry per node.
+ *
+ * A node's parent is always added before it, so the arrays are in
+ * topological order and update() is a single forward pass:
+ *
+ *  1. from the first dirty node on, a node changes if it is dirty or its
+ *     parent changed (flags propagate down in the same pass), the changed
+ *     nodes are collected in order,
+ *  2. world = parent world * local for the changed nodes only, parents
+ *     first,
+ *  3. their normal matrices, independent of each other (split into jobs
+ *     when there are many).
+ *
+ * Nothing dirty, nothing done: the per frame cost follows what moved.
+ */
+class TransformHierarchy {
+
+public:
+  TransformHierarchy() {}
+
+  // the parent has to exist already
+  uint32_t addNode(const glm::mat4 &local = glm::mat4{1.0f},
+                   uint32_t parent = NO_PARENT) {
+
+    uint32_t node = static_cast<uint32_t>(m_parents.size());
+
+    m_parents.push_back(parent < node ? parent : NO_PARENT);
+    m_local.push_back(local);
+    m_world.push_back(local);
+    m_normalMatrices.push_back(glm::mat3{1.0f});
+    m_dirty.push_back(1);
+    m_changed.push_back(0);
+
+    m_firstDirty = std::min(m_firstDirty, node);
+
+    return node;
+  }
+
+  inline void setLocal(uint32_t node, const glm::mat4 &local) {
+    m_local[node] = local;
+    m_dirty[node] = 1;
+    m_firstDirty = std::min(m_firstDirty, node);
+  }
+
+  inline const glm::mat4 &getLocal(uint32_t node) const {
+    return m_local[node];
+  }
+
+  // as of the last update()
+  inline const glm::mat4 &getWorld(uint32_t node) const {
+    return m_world[node];
+  }
+
+  inline const glm::mat3 &getNormalMatrix(uint32_t node) const {
+    return m_normalMatrices[node];
+  }
+
+  inline uint32_t getParent(uint32_t node) const { return m_parents[node]; }
+
+  inline size_t getNumNodes() const { return m_parents.size(); }
+
+  // contiguous, node order (eg. to upload a range of instances)
+  inline const glm::mat4 *getWorldMatrices() const { return m_world.data(); }
+
+  inline const glm::mat3 *getNormalMatrices() const {
+    return m_normalMatrices.data();
+  }
+
+  // the nodes recomputed by the last update(), in node order
+  inline const std::vector<uint32_t> &getChangedNodes() const {
+    return m_changedNodes;
+  }
+
+  /**
+   * Recomputes the world and normal matrices of the dirty nodes and their
+   * descendants, returns how many.
+   */
+  size_t update() {
+
+    CPU_PROFILE_ZONE("TransformHierarchy::update");
+
+    m_changedNodes.clear();
+
+    size_t nNodes = m_parents.size();
+
+    if (m_firstDirty >= nNodes) {
+      return 0;
+    }
+
+    // 1. propagate the flags
+
+    for (size_t i = m_firstDirty; i < nNodes; ++i) {
+
+      uint32_t parent = m_parents[i];
+
+      uint8_t changed =
+          m_dirty[i] | (parent != NO_PARENT ? m_changed[parent] : 0);
+
+      m_changed[i] = changed;
+      m_dirty[i] = 0;
+
+      if (changed) {
+        m_changedNodes.push_back(static_cast<uint32_t>(i));
+      }
+    }
+
+    m_firstDirty = NO_PARENT;
+
+    // 2. world matrices, a parent is always before its children in the list
+
+    for (uint32_t node : m_changedNodes) {
+
+      uint32_t parent = m_parents[node];
+
+      if (parent == NO_PARENT) {
+        m_world[node] = m_local[node];
+      } else {
+        multiplyMat4(m_world[parent], m_local[node], m_world[node]);
+      }
+    }
+
+    // 3. normal matrices
+
+    auto computeNormalMatrices = [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        uint32_t node = m_changedNodes[i];
+        m_normalMatrices[node] = computeNormalMatrix(m_world[node]);
+      }
+    };
+
+    if (m_changedNodes.size() < PARALLEL_NORMAL_MATRICES) {
+      computeNormalMatrices(0, m_changedNodes.size());
+    } else {
+      jobs::getJobSystem().parallelFor(m_changedNodes.size(),
+                                       PARALLEL_NORMAL_MATRICES / 4,
+                                       computeNormalMatrices);
+    }
+
+    // the flags stay 0 outside of update(), nodes before the next first
+    // dirty one must read as unchanged
+    for (uint32_t node : m_changedNodes) {
+      m_changed[node] = 0;
+    }
+
+    return m_changedNodes.size();
+  }
+
+private:
+  std::vector<uint32_t> m_parents;
+  std::vector<glm::mat4> m_local;
+  std::vector<glm::mat4> m_world;
+  std::vector<glm::mat3> m_normalMatrices;
+
+  // local changed since the last update, and world changed in this update
+  std::vector<uint8_t> m_dirty;
+  std::vector<uint8_t> m_changed;
+
+  uint32_t m_firstDirty = NO_PARENT;
+
+  std::vector<uint32_t> m_changedNodes;
+};
+
+} // namespace scene
+
+#endif // TRANSFORM_HIERARCHY_H